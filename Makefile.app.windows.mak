@@ -35,6 +35,16 @@ link: scaffold $(OBJ_FILES) # link
 compile: #compile .cpp files
 	@echo Compiling...
 
+.PHONY: textures
+textures: link # bake terrain textures into pre-mipped BC1 containers, rerun after editing them
+	@echo Baking textures...
+	@cd $(BUILD_DIR) && $(TITLE)$(EXTENSION) --bake-textures
+
+.PHONY: bench
+bench: link # scripted flythrough into bin/bench_report.json, fixed timestep and seed
+	@echo Benchmarking...
+	@cd $(BUILD_DIR) && $(TITLE)$(EXTENSION) --bench
+
 .PHONY: clean
 clean: # clean build directory
 	if exist $(BUILD_DIR)\$(TITLE)$(EXTENSION) del $(BUILD_DIR)\$(TITLE)$(EXTENSION)
@@ -8,10 +8,29 @@ in vec4 fragColor;
 // Input uniform values
 uniform sampler2D texture0;
 uniform vec4 colDiffuse;
-uniform float time;
-uniform vec3 viewPos;
-uniform vec3 viewTarget;
-uniform vec2 resolution;
+uniform float renderScale;      // Scene pixels per sky texel, 1, 2 or 4
+uniform int depthCull;          // 1 when the sky has its own target and depthTexture holds the scene depth
+uniform sampler2D depthTexture;
+
+// Temporal amortization, see render/atmosphere.h
+uniform int temporalFrame;        // Bayer slot marched this frame, -1 marches every pixel
+uniform sampler2D historyTexture; // Last frame's sky at the same scale, alpha 0 where nothing was marched
+uniform vec3 prevViewPos;
+uniform vec3 prevViewTarget;
+
+// Baked cloud noise, see render/atmosphere.cpp
+uniform int noiseVolumes;         // 1 samples the volumes, 0 evaluates fbm_clouds()
+uniform sampler3D cloudShape;     // fbm_clouds() octaves 1-4 over 4 cells, divided by their amplitude sum
+uniform sampler3D cloudDetail;    // Octaves 5-6, the same way
+
+// Per frame camera data shared by every program, see render/uniform.h
+layout(std140) uniform frame_data {
+  vec3 viewPos;
+  float time;
+  vec3 viewTarget;
+  float deltaTime;
+  vec2 resolution;
+};
 
 out vec4 finalColor;
 
@@ -23,6 +42,8 @@ out vec4 finalColor;
 #define cld_thick 90.0
 #define cld_absorb_coeff 1.0
 #define cld_base_height 100.0
+#define cld_shape_amplitude 0.9375   // 0.5 + 0.25 + 0.125 + 0.0625
+#define cld_detail_amplitude 0.046875 // 0.03125 + 0.015625
 
 // Fog (exponential squared) density (tweak this)
 const float FOG_DENSITY = 0.0009;
@@ -189,7 +210,15 @@ void integrate_volume(inout volume_sampler_t vol, vec3 V, vec3 L, float density,
 // Cloud density function - exactly like the working example
 float density_func(vec3 pos, float h) {
     vec3 p = pos * 0.001 + cld_wind_dir;
-    float dens = fbm_clouds(p * 2.032, 2.6434, 0.5, 0.5);
+    float dens;
+    if (noiseVolumes == 1) {
+        // Mip 0 like the ALU path, the march loop breaks early so implicit derivatives aren't defined
+        vec3 uvw = p * 2.032 / 4.0;
+        dens = textureLod(cloudShape, uvw, 0.0).r * cld_shape_amplitude
+             + textureLod(cloudDetail, uvw * 16.0, 0.0).r * cld_detail_amplitude;
+    } else {
+        dens = fbm_clouds(p * 2.032, 2.6434, 0.5, 0.5);
+    }
 
     // IMPORTANT: This smoothstep creates the cloud coverage pattern
     dens *= smoothstep(cld_coverage, cld_coverage + 0.035, dens);
@@ -299,6 +328,19 @@ vec3 apply_fog_exp2(vec3 sceneColor, vec3 fogColor, float distance, float densit
     return mix(fogColor, sceneColor, trans);
 }
 
+// Reduced texels the geometry covers completely are never seen, the upsample ignores them
+bool footprint_covered() {
+    int scale = int(renderScale);
+    ivec2 size = textureSize(depthTexture, 0);
+    ivec2 base = ivec2(gl_FragCoord.xy) * scale;
+    for (int y = 0; y < scale; y++) {
+        for (int x = 0; x < scale; x++) {
+            if (texelFetch(depthTexture, min(base + ivec2(x, y), size - 1), 0).r >= 1.0) return false;
+        }
+    }
+    return true;
+}
+
 mat3 setCamera(in vec3 ro, in vec3 ta, float cr)
 {
     vec3 cw = normalize(ta-ro);
@@ -308,16 +350,37 @@ mat3 setCamera(in vec3 ro, in vec3 ta, float cr)
     return mat3(cu, cv, cw);
 }
 
+// One pixel of every 4x4 block marches per frame, spread so the refreshed pixels never clump
+const int bayer4[16] = int[16](0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5);
+
+// Last frame's color along the same direction. The sky sits far enough away that the camera
+// rotation alone places it, the CPU drops the history when the camera moves too far.
+bool reproject_history(vec3 ray_direction, out vec4 history) {
+    mat3 prev_ca = setCamera(prevViewPos, prevViewTarget, 0.0);
+    vec3 local = transpose(prev_ca) * ray_direction;
+    if (local.z <= 0.0) return false;
+    vec2 prev_p = local.xy / local.z * 2.0;
+    vec2 prev_uv = (prev_p * resolution.y + resolution.xy) / (2.0 * resolution.xy);
+    if (any(lessThan(prev_uv, vec2(0.0))) || any(greaterThan(prev_uv, vec2(1.0)))) return false;
+    history = texture(historyTexture, prev_uv);
+    // Bilinear taps touching a texel that never marched come back translucent
+    return history.a >= 0.999;
+}
+
 // ============================================================================
 // MAIN FUNCTION
 void main() {
+    if (depthCull == 1 && footprint_covered()) discard;
+
+    // Full resolution position of the pixel, the center of the block at reduced scales
+    vec2 frag_coord = gl_FragCoord.xy * renderScale;
     vec2 aspect_ratio = vec2(resolution.x / resolution.y, 1.0);
     float FOV = 0.9;
     vec3 fin_col = vec3(0.0);
 
-    vec2 point_ndc = gl_FragCoord.xy / resolution.xy;
+    vec2 point_ndc = frag_coord / resolution.xy;
     //vec3 p = vec3((2.0 * point_ndc - 1.0) * aspect_ratio * FOV, -1.0);
-    vec2 p = (-resolution.xy + 2.0*gl_FragCoord.xy)/resolution.y;
+    vec2 p = (-resolution.xy + 2.0*frag_coord)/resolution.y;
 
     // Camera setup
     vec3 ro = viewPos;
@@ -329,6 +392,15 @@ void main() {
     // include z component properly
     vec3 ray_direction = ca * normalize(vec3(p.xy, 2.0));
 
+    if (temporalFrame >= 0) {
+        ivec2 texel = ivec2(gl_FragCoord.xy);
+        vec4 history;
+        if (bayer4[(texel.y & 3) * 4 + (texel.x & 3)] != temporalFrame && reproject_history(ray_direction, history)) {
+            finalColor = history;
+            return;
+        }
+    }
+
     // Precompute fogColor as sky in direction (gives natural tint)
     vec3 fogColor = render_sky_color(ray_direction);
 
@@ -0,0 +1,44 @@
+#version 330
+
+// Input vertex attributes (from vertex shader)
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+// Input uniform values
+uniform sampler2D texture0;          // Scene color, geometry only
+uniform vec4 colDiffuse;
+uniform sampler2D depthTexture;      // Scene depth, 1.0 where the sky shows
+uniform sampler2D atmosphereTexture; // Reduced sky, alpha 0 on texels the geometry covered
+
+out vec4 finalColor;
+
+void main()
+{
+    ivec2 pixel = ivec2(fragTexCoord * vec2(textureSize(depthTexture, 0)));
+    if (texelFetch(depthTexture, pixel, 0).r < 1.0) {
+        finalColor = texture(texture0, fragTexCoord);
+        return;
+    }
+
+    // Bilinear weights of the four nearest reduced texels, the ones that skipped marching drop out
+    ivec2 size = textureSize(atmosphereTexture, 0);
+    vec2 coord = fragTexCoord * vec2(size) - 0.5;
+    ivec2 base = ivec2(floor(coord));
+    vec2 f = coord - vec2(base);
+
+    vec3 color = vec3(0.0);
+    float weight = 0.0;
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+            vec4 texel = texelFetch(atmosphereTexture, clamp(base + ivec2(x, y), ivec2(0), size - 1), 0);
+            float w = ((x == 1) ? f.x : 1.0 - f.x) * ((y == 1) ? f.y : 1.0 - f.y) * texel.a;
+            color += texel.rgb * w;
+            weight += w;
+        }
+    }
+    // The texel holding this pixel is always among the four and never covered, guard against precision anyway
+    if (weight < 1e-4) color = texelFetch(atmosphereTexture, min(ivec2(fragTexCoord * vec2(size)), size - 1), 0).rgb;
+    else color /= weight;
+
+    finalColor = vec4(color, 1.0);
+}
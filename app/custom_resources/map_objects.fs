@@ -4,22 +4,37 @@
 in vec3 fragPosition;
 in vec2 fragTexCoord;
 in vec4 fragColor;
+in vec3 fragNormal;
 
 // Input uniform values
 uniform sampler2D texture0;
 uniform vec4 colDiffuse;
 
-uniform float time;
-uniform vec3 viewPos;
-uniform vec3 viewDir;
-uniform vec2 resolution;
+// Per frame camera data shared by every program, see render/uniform.h
+layout(std140) uniform frame_data {
+  vec3 viewPos;
+  float time;
+  vec3 viewTarget;
+  float deltaTime;
+  vec2 resolution;
+};
 
 out vec4 finalColor;
 
+// Same sun the clouds are lit by
+const vec3 sun_dir = normalize(vec3(0.0, 0.5, -1.0));
+
 void main()
 {
-  vec2 screen_pixel_coord = (gl_FragCoord.xy * 2.0 - resolution.xy) / resolution.y;
-  vec4 tex_col = texture(texture0, fragTexCoord);
+  vec4 tex_col = texture(texture0, fragTexCoord) * colDiffuse * fragColor;
+  vec3 normal = normalize(fragNormal);
+
+  float sun = max(dot(normal, sun_dir), 0.0);
+  float sky = 0.5 + 0.5 * normal.y;
+  vec3 col = tex_col.rgb * (vec3(1.0, 0.9, 0.8) * sun + vec3(0.35, 0.45, 0.6) * sky);
 
-  finalColor = vec4(0.0, 0.0, 0.0, 1);
+  // Fade into the haze with distance
+  float dist = distance(fragPosition, viewPos);
+  col = mix(col, vec3(0.5, 0.7, 1.0), 1.0 - exp(-0.00005 * dist * dist));
+  finalColor = vec4(col, tex_col.a);
 } 
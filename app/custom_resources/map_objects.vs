@@ -0,0 +1,27 @@
+#version 330
+
+// Input vertex attributes
+in vec3 vertexPosition;
+in vec2 vertexTexCoord;
+in vec3 vertexNormal;
+layout(location = 12) in mat4 instanceTransform; // SCATTER_INSTANCE_LOCATION, advances once per instance
+
+// Input uniform values
+uniform mat4 mvp; // View projection, every instance brings its own model matrix
+
+// Output vertex attributes (to fragment shader)
+out vec3 fragPosition;
+out vec2 fragTexCoord;
+out vec4 fragColor;
+out vec3 fragNormal;
+
+void main()
+{
+    vec4 world = instanceTransform * vec4(vertexPosition, 1.0);
+
+    fragPosition = world.xyz;
+    fragTexCoord = vertexTexCoord;
+    fragColor = vec4(1.0);
+    fragNormal = normalize(mat3(instanceTransform) * vertexNormal);
+    gl_Position = mvp * world;
+}
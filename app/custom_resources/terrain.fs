@@ -11,11 +11,14 @@ uniform sampler2D texture2;
 uniform sampler2D texture3;
 uniform vec4 colDiffuse;
 
-// Custom Input Uniform
-uniform vec3 viewPos;
-uniform vec3 viewTarget;
-uniform vec2 resolution;
-uniform float time;
+// Per frame camera data shared by every program, see render/uniform.h
+layout(std140) uniform frame_data {
+  vec3 viewPos;
+  float time;
+  vec3 viewTarget;
+  float deltaTime;
+  vec2 resolution;
+};
 
 // https://learnopengl.com/Advanced-OpenGL/Depth-testing
 float CalcDepth(in vec3 rd, in float Idist, in vec3 cw){
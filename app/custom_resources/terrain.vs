@@ -0,0 +1,54 @@
+#version 330
+
+// Input vertex attributes
+in vec3 vertexPosition; // Unit grid in xz, shared by every terrain node
+
+// Input uniform values
+uniform mat4 mvp;
+uniform mat4 matModel;
+uniform sampler2D texture0; // Heightmap
+
+// Per frame camera data shared by every program, see render/uniform.h
+layout(std140) uniform frame_data {
+  vec3 viewPos;
+  float time;
+  vec3 viewTarget;
+  float deltaTime;
+  vec2 resolution;
+};
+
+uniform vec4 terrainParams; // x: world size, y: height scale, z: heightmap size, w: grid resolution
+uniform vec4 nodeParams;    // xy: node min corner, z: node size, w: lod
+uniform vec2 morphParams;   // x: morph start distance, y: morph end distance
+
+// Output vertex attributes (to fragment shader)
+out vec2 fragTexCoord;
+out vec4 fragColor;
+out vec3 fragPosition;
+
+float sample_height(vec2 local) {
+    // Map the terrain extents onto texel centers so grid vertices land exactly on samples
+    float size = terrainParams.z;
+    vec2 uv = (local / terrainParams.x) * ((size - 1.0) / size) + 0.5 / size;
+    return textureLod(texture0, uv, 0.0).r * terrainParams.y;
+}
+
+void main()
+{
+    vec2 grid = vertexPosition.xz;
+    vec2 local = nodeParams.xy + grid * nodeParams.z;
+
+    // CDLOD morph: towards the edge of its range a node collapses onto its parent's grid,
+    // so neighbouring nodes of different lods meet without cracks
+    vec3 world = (matModel * vec4(local.x, sample_height(local), local.y, 1.0)).xyz;
+    float morph = clamp((distance(world, viewPos) - morphParams.x) / (morphParams.y - morphParams.x), 0.0, 1.0);
+    vec2 odd = fract(grid * terrainParams.w * 0.5) * 2.0 / terrainParams.w;
+    local -= odd * morph * nodeParams.z;
+
+    vec3 position = vec3(local.x, sample_height(local), local.y);
+
+    fragTexCoord = local / terrainParams.x;
+    fragColor = vec4(1.0);
+    fragPosition = (matModel * vec4(position, 1.0)).xyz;
+    gl_Position = mvp * vec4(position, 1.0);
+}
@@ -1,16 +1,35 @@
 #include "core/event.h"
 
+#include <atomic>
+#include <new>
+
 #include "core/fmemory.h"
 
+#define EVENT_QUEUE_MASK (EVENT_QUEUE_CAPACITY - 1)
+
+static_assert((EVENT_QUEUE_CAPACITY & EVENT_QUEUE_MASK) == 0, "EVENT_QUEUE_CAPACITY must be a power of two");
+
 typedef struct event_code_entry {
-    PFN_on_event callback;
-    event_code_entry(void) {
-        this->callback = nullptr;
-    }
+    PFN_on_event callbacks[EVENT_MAX_LISTENERS_PER_CODE];
+    u32 callback_count;
 } event_code_entry;
 
+/**
+ * @brief Sequence is the queue position the cell is free for, position + 1 once an event is posted into it.
+ */
+typedef struct queued_event {
+    std::atomic<u64> sequence;
+    i32 code;
+    event_context context;
+} queued_event;
+
 typedef struct event_system_state {
-    std::array<event_code_entry, MAX_EVENT_CODE> registered;
+    event_code_entry registered[MAX_EVENT_CODE];
+
+    queued_event* queue;
+    std::atomic<u64> post_position;
+    u8 post_padding[56]; // Producers hammer post_position, keep the consumer's cursor off that line
+    u64 dispatch_position;
 } event_system_state;
 
 static event_system_state * state;
@@ -19,61 +38,122 @@ bool event_system_initialize(void) {
     if (state) {
         return false;
     }
-    state = (event_system_state*)allocate_memory_linear(sizeof(event_system_state), true);
-    if (!state || state == nullptr) {
+    void* block = allocate_memory_linear(sizeof(event_system_state), true, MEMORY_TAG_EVENT);
+    if (!block) {
         return false;
     }
+    state = new (block) event_system_state();
 
+    state->queue = (queued_event*)allocate_memory(sizeof(queued_event) * EVENT_QUEUE_CAPACITY, false, MEMORY_TAG_EVENT);
+    for (u64 i = 0; i < EVENT_QUEUE_CAPACITY; ++i) {
+        new (&state->queue[i]) queued_event();
+        state->queue[i].sequence.store(i, std::memory_order_relaxed);
+    }
     return true;
 }
 
-consteval void event_system_shutdown(void) {
+void event_system_shutdown(void) {
     if (!state || state == nullptr) {
         return;
     }
-    state->registered.fill(event_code_entry());
-    
-    free(state);
+    free_memory(state->queue);
+    state->~event_system_state();
     state = nullptr;
 }
 
 bool event_register(i32 code, PFN_on_event on_event) {
-    if (!state) {
+    if (!state || code < 0 || code >= MAX_EVENT_CODE || !on_event) {
+        return false;
+    }
+    event_code_entry& entry = state->registered[code];
+    if (entry.callback_count >= EVENT_MAX_LISTENERS_PER_CODE) {
         return false;
     }
-    
-    event_code_entry event;
-    event.callback = on_event;
-    state->registered.at(code) = event;
+    for (u32 i = 0; i < entry.callback_count; ++i) {
+        if (entry.callbacks[i] == on_event) {
+            return false;
+        }
+    }
+    entry.callbacks[entry.callback_count++] = on_event;
     return true;
 }
 
-[[__deprecated__]] bool event_unregister([[maybe_unused]] i32 code,[[maybe_unused]] PFN_on_event on_event) {
-    if (!state) {
+bool event_unregister(i32 code, PFN_on_event on_event) {
+    if (!state || code < 0 || code >= MAX_EVENT_CODE) {
         return false;
     }
-    //std::vector<registered_event>& events = state->registered[code].events;
-    //if (events.empty()) {
-    //    return false;
-    //}
-    //
-    //for (size_t itr_000 = 0; itr_000 < events.size(); ++itr_000) {
-    //    if (events[itr_000].callback == on_event) {
-    //        events.erase(events.begin() + itr_000);
-    //        return true;
-    //    }
-    //}
+    event_code_entry& entry = state->registered[code];
+    for (u32 i = 0; i < entry.callback_count; ++i) {
+        if (entry.callbacks[i] == on_event) {
+            // Shift instead of swapping with the last one, listeners keep their order
+            for (u32 j = i + 1; j < entry.callback_count; ++j) {
+                entry.callbacks[j - 1] = entry.callbacks[j];
+            }
+            entry.callback_count--;
+            return true;
+        }
+    }
     return false;
 }
 
 bool event_fire(i32 code, event_context context) {
-    if (!state) {
+    if (!state || code < 0 || code >= MAX_EVENT_CODE) {
         return false;
     }
-    PFN_on_event callback = state->registered.at(code).callback;
-    if (!callback || callback == nullptr) {
+    // Listeners may register or unregister while handling, walk a copy
+    const event_code_entry entry = state->registered[code];
+    for (u32 i = 0; i < entry.callback_count; ++i) {
+        if (entry.callbacks[i](code, context)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool event_post(i32 code, event_context context) {
+    if (!state || code < 0 || code >= MAX_EVENT_CODE) {
         return false;
     }
+    u64 position = state->post_position.load(std::memory_order_relaxed);
+    for (;;) {
+        queued_event* cell = &state->queue[position & EVENT_QUEUE_MASK];
+        const i64 diff = (i64)cell->sequence.load(std::memory_order_acquire) - (i64)position;
+        if (diff == 0) {
+            if (state->post_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                cell->code = code;
+                cell->context = context;
+                cell->sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0) {
+            return false;
+        }
+        else {
+            position = state->post_position.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+u32 event_system_dispatch_queued(void) {
+    if (!state) {
+        return 0;
+    }
+    const u64 end = state->post_position.load(std::memory_order_acquire);
+    u32 dispatched = 0;
+    while (state->dispatch_position < end) {
+        queued_event* cell = &state->queue[state->dispatch_position & EVENT_QUEUE_MASK];
+        // A producer claimed this cell but hasn't finished writing, pick it up next frame
+        if (cell->sequence.load(std::memory_order_acquire) != state->dispatch_position + 1) {
+            break;
+        }
+        const i32 code = cell->code;
+        const event_context context = cell->context;
+        cell->sequence.store(state->dispatch_position + EVENT_QUEUE_CAPACITY, std::memory_order_release);
+        state->dispatch_position++;
 
-    return callback(code, context);
+        event_fire(code, context);
+        dispatched++;
+    }
+    return dispatched;
 }
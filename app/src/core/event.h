@@ -4,6 +4,9 @@
 
 #include "defines.h"
 
+#define EVENT_MAX_LISTENERS_PER_CODE 16
+#define EVENT_QUEUE_CAPACITY 4096
+
 typedef struct event_context {
   data128 data;
   event_context(void) {
@@ -47,17 +50,44 @@ typedef struct event_context {
   }
 } event_context;
 
+/**
+ * @brief Returning true marks the event as handled, listeners registered after this one don't see it.
+ */
 typedef bool (*PFN_on_event)(i32 code, event_context data);
 
-bool event_system_initialize(void) ;
-consteval void event_system_shutdown(void);
+[[__nodiscard__]] bool event_system_initialize(void);
+void event_system_shutdown(void);
 
+/**
+ * @brief Listeners run in registration order. Registering the same callback twice for a code fails.
+ */
 bool event_register(i32 code, PFN_on_event on_event);
 
 bool event_unregister(i32 code, PFN_on_event on_event);
 
+/**
+ * @brief Dispatches on the calling thread right away. Returns true if a listener handled it.
+ */
 bool event_fire(i32 code, event_context context);
 
+/**
+ * @brief Thread safe and lock free, the event is fired by the next event_system_dispatch_queued().
+ * Returns false when the queue is full.
+ */
+bool event_post(i32 code, event_context context);
+
+/**
+ * @brief Fires the events posted before the call, in post order. Main thread, once per frame.
+ * Events posted by the listeners themselves wait for the next call.
+ * @return Number of events dispatched
+ */
+u32 event_system_dispatch_queued(void);
+
+/**
+ * @brief Posts from every job thread while one thread drains, logs posts per second under contention.
+ */
+void event_run_benchmark(void);
+
 typedef enum system_event_code {
   // app
   EVENT_CODE_APPLICATION_QUIT,
@@ -120,6 +150,13 @@ typedef enum system_event_code {
   EVENT_CODE_PLAYER_ADD_EXP,
   EVENT_CODE_PLAYER_SET_POSITION,
   EVENT_CODE_PLAYER_TAKE_DAMAGE,
+
+  // render
+  /**
+   * @brief shader_handle context.data.u32[0], old program id u32[1], new program id u32[2]
+   * @brief Fired by shader_system_update() on the main thread, before the old program is unloaded
+   */
+  EVENT_CODE_SHADER_RELOADED,
   MAX_EVENT_CODE
 } system_event_code;
 
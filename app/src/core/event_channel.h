@@ -0,0 +1,164 @@
+#ifndef EVENT_CHANNEL_H
+#define EVENT_CHANNEL_H
+
+#include "core/event.h"
+
+#include <concepts>
+
+/**
+ * @brief Optional glue to the system_event_code world. An event type that declares
+ * `static constexpr system_event_code code`, `event_context to_context(void) const` and a constructor from
+ * event_context can be fired to, posted to and bridged from the untyped listeners during migration.
+ */
+template <typename T>
+concept event_has_code = requires(const T& event, event_context context) {
+  { T::code } -> std::convertible_to<system_event_code>;
+  { event.to_context() } -> std::same_as<event_context>;
+  T(context);
+};
+
+/**
+ * @brief One listener list per event type, resolved at compile time. There's no code table, no unpacking
+ * and no type checks at dispatch. Like event_fire, main thread only.
+ */
+template <typename T>
+struct event_channel {
+  typedef bool (*PFN_on_typed_event)(const T& event);
+
+  static inline PFN_on_typed_event listeners[EVENT_MAX_LISTENERS_PER_CODE] = {};
+  static inline u32 listener_count = 0;
+  static inline bool bridged = false;
+
+  static bool subscribe(PFN_on_typed_event on_event) {
+    if (not on_event or listener_count >= EVENT_MAX_LISTENERS_PER_CODE) {
+      return false;
+    }
+    for (u32 i = 0; i < listener_count; ++i) {
+      if (listeners[i] == on_event) {
+        return false;
+      }
+    }
+    listeners[listener_count++] = on_event;
+    return true;
+  }
+
+  static bool unsubscribe(PFN_on_typed_event on_event) {
+    for (u32 i = 0; i < listener_count; ++i) {
+      if (listeners[i] == on_event) {
+        for (u32 j = i + 1; j < listener_count; ++j) {
+          listeners[j - 1] = listeners[j];
+        }
+        listener_count--;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Typed listeners only, in subscription order until one returns true.
+   */
+  static bool dispatch(const T& event) {
+    for (u32 i = 0; i < listener_count; ++i) {
+      if (listeners[i](event)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Types with a code also reach the untyped listeners of that code. Once bridged, everything goes through
+   * event_fire so each listener sees the event exactly once, in registration order.
+   */
+  static bool fire(const T& event) {
+    if constexpr (event_has_code<T>) {
+      if (bridged) {
+        return event_fire(T::code, event.to_context());
+      }
+      return dispatch(event) or event_fire(T::code, event.to_context());
+    }
+    else {
+      return dispatch(event);
+    }
+  }
+
+  /**
+   * @brief Queued through event_post, typed listeners receive it only when the channel is bridged.
+   */
+  static bool post(const T& event) requires event_has_code<T> {
+    return event_post(T::code, event.to_context());
+  }
+
+  /**
+   * @brief Registers a listener on T::code that unpacks the context and forwards to the typed listeners,
+   * so event_fire and event_post with the old code reach them too.
+   */
+  static bool bridge(void) requires event_has_code<T> {
+    if (bridged) {
+      return true;
+    }
+    bridged = event_register(T::code, on_untyped_event);
+    return bridged;
+  }
+
+  static void unbridge(void) requires event_has_code<T> {
+    if (bridged) {
+      event_unregister(T::code, on_untyped_event);
+      bridged = false;
+    }
+  }
+
+  static bool on_untyped_event([[maybe_unused]] i32 code, event_context context) requires event_has_code<T> {
+    return dispatch(T(context));
+  }
+};
+
+/**
+ * @brief Listeners fixed at compile time, the fire is a chain of direct calls the compiler can inline.
+ */
+template <typename T, bool (*... LISTENERS)(const T&)>
+struct event_static_channel {
+  static bool fire(const T& event) {
+    return (LISTENERS(event) or ...);
+  }
+};
+
+/**
+ * @brief Typed form of EVENT_CODE_DAMAGE_ANY_SPAWN_IF_COLLIDE, same i16 layout as the packed context.
+ */
+typedef struct damage_event {
+  static constexpr system_event_code code = EVENT_CODE_DAMAGE_ANY_SPAWN_IF_COLLIDE;
+  i16 x;
+  i16 y;
+  i16 width;
+  i16 height;
+  i16 damage;
+  i16 collision_type;
+
+  damage_event(i16 x, i16 y, i16 width, i16 height, i16 damage, i16 collision_type)
+    : x(x), y(y), width(width), height(height), damage(damage), collision_type(collision_type) {}
+  explicit damage_event(event_context context)
+    : x(context.data.i16[0]), y(context.data.i16[1]), width(context.data.i16[2]), height(context.data.i16[3]),
+      damage(context.data.i16[4]), collision_type(context.data.i16[5]) {}
+  event_context to_context(void) const {
+    return event_context(x, y, width, height, damage, collision_type);
+  }
+} damage_event;
+
+/**
+ * @brief Typed form of EVENT_CODE_CAMERA_SET_CAMERA_POSITION, f32[0] and f32[1] of the packed context.
+ */
+typedef struct camera_position_event {
+  static constexpr system_event_code code = EVENT_CODE_CAMERA_SET_CAMERA_POSITION;
+  f32 x;
+  f32 y;
+
+  camera_position_event(f32 x, f32 y) : x(x), y(y) {}
+  explicit camera_position_event(event_context context) : x(context.data.f32[0]), y(context.data.f32[1]) {}
+  event_context to_context(void) const {
+    return event_context(x, y);
+  }
+} camera_position_event;
+
+#endif
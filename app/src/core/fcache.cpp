@@ -0,0 +1,343 @@
+#include "fcache.h"
+
+#include <stdio.h>  // Required for: fopen(), fwrite(), rename()
+#include <string.h> // Required for: memcpy()
+
+#if PLATFORM_WINDOWS
+  #define WIN32_LEAN_AND_MEAN
+  #define NOMINMAX
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#define CACHE_MAGIC 0x48434646u // "FFCH"
+#define CACHE_FORMAT_VERSION 1u
+#define CACHE_PATH_MAX 512
+
+typedef struct cache_header {
+  u32 magic;
+  u32 format_version;
+  u32 type;
+  u32 section_count;
+  u64 key;
+  u64 file_size;
+  u64 checksum; // Section table, then every section's data
+} cache_header;
+
+typedef struct cache_section_entry {
+  u32 id;
+  u32 padding;
+  u64 offset;
+  u64 size;
+} cache_section_entry;
+
+static_assert(sizeof(cache_header) == 40, "cache_header is written as it is");
+static_assert(sizeof(cache_section_entry) == 24, "cache_section_entry is written as it is");
+
+// XXH64 constants and rounds
+static constexpr u64 HASH_PRIME_1 = 0x9E3779B185EBCA87ull;
+static constexpr u64 HASH_PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr u64 HASH_PRIME_3 = 0x165667B19E3779F9ull;
+static constexpr u64 HASH_PRIME_4 = 0x85EBCA77C2B2AE63ull;
+static constexpr u64 HASH_PRIME_5 = 0x27D4EB2F165667C5ull;
+
+static inline u64 rotl64(u64 value, u32 bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+static inline u64 read_u64(const u8* p) {
+  u64 value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline u32 read_u32(const u8* p) {
+  u32 value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline u64 hash_round(u64 accumulator, u64 input) {
+  accumulator += input * HASH_PRIME_2;
+  accumulator = rotl64(accumulator, 31);
+  return accumulator * HASH_PRIME_1;
+}
+
+static inline u64 hash_merge(u64 hash, u64 lane) {
+  hash ^= hash_round(0, lane);
+  return hash * HASH_PRIME_1 + HASH_PRIME_4;
+}
+
+static inline u64 align_offset(u64 offset) {
+  return (offset + CACHE_SECTION_ALIGNMENT - 1) & ~(u64)(CACHE_SECTION_ALIGNMENT - 1);
+}
+
+static bool map_file(const char* path, cache_file* file);
+static void unmap_file(cache_file* file);
+static cache_result validate(cache_file* file, u32 type, u64 key);
+
+u64 cache_hash(const void* data, u64 size, u64 seed) {
+  const u8* p = (const u8*)data;
+  const u8* end = p + size;
+  u64 hash;
+  if (size >= 32) {
+    // Four independent lanes keep the multiplies pipelined
+    u64 v1 = seed + HASH_PRIME_1 + HASH_PRIME_2;
+    u64 v2 = seed + HASH_PRIME_2;
+    u64 v3 = seed;
+    u64 v4 = seed - HASH_PRIME_1;
+    const u8* limit = end - 32;
+    do {
+      v1 = hash_round(v1, read_u64(p));
+      v2 = hash_round(v2, read_u64(p + 8));
+      v3 = hash_round(v3, read_u64(p + 16));
+      v4 = hash_round(v4, read_u64(p + 24));
+      p += 32;
+    } while (p <= limit);
+    hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+    hash = hash_merge(hash, v1);
+    hash = hash_merge(hash, v2);
+    hash = hash_merge(hash, v3);
+    hash = hash_merge(hash, v4);
+  } else {
+    hash = seed + HASH_PRIME_5;
+  }
+  hash += size;
+
+  for (; p + 8 <= end; p += 8) {
+    hash ^= hash_round(0, read_u64(p));
+    hash = rotl64(hash, 27) * HASH_PRIME_1 + HASH_PRIME_4;
+  }
+  if (p + 4 <= end) {
+    hash ^= (u64)read_u32(p) * HASH_PRIME_1;
+    hash = rotl64(hash, 23) * HASH_PRIME_2 + HASH_PRIME_3;
+    p += 4;
+  }
+  for (; p < end; ++p) {
+    hash ^= (u64)(*p) * HASH_PRIME_5;
+    hash = rotl64(hash, 11) * HASH_PRIME_1;
+  }
+  hash ^= hash >> 33;
+  hash *= HASH_PRIME_2;
+  hash ^= hash >> 29;
+  hash *= HASH_PRIME_3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+bool cache_write(const char* path, u32 type, u64 key, const cache_section* sections, u32 section_count) {
+  if (not path or section_count > CACHE_MAX_SECTIONS or (section_count > 0 and not sections)) {
+    return false;
+  }
+  char temporary_path[CACHE_PATH_MAX];
+  if (snprintf(temporary_path, sizeof(temporary_path), "%s.tmp", path) >= (i32)sizeof(temporary_path)) {
+    return false;
+  }
+
+  cache_section_entry table[CACHE_MAX_SECTIONS] = {};
+  const u64 table_size = sizeof(cache_section_entry) * section_count;
+  u64 offset = align_offset(sizeof(cache_header) + table_size);
+  for (u32 i = 0; i < section_count; ++i) {
+    table[i] = cache_section_entry { sections[i].id, 0u, offset, sections[i].size };
+    offset = align_offset(offset + sections[i].size);
+  }
+  cache_header header = {};
+  header.magic = CACHE_MAGIC;
+  header.format_version = CACHE_FORMAT_VERSION;
+  header.type = type;
+  header.section_count = section_count;
+  header.key = key;
+  header.file_size = offset;
+  header.checksum = cache_hash(table, table_size, 0);
+  for (u32 i = 0; i < section_count; ++i) {
+    header.checksum = cache_hash(sections[i].data, sections[i].size, header.checksum);
+  }
+
+  FILE* file = fopen(temporary_path, "wb");
+  if (not file) {
+    return false;
+  }
+  static const u8 zeros[CACHE_SECTION_ALIGNMENT] = {};
+  u64 written = fwrite(&header, 1, sizeof(header), file);
+  written += fwrite(table, 1, table_size, file);
+  u64 position = sizeof(header) + table_size;
+  for (u32 i = 0; i <= section_count; ++i) {
+    const u64 start = (i < section_count) ? table[i].offset : header.file_size;
+    written += fwrite(zeros, 1, start - position, file);
+    position = start;
+    if (i < section_count) {
+      written += fwrite(sections[i].data, 1, sections[i].size, file);
+      position += sections[i].size;
+    }
+  }
+  const bool complete = fclose(file) == 0 and written == header.file_size;
+  if (not complete) {
+    remove(temporary_path);
+    return false;
+  }
+  #if PLATFORM_WINDOWS
+    return MoveFileExA(temporary_path, path, MOVEFILE_REPLACE_EXISTING) != 0;
+  #else
+    return rename(temporary_path, path) == 0;
+  #endif
+}
+
+cache_result cache_open(const char* path, u32 type, u64 key, cache_file* out) {
+  if (not out) {
+    return CACHE_MISSING;
+  }
+  *out = cache_file {};
+  if (not path or not map_file(path, out)) {
+    return CACHE_MISSING;
+  }
+  const cache_result result = validate(out, type, key);
+  if (result != CACHE_OK) {
+    unmap_file(out);
+    *out = cache_file {};
+  }
+  return result;
+}
+
+bool cache_map(const char* path, cache_file* out) {
+  if (not out) {
+    return false;
+  }
+  *out = cache_file {};
+  return path and map_file(path, out);
+}
+
+void cache_close(cache_file* file) {
+  if (not file or not file->data) {
+    return;
+  }
+  unmap_file(file);
+  *file = cache_file {};
+}
+
+const void* cache_find_section(const cache_file* file, u32 id, u64 expected_size) {
+  if (not file) {
+    return nullptr;
+  }
+  for (u32 i = 0; i < file->section_count; ++i) {
+    if (file->sections[i].id == id) {
+      return (file->sections[i].size == expected_size) ? file->sections[i].data : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+const char* cache_result_string(cache_result result) {
+  switch (result) {
+    case CACHE_OK: return "valid";
+    case CACHE_MISSING: return "missing";
+    case CACHE_STALE: return "stale";
+    case CACHE_CORRUPT: return "corrupt";
+    default: return "unknown";
+  }
+}
+
+static cache_result validate(cache_file* file, u32 type, u64 key) {
+  if (file->size < sizeof(cache_header)) {
+    return CACHE_CORRUPT;
+  }
+  cache_header header;
+  memcpy(&header, file->data, sizeof(header));
+  if (header.magic != CACHE_MAGIC) {
+    return CACHE_CORRUPT;
+  }
+  if (header.format_version != CACHE_FORMAT_VERSION or header.type != type or header.key != key) {
+    return CACHE_STALE;
+  }
+  const u64 table_size = sizeof(cache_section_entry) * header.section_count;
+  if (header.file_size != file->size or header.section_count > CACHE_MAX_SECTIONS or sizeof(cache_header) + table_size > file->size) {
+    return CACHE_CORRUPT;
+  }
+
+  const u8* table = file->data + sizeof(cache_header);
+  u64 checksum = cache_hash(table, table_size, 0);
+  for (u32 i = 0; i < header.section_count; ++i) {
+    cache_section_entry entry;
+    memcpy(&entry, table + i * sizeof(cache_section_entry), sizeof(entry));
+    if (entry.offset % CACHE_SECTION_ALIGNMENT != 0 or entry.offset > file->size or entry.size > file->size - entry.offset) {
+      return CACHE_CORRUPT;
+    }
+    file->sections[i] = cache_section { entry.id, file->data + entry.offset, entry.size };
+    checksum = cache_hash(file->data + entry.offset, entry.size, checksum);
+  }
+  if (checksum != header.checksum) {
+    return CACHE_CORRUPT;
+  }
+  file->section_count = header.section_count;
+  return CACHE_OK;
+}
+
+#if PLATFORM_WINDOWS
+
+static bool map_file(const char* path, cache_file* file) {
+  HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size = {};
+  if (not GetFileSizeEx(handle, &size) or size.QuadPart == 0) {
+    CloseHandle(handle);
+    return false;
+  }
+  // The mapping keeps the file open on its own
+  HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(handle);
+  if (not mapping) {
+    return false;
+  }
+  const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (not view) {
+    CloseHandle(mapping);
+    return false;
+  }
+  file->data = (const u8*)view;
+  file->size = (u64)size.QuadPart;
+  file->mapping_handle = mapping;
+  return true;
+}
+
+static void unmap_file(cache_file* file) {
+  UnmapViewOfFile(file->data);
+  CloseHandle((HANDLE)file->mapping_handle);
+}
+
+#else
+
+static bool map_file(const char* path, cache_file* file) {
+  const i32 descriptor = open(path, O_RDONLY);
+  if (descriptor < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(descriptor, &info) != 0 or info.st_size <= 0) {
+    close(descriptor);
+    return false;
+  }
+  i32 flags = MAP_PRIVATE;
+  #if PLATFORM_LINUX
+    // Validation reads every page right away, fault them in with one call
+    flags |= MAP_POPULATE;
+  #endif
+  void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, flags, descriptor, 0);
+  close(descriptor);
+  if (view == MAP_FAILED) {
+    return false;
+  }
+  file->data = (const u8*)view;
+  file->size = (u64)info.st_size;
+  return true;
+}
+
+static void unmap_file(cache_file* file) {
+  munmap((void*)file->data, (size_t)file->size);
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef FCACHE_H
+#define FCACHE_H
+
+#include "defines.h"
+
+#define CACHE_MAX_SECTIONS 32
+#define CACHE_SECTION_ALIGNMENT 64 // Sections start on cache lines, mapped pointers can be used as any array
+
+typedef enum cache_result {
+  CACHE_OK,
+  CACHE_MISSING,  // No file or it can't be mapped
+  CACHE_STALE,    // Written by another format version or for another key
+  CACHE_CORRUPT,  // Truncated, bad section table or checksum mismatch
+  CACHE_RESULT_MAX,
+} cache_result;
+
+/**
+ * @brief One array of the cache, written as it is and mapped back in place.
+ */
+typedef struct cache_section {
+  u32 id;
+  const void* data;
+  u64 size;
+} cache_section;
+
+/**
+ * @brief Read only mapping of a validated cache file. Section pointers stay valid until cache_close().
+ */
+typedef struct cache_file {
+  const u8* data;
+  u64 size;
+  u32 section_count;
+  cache_section sections[CACHE_MAX_SECTIONS];
+  void* mapping_handle; // Windows only
+} cache_file;
+
+/**
+ * @brief 64 bit hash, keys caches by their generation parameters and checksums their payload.
+ * Chain calls through seed to hash several fields.
+ */
+u64 cache_hash(const void* data, u64 size, u64 seed);
+
+/**
+ * @brief Writes a temporary file next to path and renames it over path, a crash never leaves a half written cache.
+ * @param type Format id and version of the caller, a cache of another type is stale
+ */
+bool cache_write(const char* path, u32 type, u64 key, const cache_section* sections, u32 section_count);
+
+/**
+ * @brief Maps path and validates the header, the section table and the checksum. Nothing is parsed or copied.
+ */
+cache_result cache_open(const char* path, u32 type, u64 key, cache_file* out);
+void cache_close(cache_file* file);
+
+/**
+ * @brief Maps path read only without looking at it, for formats that aren't cache files. section_count stays 0.
+ */
+bool cache_map(const char* path, cache_file* out);
+
+/**
+ * @brief Data of the section with id, nullptr when it's missing or its size isn't expected_size.
+ */
+const void* cache_find_section(const cache_file* file, u32 id, u64 expected_size);
+
+const char* cache_result_string(cache_result result);
+
+#endif
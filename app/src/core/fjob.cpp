@@ -0,0 +1,396 @@
+#include "fjob.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "core/fmemory.h"
+
+#define JOB_DEQUE_MASK (JOB_DEQUE_CAPACITY - 1)
+#define JOB_WORKER_IDLE_WAIT_MS 2
+
+static_assert((JOB_DEQUE_CAPACITY & JOB_DEQUE_MASK) == 0, "JOB_DEQUE_CAPACITY must be a power of two");
+
+typedef struct job {
+  PFN_job function;
+  void* data;
+  job_counter* counter;
+} job;
+
+/**
+ * @brief Chase-Lev deque. The owner pushes and pops at the bottom, other threads steal from the top.
+ */
+typedef struct job_deque {
+  std::atomic<i64> top;
+  u8 top_padding[56]; // Keep thieves and the owner on separate cache lines
+  std::atomic<i64> bottom;
+  u8 bottom_padding[56];
+  job jobs[JOB_DEQUE_CAPACITY];
+} job_deque;
+
+typedef struct pending_job {
+  job task;
+  job_counter* dependency;
+} pending_job;
+
+typedef struct parallel_for_context {
+  PFN_job_range function;
+  void* data;
+  u32 count;
+  u32 batch_size;
+  std::atomic<u32> next;
+} parallel_for_context;
+
+typedef struct job_system_state {
+  u32 thread_count;
+  std::atomic<bool> running;
+  job_deque* deques; // One per thread, main thread included
+
+  std::mutex injection_mutex; // Jobs pushed from threads that own no deque
+  std::vector<job> injection_queue;
+
+  std::mutex main_thread_mutex;
+  std::vector<job> main_thread_queue;
+
+  std::mutex pending_mutex;
+  std::vector<pending_job> pending_jobs;
+
+  std::mutex sleep_mutex;
+  std::condition_variable wake;
+  std::atomic<i32> queued_count;
+  std::atomic<u32> sleeping_count;
+
+  std::vector<std::thread> workers;
+} job_system_state;
+
+static job_system_state * state = nullptr;
+static thread_local u32 thread_index = U32_MAX;
+static thread_local u32 steal_seed = 0;
+
+static void worker_main(u32 index);
+static bool try_take_job(job* out);
+static void execute_job(const job& task);
+static void enqueue_job(const job& task);
+
+static bool deque_push(job_deque* dq, const job& task) {
+  const i64 b = dq->bottom.load(std::memory_order_relaxed);
+  const i64 t = dq->top.load(std::memory_order_acquire);
+  if (b - t >= JOB_DEQUE_CAPACITY) {
+    return false;
+  }
+  dq->jobs[b & JOB_DEQUE_MASK] = task;
+  std::atomic_thread_fence(std::memory_order_release);
+  dq->bottom.store(b + 1, std::memory_order_relaxed);
+  return true;
+}
+
+static bool deque_pop(job_deque* dq, job* out) {
+  const i64 b = dq->bottom.load(std::memory_order_relaxed) - 1;
+  dq->bottom.store(b, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  i64 t = dq->top.load(std::memory_order_relaxed);
+
+  if (t > b) {
+    dq->bottom.store(b + 1, std::memory_order_relaxed);
+    return false;
+  }
+  *out = dq->jobs[b & JOB_DEQUE_MASK];
+  if (t == b) {
+    // Last job, race against thieves for it
+    const bool won = dq->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    dq->bottom.store(b + 1, std::memory_order_relaxed);
+    return won;
+  }
+  return true;
+}
+
+static bool deque_steal(job_deque* dq, job* out) {
+  i64 t = dq->top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const i64 b = dq->bottom.load(std::memory_order_acquire);
+  if (t >= b) {
+    return false;
+  }
+  const job task = dq->jobs[t & JOB_DEQUE_MASK];
+  if (not dq->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    return false;
+  }
+  *out = task;
+  return true;
+}
+
+bool job_system_initialize(u32 worker_count) {
+  if (state and state != nullptr) {
+    return false;
+  }
+  if (worker_count == JOB_WORKERS_AUTO) {
+    const u32 hardware_threads = std::thread::hardware_concurrency();
+    worker_count = (hardware_threads > 1) ? hardware_threads - 1 : 0;
+  }
+  worker_count = FMIN(worker_count, (u32)JOB_MAX_WORKER_COUNT);
+
+  void* block = allocate_memory_linear(sizeof(job_system_state), true, MEMORY_TAG_JOB);
+  if (not block) {
+    return false;
+  }
+  state = new (block) job_system_state();
+  state->thread_count = worker_count + 1;
+  state->running.store(true);
+
+  state->deques = (job_deque*)allocate_memory(sizeof(job_deque) * state->thread_count, true, MEMORY_TAG_JOB);
+  for (u32 i = 0; i < state->thread_count; ++i) {
+    new (&state->deques[i]) job_deque();
+  }
+  thread_index = JOB_MAIN_THREAD_INDEX;
+
+  state->workers.reserve(worker_count);
+  for (u32 i = 1; i <= worker_count; ++i) {
+    state->workers.emplace_back(worker_main, i);
+  }
+  return true;
+}
+
+void job_system_shutdown(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(state->sleep_mutex);
+    state->running.store(false);
+  }
+  state->wake.notify_all();
+  for (std::thread& worker : state->workers) {
+    worker.join();
+  }
+  // Whatever is left for the main thread still has to run, e.g. resource releases
+  job_system_update_main_thread();
+
+  free_memory(state->deques);
+  state->~job_system_state();
+  state = nullptr;
+  thread_index = U32_MAX;
+}
+
+void job_system_update_main_thread(void) {
+  if (not state or state == nullptr or thread_index != JOB_MAIN_THREAD_INDEX) {
+    return;
+  }
+  std::vector<job> tasks;
+  {
+    std::lock_guard<std::mutex> lock(state->main_thread_mutex);
+    tasks.swap(state->main_thread_queue);
+  }
+  for (const job& task : tasks) {
+    execute_job(task);
+  }
+}
+
+void job_run(job_desc desc, job_counter* counter) {
+  const job task = job { desc.function, desc.data, counter };
+  if (counter) {
+    counter->value.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (not state or state == nullptr) {
+    execute_job(task);
+    return;
+  }
+  enqueue_job(task);
+}
+
+void job_run_after(job_desc desc, job_counter* dependency, job_counter* counter) {
+  if (not dependency or not state or state == nullptr) {
+    job_run(desc, counter);
+    return;
+  }
+  const job task = job { desc.function, desc.data, counter };
+  if (counter) {
+    counter->value.fetch_add(1, std::memory_order_relaxed);
+  }
+  {
+    // Checked under the lock, so a dependency finishing right now either sees this job or we see zero
+    std::lock_guard<std::mutex> lock(state->pending_mutex);
+    if (dependency->value.load(std::memory_order_acquire) > 0) {
+      state->pending_jobs.push_back(pending_job { task, dependency });
+      return;
+    }
+  }
+  enqueue_job(task);
+}
+
+void job_run_on_main_thread(job_desc desc, job_counter* counter) {
+  const job task = job { desc.function, desc.data, counter };
+  if (counter) {
+    counter->value.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (not state or state == nullptr) {
+    execute_job(task);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(state->main_thread_mutex);
+  state->main_thread_queue.push_back(task);
+}
+
+void job_wait(job_counter* counter) {
+  if (not counter) {
+    return;
+  }
+  while (counter->value.load(std::memory_order_acquire) > 0) {
+    job task;
+    if (state and try_take_job(&task)) {
+      execute_job(task);
+      continue;
+    }
+    if (thread_index == JOB_MAIN_THREAD_INDEX) {
+      // Jobs waited on here may depend on main thread work
+      job_system_update_main_thread();
+    }
+    std::this_thread::yield();
+  }
+}
+
+static void parallel_for_batch(void* data) {
+  parallel_for_context* ctx = (parallel_for_context*)data;
+  for (;;) {
+    const u32 begin = ctx->next.fetch_add(ctx->batch_size, std::memory_order_relaxed);
+    if (begin >= ctx->count) {
+      return;
+    }
+    ctx->function(begin, FMIN(begin + ctx->batch_size, ctx->count), ctx->data);
+  }
+}
+
+void job_parallel_for(u32 count, u32 batch_size, PFN_job_range function, void* data) {
+  if (count == 0 or not function) {
+    return;
+  }
+  batch_size = FMAX(batch_size, 1u);
+
+  parallel_for_context ctx;
+  ctx.function = function;
+  ctx.data = data;
+  ctx.count = count;
+  ctx.batch_size = batch_size;
+  ctx.next.store(0, std::memory_order_relaxed);
+
+  // One job per helping thread, each of them keeps pulling batches until the range is drained
+  const u32 batch_count = (count + batch_size - 1) / batch_size;
+  const u32 helpers = FMIN(job_thread_count(), batch_count) - 1;
+  job_counter counter;
+  for (u32 i = 0; i < helpers; ++i) {
+    job_run(job_desc { parallel_for_batch, &ctx }, &counter);
+  }
+  parallel_for_batch(&ctx);
+  job_wait(&counter);
+}
+
+u32 job_thread_count(void) {
+  if (not state or state == nullptr) {
+    return 1;
+  }
+  return state->thread_count;
+}
+
+u32 job_thread_index(void) {
+  return thread_index;
+}
+
+static void worker_main(u32 index) {
+  thread_index = index;
+  steal_seed = index * 0x9e3779b9u;
+
+  while (state->running.load(std::memory_order_acquire)) {
+    job task;
+    if (try_take_job(&task)) {
+      execute_job(task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(state->sleep_mutex);
+    state->sleeping_count.fetch_add(1, std::memory_order_relaxed);
+    state->wake.wait_for(lock, std::chrono::milliseconds(JOB_WORKER_IDLE_WAIT_MS), [] {
+      return state->queued_count.load(std::memory_order_acquire) > 0 or not state->running.load(std::memory_order_acquire);
+    });
+    state->sleeping_count.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+static bool try_take_job(job* out) {
+  const u32 self = thread_index;
+  if (self < state->thread_count and deque_pop(&state->deques[self], out)) {
+    state->queued_count.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+  {
+    std::unique_lock<std::mutex> lock(state->injection_mutex, std::try_to_lock);
+    if (lock.owns_lock() and not state->injection_queue.empty()) {
+      *out = state->injection_queue.back();
+      state->injection_queue.pop_back();
+      state->queued_count.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  // Start at a random victim so thieves don't all hammer the same deque
+  steal_seed = steal_seed * 1664525u + 1013904223u;
+  const u32 first = steal_seed % state->thread_count;
+  for (u32 i = 0; i < state->thread_count; ++i) {
+    const u32 victim = (first + i) % state->thread_count;
+    if (victim != self and deque_steal(&state->deques[victim], out)) {
+      state->queued_count.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+static void release_dependents(job_counter* counter) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  // Always under the lock, job_run_after() may be registering against this counter right now
+  std::vector<job> ready;
+  {
+    std::lock_guard<std::mutex> lock(state->pending_mutex);
+    if (state->pending_jobs.empty()) {
+      return;
+    }
+    for (size_t i = 0; i < state->pending_jobs.size();) {
+      if (state->pending_jobs[i].dependency == counter) {
+        ready.push_back(state->pending_jobs[i].task);
+        state->pending_jobs[i] = state->pending_jobs.back();
+        state->pending_jobs.pop_back();
+      }
+      else ++i;
+    }
+  }
+  for (const job& task : ready) {
+    enqueue_job(task);
+  }
+}
+
+static void execute_job(const job& task) {
+  task.function(task.data);
+  if (task.counter and task.counter->value.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    release_dependents(task.counter);
+  }
+}
+
+static void enqueue_job(const job& task) {
+  const u32 self = thread_index;
+  if (self < state->thread_count and deque_push(&state->deques[self], task)) {
+    state->queued_count.fetch_add(1, std::memory_order_release);
+  }
+  else if (self < state->thread_count) {
+    // Own deque is full, run it inline instead of growing
+    execute_job(task);
+    return;
+  }
+  else {
+    std::lock_guard<std::mutex> lock(state->injection_mutex);
+    state->injection_queue.push_back(task);
+    state->queued_count.fetch_add(1, std::memory_order_release);
+  }
+  if (state->sleeping_count.load(std::memory_order_relaxed) > 0) {
+    state->wake.notify_one();
+  }
+}
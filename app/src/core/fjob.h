@@ -0,0 +1,70 @@
+#ifndef FJOB_H
+#define FJOB_H
+
+#include "defines.h"
+
+#include <atomic>
+
+#define JOB_DEQUE_CAPACITY 4096
+#define JOB_MAX_WORKER_COUNT 64
+#define JOB_MAIN_THREAD_INDEX 0
+#define JOB_WORKERS_AUTO U32_MAX // One worker per hardware thread besides the main thread
+
+typedef void (*PFN_job)(void* data);
+typedef void (*PFN_job_range)(u32 begin, u32 end, void* data);
+
+/**
+ * @brief Number of unfinished jobs tracking it. Zero means done, jobs can be scheduled to run after it.
+ */
+typedef struct job_counter {
+  std::atomic<i32> value;
+  job_counter(void) : value(0) {}
+} job_counter;
+
+typedef struct job_desc {
+  PFN_job function;
+  void* data;
+} job_desc;
+
+/**
+ * @param worker_count JOB_WORKERS_AUTO to size by the hardware, 0 runs every job on the main thread
+ */
+[[__nodiscard__]] bool job_system_initialize(u32 worker_count);
+void job_system_shutdown(void);
+
+/**
+ * @brief Runs jobs that were queued with job_run_on_main_thread(). Call once per frame from the main thread.
+ */
+void job_system_update_main_thread(void);
+
+void job_run(job_desc job, job_counter* counter);
+void job_run_after(job_desc job, job_counter* dependency, job_counter* counter);
+void job_run_on_main_thread(job_desc job, job_counter* counter);
+
+/**
+ * @brief Executes other jobs until counter reaches zero.
+ */
+void job_wait(job_counter* counter);
+
+/**
+ * @brief Splits [0, count) into batches of batch_size and blocks until all of them ran. The caller takes part.
+ */
+void job_parallel_for(u32 count, u32 batch_size, PFN_job_range function, void* data);
+
+/**
+ * @brief Workers plus the main thread.
+ */
+u32 job_thread_count(void);
+
+/**
+ * @brief JOB_MAIN_THREAD_INDEX on the main thread, 1..worker count on workers, U32_MAX on foreign threads.
+ */
+u32 job_thread_index(void);
+
+/**
+ * @brief Restarts the system with 1 up to one thread per hardware thread and logs the speedup of a fixed
+ * CPU-bound job_parallel_for() workload over a single thread. The caller's worker count is restored at the end.
+ */
+void job_run_benchmark(void);
+
+#endif
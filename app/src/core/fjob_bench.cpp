@@ -0,0 +1,84 @@
+#include "fjob.h"
+
+#include <raylib.h>
+#include <chrono>
+#include <thread>
+
+#include "core/fmemory.h"
+
+#define JOB_BENCH_ITEM_COUNT (64u * 1024u)
+#define JOB_BENCH_BATCH_SIZE 64
+#define JOB_BENCH_ITEM_ITERATIONS 512
+#define JOB_BENCH_RUNS 3
+
+static f64 elapsed_ms(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Dependent integer and float chains per item, nothing shared between items but the output slot
+static void burn_range(u32 begin, u32 end, void* data) {
+  u32* out = (u32*)data;
+  for (u32 i = begin; i < end; ++i) {
+    u32 seed = i * 0x9e3779b9u + 1u;
+    f32 value = 1.f;
+    for (u32 k = 0; k < JOB_BENCH_ITEM_ITERATIONS; ++k) {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+      value = value * 0.999f + (f32)(seed & 0xffffu) * (1.f / 65536.f);
+    }
+    out[i] = seed ^ (u32)value;
+  }
+}
+
+static u64 checksum(const u32* values) {
+  u64 sum = 0;
+  for (u32 i = 0; i < JOB_BENCH_ITEM_COUNT; ++i) {
+    sum = sum * 31u + values[i];
+  }
+  return sum;
+}
+
+void job_run_benchmark(void) {
+  // The system is brought up again with every worker count, the caller's is restored at the end.
+  // One thread is the main thread alone, which runs every batch itself
+  const bool was_running = job_thread_index() == JOB_MAIN_THREAD_INDEX;
+  const u32 previous_threads = job_thread_count();
+  const u32 hardware_threads = FMAX(std::thread::hardware_concurrency(), 1u);
+  const u32 max_threads = FMIN(hardware_threads, (u32)JOB_MAX_WORKER_COUNT + 1);
+  u32* out = (u32*)allocate_memory(sizeof(u32) * JOB_BENCH_ITEM_COUNT, true, MEMORY_TAG_JOB);
+
+  TRACELOG(LOG_INFO, "JOB: Scaling of job_parallel_for(), %u items of %u iterations in batches of %u, best of %u", JOB_BENCH_ITEM_COUNT,
+    JOB_BENCH_ITEM_ITERATIONS, JOB_BENCH_BATCH_SIZE, JOB_BENCH_RUNS);
+  f64 single_ms = 0.0;
+  u64 reference = 0;
+  for (u32 threads = 1; threads <= max_threads; ++threads) {
+    job_system_shutdown();
+    if (not job_system_initialize(threads - 1)) {
+      TRACELOG(LOG_ERROR, "JOB: Benchmark can not start %u workers", threads - 1);
+      break;
+    }
+    f64 best_ms = 0.0;
+    for (u32 run = 0; run < JOB_BENCH_RUNS; ++run) {
+      const auto start = std::chrono::steady_clock::now();
+      job_parallel_for(JOB_BENCH_ITEM_COUNT, JOB_BENCH_BATCH_SIZE, burn_range, out);
+      const f64 ms = elapsed_ms(start);
+      best_ms = (run == 0 or ms < best_ms) ? ms : best_ms;
+    }
+    const u64 sum = checksum(out);
+    if (threads == 1) {
+      single_ms = best_ms;
+      reference = sum;
+    } else if (sum != reference) {
+      TRACELOG(LOG_ERROR, "JOB: %u threads wrote other results than one", threads);
+    }
+    const f64 speedup = (best_ms > 0.0) ? single_ms / best_ms : 0.0;
+    TRACELOG(LOG_INFO, "JOB:   %2u threads %8.2f ms, %.2fx speedup, %3.0f%% efficiency", threads, best_ms, speedup, speedup * 100.0 / threads);
+  }
+  free_memory(out);
+
+  job_system_shutdown();
+  if (was_running and not job_system_initialize(previous_threads - 1)) {
+    TRACELOG(LOG_ERROR, "JOB: Benchmark can not restore %u workers", previous_threads - 1);
+  }
+}
@@ -3,6 +3,8 @@
 
 #include "raymath.h"
 
+#include "core/fsimd.h"
+
 Vector2 get_a_point_of_a_circle(Vector2 position, i16 radius, i16 angle) {
   return {
     position.x + (radius * cos(angle * 3.1415f / 180.f)),
@@ -43,3 +45,234 @@ float get_movement_rotation(Vector2 from, Vector2 to) {
 }
 Vector2 vec2_zero(void) { return Vector2 { 0.f, 0.f }; }
 
+
+frustum frustum_from_camera(Camera3D camera, f32 aspect, f32 near_plane, f32 far_plane) {
+  Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+  Matrix proj = MatrixPerspective(camera.fovy * DEG2RAD, aspect, near_plane, far_plane);
+  Matrix m = MatrixMultiply(view, proj);
+
+  frustum fr = {};
+  fr.planes[0] = Vector4 { m.m3 + m.m0, m.m7 + m.m4, m.m11 + m.m8,  m.m15 + m.m12 }; // Left
+  fr.planes[1] = Vector4 { m.m3 - m.m0, m.m7 - m.m4, m.m11 - m.m8,  m.m15 - m.m12 }; // Right
+  fr.planes[2] = Vector4 { m.m3 + m.m1, m.m7 + m.m5, m.m11 + m.m9,  m.m15 + m.m13 }; // Bottom
+  fr.planes[3] = Vector4 { m.m3 - m.m1, m.m7 - m.m5, m.m11 - m.m9,  m.m15 - m.m13 }; // Top
+  fr.planes[4] = Vector4 { m.m3 + m.m2, m.m7 + m.m6, m.m11 + m.m10, m.m15 + m.m14 }; // Near
+  fr.planes[5] = Vector4 { m.m3 - m.m2, m.m7 - m.m6, m.m11 - m.m10, m.m15 - m.m14 }; // Far
+
+  for (Vector4& p : fr.planes) {
+    f32 len = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+    if (len > 0.f) {
+      p = Vector4 { p.x / len, p.y / len, p.z / len, p.w / len };
+    }
+  }
+  return fr;
+}
+bool frustum_intersects_aabb(const frustum* fr, Vector3 min, Vector3 max) {
+  for (const Vector4& p : fr->planes) {
+    // Test the box corner furthest along the plane normal
+    Vector3 v = Vector3 {
+      (p.x >= 0.f) ? max.x : min.x,
+      (p.y >= 0.f) ? max.y : min.y,
+      (p.z >= 0.f) ? max.z : min.z,
+    };
+    if (p.x * v.x + p.y * v.y + p.z * v.z + p.w < 0.f) {
+      return false;
+    }
+  }
+  return true;
+}
+f32 aabb_distance_sqr(Vector3 min, Vector3 max, Vector3 point) {
+  f32 dx = fmaxf(fmaxf(min.x - point.x, 0.f), point.x - max.x);
+  f32 dy = fmaxf(fmaxf(min.y - point.y, 0.f), point.y - max.y);
+  f32 dz = fmaxf(fmaxf(min.z - point.z, 0.f), point.z - max.z);
+  return dx * dx + dy * dy + dz * dz;
+}
+
+/**
+ * @brief Feeds IN input streams through `kernel` one register at a time and stores OUT streams. The tail is copied into
+ * zero padded registers, so every element goes through exactly the same operations.
+ */
+template <u32 IN, u32 OUT, typename KERNEL>
+static void batch_run(f32* const (&streams_in)[IN], f32* const (&streams_out)[OUT], u32 count, KERNEL kernel) {
+  // Local copies, the stores below could alias the caller's arrays and force a reload every iteration
+  f32* in[IN];
+  f32* out[OUT];
+  for (u32 s = 0; s < IN; ++s) in[s] = streams_in[s];
+  for (u32 s = 0; s < OUT; ++s) out[s] = streams_out[s];
+  simd_f32 lanes_in[IN];
+  simd_f32 lanes_out[OUT];
+  const u32 full = count - count % SIMD_LANE_COUNT;
+  for (u32 i = 0; i < full; i += SIMD_LANE_COUNT) {
+    SIMD_UNROLL
+    for (u32 s = 0; s < IN; ++s) lanes_in[s] = simd_load(in[s] + i);
+    kernel(lanes_in, lanes_out);
+    SIMD_UNROLL
+    for (u32 s = 0; s < OUT; ++s) simd_store(out[s] + i, lanes_out[s]);
+  }
+  if (full == count) {
+    return;
+  }
+  const u32 tail = count - full;
+  alignas(32) f32 padded[SIMD_LANE_COUNT] = {};
+  for (u32 s = 0; s < IN; ++s) {
+    for (u32 j = 0; j < tail; ++j) padded[j] = in[s][full + j];
+    lanes_in[s] = simd_load(padded);
+  }
+  kernel(lanes_in, lanes_out);
+  for (u32 s = 0; s < OUT; ++s) {
+    simd_store(padded, lanes_out[s]);
+    for (u32 j = 0; j < tail; ++j) out[s][full + j] = padded[j];
+  }
+}
+
+void vec3_batch_transform(const Matrix* mat, vec3_soa in, vec3_soa out, u32 count) {
+  const simd_f32 m0 = simd_set1(mat->m0), m4 = simd_set1(mat->m4), m8 = simd_set1(mat->m8), m12 = simd_set1(mat->m12);
+  const simd_f32 m1 = simd_set1(mat->m1), m5 = simd_set1(mat->m5), m9 = simd_set1(mat->m9), m13 = simd_set1(mat->m13);
+  const simd_f32 m2 = simd_set1(mat->m2), m6 = simd_set1(mat->m6), m10 = simd_set1(mat->m10), m14 = simd_set1(mat->m14);
+  f32* const streams_in[3] = { in.x, in.y, in.z };
+  f32* const streams_out[3] = { out.x, out.y, out.z };
+  batch_run(streams_in, streams_out, count, [&](const simd_f32* v, simd_f32* r) {
+    r[0] = simd_add(simd_add(simd_add(simd_mul(m0, v[0]), simd_mul(m4, v[1])), simd_mul(m8, v[2])), m12);
+    r[1] = simd_add(simd_add(simd_add(simd_mul(m1, v[0]), simd_mul(m5, v[1])), simd_mul(m9, v[2])), m13);
+    r[2] = simd_add(simd_add(simd_add(simd_mul(m2, v[0]), simd_mul(m6, v[1])), simd_mul(m10, v[2])), m14);
+  });
+}
+void vec4_batch_transform(const Matrix* mat, vec4_soa in, vec4_soa out, u32 count) {
+  const f32 e[16] = {
+    mat->m0, mat->m1, mat->m2, mat->m3, mat->m4, mat->m5, mat->m6, mat->m7,
+    mat->m8, mat->m9, mat->m10, mat->m11, mat->m12, mat->m13, mat->m14, mat->m15,
+  };
+  simd_f32 m[16];
+  for (u32 i = 0; i < 16; ++i) m[i] = simd_set1(e[i]);
+  f32* const streams_in[4] = { in.x, in.y, in.z, in.w };
+  f32* const streams_out[4] = { out.x, out.y, out.z, out.w };
+  batch_run(streams_in, streams_out, count, [&](const simd_f32* v, simd_f32* r) {
+    SIMD_UNROLL
+    for (u32 row = 0; row < 4; ++row) {
+      r[row] = simd_add(simd_add(simd_add(
+        simd_mul(m[row], v[0]), simd_mul(m[row + 4], v[1])), simd_mul(m[row + 8], v[2])), simd_mul(m[row + 12], v[3]));
+    }
+  });
+}
+void vec2_batch_distance(vec2_soa in, Vector2 point, f32* out, u32 count) {
+  const simd_f32 px = simd_set1(point.x), py = simd_set1(point.y);
+  f32* const streams_in[2] = { in.x, in.y };
+  f32* const streams_out[1] = { out };
+  batch_run(streams_in, streams_out, count, [&](const simd_f32* v, simd_f32* r) {
+    const simd_f32 dx = simd_sub(v[0], px), dy = simd_sub(v[1], py);
+    r[0] = simd_sqrt(simd_add(simd_mul(dx, dx), simd_mul(dy, dy)));
+  });
+}
+void vec3_batch_distance(vec3_soa in, Vector3 point, f32* out, u32 count) {
+  const simd_f32 px = simd_set1(point.x), py = simd_set1(point.y), pz = simd_set1(point.z);
+  f32* const streams_in[3] = { in.x, in.y, in.z };
+  f32* const streams_out[1] = { out };
+  batch_run(streams_in, streams_out, count, [&](const simd_f32* v, simd_f32* r) {
+    const simd_f32 dx = simd_sub(px, v[0]), dy = simd_sub(py, v[1]), dz = simd_sub(pz, v[2]);
+    r[0] = simd_sqrt(simd_add(simd_add(simd_mul(dx, dx), simd_mul(dy, dy)), simd_mul(dz, dz)));
+  });
+}
+void vec3_batch_normalize(vec3_soa in, vec3_soa out, u32 count) {
+  const simd_f32 zero = simd_set1(0.f), one = simd_set1(1.f);
+  f32* const streams_in[3] = { in.x, in.y, in.z };
+  f32* const streams_out[3] = { out.x, out.y, out.z };
+  batch_run(streams_in, streams_out, count, [&](const simd_f32* v, simd_f32* r) {
+    const simd_f32 length = simd_sqrt(simd_add(simd_add(simd_mul(v[0], v[0]), simd_mul(v[1], v[1])), simd_mul(v[2], v[2])));
+    const simd_f32 non_zero = simd_less(zero, length);
+    // Zero lengths divide by one instead, then keep the input
+    const simd_f32 inverse = simd_div(one, simd_select(non_zero, length, one));
+    SIMD_UNROLL
+    for (u32 c = 0; c < 3; ++c) {
+      r[c] = simd_select(non_zero, simd_mul(v[c], inverse), v[c]);
+    }
+  });
+}
+void vec3_batch_lerp(vec3_soa a, vec3_soa b, f32 t, vec3_soa out, u32 count) {
+  const simd_f32 amount = simd_set1(t);
+  f32* const streams_in[6] = { a.x, a.y, a.z, b.x, b.y, b.z };
+  f32* const streams_out[3] = { out.x, out.y, out.z };
+  batch_run(streams_in, streams_out, count, [&](const simd_f32* v, simd_f32* r) {
+    SIMD_UNROLL
+    for (u32 c = 0; c < 3; ++c) {
+      r[c] = simd_lerp(v[c], v[c + 3], amount);
+    }
+  });
+}
+void mat4_batch_multiply(mat4_soa a, mat4_soa b, mat4_soa out, u32 count) {
+  f32* streams_in[32];
+  for (u32 i = 0; i < 16; ++i) {
+    streams_in[i] = a.m[i];
+    streams_in[i + 16] = b.m[i];
+  }
+  batch_run(streams_in, out.m, count, [](const simd_f32* v, simd_f32* r) {
+    const simd_f32* l = v;
+    const simd_f32* rt = v + 16;
+    SIMD_UNROLL
+    for (u32 i = 0; i < 4; ++i) {
+      SIMD_UNROLL
+      for (u32 j = 0; j < 4; ++j) {
+        r[i * 4 + j] = simd_add(simd_add(simd_add(
+          simd_mul(l[i * 4], rt[j]), simd_mul(l[i * 4 + 1], rt[4 + j])), simd_mul(l[i * 4 + 2], rt[8 + j])), simd_mul(l[i * 4 + 3], rt[12 + j]));
+      }
+    }
+  });
+}
+u32 frustum_batch_intersects_aabb(const frustum* fr, vec3_soa min, vec3_soa max, u8* visible, u32 count) {
+  // The corner furthest along each normal is picked per plane, not per box
+  simd_f32 plane[6][4];
+  f32* corner[6][3];
+  for (u32 p = 0; p < 6; ++p) {
+    const Vector4& pl = fr->planes[p];
+    plane[p][0] = simd_set1(pl.x);
+    plane[p][1] = simd_set1(pl.y);
+    plane[p][2] = simd_set1(pl.z);
+    plane[p][3] = simd_set1(pl.w);
+    corner[p][0] = (pl.x >= 0.f) ? max.x : min.x;
+    corner[p][1] = (pl.y >= 0.f) ? max.y : min.y;
+    corner[p][2] = (pl.z >= 0.f) ? max.z : min.z;
+  }
+  const simd_f32 zero = simd_set1(0.f);
+  u32 visible_count = 0;
+  for (u32 i = 0; i < count; i += SIMD_LANE_COUNT) {
+    const u32 lanes = (count - i < SIMD_LANE_COUNT) ? count - i : SIMD_LANE_COUNT;
+    simd_f32 culled = simd_less(zero, zero);
+    SIMD_UNROLL
+    for (u32 p = 0; p < 6; ++p) {
+      simd_f32 v[3];
+      SIMD_UNROLL
+      for (u32 c = 0; c < 3; ++c) {
+        if (lanes == SIMD_LANE_COUNT) {
+          v[c] = simd_load(corner[p][c] + i);
+        }
+        else {
+          alignas(32) f32 padded[SIMD_LANE_COUNT] = {};
+          for (u32 j = 0; j < lanes; ++j) padded[j] = corner[p][c][i + j];
+          v[c] = simd_load(padded);
+        }
+      }
+      const simd_f32 d = simd_add(simd_add(simd_add(
+        simd_mul(plane[p][0], v[0]), simd_mul(plane[p][1], v[1])), simd_mul(plane[p][2], v[2])), plane[p][3]);
+      culled = simd_or(culled, simd_less(d, zero));
+    }
+    const u32 bits = simd_mask_bits(culled);
+    for (u32 j = 0; j < lanes; ++j) {
+      visible[i + j] = ((bits >> j) & 1u) ? 0 : 1;
+      visible_count += visible[i + j];
+    }
+  }
+  return visible_count;
+}
+void aabb_batch_distance_sqr(vec3_soa min, vec3_soa max, Vector3 point, f32* out, u32 count) {
+  const simd_f32 p[3] = { simd_set1(point.x), simd_set1(point.y), simd_set1(point.z) };
+  const simd_f32 zero = simd_set1(0.f);
+  f32* const streams_in[6] = { min.x, min.y, min.z, max.x, max.y, max.z };
+  f32* const streams_out[1] = { out };
+  batch_run(streams_in, streams_out, count, [&](const simd_f32* v, simd_f32* r) {
+    simd_f32 d[3];
+    SIMD_UNROLL
+    for (u32 c = 0; c < 3; ++c) {
+      d[c] = simd_max(simd_max(simd_sub(v[c], p[c]), zero), simd_sub(p[c], v[c + 3]));
+    }
+    r[0] = simd_add(simd_add(simd_mul(d[0], d[0]), simd_mul(d[1], d[1])), simd_mul(d[2], d[2]));
+  });
+}
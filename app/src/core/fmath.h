@@ -18,4 +18,76 @@ float vec2_distance(Vector2 v1, Vector2 v2);
 float vec2_lenght(Vector2 v1);
 float get_movement_rotation(Vector2 from, Vector2 to);
 
+/**
+ * @brief Planes are stored as (normal.xyz, distance) and point inwards.
+ */
+typedef struct frustum {
+  Vector4 planes[6];
+} frustum;
+
+frustum frustum_from_camera(Camera3D camera, f32 aspect, f32 near_plane, f32 far_plane);
+bool frustum_intersects_aabb(const frustum* fr, Vector3 min, Vector3 max);
+f32 aabb_distance_sqr(Vector3 min, Vector3 max, Vector3 point);
+
+/**
+ * @brief Structure of arrays views for the batch functions below. Each stream holds `count` floats, streams of
+ * one view must not overlap, but `out` may alias `in` element for element. Lanes are picked by fsimd at compile time
+ * and the tail is copied into a zeroed register and run as one more full vector, with only its own lanes stored back.
+ * Every element goes through the same operations, so results don't depend on the backend or the count.
+ */
+typedef struct vec2_soa {
+  f32* x;
+  f32* y;
+} vec2_soa;
+
+typedef struct vec3_soa {
+  f32* x;
+  f32* y;
+  f32* z;
+} vec3_soa;
+
+typedef struct vec4_soa {
+  f32* x;
+  f32* y;
+  f32* z;
+  f32* w;
+} vec4_soa;
+
+/**
+ * @brief One stream per element, m[0] is Matrix::m0 and so on in raymath's column major order.
+ */
+typedef struct mat4_soa {
+  f32* m[16];
+} mat4_soa;
+
+/**
+ * @brief Same as Vector3Transform, points with an implicit w of 1.
+ */
+void vec3_batch_transform(const Matrix* mat, vec3_soa in, vec3_soa out, u32 count);
+void vec4_batch_transform(const Matrix* mat, vec4_soa in, vec4_soa out, u32 count);
+void vec2_batch_distance(vec2_soa in, Vector2 point, f32* out, u32 count);
+void vec3_batch_distance(vec3_soa in, Vector3 point, f32* out, u32 count);
+
+/**
+ * @brief Same as Vector3Normalize, zero length vectors are left untouched.
+ */
+void vec3_batch_normalize(vec3_soa in, vec3_soa out, u32 count);
+void vec3_batch_lerp(vec3_soa a, vec3_soa b, f32 t, vec3_soa out, u32 count);
+
+/**
+ * @brief out = a * b for every element, same convention as MatrixMultiply.
+ */
+void mat4_batch_multiply(mat4_soa a, mat4_soa b, mat4_soa out, u32 count);
+
+/**
+ * @brief Writes 1 for boxes frustum_intersects_aabb() keeps and 0 for culled ones, returns the visible count.
+ */
+u32 frustum_batch_intersects_aabb(const frustum* fr, vec3_soa min, vec3_soa max, u8* visible, u32 count);
+void aabb_batch_distance_sqr(vec3_soa min, vec3_soa max, Vector3 point, f32* out, u32 count);
+
+/**
+ * @brief Compares every batch function against the scalar raymath loop, logs the speedup and the largest difference.
+ */
+void math_run_benchmark(void);
+
 #endif
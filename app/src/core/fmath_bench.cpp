@@ -0,0 +1,224 @@
+#include "fmath.h"
+
+#include <raylib.h>
+#include <atomic>
+#include <chrono>
+#include <math.h>
+
+#include "raymath.h"
+
+#include "core/fmemory.h"
+#include "core/frandom.h"
+#include "core/fsimd.h"
+
+#define MATH_BENCH_COUNT 65536u
+#define MATH_BENCH_REPEAT 64u
+// Soa streams of MATH_BENCH_COUNT floats, reused as inputs and outputs by every case
+#define MATH_BENCH_STREAM_COUNT 48u
+// Streams start a cache line apart, power of two strides would map every stream onto the same cache sets
+#define MATH_BENCH_STREAM_STAGGER 16u
+
+typedef struct math_bench_data {
+  f32* streams[MATH_BENCH_STREAM_COUNT];
+  f32* stream_blocks[MATH_BENCH_STREAM_COUNT];
+  Vector3* a3;
+  Vector3* b3;
+  Vector3* r3;
+  Vector4* a4;
+  Vector4* r4;
+  Matrix* am;
+  Matrix* bm;
+  Matrix* rm;
+  f32* scalar_out;
+  u8* visible;
+  u8* scalar_visible;
+  u32 sink;
+} math_bench_data;
+
+template <typename FN>
+static f64 ns_per_element(FN fn) {
+  const auto start = std::chrono::steady_clock::now();
+  for (u32 r = 0; r < MATH_BENCH_REPEAT; ++r) {
+    fn();
+    // Keeps repeats from being merged into one pass
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+  }
+  const f64 ns = std::chrono::duration<f64, std::nano>(std::chrono::steady_clock::now() - start).count();
+  return ns / ((f64)MATH_BENCH_REPEAT * MATH_BENCH_COUNT);
+}
+
+static void report(const char* name, f64 scalar_ns, f64 batch_ns, f64 max_error) {
+  TRACELOG(LOG_INFO, "MATH: %-22s raymath %6.2f ns, batch %6.2f ns, %5.2fx, max difference %g",
+    name, scalar_ns, batch_ns, scalar_ns / batch_ns, max_error);
+}
+
+static f64 max_difference(const f32* batch, const f32* scalar, u32 stride) {
+  f64 error = 0.0;
+  for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) {
+    error = fmax(error, fabs((f64)batch[i] - (f64)scalar[i * stride]));
+  }
+  return error;
+}
+
+static vec3_soa soa3(math_bench_data* d, u32 first) {
+  return vec3_soa { d->streams[first], d->streams[first + 1], d->streams[first + 2] };
+}
+
+static void run_vector_cases(math_bench_data* d) {
+  const vec3_soa a = soa3(d, 0), b = soa3(d, 3), out = soa3(d, 8);
+  const Matrix mat = MatrixMultiply(MatrixRotateXYZ(Vector3 { 0.3f, 1.1f, -0.7f }), MatrixTranslate(4.f, -2.f, 9.f));
+  const Vector3 point = Vector3 { 12.f, -3.f, 40.f };
+
+  f64 scalar = ns_per_element([&] { for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) d->r3[i] = Vector3Transform(d->a3[i], mat); });
+  f64 batch = ns_per_element([&] { vec3_batch_transform(&mat, a, out, MATH_BENCH_COUNT); });
+  report("vec3_batch_transform", scalar, batch, max_difference(out.y, &d->r3[0].y, 3));
+
+  scalar = ns_per_element([&] {
+    for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) {
+      const Vector4 v = d->a4[i];
+      d->r4[i] = Vector4 {
+        mat.m0 * v.x + mat.m4 * v.y + mat.m8 * v.z + mat.m12 * v.w,
+        mat.m1 * v.x + mat.m5 * v.y + mat.m9 * v.z + mat.m13 * v.w,
+        mat.m2 * v.x + mat.m6 * v.y + mat.m10 * v.z + mat.m14 * v.w,
+        mat.m3 * v.x + mat.m7 * v.y + mat.m11 * v.z + mat.m15 * v.w,
+      };
+    }
+  });
+  const vec4_soa a4 = vec4_soa { d->streams[0], d->streams[1], d->streams[2], d->streams[6] };
+  const vec4_soa out4 = vec4_soa { d->streams[8], d->streams[9], d->streams[10], d->streams[11] };
+  batch = ns_per_element([&] { vec4_batch_transform(&mat, a4, out4, MATH_BENCH_COUNT); });
+  report("vec4_batch_transform", scalar, batch, max_difference(out4.w, &d->r4[0].w, 4));
+
+  scalar = ns_per_element([&] {
+    for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) d->scalar_out[i] = Vector2Distance(Vector2 { d->a3[i].x, d->a3[i].y }, Vector2 { point.x, point.y });
+  });
+  batch = ns_per_element([&] { vec2_batch_distance(vec2_soa { a.x, a.y }, Vector2 { point.x, point.y }, out.x, MATH_BENCH_COUNT); });
+  report("vec2_batch_distance", scalar, batch, max_difference(out.x, d->scalar_out, 1));
+
+  scalar = ns_per_element([&] { for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) d->scalar_out[i] = Vector3Distance(d->a3[i], point); });
+  batch = ns_per_element([&] { vec3_batch_distance(a, point, out.x, MATH_BENCH_COUNT); });
+  report("vec3_batch_distance", scalar, batch, max_difference(out.x, d->scalar_out, 1));
+
+  scalar = ns_per_element([&] { for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) d->r3[i] = Vector3Normalize(d->a3[i]); });
+  batch = ns_per_element([&] { vec3_batch_normalize(a, out, MATH_BENCH_COUNT); });
+  report("vec3_batch_normalize", scalar, batch, max_difference(out.z, &d->r3[0].z, 3));
+
+  scalar = ns_per_element([&] { for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) d->r3[i] = Vector3Lerp(d->a3[i], d->b3[i], 0.35f); });
+  batch = ns_per_element([&] { vec3_batch_lerp(a, b, 0.35f, out, MATH_BENCH_COUNT); });
+  report("vec3_batch_lerp", scalar, batch, max_difference(out.x, &d->r3[0].x, 3));
+
+  scalar = ns_per_element([&] {
+    for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) d->scalar_out[i] = aabb_distance_sqr(d->a3[i], d->b3[i], point);
+  });
+  batch = ns_per_element([&] { aabb_batch_distance_sqr(a, b, point, out.x, MATH_BENCH_COUNT); });
+  report("aabb_batch_distance_sqr", scalar, batch, max_difference(out.x, d->scalar_out, 1));
+
+  Camera3D camera = {};
+  camera.position = Vector3 { 0.f, 0.f, 0.f };
+  camera.target = Vector3 { 0.f, 0.f, 1.f };
+  camera.up = Vector3 { 0.f, 1.f, 0.f };
+  camera.fovy = 60.f;
+  const frustum fr = frustum_from_camera(camera, 16.f / 9.f, 0.1f, 60.f);
+  u32 scalar_visible = 0, batch_visible = 0;
+  scalar = ns_per_element([&] {
+    scalar_visible = 0;
+    for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) {
+      d->scalar_visible[i] = frustum_intersects_aabb(&fr, d->a3[i], d->b3[i]) ? 1 : 0;
+      scalar_visible += d->scalar_visible[i];
+    }
+  });
+  batch = ns_per_element([&] { batch_visible = frustum_batch_intersects_aabb(&fr, a, b, d->visible, MATH_BENCH_COUNT); });
+  u32 mismatches = 0;
+  for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) {
+    mismatches += (d->visible[i] != d->scalar_visible[i]) ? 1 : 0;
+  }
+  report("frustum_batch_aabb", scalar, batch, (f64)mismatches);
+  d->sink += scalar_visible ^ batch_visible;
+}
+
+static void run_matrix_case(math_bench_data* d) {
+  mat4_soa a, b, out;
+  for (u32 i = 0; i < 16; ++i) {
+    a.m[i] = d->streams[i];
+    b.m[i] = d->streams[16 + i];
+    out.m[i] = d->streams[32 + i];
+  }
+  const f64 scalar = ns_per_element([&] { for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) d->rm[i] = MatrixMultiply(d->am[i], d->bm[i]); });
+  const f64 batch = ns_per_element([&] { mat4_batch_multiply(a, b, out, MATH_BENCH_COUNT); });
+  f64 error = 0.0;
+  for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) {
+    const float16 expected = MatrixToFloatV(d->rm[i]);
+    for (u32 e = 0; e < 16; ++e) {
+      error = fmax(error, fabs((f64)out.m[e][i] - (f64)expected.v[e]));
+    }
+  }
+  report("mat4_batch_multiply", scalar, batch, error);
+}
+
+void math_run_benchmark(void) {
+  math_bench_data d = {};
+  for (u32 s = 0; s < MATH_BENCH_STREAM_COUNT; ++s) {
+    d.stream_blocks[s] = (f32*)allocate_memory((MATH_BENCH_COUNT + s * MATH_BENCH_STREAM_STAGGER) * sizeof(f32), true, MEMORY_TAG_CORE);
+    d.streams[s] = d.stream_blocks[s] + s * MATH_BENCH_STREAM_STAGGER;
+  }
+  d.a3 = (Vector3*)allocate_memory(MATH_BENCH_COUNT * sizeof(Vector3), true, MEMORY_TAG_CORE);
+  d.b3 = (Vector3*)allocate_memory(MATH_BENCH_COUNT * sizeof(Vector3), true, MEMORY_TAG_CORE);
+  d.r3 = (Vector3*)allocate_memory(MATH_BENCH_COUNT * sizeof(Vector3), true, MEMORY_TAG_CORE);
+  d.a4 = (Vector4*)allocate_memory(MATH_BENCH_COUNT * sizeof(Vector4), true, MEMORY_TAG_CORE);
+  d.r4 = (Vector4*)allocate_memory(MATH_BENCH_COUNT * sizeof(Vector4), true, MEMORY_TAG_CORE);
+  d.am = (Matrix*)allocate_memory(MATH_BENCH_COUNT * sizeof(Matrix), true, MEMORY_TAG_CORE);
+  d.bm = (Matrix*)allocate_memory(MATH_BENCH_COUNT * sizeof(Matrix), true, MEMORY_TAG_CORE);
+  d.rm = (Matrix*)allocate_memory(MATH_BENCH_COUNT * sizeof(Matrix), true, MEMORY_TAG_CORE);
+  d.scalar_out = (f32*)allocate_memory(MATH_BENCH_COUNT * sizeof(f32), true, MEMORY_TAG_CORE);
+  d.visible = (u8*)allocate_memory(MATH_BENCH_COUNT, true, MEMORY_TAG_CORE);
+  d.scalar_visible = (u8*)allocate_memory(MATH_BENCH_COUNT, true, MEMORY_TAG_CORE);
+
+  // Same values in both layouts, boxes are min in a3 and min + extent in b3
+  random_bulk_state rng;
+  random_bulk_seed(&rng, 12);
+  for (u32 s = 0; s < 3; ++s) {
+    random_fill_f32(&rng, d.streams[s], MATH_BENCH_COUNT, -50.f, 50.f);
+    random_fill_f32(&rng, d.streams[3 + s], MATH_BENCH_COUNT, 0.5f, 8.f);
+  }
+  random_fill_f32(&rng, d.streams[6], MATH_BENCH_COUNT, 0.f, 1.f);
+  for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) {
+    if (i % 64 == 0) {
+      d.streams[0][i] = d.streams[1][i] = d.streams[2][i] = 0.f; // Zero vectors for normalize
+    }
+    for (u32 s = 0; s < 3; ++s) d.streams[3 + s][i] += d.streams[s][i];
+    d.a3[i] = Vector3 { d.streams[0][i], d.streams[1][i], d.streams[2][i] };
+    d.b3[i] = Vector3 { d.streams[3][i], d.streams[4][i], d.streams[5][i] };
+    d.a4[i] = Vector4 { d.a3[i].x, d.a3[i].y, d.a3[i].z, d.streams[6][i] };
+  }
+  run_vector_cases(&d);
+
+  for (u32 s = 0; s < 32; ++s) {
+    random_fill_f32(&rng, d.streams[s], MATH_BENCH_COUNT, -2.f, 2.f);
+  }
+  for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) {
+    float16 a, b;
+    for (u32 e = 0; e < 16; ++e) {
+      a.v[e] = d.streams[e][i];
+      b.v[e] = d.streams[16 + e][i];
+    }
+    d.am[i] = Matrix { a.v[0], a.v[4], a.v[8], a.v[12], a.v[1], a.v[5], a.v[9], a.v[13], a.v[2], a.v[6], a.v[10], a.v[14], a.v[3], a.v[7], a.v[11], a.v[15] };
+    d.bm[i] = Matrix { b.v[0], b.v[4], b.v[8], b.v[12], b.v[1], b.v[5], b.v[9], b.v[13], b.v[2], b.v[6], b.v[10], b.v[14], b.v[3], b.v[7], b.v[11], b.v[15] };
+  }
+  run_matrix_case(&d);
+  TRACELOG(LOG_INFO, "MATH: %u elements x %u repeats, %d simd lanes (sink %u)", MATH_BENCH_COUNT, MATH_BENCH_REPEAT, SIMD_LANE_COUNT, d.sink);
+
+  free_memory(d.scalar_visible);
+  free_memory(d.visible);
+  free_memory(d.scalar_out);
+  free_memory(d.rm);
+  free_memory(d.bm);
+  free_memory(d.am);
+  free_memory(d.r4);
+  free_memory(d.a4);
+  free_memory(d.r3);
+  free_memory(d.b3);
+  free_memory(d.a3);
+  for (u32 s = 0; s < MATH_BENCH_STREAM_COUNT; ++s) {
+    free_memory(d.stream_blocks[s]);
+  }
+}
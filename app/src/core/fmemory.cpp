@@ -1,16 +1,77 @@
 #include "fmemory.h"
 
+#include <stdio.h>  // Required for: fprintf()
 #include <stdlib.h> // Required for: malloc(), free()
 #include <string.h> // Required for: memset(), memcpy()
+#include <raylib.h>
+#include <atomic>
+
+#define FRAME_ARENA_COUNT 2
 
 typedef struct memory_system_state {
     u64 linear_memory_total_size;
     u64 linear_memory_allocated;
     void *linear_memory;
+    memory_arena frame_arenas[FRAME_ARENA_COUNT];
+    u32 frame_index;
   } memory_system_state;
 
 static memory_system_state* memory_system;
 
+#if MEMORY_TRACKING_ENABLED
+  typedef struct memory_tag_counters {
+    std::atomic<u64> current_bytes;
+    std::atomic<u64> peak_bytes;
+    std::atomic<u64> allocation_count;
+    std::atomic<u64> live_count;
+  } memory_tag_counters;
+
+  /**
+   * @brief Prefix of every tracked heap block, keeps the returned pointer 16 byte aligned.
+   */
+  typedef struct memory_allocation_header {
+    u64 size;
+    u64 tag;
+  } memory_allocation_header;
+  static_assert(sizeof(memory_allocation_header) == MEMORY_DEFAULT_ALIGNMENT);
+
+  // Static so allocations made before memory_system_initialize() are counted too
+  static memory_tag_counters tag_counters[MEMORY_TAG_MAX];
+
+  static void track_allocation(memory_tag tag, u64 size) {
+    memory_tag_counters& counters = tag_counters[tag];
+    const u64 current = counters.current_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    u64 peak = counters.peak_bytes.load(std::memory_order_relaxed);
+    while (current > peak and not counters.peak_bytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {}
+    counters.allocation_count.fetch_add(1, std::memory_order_relaxed);
+    counters.live_count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static void track_free(memory_tag tag, u64 size) {
+    tag_counters[tag].current_bytes.fetch_sub(size, std::memory_order_relaxed);
+    tag_counters[tag].live_count.fetch_sub(1, std::memory_order_relaxed);
+  }
+#endif
+
+/**
+ * @brief Frees the heap block behind the scratch arena when its thread exits.
+ */
+typedef struct scratch_arena_holder {
+  memory_arena arena;
+  ~scratch_arena_holder(void) { if (arena.base) free_memory(arena.base); }
+} scratch_arena_holder;
+
+static thread_local scratch_arena_holder scratch_arena = {};
+
+static inline u64 align_up(u64 value, u64 alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+[[noreturn]] static void memory_overflow(const char* name, u64 requested, u64 used, u64 capacity) {
+  fprintf(stderr, "[MEMORY] %s overflow: requested %llu bytes, %llu of %llu in use\n", name, requested, used, capacity);
+  exit(EXIT_FAILURE);
+}
+
 void memory_system_initialize(void) {
     memory_system = (memory_system_state*)malloc(sizeof(memory_system_state));
     memory_system->linear_memory_total_size = TOTAL_ALLOCATED_MEMORY;
@@ -18,33 +79,130 @@ void memory_system_initialize(void) {
     memory_system->linear_memory = 0;
 
     memory_system->linear_memory = malloc(memory_system->linear_memory_total_size);
+    if (memory_system->linear_memory == NULL) {
+      memory_overflow("linear", memory_system->linear_memory_total_size, 0, 0);
+    }
+
+    memory_system->frame_index = 0;
+    memory_arena_create(&memory_system->frame_arenas[0], "frame_0", FRAME_ARENA_SIZE, MEMORY_TAG_ARENA);
+    memory_arena_create(&memory_system->frame_arenas[1], "frame_1", FRAME_ARENA_SIZE, MEMORY_TAG_ARENA);
 }
 
-void* allocate_memory_linear(u64 size, bool will_zero_memory) {
+void memory_system_end_frame(void) {
+  memory_system->frame_index = (memory_system->frame_index + 1) % FRAME_ARENA_COUNT;
+  memory_arena_reset(&memory_system->frame_arenas[memory_system->frame_index]);
+}
+
+void* allocate_memory_linear(u64 size, bool will_zero_memory, memory_tag tag) {
     #ifdef _DEBUG
-      if (memory_system->linear_memory_allocated + size > memory_system->linear_memory_total_size) {
-        exit(EXIT_FAILURE);
-      }
       if (size % sizeof(size_t) != 0) {
         exit(EXIT_FAILURE);
       }
     #endif
+    // Running out of linear memory is a startup sizing bug, so release builds fail loudly too
+    if (memory_system->linear_memory_allocated + size > memory_system->linear_memory_total_size) {
+      memory_overflow("linear", size, memory_system->linear_memory_allocated, memory_system->linear_memory_total_size);
+    }
 
     void* block = ((u8*)memory_system->linear_memory) + memory_system->linear_memory_allocated;
     memory_system->linear_memory_allocated += size;
+    #if MEMORY_TRACKING_ENABLED
+      track_allocation(tag, size);
+    #else
+      (void)tag;
+    #endif
 
     if (will_zero_memory) memset(block, 0, size);
 
     return block;
 }
 
-void* allocate_memory(u64 size, bool will_zero_memory) {
-    void* block = malloc(size);
+void* allocate_memory_frame(u64 size, bool will_zero_memory) {
+  return allocate_memory_arena(&memory_system->frame_arenas[memory_system->frame_index], size, MEMORY_DEFAULT_ALIGNMENT, will_zero_memory);
+}
 
-    if (block == NULL) {
-        // TODO: 
-        exit(EXIT_FAILURE);
+void* allocate_memory_arena(memory_arena* arena, u64 size, u64 alignment, bool will_zero_memory) {
+  #ifdef _DEBUG
+    if (alignment == 0 or (alignment & (alignment - 1)) != 0) {
+      exit(EXIT_FAILURE);
     }
+  #endif
+  const u64 start = align_up((u64)(arena->base + arena->offset), alignment) - (u64)arena->base;
+  if (start + size > arena->size) {
+    #ifdef _DEBUG
+      memory_overflow(arena->name, size, arena->offset, arena->size);
+    #else
+      return nullptr;
+    #endif
+  }
+
+  void* block = arena->base + start;
+  arena->offset = start + size;
+  if (arena->offset > arena->peak) arena->peak = arena->offset;
+
+  if (will_zero_memory) memset(block, 0, size);
+
+  return block;
+}
+
+bool memory_arena_create(memory_arena* arena, const char* name, u64 size, memory_tag tag) {
+  if (not arena or arena == nullptr) {
+    return false;
+  }
+  arena->name = name;
+  arena->base = (u8*)allocate_memory_linear(align_up(size, sizeof(size_t)), false, tag);
+  arena->size = size;
+  arena->offset = 0;
+  arena->peak = 0;
+  return true;
+}
+
+arena_marker memory_arena_get_marker(memory_arena* arena) {
+  return arena_marker {arena, arena->offset};
+}
+
+void memory_arena_rollback(arena_marker marker) {
+  marker.arena->offset = marker.offset;
+}
+
+void memory_arena_reset(memory_arena* arena) {
+  arena->offset = 0;
+}
+
+memory_arena* memory_get_frame_arena(void) {
+  return &memory_system->frame_arenas[memory_system->frame_index];
+}
+
+memory_arena* memory_get_scratch_arena(void) {
+  memory_arena* arena = &scratch_arena.arena;
+  if (arena->base == nullptr) {
+    arena->name = "scratch";
+    arena->base = (u8*)allocate_memory(SCRATCH_ARENA_SIZE, false, MEMORY_TAG_ARENA);
+    arena->size = SCRATCH_ARENA_SIZE;
+    arena->offset = 0;
+    arena->peak = 0;
+  }
+  return arena;
+}
+
+void* allocate_memory(u64 size, bool will_zero_memory, memory_tag tag) {
+    #if MEMORY_TRACKING_ENABLED
+      memory_allocation_header* header = (memory_allocation_header*)malloc(sizeof(memory_allocation_header) + size);
+      if (header == NULL) {
+        exit(EXIT_FAILURE);
+      }
+      header->size = size;
+      header->tag = tag;
+      track_allocation(tag, size);
+      void* block = header + 1;
+    #else
+      (void)tag;
+      void* block = malloc(size);
+      if (block == NULL) {
+          // TODO: 
+          exit(EXIT_FAILURE);
+      }
+    #endif
 
     if (will_zero_memory) memset(block, 0, size);
 
@@ -52,7 +210,70 @@ void* allocate_memory(u64 size, bool will_zero_memory) {
 }
 
 void free_memory(void* block) {
-    free(block);
+    #if MEMORY_TRACKING_ENABLED
+      if (block == NULL) {
+        return;
+      }
+      memory_allocation_header* header = ((memory_allocation_header*)block) - 1;
+      track_free((memory_tag)header->tag, header->size);
+      free(header);
+    #else
+      free(block);
+    #endif
+}
+
+memory_tag_stats memory_get_tag_stats(memory_tag tag) {
+  memory_tag_stats stats = {};
+  #if MEMORY_TRACKING_ENABLED
+    if (tag < MEMORY_TAG_MAX) {
+      stats.current_bytes = tag_counters[tag].current_bytes.load(std::memory_order_relaxed);
+      stats.peak_bytes = tag_counters[tag].peak_bytes.load(std::memory_order_relaxed);
+      stats.allocation_count = tag_counters[tag].allocation_count.load(std::memory_order_relaxed);
+      stats.live_count = tag_counters[tag].live_count.load(std::memory_order_relaxed);
+    }
+  #else
+    (void)tag;
+  #endif
+  return stats;
+}
+
+const char* memory_tag_name(memory_tag tag) {
+  switch (tag) {
+    case MEMORY_TAG_UNKNOWN: return "unknown";
+    case MEMORY_TAG_CORE: return "core";
+    case MEMORY_TAG_ARENA: return "arena";
+    case MEMORY_TAG_POOL: return "pool";
+    case MEMORY_TAG_JOB: return "job";
+    case MEMORY_TAG_EVENT: return "event";
+    case MEMORY_TAG_LOGGER: return "logger";
+    case MEMORY_TAG_TERRAIN: return "terrain";
+    case MEMORY_TAG_RENDER: return "render";
+    case MEMORY_TAG_GAME: return "game";
+    default: return "invalid";
+  }
+}
+
+u64 memory_get_linear_usage(void) {
+  return memory_system ? memory_system->linear_memory_allocated : 0;
+}
+
+void memory_log_report(void) {
+  #if MEMORY_TRACKING_ENABLED
+    for (u32 i = 0; i < MEMORY_TAG_MAX; ++i) {
+      const memory_tag_stats stats = memory_get_tag_stats((memory_tag)i);
+      if (stats.allocation_count == 0) {
+        continue;
+      }
+      TRACELOG(LOG_INFO, "MEMORY: %-8s current %10llu B, peak %10llu B, %llu live of %llu allocations",
+        memory_tag_name((memory_tag)i), stats.current_bytes, stats.peak_bytes, stats.live_count, stats.allocation_count);
+    }
+  #endif
+  if (memory_system) {
+    const memory_arena* frames = memory_system->frame_arenas;
+    const u64 frame_peak = (frames[0].peak > frames[1].peak) ? frames[0].peak : frames[1].peak;
+    TRACELOG(LOG_INFO, "MEMORY: linear %llu of %llu B, frame arena peak %llu of %llu B",
+      memory_system->linear_memory_allocated, memory_system->linear_memory_total_size, frame_peak, (u64)FRAME_ARENA_SIZE);
+  }
 }
 
 void zero_memory(void* block, u64 size) {
@@ -1,13 +1,113 @@
-
 #ifndef FMEMORY_H
 #define FMEMORY_H
 
 #include "defines.h"
 
+#define MEMORY_DEFAULT_ALIGNMENT 16
+
+// Build with -DMEMORY_TRACKING_ENABLED=0 to strip the per tag counters and the heap allocation headers
+#ifndef MEMORY_TRACKING_ENABLED
+#define MEMORY_TRACKING_ENABLED 1
+#endif
+
+typedef enum memory_tag {
+  MEMORY_TAG_UNKNOWN,
+  MEMORY_TAG_CORE,
+  MEMORY_TAG_ARENA,
+  MEMORY_TAG_POOL,
+  MEMORY_TAG_JOB,
+  MEMORY_TAG_EVENT,
+  MEMORY_TAG_LOGGER,
+  MEMORY_TAG_TERRAIN,
+  MEMORY_TAG_RENDER,
+  MEMORY_TAG_GAME,
+  MEMORY_TAG_MAX,
+} memory_tag;
+
+typedef struct memory_tag_stats {
+  u64 current_bytes;
+  u64 peak_bytes;
+  u64 allocation_count; // Total allocations made, not the live ones
+  u64 live_count;
+} memory_tag_stats;
+
+/**
+ * @brief Bump allocator over a fixed block. Not thread safe, every thread uses its own arena.
+ */
+typedef struct memory_arena {
+  const char* name;
+  u8* base;
+  u64 size;
+  u64 offset;
+  u64 peak;
+} memory_arena;
+
+typedef struct arena_marker {
+  memory_arena* arena;
+  u64 offset;
+} arena_marker;
+
+/**
+ * @brief Rolls the arena back to where it was when the scope was entered.
+ */
+typedef struct arena_scope {
+  arena_marker marker;
+  explicit arena_scope(memory_arena* arena) : marker(arena_marker {arena, arena->offset}) {}
+  ~arena_scope(void) { marker.arena->offset = marker.offset; }
+  arena_scope(const arena_scope&) = delete;
+  arena_scope& operator=(const arena_scope&) = delete;
+} arena_scope;
+
 void memory_system_initialize(void);
 
-void* allocate_memory(u64 size, bool will_zero_memory);
-void* allocate_memory_linear(u64 size, bool will_zero_memory);
+/**
+ * @brief Swaps the double buffered frame arenas and resets the one that becomes current.
+ * Frame allocations stay valid until the end of the next frame.
+ */
+void memory_system_end_frame(void);
+
+void* allocate_memory(u64 size, bool will_zero_memory, memory_tag tag);
+void* allocate_memory_linear(u64 size, bool will_zero_memory, memory_tag tag);
+
+/**
+ * @brief Main thread only. Valid through the next frame, the second memory_system_end_frame() after the
+ * allocation resets its arena. Runs out like allocate_memory_arena().
+ */
+void* allocate_memory_frame(u64 size, bool will_zero_memory);
+
+/**
+ * @brief alignment has to be a power of two. When the arena is exhausted release builds return nullptr and
+ * leave the arena as it was, callers have to check. _DEBUG builds log the overflow and abort.
+ */
+void* allocate_memory_arena(memory_arena* arena, u64 size, u64 alignment, bool will_zero_memory);
+
+/**
+ * @brief Carves an arena from linear memory, it lives until the program exits.
+ */
+bool memory_arena_create(memory_arena* arena, const char* name, u64 size, memory_tag tag);
+arena_marker memory_arena_get_marker(memory_arena* arena);
+void memory_arena_rollback(arena_marker marker);
+void memory_arena_reset(memory_arena* arena);
+
+memory_arena* memory_get_frame_arena(void);
+
+/**
+ * @brief Arena owned by the calling thread, created on first use and freed when the thread exits.
+ * Wrap temporaries in an arena_scope so the arena never grows past a single call.
+ */
+memory_arena* memory_get_scratch_arena(void);
+
+/**
+ * @brief Everything zeroed when MEMORY_TRACKING_ENABLED is 0.
+ */
+memory_tag_stats memory_get_tag_stats(memory_tag tag);
+const char* memory_tag_name(memory_tag tag);
+u64 memory_get_linear_usage(void);
+
+/**
+ * @brief Logs every tag with live or past allocations, the linear block usage and the frame arena high-water mark.
+ */
+void memory_log_report(void);
 
 void free_memory(void* block);
 void zero_memory(void* block, u64 size);
@@ -0,0 +1,368 @@
+#include "fnoise.h"
+
+#include <math.h>
+#include <mutex>
+
+#include "core/fcache.h"
+#include "core/fjob.h"
+#include "core/fmemory.h"
+#include "core/fprofile.h"
+#include "core/fsimd.h"
+
+#define NOISE_ROWS_PER_TASK 8
+#define NOISE_WARP_SEED 0x68e31da4u
+#define NOISE_OCTAVE_SEED_STEP 0x9e3779b9u
+#define NOISE_SLICES_PER_TASK 2
+#define NOISE_VOLUME_CACHE_TYPE 0x4e564f02u // "NVO" and the layout version, bump it when the voxels change
+#define NOISE_VOLUME_SECTION_VOXELS 0u
+// Diagonal 3D gradients reach about 1.2 at the cell centers, this brings |noise| near [0, 1]
+#define NOISE_VOLUME_AMPLITUDE 0.8f
+
+typedef struct noise_task_context {
+  const noise_config* config;
+  u32 width;
+  u32 height;
+  f32* out;
+  std::mutex range_mutex;
+  f32 min_value;
+  f32 max_value;
+} noise_task_context;
+
+typedef struct noise_volume_task_context {
+  const noise_volume_config* config;
+  f32 inv_amplitude_sum;
+  u16* out;
+} noise_volume_task_context;
+
+static inline simd_u32 hash_lattice(simd_u32 x, simd_u32 y, u32 seed) {
+  simd_u32 h = simd_u32_xor(simd_u32_mul(x, simd_u32_set1(0x27d4eb2du)), simd_u32_mul(y, simd_u32_set1(0x165667b1u)));
+  h = simd_u32_xor(h, simd_u32_set1(seed));
+  h = simd_u32_mul(simd_u32_xor(h, simd_u32_shr(h, 15)), simd_u32_set1(0x2c1b3c6du));
+  h = simd_u32_mul(simd_u32_xor(h, simd_u32_shr(h, 12)), simd_u32_set1(0x297a2d39u));
+  return simd_u32_xor(h, simd_u32_shr(h, 15));
+}
+
+// Diagonal gradients, the two low hash bits flip the sign of each axis
+static inline simd_f32 lattice_gradient(simd_u32 h, simd_f32 x, simd_f32 y) {
+  const simd_u32 sign_x = simd_u32_shl(h, 31);
+  const simd_u32 sign_y = simd_u32_and(simd_u32_shl(h, 30), simd_u32_set1(0x80000000u));
+  return simd_add(
+    simd_u32_to_f32_bits(simd_u32_xor(simd_f32_to_u32_bits(x), sign_x)),
+    simd_u32_to_f32_bits(simd_u32_xor(simd_f32_to_u32_bits(y), sign_y))
+  );
+}
+
+static inline simd_f32 fade(simd_f32 t) {
+  const simd_f32 inner = simd_add(simd_mul(t, simd_sub(simd_mul(t, simd_set1(6.f)), simd_set1(15.f))), simd_set1(10.f));
+  return simd_mul(simd_mul(simd_mul(t, t), t), inner);
+}
+
+static simd_f32 gradient_noise(simd_f32 x, simd_f32 y, u32 seed) {
+  const simd_f32 fx = simd_floor(x);
+  const simd_f32 fy = simd_floor(y);
+  const simd_u32 ix = simd_to_u32(fx);
+  const simd_u32 iy = simd_to_u32(fy);
+  const simd_u32 one = simd_u32_set1(1u);
+
+  const simd_f32 tx = simd_sub(x, fx);
+  const simd_f32 ty = simd_sub(y, fy);
+  const simd_f32 tx1 = simd_sub(tx, simd_set1(1.f));
+  const simd_f32 ty1 = simd_sub(ty, simd_set1(1.f));
+
+  const simd_f32 g00 = lattice_gradient(hash_lattice(ix, iy, seed), tx, ty);
+  const simd_f32 g10 = lattice_gradient(hash_lattice(simd_u32_add(ix, one), iy, seed), tx1, ty);
+  const simd_f32 g01 = lattice_gradient(hash_lattice(ix, simd_u32_add(iy, one), seed), tx, ty1);
+  const simd_f32 g11 = lattice_gradient(hash_lattice(simd_u32_add(ix, one), simd_u32_add(iy, one), seed), tx1, ty1);
+
+  const simd_f32 u = fade(tx);
+  return simd_lerp(simd_lerp(g00, g10, u), simd_lerp(g01, g11, u), fade(ty));
+}
+
+static inline simd_u32 hash_lattice_3d(simd_u32 x, simd_u32 y, simd_u32 z, u32 seed) {
+  return hash_lattice(simd_u32_xor(x, simd_u32_mul(z, simd_u32_set1(0x9e3779b1u))), y, seed);
+}
+
+// Cube diagonal gradients, the three low hash bits flip the sign of each axis
+static inline simd_f32 lattice_gradient_3d(simd_u32 h, simd_f32 x, simd_f32 y, simd_f32 z) {
+  const simd_u32 sign_bit = simd_u32_set1(0x80000000u);
+  const simd_u32 sign_x = simd_u32_shl(h, 31);
+  const simd_u32 sign_y = simd_u32_and(simd_u32_shl(h, 30), sign_bit);
+  const simd_u32 sign_z = simd_u32_and(simd_u32_shl(h, 29), sign_bit);
+  return simd_add(simd_add(
+    simd_u32_to_f32_bits(simd_u32_xor(simd_f32_to_u32_bits(x), sign_x)),
+    simd_u32_to_f32_bits(simd_u32_xor(simd_f32_to_u32_bits(y), sign_y))),
+    simd_u32_to_f32_bits(simd_u32_xor(simd_f32_to_u32_bits(z), sign_z))
+  );
+}
+
+// Lattice coordinates wrap at period_mask + 1 cells, so the volume tiles
+static simd_f32 gradient_noise_3d(simd_f32 x, simd_f32 y, simd_f32 z, u32 period_mask, u32 seed) {
+  const simd_f32 fx = simd_floor(x);
+  const simd_f32 fy = simd_floor(y);
+  const simd_f32 fz = simd_floor(z);
+  const simd_u32 mask = simd_u32_set1(period_mask);
+  const simd_u32 one = simd_u32_set1(1u);
+  const simd_u32 ix0 = simd_u32_and(simd_to_u32(fx), mask);
+  const simd_u32 iy0 = simd_u32_and(simd_to_u32(fy), mask);
+  const simd_u32 iz0 = simd_u32_and(simd_to_u32(fz), mask);
+  const simd_u32 ix1 = simd_u32_and(simd_u32_add(ix0, one), mask);
+  const simd_u32 iy1 = simd_u32_and(simd_u32_add(iy0, one), mask);
+  const simd_u32 iz1 = simd_u32_and(simd_u32_add(iz0, one), mask);
+
+  const simd_f32 tx0 = simd_sub(x, fx);
+  const simd_f32 ty0 = simd_sub(y, fy);
+  const simd_f32 tz0 = simd_sub(z, fz);
+  const simd_f32 tx1 = simd_sub(tx0, simd_set1(1.f));
+  const simd_f32 ty1 = simd_sub(ty0, simd_set1(1.f));
+  const simd_f32 tz1 = simd_sub(tz0, simd_set1(1.f));
+
+  const simd_f32 g000 = lattice_gradient_3d(hash_lattice_3d(ix0, iy0, iz0, seed), tx0, ty0, tz0);
+  const simd_f32 g100 = lattice_gradient_3d(hash_lattice_3d(ix1, iy0, iz0, seed), tx1, ty0, tz0);
+  const simd_f32 g010 = lattice_gradient_3d(hash_lattice_3d(ix0, iy1, iz0, seed), tx0, ty1, tz0);
+  const simd_f32 g110 = lattice_gradient_3d(hash_lattice_3d(ix1, iy1, iz0, seed), tx1, ty1, tz0);
+  const simd_f32 g001 = lattice_gradient_3d(hash_lattice_3d(ix0, iy0, iz1, seed), tx0, ty0, tz1);
+  const simd_f32 g101 = lattice_gradient_3d(hash_lattice_3d(ix1, iy0, iz1, seed), tx1, ty0, tz1);
+  const simd_f32 g011 = lattice_gradient_3d(hash_lattice_3d(ix0, iy1, iz1, seed), tx0, ty1, tz1);
+  const simd_f32 g111 = lattice_gradient_3d(hash_lattice_3d(ix1, iy1, iz1, seed), tx1, ty1, tz1);
+
+  const simd_f32 u = fade(tx0);
+  const simd_f32 v = fade(ty0);
+  const simd_f32 near = simd_lerp(simd_lerp(g000, g100, u), simd_lerp(g010, g110, u), v);
+  const simd_f32 far = simd_lerp(simd_lerp(g001, g101, u), simd_lerp(g011, g111, u), v);
+  return simd_lerp(near, far, fade(tz0));
+}
+
+static simd_f32 sample_octaves(const noise_config* config, simd_f32 x, simd_f32 y) {
+  if (config->warp_strength != 0.f) {
+    const simd_f32 warp_scale = simd_set1(config->warp_scale);
+    const simd_f32 wx = simd_mul(x, warp_scale);
+    const simd_f32 wy = simd_mul(y, warp_scale);
+    const simd_f32 strength = simd_set1(config->warp_strength);
+    const simd_f32 dx = gradient_noise(wx, wy, config->seed ^ NOISE_WARP_SEED);
+    const simd_f32 dy = gradient_noise(simd_add(wx, simd_set1(5.2f)), simd_add(wy, simd_set1(1.3f)), config->seed ^ (NOISE_WARP_SEED * 3u));
+    x = simd_madd(dx, strength, x);
+    y = simd_madd(dy, strength, y);
+  }
+
+  simd_f32 sum = simd_set1(0.f);
+  simd_f32 amplitude = simd_set1(1.f);
+  simd_f32 weight = simd_set1(1.f);
+  const simd_f32 lacunarity = simd_set1(config->lacunarity);
+  const simd_f32 gain = simd_set1(config->gain);
+  u32 seed = config->seed;
+
+  for (u32 octave = 0; octave < config->octaves; ++octave) {
+    simd_f32 n = gradient_noise(x, y, seed);
+    if (config->mode == NOISE_MODE_RIDGED) {
+      n = simd_sub(simd_set1(1.f), simd_abs(n));
+      n = simd_mul(simd_mul(n, n), weight);
+      weight = simd_clamp(simd_mul(n, simd_set1(2.f)), simd_set1(0.f), simd_set1(1.f));
+    }
+    sum = simd_madd(n, amplitude, sum);
+    amplitude = simd_mul(amplitude, gain);
+    x = simd_mul(x, lacunarity);
+    y = simd_mul(y, lacunarity);
+    seed += NOISE_OCTAVE_SEED_STEP;
+  }
+  return sum;
+}
+
+static void generate_rows(u32 first_row, u32 last_row, void* data) {
+  PROFILE_SCOPE("noise_rows");
+  noise_task_context* ctx = (noise_task_context*)data;
+  const noise_config* config = ctx->config;
+  const simd_f32 step_x = simd_set1(config->scale / (f32)ctx->width);
+  const f32 step_y = config->scale / (f32)ctx->height;
+  alignas(32) f32 tail[SIMD_LANE_COUNT];
+  f32 local_min = F32_MAX;
+  f32 local_max = -F32_MAX;
+
+  for (u32 row = first_row; row < last_row; ++row) {
+    const simd_f32 y = simd_set1((f32)((i32)row + config->offset_y) * step_y);
+    f32* out_row = ctx->out + (u64)row * ctx->width;
+
+    for (u32 col = 0; col < ctx->width; col += SIMD_LANE_COUNT) {
+      const simd_f32 x = simd_mul(simd_add(simd_set1((f32)((i32)col + config->offset_x)), simd_lane_index()), step_x);
+      const simd_f32 value = sample_octaves(config, x, y);
+
+      // The last partial vector goes through a scratch buffer, every lane is computed the same way
+      const u32 lanes = FMIN((u32)SIMD_LANE_COUNT, ctx->width - col);
+      simd_store(tail, value);
+      for (u32 i = 0; i < lanes; ++i) {
+        out_row[col + i] = tail[i];
+        local_min = fminf(local_min, tail[i]);
+        local_max = fmaxf(local_max, tail[i]);
+      }
+    }
+  }
+
+  // Min and max are order independent, so the merge order between batches doesn't matter
+  std::lock_guard<std::mutex> lock(ctx->range_mutex);
+  ctx->min_value = fminf(ctx->min_value, local_min);
+  ctx->max_value = fmaxf(ctx->max_value, local_max);
+}
+
+static void generate_slices(u32 first_slice, u32 last_slice, void* data) {
+  noise_volume_task_context* ctx = (noise_volume_task_context*)data;
+  const noise_volume_config* config = ctx->config;
+  const u32 size = config->size;
+  const f32 inv_size = 1.f / (f32)size;
+  const simd_f32 half = simd_set1(0.5f);
+  alignas(32) f32 tail[SIMD_LANE_COUNT];
+
+  for (u32 z = first_slice; z < last_slice; ++z) {
+    for (u32 y = 0; y < size; ++y) {
+      u16* out_row = ctx->out + ((u64)z * size + y) * size;
+      for (u32 col = 0; col < size; col += SIMD_LANE_COUNT) {
+        // Voxel centers in [0, 1), scaled to lattice cells per octave
+        const simd_f32 x01 = simd_mul(simd_add(simd_add(simd_set1((f32)col), simd_lane_index()), half), simd_set1(inv_size));
+        const simd_f32 y01 = simd_set1(((f32)y + 0.5f) * inv_size);
+        const simd_f32 z01 = simd_set1(((f32)z + 0.5f) * inv_size);
+
+        simd_f32 sum = simd_set1(0.f);
+        f32 amplitude = 1.f;
+        u32 cells = config->cells;
+        u32 seed = config->seed;
+        for (u32 octave = 0; octave < config->octaves; ++octave) {
+          const simd_f32 frequency = simd_set1((f32)cells);
+          const simd_f32 n = gradient_noise_3d(simd_mul(x01, frequency), simd_mul(y01, frequency), simd_mul(z01, frequency), cells - 1, seed);
+          sum = simd_madd(simd_abs(n), simd_set1(amplitude * NOISE_VOLUME_AMPLITUDE), sum);
+          amplitude *= config->gain;
+          cells <<= 1;
+          seed += NOISE_OCTAVE_SEED_STEP;
+        }
+        const simd_f32 value = simd_clamp(simd_mul(sum, simd_set1(ctx->inv_amplitude_sum)), simd_set1(0.f), simd_set1(1.f));
+
+        const u32 lanes = FMIN((u32)SIMD_LANE_COUNT, size - col);
+        simd_store(tail, value);
+        for (u32 i = 0; i < lanes; ++i) {
+          out_row[col + i] = (u16)(tail[i] * 65535.f + 0.5f);
+        }
+      }
+    }
+  }
+}
+
+static void normalize_rows(u32 first_row, u32 last_row, void* data) {
+  noise_task_context* ctx = (noise_task_context*)data;
+  const f32 range = ctx->max_value - ctx->min_value;
+  const f32 inv_range = (range > 0.f) ? 1.f / range : 0.f;
+  const simd_f32 min_lanes = simd_set1(ctx->min_value);
+  const simd_f32 inv_range_lanes = simd_set1(inv_range);
+  const u64 end = (u64)last_row * ctx->width;
+
+  u64 i = (u64)first_row * ctx->width;
+  for (; i + SIMD_LANE_COUNT <= end; i += SIMD_LANE_COUNT) {
+    simd_store(ctx->out + i, simd_mul(simd_sub(simd_load(ctx->out + i), min_lanes), inv_range_lanes));
+  }
+  for (; i < end; ++i) {
+    ctx->out[i] = (ctx->out[i] - ctx->min_value) * inv_range;
+  }
+}
+
+static u64 volume_cache_key(const noise_volume_config* config) {
+  u64 key = 0;
+  const auto append = [&key](const void* field, u64 size) { key = cache_hash(field, size, key); };
+  append(&config->seed, sizeof(config->seed));
+  append(&config->size, sizeof(config->size));
+  append(&config->cells, sizeof(config->cells));
+  append(&config->octaves, sizeof(config->octaves));
+  append(&config->gain, sizeof(config->gain));
+  return key;
+}
+
+noise_config noise_config_default(void) {
+  return noise_config {
+    .seed = 1337u,
+    .octaves = 6,
+    .scale = 5.f,
+    .lacunarity = 2.f,
+    .gain = 0.5f,
+    .mode = NOISE_MODE_FBM,
+    .warp_strength = 0.f,
+    .warp_scale = 0.5f,
+    .offset_x = 0,
+    .offset_y = 0,
+    .normalize = true,
+  };
+}
+
+bool noise_generate_heightfield(const noise_config* config, u32 width, u32 height, f32* out) {
+  if (not config or not out or width == 0 or height == 0 or config->mode >= NOISE_MODE_MAX) {
+    return false;
+  }
+
+  noise_task_context ctx;
+  ctx.config = config;
+  ctx.width = width;
+  ctx.height = height;
+  ctx.out = out;
+  ctx.min_value = F32_MAX;
+  ctx.max_value = -F32_MAX;
+
+  job_parallel_for(height, NOISE_ROWS_PER_TASK, generate_rows, &ctx);
+  if (config->normalize) {
+    job_parallel_for(height, NOISE_ROWS_PER_TASK, normalize_rows, &ctx);
+  }
+  return true;
+}
+
+bool noise_generate_volume(const noise_volume_config* config, u16* out) {
+  const auto power_of_two = [](u32 v) { return v > 0 and (v & (v - 1)) == 0; };
+  if (not config or not out or not power_of_two(config->size) or not power_of_two(config->cells)
+    or config->octaves == 0 or (config->cells << (config->octaves - 1)) == 0) {
+    return false;
+  }
+
+  f32 amplitude_sum = 0.f;
+  f32 amplitude = 1.f;
+  for (u32 octave = 0; octave < config->octaves; ++octave) {
+    amplitude_sum += amplitude;
+    amplitude *= config->gain;
+  }
+
+  noise_volume_task_context ctx = {};
+  ctx.config = config;
+  ctx.inv_amplitude_sum = 1.f / amplitude_sum;
+  ctx.out = out;
+  job_parallel_for(config->size, NOISE_SLICES_PER_TASK, generate_slices, &ctx);
+  return true;
+}
+
+bool noise_load_or_generate_volume(const noise_volume_config* config, const char* cache_path, u16* out, bool* from_cache) {
+  if (from_cache) {
+    *from_cache = false;
+  }
+  if (not config or not out) {
+    return false;
+  }
+  const u64 size = (u64)config->size * config->size * config->size * sizeof(u16);
+  // Without a path the volume is baked every time
+  const bool cached = cache_path and cache_path[0] != '\0';
+  const u64 key = volume_cache_key(config);
+
+  cache_file cache = {};
+  if (cached and cache_open(cache_path, NOISE_VOLUME_CACHE_TYPE, key, &cache) == CACHE_OK) {
+    const void* voxels = cache_find_section(&cache, NOISE_VOLUME_SECTION_VOXELS, size);
+    if (voxels) {
+      copy_memory(out, voxels, size);
+    }
+    cache_close(&cache);
+    if (voxels) {
+      if (from_cache) {
+        *from_cache = true;
+      }
+      return true;
+    }
+  }
+
+  if (not noise_generate_volume(config, out)) {
+    return false;
+  }
+  if (cached) {
+    // A cache that can't be written only costs another bake on the next run
+    const cache_section section = cache_section { NOISE_VOLUME_SECTION_VOXELS, out, size };
+    cache_write(cache_path, NOISE_VOLUME_CACHE_TYPE, key, &section, 1);
+  }
+  return true;
+}
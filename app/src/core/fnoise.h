@@ -0,0 +1,63 @@
+#ifndef FNOISE_H
+#define FNOISE_H
+
+#include "defines.h"
+
+typedef enum noise_mode {
+  NOISE_MODE_FBM,
+  NOISE_MODE_RIDGED,
+  NOISE_MODE_MAX,
+} noise_mode;
+
+typedef struct noise_config {
+  u32 seed;
+  u32 octaves;
+  f32 scale;         // Same meaning as GenImagePerlinNoise() scale, cycles across the map at the first octave
+  f32 lacunarity;
+  f32 gain;
+  noise_mode mode;
+  f32 warp_strength; // Domain warp displacement in noise space, 0 disables warping
+  f32 warp_scale;    // Frequency of the warp field relative to the first octave
+  i32 offset_x;
+  i32 offset_y;
+  bool normalize;    // Remap the result to [0, 1]
+} noise_config;
+
+/**
+ * @brief Tileable volume of billowy fbm, sum of |noise| over the octaves like atmosphere.fs fbm_clouds().
+ */
+typedef struct noise_volume_config {
+  u32 seed;
+  u32 size;    // Voxels per side, power of two
+  u32 cells;   // Lattice cells per side at the first octave, power of two. Lacunarity is 2 so the octaves keep tiling
+  u32 octaves;
+  f32 gain;
+} noise_volume_config;
+
+noise_config noise_config_default(void);
+
+/**
+ * @brief Fills out with width * height samples, row major. Rows are spread over the job system,
+ * output is bit-identical for a given config regardless of thread count or lane width.
+ */
+bool noise_generate_heightfield(const noise_config* config, u32 width, u32 height, f32* out);
+
+/**
+ * @brief Fills out with size^3 samples, x fastest then y then z. Values are divided by the amplitude sum
+ * and stored as unorm16. Slices are spread over the job system, bit-identical like the heightfield.
+ */
+bool noise_generate_volume(const noise_volume_config* config, u16* out);
+
+/**
+ * @brief Reads the volume from the fcache file at cache_path when it was baked with the same config and its
+ * checksum holds, bakes and writes it otherwise. A null or empty cache_path always bakes and writes nothing.
+ * @param from_cache Optional, set to true when nothing had to be baked
+ */
+bool noise_load_or_generate_volume(const noise_volume_config* config, const char* cache_path, u16* out, bool* from_cache);
+
+/**
+ * @brief Logs heightfield throughput in Mpixels/s next to GenImagePerlinNoise() at 256, 2048 and 8192 per side.
+ */
+void noise_run_benchmark(void);
+
+#endif
@@ -0,0 +1,57 @@
+#include "fnoise.h"
+
+#include <raylib.h>
+#include <chrono>
+
+#include "core/fjob.h"
+#include "core/fmemory.h"
+
+// Small maps repeat until about this many pixels went through, large ones run once
+#define NOISE_BENCH_PIXEL_BUDGET (2048u * 2048u)
+
+static const u32 bench_sizes[] = { 256u, 2048u, 8192u };
+
+static f64 elapsed_ms(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static f64 mpixels_per_second(u32 size, u32 runs, f64 ms) {
+  return ((f64)size * size * runs / 1e6) / (ms / 1000.0);
+}
+
+static f64 time_generator(const noise_config* config, u32 size, u32 runs, f32* out) {
+  const auto start = std::chrono::steady_clock::now();
+  for (u32 i = 0; i < runs; ++i) {
+    noise_generate_heightfield(config, size, size, out);
+  }
+  return elapsed_ms(start);
+}
+
+void noise_run_benchmark(void) {
+  const noise_config fbm = noise_config_default();
+  noise_config ridged_warped = fbm;
+  ridged_warped.mode = NOISE_MODE_RIDGED;
+  ridged_warped.warp_strength = 1.f;
+
+  // GenImagePerlinNoise() is 6 octaves of fbm with lacunarity 2 and gain 0.5, the default config matches it
+  TRACELOG(LOG_INFO, "NOISE: Mpixels/s, %u octaves at scale %.1f, %u threads", fbm.octaves, fbm.scale, job_thread_count());
+  for (u32 size : bench_sizes) {
+    const u32 runs = FMAX(NOISE_BENCH_PIXEL_BUDGET / (size * size), 1u);
+    f32* heights = (f32*)allocate_memory((u64)size * size * sizeof(f32), false, MEMORY_TAG_CORE);
+    const f64 fbm_ms = time_generator(&fbm, size, runs, heights);
+    const f64 ridged_ms = time_generator(&ridged_warped, size, runs, heights);
+    free_memory(heights);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (u32 i = 0; i < runs; ++i) {
+      Image image = GenImagePerlinNoise((i32)size, (i32)size, 0, 0, fbm.scale);
+      UnloadImage(image);
+    }
+    const f64 raylib_ms = elapsed_ms(start);
+
+    const f64 fbm_rate = mpixels_per_second(size, runs, fbm_ms);
+    const f64 raylib_rate = mpixels_per_second(size, runs, raylib_ms);
+    TRACELOG(LOG_INFO, "NOISE:   %4ux%-4u fbm %8.1f, ridged warped %8.1f, GenImagePerlinNoise() %6.1f (%.1fx), %u runs", size, size, fbm_rate,
+      mpixels_per_second(size, runs, ridged_ms), raylib_rate, (raylib_rate > 0.0) ? fbm_rate / raylib_rate : 0.0, runs);
+  }
+}
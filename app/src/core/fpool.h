@@ -0,0 +1,181 @@
+#ifndef FPOOL_H
+#define FPOOL_H
+
+#include "defines.h"
+
+#include <new>
+#include <stdlib.h>
+
+#include "core/fmemory.h"
+
+#define POOL_MAX_BLOCK_COUNT 1024
+#define POOL_INVALID_INDEX U32_MAX
+
+/**
+ * @brief Generation 0 is never handed out, a zeroed handle is always invalid.
+ */
+typedef struct pool_handle {
+  u32 index;
+  u32 generation;
+} pool_handle;
+
+/**
+ * @brief Fixed-size object pool. Slots are carved out of blocks of BLOCK_CAPACITY objects that are never released
+ * before pool_shutdown(), so pointers stay stable. Free slots form an intrusive list, alloc and free are O(1).
+ * A slot's generation is odd while it's alive and is bumped on every alloc and free, which invalidates stale handles.
+ * Not thread safe, give each thread its own pool or guard it externally.
+ */
+template <typename T, u32 BLOCK_CAPACITY = 256>
+struct memory_pool {
+  struct slot {
+    alignas(T) u8 storage[sizeof(T)];
+    u32 generation;
+    u32 next_free; // Own index while the slot is alive
+  };
+  static_assert(BLOCK_CAPACITY > 0, "pool blocks can't be empty");
+
+  slot* blocks[POOL_MAX_BLOCK_COUNT];
+  u32 block_count;
+  u32 free_head;
+  u32 live_count;
+  memory_tag tag;
+};
+
+/**
+ * @param tag Blocks are accounted under the owner's tag
+ */
+template <typename T, u32 C>
+void pool_initialize(memory_pool<T, C>* pool, memory_tag tag) {
+  zero_memory(pool->blocks, sizeof(pool->blocks));
+  pool->block_count = 0;
+  pool->free_head = POOL_INVALID_INDEX;
+  pool->live_count = 0;
+  pool->tag = tag;
+}
+
+/**
+ * @brief Destroys the objects that are still alive and releases every block.
+ */
+template <typename T, u32 C>
+void pool_shutdown(memory_pool<T, C>* pool) {
+  for (u32 b = 0; b < pool->block_count; ++b) {
+    for (u32 i = 0; i < C; ++i) {
+      typename memory_pool<T, C>::slot& s = pool->blocks[b][i];
+      if (s.generation & 1u) {
+        ((T*)s.storage)->~T();
+      }
+    }
+    free_memory(pool->blocks[b]);
+    pool->blocks[b] = nullptr;
+  }
+  pool->block_count = 0;
+  pool->free_head = POOL_INVALID_INDEX;
+  pool->live_count = 0;
+}
+
+template <typename T, u32 C>
+typename memory_pool<T, C>::slot* pool_slot(memory_pool<T, C>* pool, u32 index) {
+  return &pool->blocks[index / C][index % C];
+}
+
+/**
+ * @brief Makes sure a free slot exists and returns its index, POOL_INVALID_INDEX when the pool is full.
+ */
+template <typename T, u32 C>
+u32 pool_reserve_slot(memory_pool<T, C>* pool) {
+  if (pool->free_head != POOL_INVALID_INDEX) {
+    return pool->free_head;
+  }
+  if (pool->block_count >= POOL_MAX_BLOCK_COUNT) {
+    return POOL_INVALID_INDEX;
+  }
+  typename memory_pool<T, C>::slot* block = (typename memory_pool<T, C>::slot*)allocate_memory(sizeof(typename memory_pool<T, C>::slot) * C, false, pool->tag);
+  const u32 first = pool->block_count * C;
+  for (u32 i = 0; i < C; ++i) {
+    block[i].generation = 0;
+    block[i].next_free = (i + 1 < C) ? first + i + 1 : POOL_INVALID_INDEX;
+  }
+  pool->blocks[pool->block_count++] = block;
+  pool->free_head = first;
+  return first;
+}
+
+/**
+ * @brief Constructs a T in a free slot. Returns nullptr when POOL_MAX_BLOCK_COUNT blocks are in use.
+ */
+template <typename T, u32 C, typename... Args>
+T* pool_allocate(memory_pool<T, C>* pool, pool_handle* out_handle, Args&&... args) {
+  const u32 index = pool_reserve_slot(pool);
+  if (index == POOL_INVALID_INDEX) {
+    return nullptr;
+  }
+  typename memory_pool<T, C>::slot* s = pool_slot(pool, index);
+  pool->free_head = s->next_free;
+  s->next_free = index;
+  s->generation++;
+  pool->live_count++;
+
+  if (out_handle) {
+    *out_handle = pool_handle {index, s->generation};
+  }
+  return new (s->storage) T(static_cast<Args&&>(args)...);
+}
+
+template <typename T, u32 C>
+T* pool_allocate(memory_pool<T, C>* pool) {
+  return pool_allocate(pool, (pool_handle*)nullptr);
+}
+
+/**
+ * @brief Resolves a handle, nullptr if it was freed or never belonged to this pool.
+ */
+template <typename T, u32 C>
+T* pool_get(memory_pool<T, C>* pool, pool_handle handle) {
+  if (handle.index == POOL_INVALID_INDEX or handle.index / C >= pool->block_count) {
+    return nullptr;
+  }
+  typename memory_pool<T, C>::slot* s = pool_slot(pool, handle.index);
+  return (s->generation == handle.generation and (handle.generation & 1u)) ? (T*)s->storage : nullptr;
+}
+
+template <typename T, u32 C>
+void pool_free_index(memory_pool<T, C>* pool, u32 index) {
+  typename memory_pool<T, C>::slot* s = pool_slot(pool, index);
+  #ifdef _DEBUG
+    if (not (s->generation & 1u)) {
+      exit(EXIT_FAILURE);
+    }
+  #endif
+  ((T*)s->storage)->~T();
+  s->generation++;
+  s->next_free = pool->free_head;
+  pool->free_head = index;
+  pool->live_count--;
+}
+
+/**
+ * @brief Object must be alive and come from this pool.
+ */
+template <typename T, u32 C>
+void pool_free(memory_pool<T, C>* pool, T* object) {
+  pool_free_index(pool, ((typename memory_pool<T, C>::slot*)object)->next_free);
+}
+
+/**
+ * @brief Returns false for stale handles, the slot is left untouched in that case.
+ */
+template <typename T, u32 C>
+bool pool_free_handle(memory_pool<T, C>* pool, pool_handle handle) {
+  if (not pool_get(pool, handle)) {
+    return false;
+  }
+  pool_free_index(pool, handle.index);
+  return true;
+}
+
+/**
+ * @brief Churn microbenchmarks against malloc/free, single and multi-threaded. Results are logged.
+ */
+void memory_pool_run_benchmark(void);
+
+#endif
@@ -0,0 +1,105 @@
+#include "fpool.h"
+
+#include <raylib.h>
+#include <chrono>
+#include <stdlib.h> // Required for: malloc(), free()
+
+#include "core/fjob.h"
+
+#define POOL_BENCH_LIVE_COUNT 4096
+#define POOL_BENCH_OPERATION_COUNT (4u * 1024u * 1024u)
+
+typedef struct pool_bench_object {
+  u64 payload[8];
+} pool_bench_object;
+
+typedef memory_pool<pool_bench_object, 1024> pool_bench_pool;
+
+typedef struct pool_bench_result {
+  f64 pool_ms;
+  f64 malloc_ms;
+} pool_bench_result;
+
+static inline u32 bench_next(u32* seed) {
+  *seed = *seed * 1664525u + 1013904223u;
+  return *seed >> 8;
+}
+
+static f64 elapsed_ms(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Keeps POOL_BENCH_LIVE_COUNT objects alive and replaces a random one per operation
+static pool_bench_result run_churn(u32 seed) {
+  pool_bench_result result = {};
+  pool_bench_object* live[POOL_BENCH_LIVE_COUNT];
+
+  pool_bench_pool* pool = (pool_bench_pool*)allocate_memory(sizeof(pool_bench_pool), false, MEMORY_TAG_POOL);
+  pool_initialize(pool, MEMORY_TAG_POOL);
+  u32 rng = seed;
+  auto start = std::chrono::steady_clock::now();
+  for (u32 i = 0; i < POOL_BENCH_LIVE_COUNT; ++i) {
+    live[i] = pool_allocate(pool);
+  }
+  for (u32 i = 0; i < POOL_BENCH_OPERATION_COUNT; ++i) {
+    const u32 slot = bench_next(&rng) % POOL_BENCH_LIVE_COUNT;
+    pool_free(pool, live[slot]);
+    live[slot] = pool_allocate(pool);
+    live[slot]->payload[0] = i;
+  }
+  for (u32 i = 0; i < POOL_BENCH_LIVE_COUNT; ++i) {
+    pool_free(pool, live[i]);
+  }
+  result.pool_ms = elapsed_ms(start);
+  pool_shutdown(pool);
+  free_memory(pool);
+
+  rng = seed;
+  start = std::chrono::steady_clock::now();
+  for (u32 i = 0; i < POOL_BENCH_LIVE_COUNT; ++i) {
+    live[i] = (pool_bench_object*)malloc(sizeof(pool_bench_object));
+  }
+  for (u32 i = 0; i < POOL_BENCH_OPERATION_COUNT; ++i) {
+    const u32 slot = bench_next(&rng) % POOL_BENCH_LIVE_COUNT;
+    free(live[slot]);
+    live[slot] = (pool_bench_object*)malloc(sizeof(pool_bench_object));
+    live[slot]->payload[0] = i;
+  }
+  for (u32 i = 0; i < POOL_BENCH_LIVE_COUNT; ++i) {
+    free(live[i]);
+  }
+  result.malloc_ms = elapsed_ms(start);
+  return result;
+}
+
+static void churn_task(u32 begin, u32 end, void* data) {
+  pool_bench_result* results = (pool_bench_result*)data;
+  for (u32 i = begin; i < end; ++i) {
+    results[i] = run_churn(0x9e3779b9u * (i + 1));
+  }
+}
+
+void memory_pool_run_benchmark(void) {
+  const f64 ops = (f64)POOL_BENCH_OPERATION_COUNT;
+
+  const pool_bench_result single = run_churn(1u);
+  TRACELOG(LOG_INFO, "POOL: single thread, %u ops: pool %.2f ns/op, malloc %.2f ns/op",
+    POOL_BENCH_OPERATION_COUNT, single.pool_ms * 1e6 / ops, single.malloc_ms * 1e6 / ops);
+
+  // Every thread churns its own pool, malloc shares the process heap
+  const u32 thread_count = job_thread_count();
+  pool_bench_result* results = (pool_bench_result*)allocate_memory(sizeof(pool_bench_result) * thread_count, true, MEMORY_TAG_POOL);
+  const auto start = std::chrono::steady_clock::now();
+  job_parallel_for(thread_count, 1, churn_task, results);
+  const f64 wall_ms = elapsed_ms(start);
+
+  f64 pool_ms = 0.0;
+  f64 malloc_ms = 0.0;
+  for (u32 i = 0; i < thread_count; ++i) {
+    pool_ms += results[i].pool_ms;
+    malloc_ms += results[i].malloc_ms;
+  }
+  TRACELOG(LOG_INFO, "POOL: %u threads, %u ops each: pool %.2f ns/op, malloc %.2f ns/op, %.1f ms wall",
+    thread_count, POOL_BENCH_OPERATION_COUNT, pool_ms * 1e6 / (ops * thread_count), malloc_ms * 1e6 / (ops * thread_count), wall_ms);
+  free_memory(results);
+}
@@ -0,0 +1,306 @@
+#include "fprofile.h"
+
+#include <chrono>
+#include <stdio.h>  // Required for: fopen(), fprintf()
+#include <stdlib.h> // Required for: qsort()
+#include <string.h> // Required for: strcmp()
+#include <raylib.h>
+
+#include "core/fjob.h"
+#include "core/fmemory.h"
+
+#define PROFILE_PATH_MAX 256
+
+/**
+ * @brief One producer, the thread it belongs to, and one consumer, the main thread in profile_frame_end().
+ */
+typedef struct profile_ring {
+  profile_event events[PROFILE_RING_CAPACITY];
+  std::atomic<u64> write_position;
+  std::atomic<u64> read_position;
+  std::atomic<u64> dropped_count;
+} profile_ring;
+
+typedef struct profile_scope_history {
+  const char* name;
+  u32 depth;
+  bool gpu;
+  bool ran;      // This frame
+  f64 frame_ms;  // Summed over every run this frame
+  f32 samples[PROFILE_HISTORY];
+  u32 sample_count;
+  u32 next_sample;
+  u64 sampled_frame; // frame_index of the latest sample
+} profile_scope_history;
+
+typedef struct profile_system_state {
+  u32 thread_count;
+  profile_ring* rings;
+  u32 scope_count;
+  profile_scope_history scopes[PROFILE_MAX_SCOPES];
+  u64 frame_begin_ns;
+  u64 frame_index;
+  profile_event* capture_events;
+  u64 capture_count;
+  u64 capture_dropped;
+  u64 capture_begin_ns;
+  u32 capture_frames_left;
+  char capture_path[PROFILE_PATH_MAX];
+} profile_system_state;
+
+std::atomic<bool> profile_active(false);
+
+static profile_system_state * state = nullptr;
+static thread_local u32 scope_depth = 0;
+
+static void push_event(profile_ring* ring, const profile_event& event);
+static void consume_event(const profile_event& event);
+static void push_sample(profile_scope_history* scope, f32 ms);
+static void write_capture(void);
+static i32 compare_f32(const void* a, const void* b);
+
+bool profile_system_initialize(void) {
+  if (state and state != nullptr) {
+    return false;
+  }
+  state = (profile_system_state*)allocate_memory_linear(sizeof(profile_system_state), true, MEMORY_TAG_CORE);
+  state->thread_count = job_thread_count();
+  state->rings = (profile_ring*)allocate_memory(sizeof(profile_ring) * state->thread_count, true, MEMORY_TAG_CORE);
+  state->scopes[0].name = "frame";
+  state->scope_count = 1;
+  state->frame_begin_ns = profile_now_ns();
+  profile_active.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void profile_system_shutdown(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  profile_active.store(false, std::memory_order_relaxed);
+  if (state->capture_events) {
+    write_capture();
+  }
+  free_memory(state->rings);
+  state = nullptr;
+}
+
+void profile_set_enabled(bool enabled) {
+  profile_active.store(enabled and state, std::memory_order_relaxed);
+}
+
+u64 profile_now_ns(void) {
+  return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+u64 profile_push(void) {
+  ++scope_depth;
+  return profile_now_ns();
+}
+
+void profile_pop(const char* name, u64 begin_ns) {
+  const u64 end_ns = profile_now_ns();
+  --scope_depth;
+  const u32 thread = job_thread_index();
+  if (not state or thread >= state->thread_count) {
+    return;
+  }
+  push_event(&state->rings[thread], profile_event { name, begin_ns, end_ns, thread, scope_depth });
+}
+
+void profile_record_gpu(const char* name, u64 begin_ns, u64 end_ns, u32 depth) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  push_event(&state->rings[JOB_MAIN_THREAD_INDEX], profile_event { name, begin_ns, end_ns, PROFILE_GPU_THREAD, depth });
+}
+
+void profile_frame_end(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  const u64 now_ns = profile_now_ns();
+  for (u32 i = 0; i < state->thread_count; ++i) {
+    profile_ring* ring = &state->rings[i];
+    const u64 read = ring->read_position.load(std::memory_order_relaxed);
+    const u64 write = ring->write_position.load(std::memory_order_acquire);
+    for (u64 position = read; position < write; ++position) {
+      consume_event(ring->events[position % PROFILE_RING_CAPACITY]);
+    }
+    ring->read_position.store(write, std::memory_order_release);
+  }
+  const profile_event frame = profile_event { state->scopes[0].name, state->frame_begin_ns, now_ns, JOB_MAIN_THREAD_INDEX, 0 };
+  consume_event(frame);
+  state->frame_begin_ns = now_ns;
+
+  for (u32 i = 0; i < state->scope_count; ++i) {
+    profile_scope_history* scope = &state->scopes[i];
+    if (scope->ran) {
+      push_sample(scope, (f32)scope->frame_ms);
+      scope->sampled_frame = state->frame_index;
+    }
+    scope->ran = false;
+    scope->frame_ms = 0.0;
+  }
+  ++state->frame_index;
+  if (state->capture_events and --state->capture_frames_left == 0) {
+    write_capture();
+  }
+}
+
+u32 profile_get_scope_stats(profile_scope_stats* out, u32 capacity) {
+  if (not state or state == nullptr or not out) {
+    return 0;
+  }
+  f32 sorted[PROFILE_HISTORY];
+  u32 count = 0;
+  for (u32 i = 0; i < state->scope_count and count < capacity; ++i) {
+    const profile_scope_history* scope = &state->scopes[i];
+    if (scope->sample_count == 0) {
+      continue;
+    }
+    for (u32 s = 0; s < scope->sample_count; ++s) {
+      sorted[s] = scope->samples[s];
+    }
+    qsort(sorted, scope->sample_count, sizeof(f32), compare_f32);
+    const u32 last = scope->sample_count - 1;
+    profile_scope_stats& stats = out[count++];
+    stats.name = scope->name;
+    stats.depth = scope->depth;
+    stats.gpu = scope->gpu;
+    stats.last_ms = scope->samples[(scope->next_sample + PROFILE_HISTORY - 1) % PROFILE_HISTORY];
+    stats.p50_ms = sorted[(u32)(last * 0.50f)];
+    stats.p95_ms = sorted[(u32)(last * 0.95f)];
+    stats.p99_ms = sorted[(u32)(last * 0.99f)];
+    stats.max_ms = sorted[last];
+    stats.sample_count = scope->sample_count;
+  }
+  return count;
+}
+
+u32 profile_get_last_frame(profile_scope_stats* out, u32 capacity) {
+  if (not state or state == nullptr or not out or state->frame_index == 0) {
+    return 0;
+  }
+  u32 count = 0;
+  for (u32 i = 0; i < state->scope_count and count < capacity; ++i) {
+    const profile_scope_history* scope = &state->scopes[i];
+    if (scope->sample_count == 0 or scope->sampled_frame != state->frame_index - 1) {
+      continue;
+    }
+    profile_scope_stats& stats = out[count++];
+    stats = profile_scope_stats {};
+    stats.name = scope->name;
+    stats.depth = scope->depth;
+    stats.gpu = scope->gpu;
+    stats.last_ms = scope->samples[(scope->next_sample + PROFILE_HISTORY - 1) % PROFILE_HISTORY];
+    stats.sample_count = scope->sample_count;
+  }
+  return count;
+}
+
+bool profile_capture_begin(u32 frame_count, const char* path) {
+  if (not state or state == nullptr or state->capture_events or frame_count == 0 or not path) {
+    return false;
+  }
+  if (snprintf(state->capture_path, PROFILE_PATH_MAX, "%s", path) >= PROFILE_PATH_MAX) {
+    return false;
+  }
+  state->capture_events = (profile_event*)allocate_memory(sizeof(profile_event) * PROFILE_CAPTURE_MAX_EVENTS, false, MEMORY_TAG_CORE);
+  state->capture_count = 0;
+  state->capture_dropped = 0;
+  state->capture_begin_ns = profile_now_ns();
+  state->capture_frames_left = frame_count;
+  TRACELOG(LOG_INFO, "PROFILE: Capturing %u frames to %s", frame_count, path);
+  return true;
+}
+
+bool profile_is_capturing(void) {
+  return state and state->capture_events;
+}
+
+static void push_event(profile_ring* ring, const profile_event& event) {
+  const u64 write = ring->write_position.load(std::memory_order_relaxed);
+  if (write - ring->read_position.load(std::memory_order_acquire) >= PROFILE_RING_CAPACITY) {
+    ring->dropped_count.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  ring->events[write % PROFILE_RING_CAPACITY] = event;
+  ring->write_position.store(write + 1, std::memory_order_release);
+}
+
+static void consume_event(const profile_event& event) {
+  const bool gpu = event.thread == PROFILE_GPU_THREAD;
+  profile_scope_history* scope = nullptr;
+  for (u32 i = 0; i < state->scope_count; ++i) {
+    profile_scope_history* candidate = &state->scopes[i];
+    if (candidate->gpu == gpu and (candidate->name == event.name or strcmp(candidate->name, event.name) == 0)) {
+      scope = candidate;
+      break;
+    }
+  }
+  if (not scope and state->scope_count < PROFILE_MAX_SCOPES) {
+    scope = &state->scopes[state->scope_count++];
+    scope->name = event.name;
+    scope->gpu = gpu;
+    scope->depth = event.depth;
+  }
+  if (scope) {
+    scope->ran = true;
+    scope->frame_ms += (f64)(event.end_ns - event.begin_ns) / 1000000.0;
+  }
+  // GPU results arrive frames late, the ones older than the capture are left out
+  if (state->capture_events and event.end_ns >= state->capture_begin_ns) {
+    if (state->capture_count < PROFILE_CAPTURE_MAX_EVENTS) {
+      state->capture_events[state->capture_count++] = event;
+    } else {
+      ++state->capture_dropped;
+    }
+  }
+}
+
+static void push_sample(profile_scope_history* scope, f32 ms) {
+  scope->samples[scope->next_sample] = ms;
+  scope->next_sample = (scope->next_sample + 1) % PROFILE_HISTORY;
+  scope->sample_count = (scope->sample_count < PROFILE_HISTORY) ? scope->sample_count + 1 : PROFILE_HISTORY;
+}
+
+// Complete events ("ph":"X") in microseconds, one named track per job thread and one for the GPU
+static void write_capture(void) {
+  FILE* file = fopen(state->capture_path, "w");
+  if (file) {
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"gpu\"}}", PROFILE_GPU_THREAD);
+    for (u32 i = 0; i < state->thread_count; ++i) {
+      fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+        i, (i == JOB_MAIN_THREAD_INDEX) ? "main" : "worker", i);
+    }
+    for (u64 i = 0; i < state->capture_count; ++i) {
+      const profile_event& event = state->capture_events[i];
+      const f64 begin_us = ((f64)event.begin_ns - (f64)state->capture_begin_ns) / 1000.0;
+      fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", event.name,
+        (event.thread == PROFILE_GPU_THREAD) ? "gpu" : "cpu", event.thread, begin_us, (f64)(event.end_ns - event.begin_ns) / 1000.0);
+    }
+    fprintf(file, "\n]}\n");
+  }
+  const bool written = file and fclose(file) == 0;
+  u64 ring_dropped = 0;
+  for (u32 i = 0; i < state->thread_count; ++i) {
+    ring_dropped += state->rings[i].dropped_count.load(std::memory_order_relaxed);
+  }
+  if (written) {
+    TRACELOG(LOG_INFO, "PROFILE: Capture written to %s, %llu events, %llu over the capture limit, %llu dropped by full rings so far",
+      state->capture_path, state->capture_count, state->capture_dropped, ring_dropped);
+  } else {
+    TRACELOG(LOG_WARNING, "PROFILE: Capture couldn't be written to %s", state->capture_path);
+  }
+  free_memory(state->capture_events);
+  state->capture_events = nullptr;
+  state->capture_frames_left = 0;
+}
+
+static i32 compare_f32(const void* a, const void* b) {
+  const f32 left = *(const f32*)a;
+  const f32 right = *(const f32*)b;
+  return (left > right) - (left < right);
+}
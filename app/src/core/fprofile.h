@@ -0,0 +1,107 @@
+#ifndef FPROFILE_H
+#define FPROFILE_H
+
+#include "defines.h"
+
+#include <atomic>
+
+// 0 compiles every PROFILE_SCOPE() away
+#ifndef PROFILE_ENABLED
+#define PROFILE_ENABLED 1
+#endif
+
+#define PROFILE_MAX_SCOPES 64
+#define PROFILE_RING_CAPACITY 2048      // Events a thread can record between two profile_frame_end() calls
+#define PROFILE_HISTORY 128             // Frames behind the percentiles
+#define PROFILE_CAPTURE_MAX_EVENTS (256 * 1024)
+#define PROFILE_GPU_THREAD 1000         // Thread id of GPU events in captures
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+typedef struct profile_event {
+  const char* name; // Has to outlive the profiler, literals
+  u64 begin_ns;
+  u64 end_ns;
+  u32 thread;       // job_thread_index() or PROFILE_GPU_THREAD
+  u32 depth;
+} profile_event;
+
+/**
+ * @brief Per frame totals of one scope name, over the last PROFILE_HISTORY frames it ran in.
+ */
+typedef struct profile_scope_stats {
+  const char* name;
+  u32 depth;
+  bool gpu;
+  f32 last_ms;
+  f32 p50_ms;
+  f32 p95_ms;
+  f32 p99_ms;
+  f32 max_ms;
+  u32 sample_count;
+} profile_scope_stats;
+
+extern std::atomic<bool> profile_active;
+
+/**
+ * @brief After job_system_initialize(), every job thread gets its own event ring.
+ */
+[[__nodiscard__]] bool profile_system_initialize(void);
+void profile_system_shutdown(void);
+
+/**
+ * @brief Stopped scopes cost a relaxed load, the clock isn't read.
+ */
+void profile_set_enabled(bool enabled);
+u64 profile_now_ns(void);
+
+/**
+ * @brief Scope bookkeeping behind PROFILE_SCOPE(), any job thread. Foreign threads are ignored.
+ */
+u64 profile_push(void);
+void profile_pop(const char* name, u64 begin_ns);
+
+/**
+ * @brief Main thread. Times are already on the profile_now_ns() clock.
+ */
+void profile_record_gpu(const char* name, u64 begin_ns, u64 end_ns, u32 depth);
+
+/**
+ * @brief Main thread, once per frame. Drains the rings, updates the history and feeds an ongoing capture.
+ */
+void profile_frame_end(void);
+
+/**
+ * @brief Fills out in the order the scopes first ran, the first entry is the whole frame. Computes the percentiles, call it for display only.
+ */
+u32 profile_get_scope_stats(profile_scope_stats* out, u32 capacity);
+
+/**
+ * @brief The scopes the last profile_frame_end() took a sample of, only last_ms is set. Cheap enough for every frame.
+ */
+u32 profile_get_last_frame(profile_scope_stats* out, u32 capacity);
+
+/**
+ * @brief Records the next frame_count frames and writes them to path as Chrome trace JSON, it opens in Perfetto.
+ */
+bool profile_capture_begin(u32 frame_count, const char* path);
+bool profile_is_capturing(void);
+
+typedef struct profile_scope {
+  const char* name;
+  u64 begin_ns; // 0 while profiling is stopped
+  explicit profile_scope(const char* scope_name)
+    : name(scope_name), begin_ns(profile_active.load(std::memory_order_relaxed) ? profile_push() : 0) {}
+  ~profile_scope(void) { if (begin_ns != 0) profile_pop(name, begin_ns); }
+  profile_scope(const profile_scope&) = delete;
+  profile_scope& operator=(const profile_scope&) = delete;
+} profile_scope;
+
+#if PROFILE_ENABLED
+  #define PROFILE_SCOPE(name) profile_scope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#else
+  #define PROFILE_SCOPE(name) ((void)0)
+#endif
+
+#endif
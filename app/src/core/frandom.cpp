@@ -0,0 +1,208 @@
+#include "frandom.h"
+
+#include <atomic>
+
+#include "core/fjob.h"
+#include "core/fmemory.h"
+#include "core/fsimd.h"
+
+static_assert(RANDOM_BULK_LANE_COUNT % SIMD_LANE_COUNT == 0, "Bulk lanes must split evenly into simd registers");
+
+typedef struct random_thread_slot {
+  random_state state;
+  u32 seed_generation;
+} random_thread_slot;
+
+static std::atomic<u64> global_seed(RANDOM_DEFAULT_SEED);
+static std::atomic<u32> global_seed_generation(1);
+static std::atomic<u32> foreign_stream_index(JOB_MAX_WORKER_COUNT + 1);
+static thread_local random_thread_slot thread_slot = {};
+static thread_local u32 thread_stream_index = U32_MAX;
+
+static inline u32 rotl(u32 x, u32 k) {
+  return (x << k) | (x >> (32 - k));
+}
+
+static inline u64 splitmix64(u64* x) {
+  u64 z = (*x += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+// [1, 2) mantissa trick, top 23 bits of the output
+static inline f32 to_unit_f32(u32 bits) {
+  const u32 mantissa = (bits >> 9) | 0x3f800000u;
+  f32 value;
+  copy_memory(&value, &mantissa, sizeof(value));
+  return value - 1.f;
+}
+
+void random_seed(random_state* state, u64 seed) {
+  const u64 a = splitmix64(&seed);
+  const u64 b = splitmix64(&seed);
+  state->s[0] = (u32)a;
+  state->s[1] = (u32)(a >> 32);
+  state->s[2] = (u32)b;
+  state->s[3] = (u32)(b >> 32);
+  if ((state->s[0] | state->s[1] | state->s[2] | state->s[3]) == 0) {
+    state->s[0] = 1;
+  }
+}
+
+u32 random_next_u32(random_state* state) {
+  u32* s = state->s;
+  const u32 result = rotl(s[1] * 5, 7) * 9;
+  const u32 t = s[1] << 9;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 11);
+  return result;
+}
+
+void random_jump(random_state* state) {
+  static const u32 jump[4] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+  u32 s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  for (u32 i = 0; i < 4; ++i) {
+    for (u32 b = 0; b < 32; ++b) {
+      if (jump[i] & (1u << b)) {
+        s0 ^= state->s[0];
+        s1 ^= state->s[1];
+        s2 ^= state->s[2];
+        s3 ^= state->s[3];
+      }
+      random_next_u32(state);
+    }
+  }
+  state->s[0] = s0;
+  state->s[1] = s1;
+  state->s[2] = s2;
+  state->s[3] = s3;
+}
+
+f32 random_next_f32(random_state* state) {
+  return to_unit_f32(random_next_u32(state));
+}
+
+i32 random_range_i32(random_state* state, i32 min, i32 max) {
+  if (max <= min) {
+    return min;
+  }
+  const u64 range = (u64)((i64)max - (i64)min) + 1;
+  if (range > U32_MAX) {
+    return (i32)((i64)min + random_next_u32(state));
+  }
+  // Lemire's multiply-shift, the rejection only triggers for the few values that would bias the result
+  u64 product = (u64)random_next_u32(state) * range;
+  u32 low = (u32)product;
+  if (low < range) {
+    const u32 threshold = (u32)((0x100000000ull - range) % range);
+    while (low < threshold) {
+      product = (u64)random_next_u32(state) * range;
+      low = (u32)product;
+    }
+  }
+  return (i32)((i64)min + (i64)(product >> 32));
+}
+
+f32 random_range_f32(random_state* state, f32 min, f32 max) {
+  return min + (max - min) * random_next_f32(state);
+}
+
+random_state* random_thread_state(void) {
+  const u32 generation = global_seed_generation.load(std::memory_order_acquire);
+  if (thread_slot.seed_generation != generation) {
+    if (thread_stream_index == U32_MAX) {
+      const u32 job_index = job_thread_index();
+      thread_stream_index = (job_index != U32_MAX) ? job_index : foreign_stream_index.fetch_add(1, std::memory_order_relaxed);
+    }
+    random_seed(&thread_slot.state, global_seed.load(std::memory_order_relaxed));
+    for (u32 i = 0; i < thread_stream_index; ++i) {
+      random_jump(&thread_slot.state);
+    }
+    thread_slot.seed_generation = generation;
+  }
+  return &thread_slot.state;
+}
+
+void random_set_global_seed(u64 seed) {
+  global_seed.store(seed, std::memory_order_relaxed);
+  global_seed_generation.fetch_add(1, std::memory_order_release);
+}
+
+void random_bulk_seed(random_bulk_state* state, u64 seed) {
+  random_state lane;
+  random_seed(&lane, seed);
+  for (u32 k = 0; k < RANDOM_BULK_LANE_COUNT; ++k) {
+    for (u32 w = 0; w < 4; ++w) {
+      state->s[w][k] = lane.s[w];
+    }
+    random_jump(&lane);
+  }
+}
+
+/**
+ * @brief Output block b holds one value per lane, out[b * RANDOM_BULK_LANE_COUNT + k]. Each register group keeps its
+ * state in registers for the whole call.
+ */
+template <bool TO_FLOAT>
+static void fill_blocks(random_bulk_state* state, void* out, u64 block_count, f32 min, f32 scale) {
+  for (u32 g = 0; g < RANDOM_BULK_LANE_COUNT; g += SIMD_LANE_COUNT) {
+    simd_u32 s0 = simd_u32_load(&state->s[0][g]);
+    simd_u32 s1 = simd_u32_load(&state->s[1][g]);
+    simd_u32 s2 = simd_u32_load(&state->s[2][g]);
+    simd_u32 s3 = simd_u32_load(&state->s[3][g]);
+    const simd_u32 five = simd_u32_set1(5);
+    const simd_u32 nine = simd_u32_set1(9);
+
+    for (u64 b = 0; b < block_count; ++b) {
+      const simd_u32 result = simd_u32_mul(simd_u32_rotl(simd_u32_mul(s1, five), 7), nine);
+      const simd_u32 t = simd_u32_shl(s1, 9);
+      s2 = simd_u32_xor(s2, s0);
+      s3 = simd_u32_xor(s3, s1);
+      s1 = simd_u32_xor(s1, s2);
+      s0 = simd_u32_xor(s0, s3);
+      s2 = simd_u32_xor(s2, t);
+      s3 = simd_u32_rotl(s3, 11);
+
+      const u64 index = b * RANDOM_BULK_LANE_COUNT + g;
+      if constexpr (TO_FLOAT) {
+        const simd_u32 mantissa = simd_u32_or(simd_u32_shr(result, 9), simd_u32_set1(0x3f800000u));
+        const simd_f32 unit = simd_sub(simd_u32_to_f32_bits(mantissa), simd_set1(1.f));
+        simd_store((f32*)out + index, simd_madd(unit, simd_set1(scale), simd_set1(min)));
+      }
+      else {
+        simd_u32_store((u32*)out + index, result);
+      }
+    }
+    simd_u32_store(&state->s[0][g], s0);
+    simd_u32_store(&state->s[1][g], s1);
+    simd_u32_store(&state->s[2][g], s2);
+    simd_u32_store(&state->s[3][g], s3);
+  }
+}
+
+void random_fill_u32(random_bulk_state* state, u32* out, u64 count) {
+  const u64 full_blocks = count / RANDOM_BULK_LANE_COUNT;
+  fill_blocks<false>(state, out, full_blocks, 0.f, 0.f);
+  const u64 tail = count - full_blocks * RANDOM_BULK_LANE_COUNT;
+  if (tail > 0) {
+    u32 block[RANDOM_BULK_LANE_COUNT];
+    fill_blocks<false>(state, block, 1, 0.f, 0.f);
+    copy_memory(out + full_blocks * RANDOM_BULK_LANE_COUNT, block, tail * sizeof(u32));
+  }
+}
+
+void random_fill_f32(random_bulk_state* state, f32* out, u64 count, f32 min, f32 max) {
+  const u64 full_blocks = count / RANDOM_BULK_LANE_COUNT;
+  fill_blocks<true>(state, out, full_blocks, min, max - min);
+  const u64 tail = count - full_blocks * RANDOM_BULK_LANE_COUNT;
+  if (tail > 0) {
+    f32 block[RANDOM_BULK_LANE_COUNT];
+    fill_blocks<true>(state, block, 1, min, max - min);
+    copy_memory(out + full_blocks * RANDOM_BULK_LANE_COUNT, block, tail * sizeof(f32));
+  }
+}
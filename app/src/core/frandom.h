@@ -0,0 +1,67 @@
+#ifndef FRANDOM_H
+#define FRANDOM_H
+
+#include "defines.h"
+
+#define RANDOM_DEFAULT_SEED 0x5eed1337c0ffeeull
+#define RANDOM_BULK_LANE_COUNT 8
+
+/**
+ * @brief xoshiro128** state. 2^128 - 1 period, random_jump() skips 2^64 outputs so jumped copies never overlap in practice.
+ */
+typedef struct random_state {
+  u32 s[4];
+} random_state;
+
+/**
+ * @brief RANDOM_BULK_LANE_COUNT interleaved xoshiro128** streams, lane k is the scalar stream of the same seed jumped k times.
+ * The lane count is fixed, so output is bit-identical on AVX2, SSE2 and scalar builds.
+ */
+typedef struct random_bulk_state {
+  alignas(32) u32 s[4][RANDOM_BULK_LANE_COUNT];
+} random_bulk_state;
+
+void random_seed(random_state* state, u64 seed);
+void random_jump(random_state* state);
+
+u32 random_next_u32(random_state* state);
+
+/**
+ * @brief Uniform in [0, 1), 23 bits of resolution.
+ */
+f32 random_next_f32(random_state* state);
+
+/**
+ * @brief Uniform in [min, max], inclusive and unbiased.
+ */
+i32 random_range_i32(random_state* state, i32 min, i32 max);
+/**
+ * @brief Uniform in [min, max), scaled from random_next_f32().
+ */
+f32 random_range_f32(random_state* state, f32 min, f32 max);
+
+/**
+ * @brief Generator of the calling thread. Job threads get stream job_thread_index() of the global seed,
+ * other threads the streams after them, so parallel jobs never share or overlap a sequence.
+ */
+random_state* random_thread_state(void);
+
+/**
+ * @brief Reseeds every thread's stream, each thread picks it up on its next random_thread_state().
+ */
+void random_set_global_seed(u64 seed);
+
+void random_bulk_seed(random_bulk_state* state, u64 seed);
+void random_fill_u32(random_bulk_state* state, u32* out, u64 count);
+
+/**
+ * @brief Uniform in [min, max). Same sequence as random_fill_u32 mapped through random_next_f32's conversion.
+ */
+void random_fill_f32(random_bulk_state* state, f32* out, u64 count, f32 min, f32 max);
+
+/**
+ * @brief Logs scalar and bulk throughput, then runs distribution, correlation and stream consistency checks.
+ */
+void random_run_benchmark(void);
+
+#endif
@@ -0,0 +1,153 @@
+#include "frandom.h"
+
+#include <raylib.h>
+#include <chrono>
+#include <math.h>
+#include <stdlib.h> // Required for: rand()
+
+#include "core/fmemory.h"
+
+#define RANDOM_BENCH_COUNT (16u * 1024u * 1024u)
+#define RANDOM_CHI_BUCKETS 256
+// 255 degrees of freedom, mean 255 and sd ~22.6. 5 sd either side still flags a broken generator.
+#define RANDOM_CHI_LOW 142.0
+#define RANDOM_CHI_HIGH 368.0
+
+static f64 elapsed_ms(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void run_throughput(u32* buffer_u32, f32* buffer_f32) {
+  random_state state;
+  random_seed(&state, 1);
+  u32 sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (u32 i = 0; i < RANDOM_BENCH_COUNT; ++i) {
+    sink ^= random_next_u32(&state);
+  }
+  const f64 scalar_ms = elapsed_ms(start);
+
+  start = std::chrono::steady_clock::now();
+  for (u32 i = 0; i < RANDOM_BENCH_COUNT; ++i) {
+    sink ^= (u32)rand();
+  }
+  const f64 crt_ms = elapsed_ms(start);
+
+  random_bulk_state bulk;
+  random_bulk_seed(&bulk, 1);
+  start = std::chrono::steady_clock::now();
+  random_fill_u32(&bulk, buffer_u32, RANDOM_BENCH_COUNT);
+  const f64 bulk_u32_ms = elapsed_ms(start);
+
+  start = std::chrono::steady_clock::now();
+  random_fill_f32(&bulk, buffer_f32, RANDOM_BENCH_COUNT, -10.f, 10.f);
+  const f64 bulk_f32_ms = elapsed_ms(start);
+
+  const f64 millions = RANDOM_BENCH_COUNT / 1e6;
+  TRACELOG(LOG_INFO, "RANDOM: M values/s, scalar u32 %.0f, rand() %.0f, bulk u32 %.0f, bulk f32 %.0f (sink %u)",
+    millions / (scalar_ms / 1000.0), millions / (crt_ms / 1000.0), millions / (bulk_u32_ms / 1000.0), millions / (bulk_f32_ms / 1000.0), sink);
+}
+
+static bool check(bool passed, const char* name, f64 value) {
+  TRACELOG(passed ? LOG_INFO : LOG_ERROR, "RANDOM: %s %s (%.6f)", passed ? "pass" : "FAIL", name, value);
+  return passed;
+}
+
+static bool run_sanity(u32* buffer_u32, f32* buffer_f32) {
+  bool passed = true;
+  random_bulk_state bulk;
+  random_bulk_seed(&bulk, 42);
+  random_fill_u32(&bulk, buffer_u32, RANDOM_BENCH_COUNT);
+
+  // Top byte histogram
+  u64 buckets[RANDOM_CHI_BUCKETS] = {};
+  for (u32 i = 0; i < RANDOM_BENCH_COUNT; ++i) {
+    buckets[buffer_u32[i] >> 24]++;
+  }
+  const f64 expected = (f64)RANDOM_BENCH_COUNT / RANDOM_CHI_BUCKETS;
+  f64 chi = 0.0;
+  for (u32 i = 0; i < RANDOM_CHI_BUCKETS; ++i) {
+    chi += ((f64)buckets[i] - expected) * ((f64)buckets[i] - expected) / expected;
+  }
+  passed &= check(chi > RANDOM_CHI_LOW and chi < RANDOM_CHI_HIGH, "chi-square of the top byte", chi);
+
+  // Every bit should be set half of the time
+  f64 worst_bit = 0.0;
+  for (u32 bit = 0; bit < 32; ++bit) {
+    u64 ones = 0;
+    for (u32 i = 0; i < RANDOM_BENCH_COUNT; ++i) {
+      ones += (buffer_u32[i] >> bit) & 1u;
+    }
+    worst_bit = fmax(worst_bit, fabs((f64)ones / RANDOM_BENCH_COUNT - 0.5));
+  }
+  passed &= check(worst_bit < 0.001, "per bit balance, worst deviation", worst_bit);
+
+  // Mean, variance and lag-1 correlation of the float conversion, U(0,1) has 1/2 and 1/12
+  random_fill_f32(&bulk, buffer_f32, RANDOM_BENCH_COUNT, 0.f, 1.f);
+  f64 sum = 0.0, sum_sqr = 0.0, sum_lag = 0.0;
+  f32 min_value = 1.f, max_value = 0.f;
+  for (u32 i = 0; i < RANDOM_BENCH_COUNT; ++i) {
+    const f64 v = buffer_f32[i];
+    sum += v;
+    sum_sqr += v * v;
+    if (i > 0) sum_lag += v * buffer_f32[i - 1];
+    min_value = fminf(min_value, buffer_f32[i]);
+    max_value = fmaxf(max_value, buffer_f32[i]);
+  }
+  const f64 mean = sum / RANDOM_BENCH_COUNT;
+  const f64 variance = sum_sqr / RANDOM_BENCH_COUNT - mean * mean;
+  const f64 correlation = (sum_lag / (RANDOM_BENCH_COUNT - 1) - mean * mean) / variance;
+  passed &= check(fabs(mean - 0.5) < 0.001, "float mean", mean);
+  passed &= check(fabs(variance - 1.0 / 12.0) < 0.001, "float variance", variance);
+  passed &= check(fabs(correlation) < 0.002, "lag-1 correlation", correlation);
+  passed &= check(min_value >= 0.f and max_value < 1.f, "float range [0, 1)", max_value);
+
+  // Lane k of the bulk generator must be the scalar stream jumped k times, and f32 must follow u32
+  random_bulk_state lanes;
+  random_bulk_seed(&lanes, 7);
+  u32 block[RANDOM_BULK_LANE_COUNT * 4];
+  random_fill_u32(&lanes, block, RANDOM_BULK_LANE_COUNT * 4);
+  random_state scalar;
+  random_seed(&scalar, 7);
+  bool lanes_match = true;
+  for (u32 k = 0; k < RANDOM_BULK_LANE_COUNT; ++k) {
+    random_state lane = scalar;
+    for (u32 j = 0; j < 4; ++j) {
+      lanes_match &= block[j * RANDOM_BULK_LANE_COUNT + k] == random_next_u32(&lane);
+    }
+    random_jump(&scalar);
+  }
+  random_bulk_seed(&lanes, 7);
+  f32 floats[RANDOM_BULK_LANE_COUNT * 4];
+  random_fill_f32(&lanes, floats, RANDOM_BULK_LANE_COUNT * 4, -3.f, 5.f);
+  random_seed(&scalar, 7);
+  random_state first_lane = scalar;
+  for (u32 j = 0; j < 4; ++j) {
+    lanes_match &= floats[j * RANDOM_BULK_LANE_COUNT] == random_range_f32(&first_lane, -3.f, 5.f);
+  }
+  passed &= check(lanes_match, "bulk lanes match jumped scalar streams", 0.0);
+
+  // Small inclusive range hits both ends evenly
+  random_state range_state;
+  random_seed(&range_state, 3);
+  u32 faces[6] = {};
+  for (u32 i = 0; i < 600000; ++i) {
+    faces[random_range_i32(&range_state, 1, 6) - 1]++;
+  }
+  f64 worst_face = 0.0;
+  for (u32 i = 0; i < 6; ++i) {
+    worst_face = fmax(worst_face, fabs(faces[i] / 100000.0 - 1.0));
+  }
+  passed &= check(worst_face < 0.02, "random_range_i32(1, 6) uniformity", worst_face);
+  return passed;
+}
+
+void random_run_benchmark(void) {
+  u32* buffer_u32 = (u32*)allocate_memory(RANDOM_BENCH_COUNT * sizeof(u32), false, MEMORY_TAG_CORE);
+  f32* buffer_f32 = (f32*)allocate_memory(RANDOM_BENCH_COUNT * sizeof(f32), false, MEMORY_TAG_CORE);
+  run_throughput(buffer_u32, buffer_f32);
+  const bool passed = run_sanity(buffer_u32, buffer_f32);
+  TRACELOG(passed ? LOG_INFO : LOG_ERROR, "RANDOM: statistical sanity checks %s", passed ? "passed" : "FAILED");
+  free_memory(buffer_f32);
+  free_memory(buffer_u32);
+}
@@ -0,0 +1,682 @@
+#include "fsdf.h"
+
+#include <math.h>
+
+#include "core/fjob.h"
+#include "core/fsimd.h"
+
+#define SDF_ROWS_PER_TASK 4
+#define SDF_PACKETS_PER_TASK 64
+#define SDF_NORMAL_EPSILON (0.5773f * 0.0005f)
+
+/**
+ * @brief Everything below mirrors the GLSL line by line on simd lanes. Expressions keep the shader's operand order
+ * so a single lane and a full packet give identical results. Transcendentals go through libm one lane at a time.
+ */
+typedef struct lane_v3 {
+  simd_f32 x;
+  simd_f32 y;
+  simd_f32 z;
+} lane_v3;
+
+typedef struct lane_sample {
+  simd_f32 d;
+  simd_f32 m;
+} lane_sample;
+
+typedef struct sdf_batch_context {
+  sdf_scene scene;
+  vec3_soa positions;
+  vec3_soa directions;
+  f32* distance;
+  f32* material;
+  u32 count;
+} sdf_batch_context;
+
+typedef struct sdf_render_context {
+  Color* pixels;
+  i32 width;
+  i32 height;
+  Vector3 eye;
+  Vector3 cu;
+  Vector3 cv;
+  Vector3 cw;
+  Vector3 light;
+  Vector3 back_light;
+} sdf_render_context;
+
+template <typename FN>
+static inline simd_f32 lanes_apply(simd_f32 a, FN fn) {
+  alignas(32) f32 v[SIMD_LANE_COUNT];
+  simd_store(v, a);
+  for (u32 i = 0; i < SIMD_LANE_COUNT; ++i) v[i] = fn(v[i]);
+  return simd_load(v);
+}
+template <typename FN>
+static inline simd_f32 lanes_apply2(simd_f32 a, simd_f32 b, FN fn) {
+  alignas(32) f32 va[SIMD_LANE_COUNT];
+  alignas(32) f32 vb[SIMD_LANE_COUNT];
+  simd_store(va, a);
+  simd_store(vb, b);
+  for (u32 i = 0; i < SIMD_LANE_COUNT; ++i) va[i] = fn(va[i], vb[i]);
+  return simd_load(va);
+}
+static inline f32 lane_first(simd_f32 a) {
+  alignas(32) f32 v[SIMD_LANE_COUNT];
+  simd_store(v, a);
+  return v[0];
+}
+static inline simd_f32 lanes_load(const f32* src, u32 lanes) {
+  if (lanes == SIMD_LANE_COUNT) {
+    return simd_load(src);
+  }
+  alignas(32) f32 padded[SIMD_LANE_COUNT] = {};
+  for (u32 i = 0; i < lanes; ++i) padded[i] = src[i];
+  return simd_load(padded);
+}
+static inline void lanes_store(f32* dst, u32 lanes, simd_f32 v) {
+  if (lanes == SIMD_LANE_COUNT) {
+    simd_store(dst, v);
+    return;
+  }
+  alignas(32) f32 padded[SIMD_LANE_COUNT];
+  simd_store(padded, v);
+  for (u32 i = 0; i < lanes; ++i) dst[i] = padded[i];
+}
+
+static inline simd_f32 mask_all(void) { return simd_less(simd_set1(0.f), simd_set1(1.f)); }
+static inline simd_f32 mask_none(void) { return simd_set1(0.f); }
+static inline simd_f32 mask_andnot(simd_f32 mask, simd_f32 remove) { return simd_select(remove, mask_none(), mask); }
+static inline simd_f32 mask_first_lanes(u32 lanes) { return simd_less(simd_lane_index(), simd_set1((f32)lanes)); }
+
+static inline simd_f32 neg(simd_f32 a) { return simd_sub(simd_set1(0.f), a); }
+static inline simd_f32 clamp01(simd_f32 a) { return simd_clamp(a, simd_set1(0.f), simd_set1(1.f)); }
+static inline simd_f32 fract(simd_f32 a) { return simd_sub(a, simd_floor(a)); }
+static inline simd_f32 glsl_mod(simd_f32 x, f32 y) { return simd_sub(x, simd_mul(simd_set1(y), simd_floor(simd_div(x, simd_set1(y))))); }
+static inline simd_f32 pow_lanes(simd_f32 a, f32 e) { return lanes_apply(a, [e](f32 v) { return powf(v, e); }); }
+static inline simd_f32 sin_lanes(simd_f32 a) { return lanes_apply(a, [](f32 v) { return sinf(v); }); }
+static inline simd_f32 smoothstep(f32 e0, f32 e1, simd_f32 x) {
+  const simd_f32 t = clamp01(simd_div(simd_sub(x, simd_set1(e0)), simd_set1(e1 - e0)));
+  return simd_mul(simd_mul(t, t), simd_sub(simd_set1(3.f), simd_mul(simd_set1(2.f), t)));
+}
+
+static inline lane_v3 v3_set(f32 x, f32 y, f32 z) { return lane_v3 { simd_set1(x), simd_set1(y), simd_set1(z) }; }
+static inline lane_v3 v3_set(Vector3 v) { return v3_set(v.x, v.y, v.z); }
+static inline lane_v3 v3_add(lane_v3 a, lane_v3 b) { return lane_v3 { simd_add(a.x, b.x), simd_add(a.y, b.y), simd_add(a.z, b.z) }; }
+static inline lane_v3 v3_sub(lane_v3 a, lane_v3 b) { return lane_v3 { simd_sub(a.x, b.x), simd_sub(a.y, b.y), simd_sub(a.z, b.z) }; }
+static inline lane_v3 v3_scale(lane_v3 a, simd_f32 s) { return lane_v3 { simd_mul(a.x, s), simd_mul(a.y, s), simd_mul(a.z, s) }; }
+static inline lane_v3 v3_abs(lane_v3 a) { return lane_v3 { simd_abs(a.x), simd_abs(a.y), simd_abs(a.z) }; }
+static inline lane_v3 v3_max0(lane_v3 a) {
+  const simd_f32 zero = simd_set1(0.f);
+  return lane_v3 { simd_max(a.x, zero), simd_max(a.y, zero), simd_max(a.z, zero) };
+}
+static inline lane_v3 v3_select(simd_f32 mask, lane_v3 a, lane_v3 b) {
+  return lane_v3 { simd_select(mask, a.x, b.x), simd_select(mask, a.y, b.y), simd_select(mask, a.z, b.z) };
+}
+static inline simd_f32 dot3(lane_v3 a, lane_v3 b) { return simd_add(simd_add(simd_mul(a.x, b.x), simd_mul(a.y, b.y)), simd_mul(a.z, b.z)); }
+static inline simd_f32 len2(simd_f32 x, simd_f32 y) { return simd_sqrt(simd_add(simd_mul(x, x), simd_mul(y, y))); }
+static inline simd_f32 len3(lane_v3 a) { return simd_sqrt(dot3(a, a)); }
+static inline lane_v3 v3_normalize(lane_v3 a) {
+  const simd_f32 l = len3(a);
+  return lane_v3 { simd_div(a.x, l), simd_div(a.y, l), simd_div(a.z, l) };
+}
+// ro + rd * t
+static inline lane_v3 v3_along(lane_v3 ro, lane_v3 rd, simd_f32 t) { return v3_add(ro, v3_scale(rd, t)); }
+static inline lane_v3 at(lane_v3 p, f32 x, f32 y, f32 z) { return v3_sub(p, v3_set(x, y, z)); }
+// length(max(vec2(d1, d2), 0.0)) + min(max(d1, d2), 0.0)
+static inline simd_f32 combine(simd_f32 d1, simd_f32 d2) {
+  const simd_f32 zero = simd_set1(0.f);
+  return simd_add(len2(simd_max(d1, zero), simd_max(d2, zero)), simd_min(simd_max(d1, d2), zero));
+}
+
+// Primitives --------------------------------------------------------------------------------------------------------
+
+static inline simd_f32 sd_plane(lane_v3 p) {
+  return p.y;
+}
+static inline simd_f32 sd_sphere(lane_v3 p, f32 s) {
+  return simd_sub(len3(p), simd_set1(s));
+}
+static inline simd_f32 sd_box(lane_v3 p, f32 bx, f32 by, f32 bz) {
+  const lane_v3 d = v3_sub(v3_abs(p), v3_set(bx, by, bz));
+  return simd_add(simd_min(simd_max(d.x, simd_max(d.y, d.z)), simd_set1(0.f)), len3(v3_max0(d)));
+}
+static inline simd_f32 sd_ellipsoid(lane_v3 p, f32 rx, f32 ry, f32 rz) {
+  const lane_v3 q = lane_v3 { simd_div(p.x, simd_set1(rx)), simd_div(p.y, simd_set1(ry)), simd_div(p.z, simd_set1(rz)) };
+  return simd_mul(simd_sub(len3(q), simd_set1(1.f)), simd_set1(fminf(fminf(rx, ry), rz)));
+}
+static inline simd_f32 ud_round_box(lane_v3 p, f32 b, f32 r) {
+  return simd_sub(len3(v3_max0(v3_sub(v3_abs(p), v3_set(b, b, b)))), simd_set1(r));
+}
+static inline simd_f32 sd_torus(lane_v3 p, f32 tx, f32 ty) {
+  return simd_sub(len2(simd_sub(len2(p.x, p.z), simd_set1(tx)), p.y), simd_set1(ty));
+}
+static inline simd_f32 sd_hex_prism(lane_v3 p, f32 hx, f32 hy) {
+  const lane_v3 q = v3_abs(p);
+  const simd_f32 d1 = simd_sub(q.z, simd_set1(hy));
+  const simd_f32 d2 = simd_sub(simd_max(simd_add(simd_mul(q.x, simd_set1(0.866025f)), simd_mul(q.y, simd_set1(0.5f))), q.y), simd_set1(hx));
+  return combine(d1, d2);
+}
+static inline simd_f32 sd_capsule(lane_v3 p, Vector3 a, Vector3 b, f32 r) {
+  const lane_v3 pa = v3_sub(p, v3_set(a));
+  const lane_v3 ba = v3_set(b.x - a.x, b.y - a.y, b.z - a.z);
+  const simd_f32 h = clamp01(simd_div(dot3(pa, ba), dot3(ba, ba)));
+  return simd_sub(len3(v3_sub(pa, v3_scale(ba, h))), simd_set1(r));
+}
+static inline simd_f32 sd_tri_prism(lane_v3 p, f32 hx, f32 hy) {
+  const lane_v3 q = v3_abs(p);
+  const simd_f32 d1 = simd_sub(q.z, simd_set1(hy));
+  const simd_f32 d2 = simd_sub(simd_max(simd_add(simd_mul(q.x, simd_set1(0.866025f)), simd_mul(p.y, simd_set1(0.5f))), neg(p.y)), simd_set1(hx * 0.5f));
+  return combine(d1, d2);
+}
+static inline simd_f32 sd_cylinder(lane_v3 p, f32 hx, f32 hy) {
+  const simd_f32 dx = simd_sub(simd_abs(len2(p.x, p.z)), simd_set1(hx));
+  const simd_f32 dy = simd_sub(simd_abs(p.y), simd_set1(hy));
+  const simd_f32 zero = simd_set1(0.f);
+  return simd_add(simd_min(simd_max(dx, dy), zero), len2(simd_max(dx, zero), simd_max(dy, zero)));
+}
+static inline simd_f32 sd_cone(lane_v3 p, f32 cx, f32 cy, f32 cz) {
+  const simd_f32 qx = len2(p.x, p.z);
+  const simd_f32 qy = p.y;
+  const simd_f32 d1 = simd_sub(neg(qy), simd_set1(cz));
+  const simd_f32 d2 = simd_max(simd_add(simd_mul(qx, simd_set1(cx)), simd_mul(qy, simd_set1(cy))), qy);
+  return combine(d1, d2);
+}
+static inline simd_f32 sd_cone_section(lane_v3 p, f32 h, f32 r1, f32 r2) {
+  const simd_f32 d1 = simd_sub(neg(p.y), simd_set1(h));
+  const simd_f32 q = simd_sub(p.y, simd_set1(h));
+  const f32 si = 0.5f * (r1 - r2) / h;
+  const simd_f32 xz = simd_add(simd_mul(p.x, p.x), simd_mul(p.z, p.z));
+  const simd_f32 d2 = simd_max(simd_sub(simd_add(simd_sqrt(simd_mul(xz, simd_set1(1.f - si * si))), simd_mul(q, simd_set1(si))), simd_set1(r2)), q);
+  return combine(d1, d2);
+}
+static inline simd_f32 sd_pyramid4(lane_v3 p, f32 hx, f32 hy, f32 hz) {
+  // Tetrahedron = Octahedron - Cube
+  const simd_f32 box = sd_box(at(p, 0.f, -2.f * hz, 0.f), 2.f * hz, 2.f * hz, 2.f * hz);
+  simd_f32 d = simd_set1(0.f);
+  d = simd_max(d, simd_abs(dot3(p, v3_set(-hx, hy, 0.f))));
+  d = simd_max(d, simd_abs(dot3(p, v3_set(hx, hy, 0.f))));
+  d = simd_max(d, simd_abs(dot3(p, v3_set(0.f, hy, hx))));
+  d = simd_max(d, simd_abs(dot3(p, v3_set(0.f, hy, -hx))));
+  const simd_f32 octa = simd_sub(d, simd_set1(hz));
+  return simd_max(neg(box), octa);
+}
+static inline simd_f32 length6(simd_f32 x, simd_f32 y) {
+  x = simd_mul(simd_mul(x, x), x);
+  y = simd_mul(simd_mul(y, y), y);
+  x = simd_mul(x, x);
+  y = simd_mul(y, y);
+  return pow_lanes(simd_add(x, y), 1.f / 6.f);
+}
+static inline simd_f32 length8(simd_f32 x, simd_f32 y) {
+  x = simd_mul(x, x); y = simd_mul(y, y);
+  x = simd_mul(x, x); y = simd_mul(y, y);
+  x = simd_mul(x, x); y = simd_mul(y, y);
+  return pow_lanes(simd_add(x, y), 1.f / 8.f);
+}
+static inline simd_f32 sd_torus82(lane_v3 p, f32 tx, f32 ty) {
+  return simd_sub(length8(simd_sub(len2(p.x, p.z), simd_set1(tx)), p.y), simd_set1(ty));
+}
+static inline simd_f32 sd_torus88(lane_v3 p, f32 tx, f32 ty) {
+  return simd_sub(length8(simd_sub(length8(p.x, p.z), simd_set1(tx)), p.y), simd_set1(ty));
+}
+static inline simd_f32 sd_cylinder6(lane_v3 p, f32 hx, f32 hy) {
+  return simd_max(simd_sub(length6(p.x, p.z), simd_set1(hx)), simd_sub(simd_abs(p.y), simd_set1(hy)));
+}
+static inline simd_f32 sd_horseshoe(lane_v3 p, f32 cx, f32 cy, f32 r, f32 le, f32 wx, f32 wy) {
+  const simd_f32 zero = simd_set1(0.f);
+  simd_f32 px = simd_abs(p.x);
+  simd_f32 py = p.y;
+  const simd_f32 l = len2(px, py);
+  const simd_f32 rx = simd_add(simd_mul(simd_set1(-cx), px), simd_mul(simd_set1(cy), py));
+  const simd_f32 ry = simd_add(simd_mul(simd_set1(cy), px), simd_mul(simd_set1(cx), py));
+  const f32 sign_cx = (-cx > 0.f) ? 1.f : ((-cx < 0.f) ? -1.f : 0.f);
+  const simd_f32 x_positive = simd_less(zero, rx);
+  px = simd_select(simd_or(simd_less(zero, ry), x_positive), rx, simd_mul(l, simd_set1(sign_cx)));
+  py = simd_select(x_positive, ry, l);
+  px = simd_sub(px, simd_set1(le));
+  py = simd_abs(simd_sub(py, simd_set1(r)));
+  const simd_f32 qx = simd_add(len2(simd_max(px, zero), simd_max(py, zero)), simd_min(zero, simd_max(px, py)));
+  const simd_f32 dx = simd_sub(simd_abs(qx), simd_set1(wx));
+  const simd_f32 dy = simd_sub(simd_abs(p.z), simd_set1(wy));
+  return simd_add(simd_min(simd_max(dx, dy), zero), len2(simd_max(dx, zero), simd_max(dy, zero)));
+}
+static inline simd_f32 sd_six_way_cut_hollow_sphere(lane_v3 p, f32 r, f32 h, f32 t) {
+  // Six way symmetry transformation
+  const lane_v3 ap = v3_abs(p);
+  const simd_f32 fold = simd_less(ap.x, simd_max(ap.y, ap.z));
+  const simd_f32 z_largest = simd_less(ap.y, ap.z);
+  const simd_f32 x = simd_select(fold, simd_select(z_largest, ap.z, ap.y), ap.x);
+  const simd_f32 y = simd_select(fold, simd_select(z_largest, ap.y, ap.x), ap.y);
+  const simd_f32 z = simd_select(fold, simd_select(z_largest, ap.x, ap.z), ap.z);
+
+  const simd_f32 qx = len2(y, z);
+  const simd_f32 qy = x;
+  const f32 w = sqrtf(r * r - h * h);
+  const simd_f32 rim = len2(simd_sub(qx, simd_set1(w)), simd_sub(qy, simd_set1(h)));
+  const simd_f32 shell = simd_abs(simd_sub(len2(qx, qy), simd_set1(r)));
+  return simd_sub(simd_select(simd_less(simd_mul(simd_set1(h), qx), simd_mul(simd_set1(w), qy)), rim, shell), simd_set1(t));
+}
+
+static inline simd_f32 op_subtract(simd_f32 d1, simd_f32 d2) {
+  return simd_max(neg(d2), d1);
+}
+static inline void op_union(lane_sample* res, simd_f32 d, f32 material) {
+  const simd_f32 keep = simd_less(res->d, d);
+  res->d = simd_select(keep, res->d, d);
+  res->m = simd_select(keep, res->m, simd_set1(material));
+}
+static inline lane_v3 op_rep(lane_v3 p, f32 cx, f32 cy, f32 cz) {
+  return lane_v3 {
+    simd_sub(glsl_mod(p.x, cx), simd_set1(0.5f * cx)),
+    simd_sub(glsl_mod(p.y, cy), simd_set1(0.5f * cy)),
+    simd_sub(glsl_mod(p.z, cz), simd_set1(0.5f * cz)),
+  };
+}
+static inline lane_v3 op_twist(lane_v3 p) {
+  const simd_f32 angle = simd_add(simd_mul(simd_set1(10.f), p.y), simd_set1(10.f));
+  const simd_f32 c = lanes_apply(angle, [](f32 v) { return cosf(v); });
+  const simd_f32 s = sin_lanes(angle);
+  // mat2(c, -s, s, c) * p.xz, column major like GLSL
+  return lane_v3 { simd_add(simd_mul(c, p.x), simd_mul(s, p.z)), simd_add(simd_mul(neg(s), p.x), simd_mul(c, p.z)), p.y };
+}
+
+// Scenes ------------------------------------------------------------------------------------------------------------
+
+static lane_sample map_raymarching(lane_v3 pos) {
+  lane_sample res = lane_sample { sd_plane(pos), simd_set1(1.f) };
+  op_union(&res, sd_sphere(at(pos, 0.0f, 0.25f, 0.0f), 0.25f), 46.9f);
+  op_union(&res, sd_box(at(pos, 1.0f, 0.25f, 0.0f), 0.25f, 0.25f, 0.25f), 3.0f);
+  op_union(&res, ud_round_box(at(pos, 1.0f, 0.25f, 1.0f), 0.15f, 0.1f), 41.0f);
+  op_union(&res, sd_torus(at(pos, 0.0f, 0.25f, 1.0f), 0.20f, 0.05f), 25.0f);
+  op_union(&res, sd_capsule(pos, Vector3 { -1.3f, 0.10f, -0.1f }, Vector3 { -0.8f, 0.50f, 0.2f }, 0.1f), 31.9f);
+  op_union(&res, sd_tri_prism(at(pos, -1.0f, 0.25f, -1.0f), 0.25f, 0.05f), 43.5f);
+  op_union(&res, sd_cylinder(at(pos, 1.0f, 0.30f, -1.0f), 0.1f, 0.2f), 8.0f);
+  op_union(&res, sd_cone(at(pos, 0.0f, 0.50f, -1.0f), 0.8f, 0.6f, 0.3f), 55.0f);
+  op_union(&res, sd_torus82(at(pos, 0.0f, 0.25f, 2.0f), 0.20f, 0.05f), 50.0f);
+  op_union(&res, sd_torus88(at(pos, -1.0f, 0.25f, 2.0f), 0.20f, 0.05f), 43.0f);
+  op_union(&res, sd_cylinder6(at(pos, 1.0f, 0.30f, 2.0f), 0.1f, 0.2f), 12.0f);
+  op_union(&res, sd_hex_prism(at(pos, -1.0f, 0.20f, 1.0f), 0.25f, 0.05f), 17.0f);
+  op_union(&res, sd_pyramid4(at(pos, -1.0f, 0.15f, -2.0f), 0.8f, 0.6f, 0.25f), 37.0f);
+  op_union(&res, op_subtract(ud_round_box(at(pos, -2.0f, 0.2f, 1.0f), 0.15f, 0.05f), sd_sphere(at(pos, -2.0f, 0.2f, 1.0f), 0.25f)), 13.0f);
+  {
+    const simd_f32 angle = lanes_apply2(simd_add(pos.x, simd_set1(2.0f)), pos.z, [](f32 y, f32 x) { return atan2f(y, x); });
+    const lane_v3 rep = lane_v3 {
+      simd_div(angle, simd_set1(6.2831f)),
+      pos.y,
+      simd_add(simd_set1(0.02f), simd_mul(simd_set1(0.5f), len3(at(pos, -2.0f, 0.2f, 0.0f)))),
+    };
+    op_union(&res, op_subtract(sd_torus82(at(pos, -2.0f, 0.2f, 0.0f), 0.20f, 0.1f), sd_cylinder(op_rep(rep, 0.05f, 1.0f, 0.05f), 0.02f, 0.6f)), 51.0f);
+  }
+  {
+    const simd_f32 fifty = simd_set1(50.0f);
+    const simd_f32 displacement = simd_mul(simd_mul(simd_mul(simd_set1(0.03f),
+      sin_lanes(simd_mul(fifty, pos.x))), sin_lanes(simd_mul(fifty, pos.y))), sin_lanes(simd_mul(fifty, pos.z)));
+    op_union(&res, simd_add(simd_mul(simd_set1(0.5f), sd_sphere(at(pos, -2.0f, 0.25f, -1.0f), 0.2f)), displacement), 65.0f);
+  }
+  op_union(&res, simd_mul(simd_set1(0.5f), sd_torus(op_twist(at(pos, -2.0f, 0.25f, 2.0f)), 0.20f, 0.05f)), 46.7f);
+  op_union(&res, sd_cone_section(at(pos, 0.0f, 0.35f, -2.0f), 0.15f, 0.2f, 0.1f), 13.67f);
+  op_union(&res, sd_ellipsoid(at(pos, 1.0f, 0.35f, -2.0f), 0.15f, 0.2f, 0.05f), 43.17f);
+  return res;
+}
+
+// The shader redeclares res after these two, which doesn't compile. This is the scene it was meant to have.
+static lane_sample map_hybrid(lane_v3 pos) {
+  lane_sample res = lane_sample {
+    sd_horseshoe(at(pos, -1.0f, 0.08f, 1.0f), cosf(1.3f), sinf(1.3f), 0.2f, 0.3f, 0.03f, 0.5f),
+    simd_set1(11.5f),
+  };
+  op_union(&res, sd_six_way_cut_hollow_sphere(at(pos, 0.0f, 1.0f, 0.0f), 4.0f, 3.5f, 0.5f), 4.5f);
+  return res;
+}
+
+static inline lane_sample map_scene(sdf_scene scene, lane_v3 pos) {
+  return (scene == SDF_SCENE_HYBRID_RAYMARCH) ? map_hybrid(pos) : map_raymarching(pos);
+}
+
+static lane_v3 normal_lanes(sdf_scene scene, lane_v3 pos) {
+  const f32 e = SDF_NORMAL_EPSILON;
+  const lane_v3 xyy = v3_set(e, -e, -e);
+  const lane_v3 yyx = v3_set(-e, -e, e);
+  const lane_v3 yxy = v3_set(-e, e, -e);
+  const lane_v3 xxx = v3_set(e, e, e);
+  lane_v3 n = v3_scale(xyy, map_scene(scene, v3_add(pos, xyy)).d);
+  n = v3_add(n, v3_scale(yyx, map_scene(scene, v3_add(pos, yyx)).d));
+  n = v3_add(n, v3_scale(yxy, map_scene(scene, v3_add(pos, yxy)).d));
+  n = v3_add(n, v3_scale(xxx, map_scene(scene, v3_add(pos, xxx)).d));
+  return v3_normalize(n);
+}
+
+// castRay() of raymarching.fs, the bounding volume clips the march between the floor and y = 1.6
+static lane_sample cast_raymarching(lane_v3 ro, lane_v3 rd, simd_f32 active) {
+  const simd_f32 zero = simd_set1(0.f);
+  simd_f32 tmin = simd_set1(0.2f);
+  simd_f32 tmax = simd_set1(30.0f);
+  const simd_f32 tp1 = simd_div(simd_sub(zero, ro.y), rd.y);
+  tmax = simd_select(simd_less(zero, tp1), simd_min(tmax, tp1), tmax);
+  const simd_f32 tp2 = simd_div(simd_sub(simd_set1(1.6f), ro.y), rd.y);
+  const simd_f32 above = simd_less(simd_set1(1.6f), ro.y);
+  const simd_f32 tp2_positive = simd_less(zero, tp2);
+  tmin = simd_select(tp2_positive, simd_select(above, simd_max(tmin, tp2), tmin), tmin);
+  tmax = simd_select(tp2_positive, simd_select(above, tmax, simd_min(tmax, tp2)), tmax);
+
+  simd_f32 t = tmin;
+  simd_f32 m = simd_set1(-1.f);
+  for (u32 i = 0; i < 64 and simd_mask_bits(active) != 0; ++i) {
+    const simd_f32 precis = simd_mul(simd_set1(0.0005f), t);
+    const lane_sample res = map_scene(SDF_SCENE_RAYMARCHING, v3_along(ro, rd, t));
+    active = mask_andnot(active, simd_or(simd_less(res.d, precis), simd_less(tmax, t)));
+    t = simd_select(active, simd_add(t, res.d), t);
+    m = simd_select(active, res.m, m);
+  }
+  m = simd_select(simd_less(tmax, t), simd_set1(SDF_MISS_MATERIAL), m);
+  return lane_sample { t, m };
+}
+
+// raycast() of hybrid_raymarch.fs, the floor is intersected analytically and only the map is marched
+static lane_sample cast_hybrid(lane_v3 ro, lane_v3 rd, simd_f32 active) {
+  const simd_f32 zero = simd_set1(0.f);
+  simd_f32 res_t = simd_set1(-1.f);
+  simd_f32 res_m = simd_set1(-1.f);
+  const simd_f32 tmin = simd_set1(1.0f);
+  simd_f32 tmax = simd_set1(20.0f);
+  const simd_f32 tp1 = simd_div(neg(ro.y), rd.y);
+  const simd_f32 floor_hit = simd_less(zero, tp1);
+  tmax = simd_select(floor_hit, simd_min(tmax, tp1), tmax);
+  res_t = simd_select(floor_hit, tp1, res_t);
+  res_m = simd_select(floor_hit, simd_set1(1.0f), res_m);
+
+  simd_f32 t = tmin;
+  for (u32 i = 0; i < 70; ++i) {
+    active = mask_andnot(active, simd_less(tmax, t));
+    if (simd_mask_bits(active) == 0) {
+      break;
+    }
+    const lane_sample h = map_scene(SDF_SCENE_HYBRID_RAYMARCH, v3_along(ro, rd, t));
+    const simd_f32 hit = simd_and(active, simd_less(simd_abs(h.d), simd_mul(simd_set1(0.0001f), t)));
+    res_t = simd_select(hit, t, res_t);
+    res_m = simd_select(hit, h.m, res_m);
+    active = mask_andnot(active, hit);
+    t = simd_select(active, simd_add(t, h.d), t);
+  }
+  return lane_sample { res_t, res_m };
+}
+
+static inline lane_sample cast_scene(sdf_scene scene, lane_v3 ro, lane_v3 rd, simd_f32 active) {
+  return (scene == SDF_SCENE_HYBRID_RAYMARCH) ? cast_hybrid(ro, rd, active) : cast_raymarching(ro, rd, active);
+}
+
+// Public queries ----------------------------------------------------------------------------------------------------
+
+sdf_sample sdf_map(sdf_scene scene, Vector3 position) {
+  const lane_sample res = map_scene(scene, v3_set(position));
+  return sdf_sample { lane_first(res.d), lane_first(res.m) };
+}
+
+static void map_packets(u32 begin, u32 end, void* data) {
+  const sdf_batch_context* ctx = (const sdf_batch_context*)data;
+  for (u32 packet = begin; packet < end; ++packet) {
+    const u32 i = packet * SIMD_LANE_COUNT;
+    const u32 lanes = (ctx->count - i < SIMD_LANE_COUNT) ? ctx->count - i : SIMD_LANE_COUNT;
+    const lane_v3 pos = lane_v3 { lanes_load(ctx->positions.x + i, lanes), lanes_load(ctx->positions.y + i, lanes), lanes_load(ctx->positions.z + i, lanes) };
+    const lane_sample res = map_scene(ctx->scene, pos);
+    lanes_store(ctx->distance + i, lanes, res.d);
+    if (ctx->material) {
+      lanes_store(ctx->material + i, lanes, res.m);
+    }
+  }
+}
+
+void sdf_map_batch(sdf_scene scene, vec3_soa positions, f32* distance, f32* material, u32 count) {
+  if (not distance or count == 0 or scene >= SDF_SCENE_MAX) {
+    return;
+  }
+  sdf_batch_context ctx = {};
+  ctx.scene = scene;
+  ctx.positions = positions;
+  ctx.distance = distance;
+  ctx.material = material;
+  ctx.count = count;
+  job_parallel_for((count + SIMD_LANE_COUNT - 1) / SIMD_LANE_COUNT, SDF_PACKETS_PER_TASK, map_packets, &ctx);
+}
+
+Vector3 sdf_normal(sdf_scene scene, Vector3 position) {
+  const lane_v3 n = normal_lanes(scene, v3_set(position));
+  return Vector3 { lane_first(n.x), lane_first(n.y), lane_first(n.z) };
+}
+
+sdf_hit sdf_cast_ray(sdf_scene scene, Vector3 origin, Vector3 direction) {
+  const lane_sample res = cast_scene(scene, v3_set(origin), v3_set(direction), mask_all());
+  sdf_hit hit = {};
+  hit.t = lane_first(res.d);
+  hit.material = lane_first(res.m);
+  if (hit.material > -0.5f) {
+    hit.position = Vector3 { origin.x + direction.x * hit.t, origin.y + direction.y * hit.t, origin.z + direction.z * hit.t };
+    // hybrid_raymarch.fs doesn't march the floor, its normal is fixed
+    hit.normal = (scene == SDF_SCENE_HYBRID_RAYMARCH and hit.material < 1.5f) ? Vector3 { 0.f, 1.f, 0.f } : sdf_normal(scene, hit.position);
+  }
+  return hit;
+}
+
+static void cast_packets(u32 begin, u32 end, void* data) {
+  const sdf_batch_context* ctx = (const sdf_batch_context*)data;
+  for (u32 packet = begin; packet < end; ++packet) {
+    const u32 i = packet * SIMD_LANE_COUNT;
+    const u32 lanes = (ctx->count - i < SIMD_LANE_COUNT) ? ctx->count - i : SIMD_LANE_COUNT;
+    const lane_v3 ro = lane_v3 { lanes_load(ctx->positions.x + i, lanes), lanes_load(ctx->positions.y + i, lanes), lanes_load(ctx->positions.z + i, lanes) };
+    const lane_v3 rd = lane_v3 { lanes_load(ctx->directions.x + i, lanes), lanes_load(ctx->directions.y + i, lanes), lanes_load(ctx->directions.z + i, lanes) };
+    const lane_sample res = cast_scene(ctx->scene, ro, rd, mask_first_lanes(lanes));
+    lanes_store(ctx->distance + i, lanes, res.d);
+    if (ctx->material) {
+      lanes_store(ctx->material + i, lanes, res.m);
+    }
+  }
+}
+
+void sdf_cast_rays(sdf_scene scene, vec3_soa origins, vec3_soa directions, f32* t, f32* material, u32 count) {
+  if (not t or count == 0 or scene >= SDF_SCENE_MAX) {
+    return;
+  }
+  sdf_batch_context ctx = {};
+  ctx.scene = scene;
+  ctx.positions = origins;
+  ctx.directions = directions;
+  ctx.distance = t;
+  ctx.material = material;
+  ctx.count = count;
+  job_parallel_for((count + SIMD_LANE_COUNT - 1) / SIMD_LANE_COUNT, SDF_PACKETS_PER_TASK, cast_packets, &ctx);
+}
+
+// Reference render --------------------------------------------------------------------------------------------------
+
+static simd_f32 soft_shadow(lane_v3 ro, lane_v3 rd, f32 mint, f32 tmax, simd_f32 active) {
+  simd_f32 res = simd_set1(1.0f);
+  simd_f32 t = simd_set1(mint);
+  for (u32 i = 0; i < 16 and simd_mask_bits(active) != 0; ++i) {
+    const simd_f32 h = map_scene(SDF_SCENE_RAYMARCHING, v3_along(ro, rd, t)).d;
+    res = simd_select(active, simd_min(res, simd_div(simd_mul(simd_set1(8.0f), h), t)), res);
+    t = simd_select(active, simd_add(t, simd_clamp(h, simd_set1(0.02f), simd_set1(0.10f))), t);
+    active = mask_andnot(active, simd_or(simd_less(h, simd_set1(0.001f)), simd_less(simd_set1(tmax), t)));
+  }
+  return clamp01(res);
+}
+
+static simd_f32 ambient_occlusion(lane_v3 pos, lane_v3 nor) {
+  simd_f32 occ = simd_set1(0.0f);
+  f32 sca = 1.0f;
+  for (u32 i = 0; i < 5; ++i) {
+    const f32 hr = 0.01f + 0.12f * (f32)i / 4.0f;
+    const simd_f32 dd = map_scene(SDF_SCENE_RAYMARCHING, v3_add(v3_scale(nor, simd_set1(hr)), pos)).d;
+    occ = simd_add(occ, simd_mul(neg(simd_sub(dd, simd_set1(hr))), simd_set1(sca)));
+    sca *= 0.95f;
+  }
+  return clamp01(simd_sub(simd_set1(1.0f), simd_mul(simd_set1(3.0f), occ)));
+}
+
+// Analytical box filtered checkers, w is the filter width fwidth() gives the shader
+static simd_f32 checkers_grad_box(simd_f32 px, simd_f32 py, simd_f32 wx, simd_f32 wy) {
+  const simd_f32 half = simd_set1(0.5f);
+  const simd_f32 two = simd_set1(2.0f);
+  const simd_f32 ix = simd_div(simd_mul(two, simd_sub(
+    simd_abs(simd_sub(fract(simd_mul(simd_sub(px, simd_mul(half, wx)), half)), half)),
+    simd_abs(simd_sub(fract(simd_mul(simd_add(px, simd_mul(half, wx)), half)), half)))), wx);
+  const simd_f32 iy = simd_div(simd_mul(two, simd_sub(
+    simd_abs(simd_sub(fract(simd_mul(simd_sub(py, simd_mul(half, wy)), half)), half)),
+    simd_abs(simd_sub(fract(simd_mul(simd_add(py, simd_mul(half, wy)), half)), half)))), wy);
+  return simd_sub(half, simd_mul(simd_mul(half, ix), iy));
+}
+
+static lane_v3 camera_ray(const sdf_render_context* ctx, simd_f32 frag_x, simd_f32 frag_y) {
+  const simd_f32 inv_height = simd_set1(1.f / (f32)ctx->height);
+  const simd_f32 px = simd_mul(simd_add(simd_set1((f32)-ctx->width), simd_mul(simd_set1(2.f), frag_x)), inv_height);
+  const simd_f32 py = simd_mul(simd_add(simd_set1((f32)-ctx->height), simd_mul(simd_set1(2.f), frag_y)), inv_height);
+  const lane_v3 n = v3_normalize(lane_v3 { px, py, simd_set1(2.f) });
+  return v3_add(v3_add(v3_scale(v3_set(ctx->cu), n.x), v3_scale(v3_set(ctx->cv), n.y)), v3_scale(v3_set(ctx->cw), n.z));
+}
+
+// 5 * xz of where the ray meets the floor, stands in for the neighbouring fragment of fwidth()
+static void floor_checker_coords(lane_v3 ro, lane_v3 rd, simd_f32* x, simd_f32* z) {
+  const simd_f32 t = simd_div(neg(ro.y), rd.y);
+  *x = simd_mul(simd_set1(5.f), simd_add(ro.x, simd_mul(rd.x, t)));
+  *z = simd_mul(simd_set1(5.f), simd_add(ro.z, simd_mul(rd.z, t)));
+}
+
+static lane_v3 render_lanes(const sdf_render_context* ctx, simd_f32 frag_x, simd_f32 frag_y) {
+  const lane_v3 ro = v3_set(ctx->eye);
+  const lane_v3 rd = camera_ray(ctx, frag_x, frag_y);
+  const lane_v3 background = v3_add(v3_set(0.7f, 0.9f, 1.0f), v3_scale(v3_set(1.f, 1.f, 1.f), simd_mul(rd.y, simd_set1(0.8f))));
+  const lane_sample res = cast_raymarching(ro, rd, mask_all());
+  const simd_f32 t = res.d;
+  const simd_f32 m = res.m;
+  const simd_f32 hit = simd_less(simd_set1(-0.5f), m);
+  if (simd_mask_bits(hit) == 0) {
+    return background;
+  }
+
+  const lane_v3 pos = v3_along(ro, rd, t);
+  const lane_v3 nor = normal_lanes(SDF_SCENE_RAYMARCHING, pos);
+  const lane_v3 ref = v3_sub(rd, v3_scale(nor, simd_mul(simd_set1(2.f), dot3(nor, rd))));
+
+  // Material
+  const simd_f32 m1 = simd_sub(m, simd_set1(1.0f));
+  lane_v3 col = lane_v3 {
+    simd_add(simd_set1(0.45f), simd_mul(simd_set1(0.35f), sin_lanes(simd_mul(simd_set1(0.05f), m1)))),
+    simd_add(simd_set1(0.45f), simd_mul(simd_set1(0.35f), sin_lanes(simd_mul(simd_set1(0.08f), m1)))),
+    simd_add(simd_set1(0.45f), simd_mul(simd_set1(0.35f), sin_lanes(simd_mul(simd_set1(0.10f), m1)))),
+  };
+  const simd_f32 on_floor = simd_and(hit, simd_less(m, simd_set1(1.5f)));
+  if (simd_mask_bits(on_floor) != 0) {
+    simd_f32 cx, cz, dx_x, dx_z, dy_x, dy_z;
+    floor_checker_coords(ro, rd, &cx, &cz);
+    floor_checker_coords(ro, camera_ray(ctx, simd_add(frag_x, simd_set1(1.f)), frag_y), &dx_x, &dx_z);
+    floor_checker_coords(ro, camera_ray(ctx, frag_x, simd_add(frag_y, simd_set1(1.f))), &dy_x, &dy_z);
+    const simd_f32 wx = simd_add(simd_add(simd_abs(simd_sub(dx_x, cx)), simd_abs(simd_sub(dy_x, cx))), simd_set1(0.001f));
+    const simd_f32 wz = simd_add(simd_add(simd_abs(simd_sub(dx_z, cz)), simd_abs(simd_sub(dy_z, cz))), simd_set1(0.001f));
+    const simd_f32 f = checkers_grad_box(simd_mul(simd_set1(5.f), pos.x), simd_mul(simd_set1(5.f), pos.z), wx, wz);
+    const simd_f32 checker = simd_add(simd_set1(0.3f), simd_mul(f, simd_set1(0.1f)));
+    col = v3_select(on_floor, lane_v3 { checker, checker, checker }, col);
+  }
+
+  // Lighting
+  const simd_f32 occ = ambient_occlusion(pos, nor);
+  const lane_v3 lig = v3_set(ctx->light);
+  const lane_v3 hal = v3_normalize(v3_sub(lig, rd));
+  const simd_f32 amb = clamp01(simd_add(simd_set1(0.5f), simd_mul(simd_set1(0.5f), nor.y)));
+  simd_f32 dif = clamp01(dot3(nor, lig));
+  const simd_f32 bac = simd_mul(clamp01(dot3(nor, v3_set(ctx->back_light))), clamp01(simd_sub(simd_set1(1.0f), pos.y)));
+  simd_f32 dom = smoothstep(-0.1f, 0.1f, ref.y);
+  const simd_f32 fre = pow_lanes(clamp01(simd_add(simd_set1(1.0f), dot3(nor, rd))), 2.0f);
+
+  dif = simd_mul(dif, soft_shadow(pos, lig, 0.02f, 2.5f, hit));
+  dom = simd_mul(dom, soft_shadow(pos, ref, 0.02f, 2.5f, hit));
+
+  const simd_f32 spe = simd_mul(simd_mul(pow_lanes(clamp01(dot3(nor, hal)), 16.0f), dif),
+    simd_add(simd_set1(0.04f), simd_mul(simd_set1(0.96f), pow_lanes(clamp01(simd_add(simd_set1(1.0f), dot3(hal, rd))), 5.0f))));
+
+  lane_v3 lin = v3_scale(v3_set(1.00f, 0.80f, 0.55f), simd_mul(simd_set1(1.30f), dif));
+  lin = v3_add(lin, v3_scale(v3_set(0.40f, 0.60f, 1.00f), simd_mul(simd_mul(simd_set1(0.40f), amb), occ)));
+  lin = v3_add(lin, v3_scale(v3_set(0.40f, 0.60f, 1.00f), simd_mul(simd_mul(simd_set1(0.50f), dom), occ)));
+  lin = v3_add(lin, v3_scale(v3_set(0.25f, 0.25f, 0.25f), simd_mul(simd_mul(simd_set1(0.50f), bac), occ)));
+  lin = v3_add(lin, v3_scale(v3_set(1.00f, 1.00f, 1.00f), simd_mul(simd_mul(simd_set1(0.25f), fre), occ)));
+  col = lane_v3 { simd_mul(col.x, lin.x), simd_mul(col.y, lin.y), simd_mul(col.z, lin.z) };
+  col = v3_add(col, v3_scale(v3_set(1.00f, 0.90f, 0.70f), simd_mul(simd_set1(10.00f), spe)));
+
+  const simd_f32 fog = simd_sub(simd_set1(1.0f),
+    lanes_apply(simd_mul(simd_mul(simd_mul(simd_set1(-0.0002f), t), t), t), [](f32 v) { return expf(v); }));
+  const lane_v3 fog_color = v3_set(0.8f, 0.9f, 1.0f);
+  col = lane_v3 { simd_lerp(col.x, fog_color.x, fog), simd_lerp(col.y, fog_color.y, fog), simd_lerp(col.z, fog_color.z, fog) };
+  return v3_select(hit, col, background);
+}
+
+static void render_rows(u32 begin, u32 end, void* data) {
+  const sdf_render_context* ctx = (const sdf_render_context*)data;
+  alignas(32) f32 channel[3][SIMD_LANE_COUNT];
+  for (u32 row = begin; row < end; ++row) {
+    // gl_FragCoord has its origin at the bottom left
+    const simd_f32 frag_y = simd_set1((f32)(ctx->height - 1 - (i32)row) + 0.5f);
+    for (i32 x = 0; x < ctx->width; x += SIMD_LANE_COUNT) {
+      const simd_f32 frag_x = simd_add(simd_set1((f32)x + 0.5f), simd_lane_index());
+      const lane_v3 col = render_lanes(ctx, frag_x, frag_y);
+      // Gamma
+      simd_store(channel[0], pow_lanes(clamp01(col.x), 0.4545f));
+      simd_store(channel[1], pow_lanes(clamp01(col.y), 0.4545f));
+      simd_store(channel[2], pow_lanes(clamp01(col.z), 0.4545f));
+      for (i32 i = 0; i < SIMD_LANE_COUNT and x + i < ctx->width; ++i) {
+        ctx->pixels[row * ctx->width + x + i] = Color {
+          (u8)(channel[0][i] * 255.f + 0.5f), (u8)(channel[1][i] * 255.f + 0.5f), (u8)(channel[2][i] * 255.f + 0.5f), 255
+        };
+      }
+    }
+  }
+}
+
+static Vector3 normalize3(Vector3 v) {
+  const f32 l = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+  return Vector3 { v.x / l, v.y / l, v.z / l };
+}
+static Vector3 cross3(Vector3 a, Vector3 b) {
+  return Vector3 { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+Image sdf_render_reference(i32 width, i32 height, Vector3 view_eye, Vector3 view_center, f32 run_time) {
+  if (width <= 0 or height <= 0) {
+    return Image {};
+  }
+  Image image = GenImageColor(width, height, BLACK);
+  if (not image.data) {
+    return image;
+  }
+
+  sdf_render_context ctx = {};
+  ctx.pixels = (Color*)image.data;
+  ctx.width = width;
+  ctx.height = height;
+  ctx.eye = view_eye;
+  // setCamera(ro, ta, 0.0)
+  ctx.cw = normalize3(Vector3 { view_center.x - view_eye.x, view_center.y - view_eye.y, view_center.z - view_eye.z });
+  ctx.cu = normalize3(cross3(ctx.cw, Vector3 { 0.f, 1.f, 0.f }));
+  ctx.cv = normalize3(cross3(ctx.cu, ctx.cw));
+  ctx.light = normalize3(Vector3 { cosf(-0.4f * run_time), sinf(0.7f * run_time), -0.6f });
+  ctx.back_light = normalize3(Vector3 { -ctx.light.x, 0.f, -ctx.light.z });
+
+  job_parallel_for((u32)height, SDF_ROWS_PER_TASK, render_rows, &ctx);
+  return image;
+}
+
+f32 sdf_image_difference(Image a, Image b) {
+  if (not a.data or not b.data or a.width != b.width or a.height != b.height or
+      a.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 or b.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+    return -1.f;
+  }
+  const Color* pa = (const Color*)a.data;
+  const Color* pb = (const Color*)b.data;
+  const u64 count = (u64)a.width * (u64)a.height;
+  f64 sum = 0.0;
+  for (u64 i = 0; i < count; ++i) {
+    const f64 dr = ((f64)pa[i].r - (f64)pb[i].r) / 255.0;
+    const f64 dg = ((f64)pa[i].g - (f64)pb[i].g) / 255.0;
+    const f64 db = ((f64)pa[i].b - (f64)pb[i].b) / 255.0;
+    sum += dr * dr + dg * dg + db * db;
+  }
+  return (f32)sqrt(sum / (f64)(count * 3));
+}
@@ -0,0 +1,69 @@
+#ifndef FSDF_H
+#define FSDF_H
+
+#include "defines.h"
+#include "raylib.h"
+
+#include "core/fmath.h"
+
+#define SDF_MISS_MATERIAL -1.f
+
+/**
+ * @brief Distance fields of the raymarching shaders, evaluated on the CPU with the same primitives and constants.
+ */
+typedef enum sdf_scene {
+  SDF_SCENE_RAYMARCHING,     // map() of raymarching.fs
+  SDF_SCENE_HYBRID_RAYMARCH, // map() of hybrid_raymarch.fs, floor plane handled by the ray cast like the shader
+  SDF_SCENE_MAX,
+} sdf_scene;
+
+typedef struct sdf_sample {
+  f32 distance;
+  f32 material;
+} sdf_sample;
+
+typedef struct sdf_hit {
+  Vector3 position;
+  Vector3 normal;
+  f32 t;
+  f32 material; // SDF_MISS_MATERIAL when nothing was hit
+} sdf_hit;
+
+/**
+ * @brief Nearest distance and the material of the closest primitive, like the shader's map().
+ */
+sdf_sample sdf_map(sdf_scene scene, Vector3 position);
+
+/**
+ * @brief sdf_map() for a stream of points, spread over the job system. material may be null.
+ */
+void sdf_map_batch(sdf_scene scene, vec3_soa positions, f32* distance, f32* material, u32 count);
+Vector3 sdf_normal(sdf_scene scene, Vector3 position);
+
+/**
+ * @brief castRay() of raymarching.fs or raycast() of hybrid_raymarch.fs, same step count and bounds.
+ */
+sdf_hit sdf_cast_ray(sdf_scene scene, Vector3 origin, Vector3 direction);
+
+/**
+ * @brief Marches packets of simd lanes, each lane stops on its own. Spread over the job system, material may be null.
+ */
+void sdf_cast_rays(sdf_scene scene, vec3_soa origins, vec3_soa directions, f32* t, f32* material, u32 count);
+
+/**
+ * @brief CPU version of raymarching.fs's main(), uniforms passed as arguments. Unload with UnloadImage().
+ * fwidth() has no CPU equivalent, the checker filter width comes from the neighbouring pixels' floor hits instead.
+ */
+Image sdf_render_reference(i32 width, i32 height, Vector3 view_eye, Vector3 view_center, f32 run_time);
+
+/**
+ * @brief Root mean square of the per channel difference in [0, 1], negative when the sizes or formats don't match.
+ */
+f32 sdf_image_difference(Image a, Image b);
+
+/**
+ * @brief Scalar against packet ray casts, logs rays per second and the largest disagreement.
+ */
+void sdf_run_benchmark(void);
+
+#endif
@@ -0,0 +1,96 @@
+#include "fsdf.h"
+
+#include <chrono>
+#include <math.h>
+
+#include "core/fjob.h"
+#include "core/fmemory.h"
+#include "core/fsimd.h"
+
+#define SDF_BENCH_WIDTH 256u
+#define SDF_BENCH_HEIGHT 144u
+#define SDF_BENCH_RAY_COUNT (SDF_BENCH_WIDTH * SDF_BENCH_HEIGHT)
+
+static f64 elapsed_ms(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Pinhole rays over the scene from the shader's default camera
+static void build_rays(sdf_scene scene, vec3_soa origins, vec3_soa directions) {
+  const Vector3 eye = (scene == SDF_SCENE_HYBRID_RAYMARCH) ? Vector3 { 0.f, 1.5f, 6.f } : Vector3 { 3.f, 2.f, 0.5f };
+  const Vector3 forward = (scene == SDF_SCENE_HYBRID_RAYMARCH) ? Vector3 { 0.f, -0.2f, -1.f } : Vector3 { -0.9f, -0.6f, 0.f };
+  for (u32 y = 0; y < SDF_BENCH_HEIGHT; ++y) {
+    for (u32 x = 0; x < SDF_BENCH_WIDTH; ++x) {
+      const u32 i = y * SDF_BENCH_WIDTH + x;
+      const f32 u = ((f32)x / SDF_BENCH_WIDTH - 0.5f) * 1.6f;
+      const f32 v = ((f32)y / SDF_BENCH_HEIGHT - 0.5f) * 0.9f;
+      Vector3 d = Vector3 { forward.x - u * forward.z, forward.y - v, forward.z + u * forward.x };
+      const f32 l = sqrtf(d.x * d.x + d.y * d.y + d.z * d.z);
+      origins.x[i] = eye.x;
+      origins.y[i] = eye.y;
+      origins.z[i] = eye.z;
+      directions.x[i] = d.x / l;
+      directions.y[i] = d.y / l;
+      directions.z[i] = d.z / l;
+    }
+  }
+}
+
+static void bench_scene(sdf_scene scene, f32* streams) {
+  const vec3_soa origins = vec3_soa { streams, streams + SDF_BENCH_RAY_COUNT, streams + 2 * SDF_BENCH_RAY_COUNT };
+  const vec3_soa directions = vec3_soa { streams + 3 * SDF_BENCH_RAY_COUNT, streams + 4 * SDF_BENCH_RAY_COUNT, streams + 5 * SDF_BENCH_RAY_COUNT };
+  f32* t = streams + 6 * SDF_BENCH_RAY_COUNT;
+  f32* material = streams + 7 * SDF_BENCH_RAY_COUNT;
+  build_rays(scene, origins, directions);
+
+  f32 scalar_sum = 0.f;
+  u32 mismatches = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (u32 i = 0; i < SDF_BENCH_RAY_COUNT; ++i) {
+    const sdf_hit hit = sdf_cast_ray(scene,
+      Vector3 { origins.x[i], origins.y[i], origins.z[i] }, Vector3 { directions.x[i], directions.y[i], directions.z[i] });
+    scalar_sum += hit.t;
+    t[i] = hit.t;
+    material[i] = hit.material;
+  }
+  const f64 scalar_ms = elapsed_ms(start);
+
+  f32* packet_t = streams + 8 * SDF_BENCH_RAY_COUNT;
+  f32* packet_material = streams + 9 * SDF_BENCH_RAY_COUNT;
+  start = std::chrono::steady_clock::now();
+  sdf_cast_rays(scene, origins, directions, packet_t, packet_material, SDF_BENCH_RAY_COUNT);
+  const f64 packet_ms = elapsed_ms(start);
+
+  u32 hits = 0;
+  for (u32 i = 0; i < SDF_BENCH_RAY_COUNT; ++i) {
+    mismatches += (t[i] != packet_t[i] or material[i] != packet_material[i]) ? 1 : 0;
+    hits += (packet_material[i] > -0.5f) ? 1 : 0;
+  }
+  TRACELOG(mismatches == 0 ? LOG_INFO : LOG_ERROR,
+    "SDF: scene %d, %u rays (%u hits): scalar %.2f Mrays/s, packets on %u threads %.2f Mrays/s, %.1fx, %u mismatches (sum %.1f)",
+    scene, SDF_BENCH_RAY_COUNT, hits, SDF_BENCH_RAY_COUNT / (scalar_ms * 1000.0), job_thread_count(),
+    SDF_BENCH_RAY_COUNT / (packet_ms * 1000.0), scalar_ms / packet_ms, mismatches, scalar_sum);
+}
+
+void sdf_run_benchmark(void) {
+  f32* streams = (f32*)allocate_memory(10 * SDF_BENCH_RAY_COUNT * sizeof(f32), true, MEMORY_TAG_CORE);
+  bench_scene(SDF_SCENE_RAYMARCHING, streams);
+  bench_scene(SDF_SCENE_HYBRID_RAYMARCH, streams);
+
+  // Nearest distance queries share the map with the ray casts
+  const vec3_soa points = vec3_soa { streams + 3 * SDF_BENCH_RAY_COUNT, streams + 4 * SDF_BENCH_RAY_COUNT, streams + 5 * SDF_BENCH_RAY_COUNT };
+  f32* distance = streams + 6 * SDF_BENCH_RAY_COUNT;
+  sdf_map_batch(SDF_SCENE_RAYMARCHING, points, distance, nullptr, SDF_BENCH_RAY_COUNT);
+  u32 map_mismatches = 0;
+  for (u32 i = 0; i < SDF_BENCH_RAY_COUNT; i += 97) {
+    map_mismatches += (sdf_map(SDF_SCENE_RAYMARCHING, Vector3 { points.x[i], points.y[i], points.z[i] }).distance != distance[i]) ? 1 : 0;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  Image image = sdf_render_reference(SDF_BENCH_WIDTH, SDF_BENCH_HEIGHT, Vector3 { 3.f, 2.f, 0.5f }, Vector3 { -0.5f, -0.4f, 0.5f }, 0.f);
+  const f64 render_ms = elapsed_ms(start);
+  TRACELOG(map_mismatches == 0 ? LOG_INFO : LOG_ERROR, "SDF: reference render %ux%u in %.1f ms, %u sdf_map_batch mismatches",
+    SDF_BENCH_WIDTH, SDF_BENCH_HEIGHT, render_ms, map_mismatches);
+  UnloadImage(image);
+  free_memory(streams);
+}
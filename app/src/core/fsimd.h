@@ -0,0 +1,167 @@
+#ifndef FSIMD_H
+#define FSIMD_H
+
+#include "defines.h"
+
+/**
+ * @brief Thin lane abstraction picked at compile time: AVX2 (8 lanes) when built with -mavx2,
+ * SSE2 (4 lanes) on every x86-64 target, scalar (1 lane) elsewhere.
+ * Integer lanes are unsigned 32 bit, arithmetic wraps and shifts are logical on every backend,
+ * so results are bit-identical no matter which backend produced them.
+ */
+#if defined(__AVX2__)
+  #include <immintrin.h>
+  #define SIMD_AVX2 1
+  #define SIMD_LANE_COUNT 8
+  typedef __m256 simd_f32;
+  typedef __m256i simd_u32;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define SIMD_SSE2 1
+  #define SIMD_LANE_COUNT 4
+  typedef __m128 simd_f32;
+  typedef __m128i simd_u32;
+#else
+  #include <math.h>
+  #include <string.h>
+  #define SIMD_SCALAR 1
+  #define SIMD_LANE_COUNT 1
+  typedef f32 simd_f32;
+  typedef u32 simd_u32;
+#endif
+
+#if defined(SIMD_AVX2)
+
+static inline simd_f32 simd_set1(f32 v) { return _mm256_set1_ps(v); }
+static inline simd_f32 simd_load(const f32* p) { return _mm256_loadu_ps(p); }
+static inline void     simd_store(f32* p, simd_f32 v) { _mm256_storeu_ps(p, v); }
+static inline simd_f32 simd_add(simd_f32 a, simd_f32 b) { return _mm256_add_ps(a, b); }
+static inline simd_f32 simd_sub(simd_f32 a, simd_f32 b) { return _mm256_sub_ps(a, b); }
+static inline simd_f32 simd_mul(simd_f32 a, simd_f32 b) { return _mm256_mul_ps(a, b); }
+static inline simd_f32 simd_div(simd_f32 a, simd_f32 b) { return _mm256_div_ps(a, b); }
+static inline simd_f32 simd_min(simd_f32 a, simd_f32 b) { return _mm256_min_ps(a, b); }
+static inline simd_f32 simd_max(simd_f32 a, simd_f32 b) { return _mm256_max_ps(a, b); }
+static inline simd_f32 simd_sqrt(simd_f32 a) { return _mm256_sqrt_ps(a); }
+static inline simd_f32 simd_floor(simd_f32 a) { return _mm256_floor_ps(a); }
+static inline simd_f32 simd_abs(simd_f32 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+static inline simd_f32 simd_lane_index(void) { return _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f); }
+// Lane mask (all bits set) where a < b
+static inline simd_f32 simd_less(simd_f32 a, simd_f32 b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline simd_f32 simd_select(simd_f32 mask, simd_f32 a, simd_f32 b) { return _mm256_blendv_ps(b, a, mask); }
+static inline simd_f32 simd_and(simd_f32 a, simd_f32 b) { return _mm256_and_ps(a, b); }
+static inline simd_f32 simd_or(simd_f32 a, simd_f32 b) { return _mm256_or_ps(a, b); }
+static inline u32      simd_mask_bits(simd_f32 mask) { return (u32)_mm256_movemask_ps(mask); }
+
+static inline simd_u32 simd_u32_set1(u32 v) { return _mm256_set1_epi32((i32)v); }
+static inline simd_u32 simd_u32_load(const u32* p) { return _mm256_loadu_si256((const __m256i*)p); }
+static inline void     simd_u32_store(u32* p, simd_u32 v) { _mm256_storeu_si256((__m256i*)p, v); }
+static inline simd_u32 simd_u32_add(simd_u32 a, simd_u32 b) { return _mm256_add_epi32(a, b); }
+static inline simd_u32 simd_u32_mul(simd_u32 a, simd_u32 b) { return _mm256_mullo_epi32(a, b); }
+static inline simd_u32 simd_u32_xor(simd_u32 a, simd_u32 b) { return _mm256_xor_si256(a, b); }
+static inline simd_u32 simd_u32_and(simd_u32 a, simd_u32 b) { return _mm256_and_si256(a, b); }
+static inline simd_u32 simd_u32_or(simd_u32 a, simd_u32 b) { return _mm256_or_si256(a, b); }
+#define simd_u32_shr(a, n) _mm256_srli_epi32((a), (n))
+#define simd_u32_shl(a, n) _mm256_slli_epi32((a), (n))
+// Float to int conversion of an already integral value
+static inline simd_u32 simd_to_u32(simd_f32 a) { return _mm256_cvttps_epi32(a); }
+static inline simd_f32 simd_u32_to_f32_bits(simd_u32 a) { return _mm256_castsi256_ps(a); }
+static inline simd_u32 simd_f32_to_u32_bits(simd_f32 a) { return _mm256_castps_si256(a); }
+
+#elif defined(SIMD_SSE2)
+
+static inline simd_f32 simd_set1(f32 v) { return _mm_set1_ps(v); }
+static inline simd_f32 simd_load(const f32* p) { return _mm_loadu_ps(p); }
+static inline void     simd_store(f32* p, simd_f32 v) { _mm_storeu_ps(p, v); }
+static inline simd_f32 simd_add(simd_f32 a, simd_f32 b) { return _mm_add_ps(a, b); }
+static inline simd_f32 simd_sub(simd_f32 a, simd_f32 b) { return _mm_sub_ps(a, b); }
+static inline simd_f32 simd_mul(simd_f32 a, simd_f32 b) { return _mm_mul_ps(a, b); }
+static inline simd_f32 simd_div(simd_f32 a, simd_f32 b) { return _mm_div_ps(a, b); }
+static inline simd_f32 simd_min(simd_f32 a, simd_f32 b) { return _mm_min_ps(a, b); }
+static inline simd_f32 simd_max(simd_f32 a, simd_f32 b) { return _mm_max_ps(a, b); }
+static inline simd_f32 simd_sqrt(simd_f32 a) { return _mm_sqrt_ps(a); }
+static inline simd_f32 simd_floor(simd_f32 a) {
+  // Truncate, then step down where truncation rounded towards zero from below
+  const simd_f32 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+  return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.f)));
+}
+static inline simd_f32 simd_abs(simd_f32 a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+static inline simd_f32 simd_lane_index(void) { return _mm_setr_ps(0.f, 1.f, 2.f, 3.f); }
+static inline simd_f32 simd_less(simd_f32 a, simd_f32 b) { return _mm_cmplt_ps(a, b); }
+static inline simd_f32 simd_select(simd_f32 mask, simd_f32 a, simd_f32 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+static inline simd_f32 simd_and(simd_f32 a, simd_f32 b) { return _mm_and_ps(a, b); }
+static inline simd_f32 simd_or(simd_f32 a, simd_f32 b) { return _mm_or_ps(a, b); }
+static inline u32      simd_mask_bits(simd_f32 mask) { return (u32)_mm_movemask_ps(mask); }
+
+static inline simd_u32 simd_u32_set1(u32 v) { return _mm_set1_epi32((i32)v); }
+static inline simd_u32 simd_u32_load(const u32* p) { return _mm_loadu_si128((const __m128i*)p); }
+static inline void     simd_u32_store(u32* p, simd_u32 v) { _mm_storeu_si128((__m128i*)p, v); }
+static inline simd_u32 simd_u32_add(simd_u32 a, simd_u32 b) { return _mm_add_epi32(a, b); }
+static inline simd_u32 simd_u32_mul(simd_u32 a, simd_u32 b) {
+  // SSE2 has no 32 bit mullo, multiply even and odd lanes separately and interleave the low halves
+  const __m128i even = _mm_mul_epu32(a, b);
+  const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+static inline simd_u32 simd_u32_xor(simd_u32 a, simd_u32 b) { return _mm_xor_si128(a, b); }
+static inline simd_u32 simd_u32_and(simd_u32 a, simd_u32 b) { return _mm_and_si128(a, b); }
+static inline simd_u32 simd_u32_or(simd_u32 a, simd_u32 b) { return _mm_or_si128(a, b); }
+#define simd_u32_shr(a, n) _mm_srli_epi32((a), (n))
+#define simd_u32_shl(a, n) _mm_slli_epi32((a), (n))
+static inline simd_u32 simd_to_u32(simd_f32 a) { return _mm_cvttps_epi32(a); }
+static inline simd_f32 simd_u32_to_f32_bits(simd_u32 a) { return _mm_castsi128_ps(a); }
+static inline simd_u32 simd_f32_to_u32_bits(simd_f32 a) { return _mm_castps_si128(a); }
+
+#else
+
+static inline simd_f32 simd_set1(f32 v) { return v; }
+static inline simd_f32 simd_load(const f32* p) { return *p; }
+static inline void     simd_store(f32* p, simd_f32 v) { *p = v; }
+static inline simd_f32 simd_add(simd_f32 a, simd_f32 b) { return a + b; }
+static inline simd_f32 simd_sub(simd_f32 a, simd_f32 b) { return a - b; }
+static inline simd_f32 simd_mul(simd_f32 a, simd_f32 b) { return a * b; }
+static inline simd_f32 simd_div(simd_f32 a, simd_f32 b) { return a / b; }
+// Same operand order as minps/maxps, so signed zeros and NaNs resolve like the vector backends
+static inline simd_f32 simd_min(simd_f32 a, simd_f32 b) { return (a < b) ? a : b; }
+static inline simd_f32 simd_max(simd_f32 a, simd_f32 b) { return (a > b) ? a : b; }
+static inline simd_f32 simd_sqrt(simd_f32 a) { return sqrtf(a); }
+static inline simd_f32 simd_floor(simd_f32 a) { return floorf(a); }
+static inline simd_f32 simd_abs(simd_f32 a) { return fabsf(a); }
+static inline simd_f32 simd_lane_index(void) { return 0.f; }
+static inline u32      simd_f32_bits(f32 a) { u32 u; memcpy(&u, &a, sizeof(u)); return u; }
+static inline f32      simd_bits_f32(u32 u) { f32 a; memcpy(&a, &u, sizeof(a)); return a; }
+static inline simd_f32 simd_less(simd_f32 a, simd_f32 b) { return simd_bits_f32((a < b) ? U32_MAX : 0u); }
+static inline simd_f32 simd_select(simd_f32 mask, simd_f32 a, simd_f32 b) { return simd_f32_bits(mask) ? a : b; }
+static inline simd_f32 simd_and(simd_f32 a, simd_f32 b) { return simd_bits_f32(simd_f32_bits(a) & simd_f32_bits(b)); }
+static inline simd_f32 simd_or(simd_f32 a, simd_f32 b) { return simd_bits_f32(simd_f32_bits(a) | simd_f32_bits(b)); }
+static inline u32      simd_mask_bits(simd_f32 mask) { return simd_f32_bits(mask) >> 31; }
+
+static inline simd_u32 simd_u32_set1(u32 v) { return v; }
+static inline simd_u32 simd_u32_load(const u32* p) { return *p; }
+static inline void     simd_u32_store(u32* p, simd_u32 v) { *p = v; }
+static inline simd_u32 simd_u32_add(simd_u32 a, simd_u32 b) { return a + b; }
+static inline simd_u32 simd_u32_mul(simd_u32 a, simd_u32 b) { return a * b; }
+static inline simd_u32 simd_u32_xor(simd_u32 a, simd_u32 b) { return a ^ b; }
+static inline simd_u32 simd_u32_and(simd_u32 a, simd_u32 b) { return a & b; }
+static inline simd_u32 simd_u32_or(simd_u32 a, simd_u32 b) { return a | b; }
+#define simd_u32_shr(a, n) ((simd_u32)(a) >> (n))
+#define simd_u32_shl(a, n) ((simd_u32)(a) << (n))
+static inline simd_u32 simd_to_u32(simd_f32 a) { return (u32)(i32)a; }
+static inline simd_f32 simd_u32_to_f32_bits(simd_u32 a) { return simd_bits_f32(a); }
+static inline simd_u32 simd_f32_to_u32_bits(simd_f32 a) { return simd_f32_bits(a); }
+
+#endif
+
+static inline simd_f32 simd_madd(simd_f32 a, simd_f32 b, simd_f32 c) { return simd_add(simd_mul(a, b), c); }
+static inline simd_f32 simd_lerp(simd_f32 a, simd_f32 b, simd_f32 t) { return simd_add(a, simd_mul(t, simd_sub(b, a))); }
+static inline simd_f32 simd_clamp(simd_f32 v, simd_f32 lo, simd_f32 hi) { return simd_min(simd_max(v, lo), hi); }
+// Fully unrolls the fixed count loop that follows, so per lane arrays stay in registers
+#if defined(__clang__)
+  #define SIMD_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+  #define SIMD_UNROLL _Pragma("GCC unroll 32")
+#else
+  #define SIMD_UNROLL
+#endif
+#define simd_u32_rotl(a, n) simd_u32_or(simd_u32_shl((a), (n)), simd_u32_shr((a), 32 - (n)))
+
+#endif
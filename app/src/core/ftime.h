@@ -4,12 +4,13 @@
 
 #include "defines.h"
 
-#define RANDOM_TABLE_NUMBER_COUNT 507
-
 bool time_system_initialize(void);
 
 void update_time(void);
 
+/**
+ * @brief Inclusive, drawn from the calling thread's stream, see random_thread_state().
+ */
 i32 get_random(i32 min, i32 max);
 
 #endif
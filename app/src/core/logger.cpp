@@ -1,33 +1,105 @@
 #include "logger.h"
-#include <raylib.h>
-#include <vector>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+#include <stdlib.h> // Required for: atoi()
+#include <string.h> // Required for: strlen(), strchr(), memchr()
+#include <mutex>
+#include <new>
+#include <thread>
 
 #include "core/fmemory.h"
 
 #define LOGGING_SEVERITY LOG_SEV_INFO
 #define LOG_FILE_LOCATION ""
 #define LOG_FILE_NAME "log.txt"
+#define LOG_FILE_MAX_SIZE (8u * 1024u * 1024u)
+#define LOG_FILE_MAX_ROTATIONS 3
+#define LOG_RING_MASK (LOG_RING_CAPACITY - 1)
+#define LOG_WRITE_BATCH_SIZE (64u * 1024u)
+#define LOG_WRITER_IDLE_WAIT_MS 5
+#define LOG_PATH_MAX 512
+#define LOG_DECODED_LINE_MAX 1024
+#define LOG_SPEC_MAX 32
+
+static_assert((LOG_RING_CAPACITY & LOG_RING_MASK) == 0, "LOG_RING_CAPACITY must be a power of two");
+
+/**
+ * @brief Sequence is the ring position the slot is free for, position + 1 once a line is published into it.
+ * Format is null for lines formatted by the caller, otherwise text holds a deferred record's raw arguments.
+ */
+typedef struct log_slot {
+  std::atomic<u64> sequence;
+  u64 timestamp; // Monotonic nanoseconds
+  const char* format;
+  logging_severity severity;
+  u32 length;
+  char text[LOG_LINE_MAX];
+} log_slot;
 
 typedef struct logging_system_state {
-  std::vector<std::string> logs;
+  log_slot* ring;
+  std::atomic<u64> write_position;
+  u8 write_padding[56]; // Producers and the writer thread touch these from different cores
+  std::atomic<u64> flushed_position;
+  std::atomic<u64> dropped_count;
+  std::atomic<bool> running;
+
+  std::mutex wake_mutex;
+  std::condition_variable wake;
+  std::condition_variable flushed;
+  u64 flush_request;
+
+  std::thread writer;
+  i64 wall_clock_offset; // Added to monotonic timestamps to get wall clock nanoseconds
+  FILE* file;
+  u64 file_size;
+  char path[LOG_PATH_MAX];
+  char* batch; // Writer thread only
 } logging_system_state;
 
 static logging_system_state * state = nullptr;
 
+static void writer_main(void);
+static u32 format_prefix(char* dest, u64 timestamp, logging_severity severity);
+static u32 decode_record(char* dest, const log_slot* slot);
+static void rotate_log_file(void);
+
+static inline u64 monotonic_now(void) {
+  return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 bool logging_system_initialize(void) {
   if (state and state != nullptr) {
     return false;
   }
-  state = (logging_system_state*)allocate_memory_linear(sizeof(logging_system_state), true);
-  if (not state or state == nullptr) {
+  void* block = allocate_memory_linear(sizeof(logging_system_state), true, MEMORY_TAG_LOGGER);
+  if (not block) {
     return false;
   }
+  state = new (block) logging_system_state();
+  state->wall_clock_offset = (i64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count() - (i64)monotonic_now();
+  snprintf(state->path, LOG_PATH_MAX, "%s%s", LOG_FILE_LOCATION, LOG_FILE_NAME);
 
-  const char * path = TextFormat("%s%s",LOG_FILE_LOCATION, LOG_FILE_NAME);
-  if (FileExists(path)) {
-    SaveFileText(path, " ");
+  // Every session starts with an empty log, older sessions only survive through rotation
+  state->file = fopen(state->path, "wb");
+  if (not state->file) {
+    state->~logging_system_state();
+    state = nullptr;
+    return false;
   }
-
+  state->ring = (log_slot*)allocate_memory(sizeof(log_slot) * LOG_RING_CAPACITY, false, MEMORY_TAG_LOGGER);
+  for (u64 i = 0; i < LOG_RING_CAPACITY; ++i) {
+    new (&state->ring[i]) log_slot();
+    state->ring[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  state->batch = (char*)allocate_memory(LOG_WRITE_BATCH_SIZE, false, MEMORY_TAG_LOGGER);
+  state->running.store(true);
+  state->writer = std::thread(writer_main);
   return true;
 }
 
@@ -35,70 +107,337 @@ void logging_system_shutdown(void) {
   if (not state or state == nullptr) {
     return;
   }
-  for (std::string str : state->logs) {
-		str.clear();
-		str.shrink_to_fit();
-	}
-  state->logs.clear();
-	state->logs.shrink_to_fit();
-	
-  free(state);
+  {
+    std::lock_guard<std::mutex> lock(state->wake_mutex);
+    state->running.store(false);
+  }
+  state->wake.notify_all();
+  state->writer.join();
+
+  if (state->file) fclose(state->file);
+  free_memory(state->batch);
+  free_memory(state->ring);
+  state->~logging_system_state();
   state = nullptr;
 }
 
+void logging_system_flush(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  // Lines claimed before this point must be on disk before returning
+  const u64 target = state->write_position.load(std::memory_order_acquire);
+  std::unique_lock<std::mutex> lock(state->wake_mutex);
+  if (target > state->flush_request) {
+    state->flush_request = target;
+  }
+  state->wake.notify_all();
+  state->flushed.wait(lock, [target] {
+    return state->flushed_position.load(std::memory_order_acquire) >= target or not state->running.load();
+  });
+}
+
+u64 logging_get_dropped_count(void) {
+  return (state and state != nullptr) ? state->dropped_count.load(std::memory_order_relaxed) : 0;
+}
+
+// A full ring drops the line rather than stalling the caller, fatal lines wait for room
+static log_slot* claim_slot(logging_severity ls, u64* out_position) {
+  u64 position = state->write_position.load(std::memory_order_relaxed);
+  for (;;) {
+    log_slot* slot = &state->ring[position & LOG_RING_MASK];
+    const i64 diff = (i64)slot->sequence.load(std::memory_order_acquire) - (i64)position;
+    if (diff == 0) {
+      if (state->write_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        *out_position = position;
+        return slot;
+      }
+    }
+    else if (diff < 0) {
+      if (ls != LOG_SEV_FATAL) {
+        state->dropped_count.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+      }
+      state->wake.notify_one();
+      std::this_thread::yield();
+      position = state->write_position.load(std::memory_order_relaxed);
+    }
+    else {
+      position = state->write_position.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+static void publish_slot(log_slot* slot, u64 position, logging_severity ls) {
+  slot->sequence.store(position + 1, std::memory_order_release);
+  if (ls >= LOG_SEV_FATAL) {
+    logging_system_flush();
+  }
+}
+
 void inc_logging(logging_severity ls, const char* fmt, ...) {
-  if(not state or state == nullptr) {
+  if(not state or state == nullptr or ls < LOGGING_SEVERITY) {
 		return;
   }
-  std::string out_log = std::string();
-  char timeStr[64] = { 0 };
-  time_t now = time(NULL);
+  u64 position = 0;
+  log_slot* slot = claim_slot(ls, &position);
+  if (not slot) {
+    return;
+  }
+  slot->timestamp = monotonic_now();
+  slot->format = nullptr;
+  slot->severity = ls;
+  va_list arg_ptr;
+  va_start(arg_ptr, fmt);
+  const i32 length = vsnprintf(slot->text, LOG_LINE_MAX, fmt, arg_ptr);
+  va_end(arg_ptr);
+  slot->length = (length < 0) ? 0 : FMIN((u32)length, (u32)LOG_LINE_MAX - 1);
+  publish_slot(slot, position, ls);
+}
 
-  struct tm *tm_info = localtime(&now);
-  strftime(timeStr, sizeof(timeStr), "[%Y-%m-%d %H:%M:%S", tm_info);
-  out_log.append(timeStr);
+bool logging_begin_record(logging_severity ls, const char* fmt, log_record* out_record) {
+  if(not state or state == nullptr or ls < LOGGING_SEVERITY) {
+		return false;
+  }
+  u64 position = 0;
+  log_slot* slot = claim_slot(ls, &position);
+  if (not slot) {
+    return false;
+  }
+  slot->timestamp = monotonic_now();
+  slot->format = fmt;
+  slot->severity = ls;
+  *out_record = log_record {(u8*)slot->text, slot, position, ls};
+  return true;
+}
+
+void logging_commit_record(const log_record* record, u32 payload_size) {
+  log_slot* slot = (log_slot*)record->slot;
+  slot->length = payload_size;
+  publish_slot(slot, record->position, record->severity);
+}
+
+static void write_batch(u64 size) {
+  if (size == 0 or not state->file) {
+    return;
+  }
+  fwrite(state->batch, 1, size, state->file);
+  state->file_size += size;
+}
+
+static void writer_main(void) {
+  u64 read_position = 0;
+  u64 reported_drops = 0;
+  const u32 max_line = 64 + LOG_DECODED_LINE_MAX;
+
+  for (;;) {
+    const bool running = state->running.load();
+    u64 batch_size = 0;
+    u64 line_count = 0;
+
+    for (;;) {
+      log_slot* slot = &state->ring[read_position & LOG_RING_MASK];
+      if (slot->sequence.load(std::memory_order_acquire) != read_position + 1) {
+        break;
+      }
+      if (batch_size + max_line > LOG_WRITE_BATCH_SIZE) {
+        write_batch(batch_size);
+        batch_size = 0;
+      }
+      batch_size += format_prefix(state->batch + batch_size, slot->timestamp, slot->severity);
+      if (slot->format) {
+        batch_size += decode_record(state->batch + batch_size, slot);
+      }
+      else {
+        copy_memory(state->batch + batch_size, slot->text, slot->length);
+        batch_size += slot->length;
+      }
+      state->batch[batch_size++] = '\n';
+      slot->sequence.store(read_position + LOG_RING_CAPACITY, std::memory_order_release);
+      read_position++;
+      line_count++;
+    }
+
+    const u64 drops = state->dropped_count.load(std::memory_order_relaxed);
+    if (drops != reported_drops) {
+      if (batch_size + max_line > LOG_WRITE_BATCH_SIZE) {
+        write_batch(batch_size);
+        batch_size = 0;
+      }
+      batch_size += format_prefix(state->batch + batch_size, monotonic_now(), LOG_SEV_WARNING);
+      batch_size += snprintf(state->batch + batch_size, LOG_LINE_MAX, "Logger ring full, %llu lines dropped\n", drops - reported_drops);
+      reported_drops = drops;
+      line_count++;
+    }
+
+    if (line_count > 0) {
+      write_batch(batch_size);
+      if (state->file) fflush(state->file);
+      if (state->file_size >= LOG_FILE_MAX_SIZE) {
+        rotate_log_file();
+      }
+    }
+    {
+      std::unique_lock<std::mutex> lock(state->wake_mutex);
+      state->flushed_position.store(read_position, std::memory_order_release);
+      state->flushed.notify_all();
+      if (line_count > 0) {
+        continue;
+      }
+      if (not running) {
+        break;
+      }
+      if (state->flush_request <= read_position) {
+        state->wake.wait_for(lock, std::chrono::milliseconds(LOG_WRITER_IDLE_WAIT_MS));
+      }
+    }
+  }
+}
+
+static u32 format_prefix(char* dest, u64 monotonic_timestamp, logging_severity severity) {
+  const time_t timestamp = (time_t)(((i64)monotonic_timestamp + state->wall_clock_offset) / 1000000000ll);
+  // Lines arrive in bursts with the same second, localtime only runs when it changes
+  static thread_local time_t cached_time = -1;
+  static thread_local char cached_text[32];
+  static thread_local u32 cached_length = 0;
+  if (timestamp != cached_time) {
+    struct tm tm_info;
+    #if PLATFORM_WINDOWS
+      localtime_s(&tm_info, &timestamp);
+    #else
+      localtime_r(&timestamp, &tm_info);
+    #endif
+    cached_length = (u32)strftime(cached_text, sizeof(cached_text), "[%Y-%m-%d %H:%M:%S", &tm_info);
+    cached_time = timestamp;
+  }
+  copy_memory(dest, cached_text, cached_length);
 
-  switch (ls)
+  const char* tag = "";
+  switch (severity)
   {
-    case LOG_SEV_INFO : out_log.append("::INFO]: "); break;
-    case LOG_SEV_WARNING : out_log.append("::WARN]: "); break;
-    case LOG_SEV_ERROR : out_log.append("::ERROR]: "); break;
-    case LOG_SEV_FATAL : out_log.append("::FATAL]: "); break;
-    default: break;
-  }
-  __builtin_va_list arg_ptr;
-  va_start(arg_ptr, fmt); 
-
-  // https://stackoverflow.com/questions/19009094/c-variable-arguments-with-stdstring-only
-  // reliably acquire the size from a copy of
-  // the variable argument array
-  // and a functionally reliable call
-  // to mock the formatting
-  va_list arg_ptr_copy;
-  va_copy(arg_ptr_copy, arg_ptr);
-  const int iLen = std::vsnprintf(NULL, 0, fmt, arg_ptr_copy);
-  va_end(arg_ptr_copy);
-
-  // return a formatted string without
-  // risking memory mismanagement
-  // and without assuming any compiler
-  // or platform specific behavior
-  std::vector<char> zc(iLen + 1);
-  std::vsnprintf(zc.data(), zc.size(), fmt, arg_ptr);
-  va_end(arg_ptr);
+    case LOG_SEV_TRACE : tag = "::TRACE]: "; break;
+    case LOG_SEV_DEBUG : tag = "::DEBUG]: "; break;
+    case LOG_SEV_INFO : tag = "::INFO]: "; break;
+    case LOG_SEV_WARNING : tag = "::WARN]: "; break;
+    case LOG_SEV_ERROR : tag = "::ERROR]: "; break;
+    case LOG_SEV_FATAL : tag = "::FATAL]: "; break;
+    default: tag = "]: "; break;
+  }
+  const u32 tag_length = (u32)strlen(tag);
+  copy_memory(dest + cached_length, tag, tag_length);
+  return cached_length + tag_length;
+}
 
-  out_log.append(std::string(zc.data(), zc.size()-1)).append("\n");
-	std::string& log = state->logs.emplace_back(out_log);
+/**
+ * @brief Expands a deferred record with its format string. Every conversion is printed on its own with the length
+ * modifier replaced by the recorded argument's type, so %d with an i64 argument or %f with a float stays well defined.
+ */
+static u32 decode_record(char* dest, const log_slot* slot) {
+  const u8* payload = (const u8*)slot->text;
+  const u8* payload_end = payload + slot->length;
+  const u8* cursor = payload + 1;
+  u32 out = 0;
+  char spec[LOG_SPEC_MAX + 4];
 
-	if (ls >= LOGGING_SEVERITY) {
-		const char * path = TextFormat("%s%s",LOG_FILE_LOCATION, LOG_FILE_NAME);
-    if (FileExists(path)) {
-      char * logged_text = LoadFileText(path);
-      SaveFileText(path, TextFormat("%s%s", logged_text, log.c_str()));
-      UnloadFileText(logged_text);
+  for (const char* fmt = slot->format; *fmt and out < LOG_DECODED_LINE_MAX - 1; ++fmt) {
+    if (*fmt != '%') {
+      dest[out++] = *fmt;
+      continue;
+    }
+    if (fmt[1] == '%') {
+      dest[out++] = '%';
+      ++fmt;
+      continue;
+    }
+    // Flags, width and precision are kept, length modifiers are dropped. '*' widths aren't recorded.
+    u32 spec_length = 0;
+    spec[spec_length++] = *fmt++;
+    while (*fmt and strchr("-+ #0123456789.", *fmt) and spec_length < LOG_SPEC_MAX) {
+      spec[spec_length++] = *fmt++;
+    }
+    while (*fmt and strchr("hljztL", *fmt)) {
+      ++fmt;
+    }
+    if (not *fmt) {
+      break;
+    }
+    const char conversion = *fmt;
+    const u32 room = LOG_DECODED_LINE_MAX - out;
+
+    if (cursor + 1 > payload_end) {
+      out += snprintf(dest + out, room, "<?>");
+      continue;
+    }
+    const log_arg_type type = (log_arg_type)*cursor++;
+    if (type == LOG_ARG_STRING) {
+      u16 stored_length = 0;
+      copy_memory(&stored_length, cursor, sizeof(u16));
+      u16 length = stored_length;
+      cursor += sizeof(u16);
+      const char* precision = (const char*)memchr(spec, '.', spec_length);
+      if (precision) {
+        const u32 max_length = (u32)atoi(precision + 1);
+        if (max_length < length) length = (u16)max_length;
+        spec_length = (u32)(precision - spec);
+      }
+      spec[spec_length++] = '.';
+      spec[spec_length++] = '*';
+      spec[spec_length++] = 's';
+      spec[spec_length] = '\0';
+      out += snprintf(dest + out, room, spec, (i32)length, (const char*)cursor);
+      cursor += stored_length;
     }
     else {
-      SaveFileText(path, TextFormat("%s", log.c_str()));
+      u64 bits = 0;
+      copy_memory(&bits, cursor, 8);
+      cursor += 8;
+      if (type == LOG_ARG_F64 or strchr("eEfFgGaA", conversion)) {
+        f64 value = 0.0;
+        if (type == LOG_ARG_F64) copy_memory(&value, &bits, 8);
+        else value = (type == LOG_ARG_I64) ? (f64)(i64)bits : (f64)bits;
+        spec[spec_length++] = strchr("eEfFgGaA", conversion) ? conversion : 'g';
+        spec[spec_length] = '\0';
+        out += snprintf(dest + out, room, spec, value);
+      }
+      else if (conversion == 'p' or type == LOG_ARG_POINTER) {
+        spec[spec_length++] = 'p';
+        spec[spec_length] = '\0';
+        out += snprintf(dest + out, room, spec, (void*)(uintptr_t)bits);
+      }
+      else if (conversion == 'c') {
+        spec[spec_length++] = 'c';
+        spec[spec_length] = '\0';
+        out += snprintf(dest + out, room, spec, (i32)bits);
+      }
+      else {
+        spec[spec_length++] = 'l';
+        spec[spec_length++] = 'l';
+        spec[spec_length++] = strchr("diouxX", conversion) ? conversion : 'd';
+        spec[spec_length] = '\0';
+        if (type == LOG_ARG_I64 and (conversion == 'd' or conversion == 'i')) out += snprintf(dest + out, room, spec, (long long)(i64)bits);
+        else out += snprintf(dest + out, room, spec, (unsigned long long)bits);
+      }
     }
-	}
+    if (out > LOG_DECODED_LINE_MAX - 1) {
+      out = LOG_DECODED_LINE_MAX - 1;
+    }
+  }
+  return out;
+}
+
+// log.txt -> log.txt.1 -> ... -> log.txt.LOG_FILE_MAX_ROTATIONS, the oldest one is overwritten
+static void rotate_log_file(void) {
+  char from[LOG_PATH_MAX + 8];
+  char to[LOG_PATH_MAX + 8];
+  if (state->file) fclose(state->file);
+  for (u32 i = LOG_FILE_MAX_ROTATIONS - 1; i >= 1; --i) {
+    snprintf(from, sizeof(from), "%s.%u", state->path, i);
+    snprintf(to, sizeof(to), "%s.%u", state->path, i + 1);
+    rename(from, to);
+  }
+  snprintf(to, sizeof(to), "%s.1", state->path);
+  rename(state->path, to);
+
+  state->file = fopen(state->path, "wb");
+  state->file_size = 0;
 }
@@ -1,6 +1,20 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include "defines.h"
+
+#include <stdint.h> // Required for: uintptr_t
+#include <string.h> // Required for: memcpy(), strlen()
+#include <type_traits>
+
+#define LOG_RING_CAPACITY 4096
+#define LOG_LINE_MAX 256 // Longer messages are truncated
+
+// 1: call sites store the format pointer and raw arguments, the writer thread formats. 0: format on the calling thread.
+#ifndef LOG_DEFERRED_FORMATTING
+#define LOG_DEFERRED_FORMATTING 1
+#endif
+
 typedef enum logging_severity {
 	LOG_SEV_UNDEFINED,
 	LOG_SEV_TRACE,
@@ -12,16 +26,117 @@ typedef enum logging_severity {
 	LOG_SEV_MAX,
 } logging_severity;
 
+typedef enum log_arg_type {
+  LOG_ARG_I64,
+  LOG_ARG_U64,
+  LOG_ARG_F64,
+  LOG_ARG_STRING, // Copied into the record, u16 length followed by the bytes
+  LOG_ARG_POINTER,
+} log_arg_type;
+
+/**
+ * @brief Slot claimed by logging_begin_record(). Payload is LOG_LINE_MAX bytes, valid until logging_commit_record().
+ */
+typedef struct log_record {
+  u8* payload;
+  void* slot;
+  u64 position;
+  logging_severity severity;
+} log_record;
+
+/**
+ * @brief Formats into a slot of the ring and returns, a writer thread appends the lines to the log file in batches.
+ * When the ring is full the line is dropped and counted. Fatal lines wait for room and are flushed before returning.
+ */
 void inc_logging(logging_severity ls, const char* fmt, ...);
 
-#define ITRACE(fmt, ...) do { inc_logging(LOG_SEV_TRACE, 		fmt __VA_OPT__(,) __VA_ARGS__); } while(0)
-#define IDEBUG(fmt, ...) do { inc_logging(LOG_SEV_DEBUG, 		fmt __VA_OPT__(,) __VA_ARGS__); } while(0)
-#define IINFO(fmt, ...) 	do { inc_logging(LOG_SEV_INFO, 			fmt __VA_OPT__(,) __VA_ARGS__); } while(0)
-#define IWARN(fmt, ...) 	do { inc_logging(LOG_SEV_WARNING,	fmt __VA_OPT__(,) __VA_ARGS__); } while(0)
-#define IERROR(fmt, ...) do { inc_logging(LOG_SEV_ERROR,			fmt __VA_OPT__(,) __VA_ARGS__); } while(0)
-#define IFATAL(fmt, ...) do { inc_logging(LOG_SEV_FATAL,			fmt __VA_OPT__(,) __VA_ARGS__); } while(0)
+/**
+ * @brief fmt doubles as the record's format ID, it has to outlive the logging system. Returns false if the line is filtered or dropped.
+ */
+bool logging_begin_record(logging_severity ls, const char* fmt, log_record* out_record);
+void logging_commit_record(const log_record* record, u32 payload_size);
+
+template <typename T>
+constexpr log_arg_type log_arg_type_of(void) {
+  typedef std::decay_t<T> U;
+  if constexpr (std::is_floating_point_v<U>) return LOG_ARG_F64;
+  else if constexpr (std::is_enum_v<U>) return std::is_signed_v<std::underlying_type_t<U>> ? LOG_ARG_I64 : LOG_ARG_U64;
+  else if constexpr (std::is_integral_v<U>) return std::is_signed_v<U> ? LOG_ARG_I64 : LOG_ARG_U64;
+  else if constexpr (std::is_same_v<U, char*> or std::is_same_v<U, const char*>) return LOG_ARG_STRING;
+  else if constexpr (std::is_pointer_v<U> or std::is_null_pointer_v<U>) return LOG_ARG_POINTER;
+  else static_assert(std::is_pointer_v<U>, "Unsupported log argument type");
+}
+
+/**
+ * @brief Appends [type][value] to the payload. Returns the bytes written, 0 when the argument doesn't fit.
+ */
+template <typename T>
+inline u32 log_encode_arg(u8* dest, u32 capacity, T value) {
+  constexpr log_arg_type type = log_arg_type_of<T>();
+  if constexpr (type == LOG_ARG_STRING) {
+    if (capacity < 1 + sizeof(u16)) return 0;
+    const char* text = value ? value : "(null)";
+    u64 length = strlen(text);
+    if (length > capacity - 1 - sizeof(u16)) length = capacity - 1 - sizeof(u16);
+    const u16 stored = (u16)length;
+    dest[0] = (u8)type;
+    memcpy(dest + 1, &stored, sizeof(u16));
+    memcpy(dest + 1 + sizeof(u16), text, stored);
+    return 1 + sizeof(u16) + stored;
+  }
+  else {
+    if (capacity < 1 + 8) return 0;
+    dest[0] = (u8)type;
+    if constexpr (type == LOG_ARG_F64) { const f64 v = (f64)value; memcpy(dest + 1, &v, 8); }
+    else if constexpr (type == LOG_ARG_POINTER) { const u64 v = (u64)(uintptr_t)value; memcpy(dest + 1, &v, 8); }
+    else if constexpr (type == LOG_ARG_I64) { const i64 v = (i64)value; memcpy(dest + 1, &v, 8); }
+    else { const u64 v = (u64)value; memcpy(dest + 1, &v, 8); }
+    return 1 + 8;
+  }
+}
+
+/**
+ * @brief Records the format pointer, a monotonic timestamp and the raw arguments. No formatting, no clock conversion.
+ */
+template <typename... Args>
+inline void inc_logging_deferred(logging_severity ls, const char* fmt, Args... args) {
+  log_record record;
+  if (not logging_begin_record(ls, fmt, &record)) {
+    return;
+  }
+  u32 size = 1;
+  record.payload[0] = (u8)sizeof...(Args);
+  ((size += log_encode_arg(record.payload + size, LOG_LINE_MAX - size, args)), ...);
+  logging_commit_record(&record, size);
+}
+
+#if LOG_DEFERRED_FORMATTING
+  // The empty literal rejects runtime format strings, their address is the record's format ID
+  #define LOG_DISPATCH(sev, fmt, ...) inc_logging_deferred(sev, "" fmt __VA_OPT__(,) __VA_ARGS__)
+#else
+  #define LOG_DISPATCH(sev, fmt, ...) inc_logging(sev, fmt __VA_OPT__(,) __VA_ARGS__)
+#endif
+
+#define ITRACE(fmt, ...) do { LOG_DISPATCH(LOG_SEV_TRACE, 		fmt __VA_OPT__(,) __VA_ARGS__); } while(0)
+#define IDEBUG(fmt, ...) do { LOG_DISPATCH(LOG_SEV_DEBUG, 		fmt __VA_OPT__(,) __VA_ARGS__); } while(0)
+#define IINFO(fmt, ...) 	do { LOG_DISPATCH(LOG_SEV_INFO, 			fmt __VA_OPT__(,) __VA_ARGS__); } while(0)
+#define IWARN(fmt, ...) 	do { LOG_DISPATCH(LOG_SEV_WARNING,	fmt __VA_OPT__(,) __VA_ARGS__); } while(0)
+#define IERROR(fmt, ...) do { LOG_DISPATCH(LOG_SEV_ERROR,			fmt __VA_OPT__(,) __VA_ARGS__); } while(0)
+#define IFATAL(fmt, ...) do { LOG_DISPATCH(LOG_SEV_FATAL,			fmt __VA_OPT__(,) __VA_ARGS__); } while(0)
 
 [[__nodiscard__]] bool logging_system_initialize(void);
 void logging_system_shutdown(void);
 
-#endif
\ No newline at end of file
+/**
+ * @brief Blocks until every line logged before the call is written to the file.
+ */
+void logging_system_flush(void);
+u64 logging_get_dropped_count(void);
+
+/**
+ * @brief Logs from every job thread, reports sustained lines per second and the call site latency percentiles
+ * for both the formatted and the deferred path.
+ */
+void logging_run_benchmark(void);
+
+#endif
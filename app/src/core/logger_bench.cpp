@@ -0,0 +1,73 @@
+#include "logger.h"
+
+#include <raylib.h>
+#include <algorithm>
+#include <chrono>
+
+#include "core/fjob.h"
+#include "core/fmemory.h"
+
+#define LOG_BENCH_LINES_PER_THREAD 200000u
+
+typedef struct log_bench_context {
+  u32* latencies_ns; // LOG_BENCH_LINES_PER_THREAD per thread
+  u32 burst_size;
+  bool deferred;
+} log_bench_context;
+
+static void log_bench_task(u32 begin, u32 end, void* data) {
+  log_bench_context* ctx = (log_bench_context*)data;
+  for (u32 t = begin; t < end; ++t) {
+    u32* latencies = ctx->latencies_ns + (u64)t * LOG_BENCH_LINES_PER_THREAD;
+    for (u32 i = 0; i < LOG_BENCH_LINES_PER_THREAD; ++i) {
+      const auto start = std::chrono::steady_clock::now();
+      if (ctx->deferred) {
+        inc_logging_deferred(LOG_SEV_INFO, "bench thread %u line %u value %.3f", t, i, i * 0.5f);
+      }
+      else {
+        inc_logging(LOG_SEV_INFO, "bench thread %u line %u value %.3f", t, i, i * 0.5f);
+      }
+      latencies[i] = (u32)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+      // Let the writer catch up between bursts so the calls measure writes instead of drops
+      if ((i + 1) % ctx->burst_size == 0) {
+        logging_system_flush();
+      }
+    }
+  }
+}
+
+static void run_pass(log_bench_context* ctx, const char* name) {
+  const u32 thread_count = job_thread_count();
+  const u64 total = (u64)thread_count * LOG_BENCH_LINES_PER_THREAD;
+
+  const u64 dropped_before = logging_get_dropped_count();
+  const auto start = std::chrono::steady_clock::now();
+  job_parallel_for(thread_count, 1, log_bench_task, ctx);
+  const f64 submit_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+  logging_system_flush();
+  const f64 total_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+  const u64 dropped = logging_get_dropped_count() - dropped_before;
+
+  std::nth_element(ctx->latencies_ns, ctx->latencies_ns + total / 2, ctx->latencies_ns + total);
+  const u32 p50 = ctx->latencies_ns[total / 2];
+  std::nth_element(ctx->latencies_ns, ctx->latencies_ns + total * 99 / 100, ctx->latencies_ns + total);
+  const u32 p99 = ctx->latencies_ns[total * 99 / 100];
+
+  TRACELOG(LOG_INFO, "LOG: %s, %u threads, %llu lines in %.1f ms (%.1f ms until on disk), %llu dropped",
+    name, thread_count, total, submit_ms, total_ms, dropped);
+  TRACELOG(LOG_INFO, "LOG: %s, sustained %.0f written lines/s, call site p50 %u ns, p99 %u ns",
+    name, (total - dropped) / (total_ms / 1000.0), p50, p99);
+}
+
+void logging_run_benchmark(void) {
+  log_bench_context ctx = {};
+  ctx.latencies_ns = (u32*)allocate_memory((u64)job_thread_count() * LOG_BENCH_LINES_PER_THREAD * sizeof(u32), false, MEMORY_TAG_LOGGER);
+  ctx.burst_size = (LOG_RING_CAPACITY / 2) / job_thread_count();
+  ctx.burst_size = (ctx.burst_size > 0) ? ctx.burst_size : 1;
+
+  ctx.deferred = false;
+  run_pass(&ctx, "formatted");
+  ctx.deferred = true;
+  run_pass(&ctx, "deferred");
+  free_memory(ctx.latencies_ns);
+}
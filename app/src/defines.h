@@ -38,6 +38,8 @@
 #endif
 
 #define TOTAL_ALLOCATED_MEMORY 16 * 1024 * 1024
+#define FRAME_ARENA_SIZE 2 * 1024 * 1024
+#define SCRATCH_ARENA_SIZE 4 * 1024 * 1024 // Per thread that asks for one, holds a compressed texture while it decodes
 #define TARGET_FPS 60
 
 #define FCLAMP(value, min, max) ((value <= min) ? min : (value >= max) ? max : value)
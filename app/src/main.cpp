@@ -2,134 +2,276 @@
 
 #include "raymath.h"
 #include "rlgl.h"
-#include <math.h> // Required for: tanf()
+#include <math.h> // Required for: tanf(), sinf()
 
 #include "defines.h"
 
+#include <core/event.h>
+#include <core/fjob.h>
+#include <core/fmath.h>
 #include <core/fmemory.h>
+#include <core/fnoise.h>
+#include <core/fprofile.h>
+#include <core/fpool.h>
+#include <core/frandom.h>
+#include <core/fsdf.h>
+#include <core/logger.h>
+#include <render/atmosphere.h>
+#include <render/bench.h>
+#include <render/gpu_timer.h>
+#include <render/shader.h>
+#include <render/texture.h>
+#include <render/uniform.h>
+#include <world/scatter.h>
+#include <world/scene.h>
+#include <world/terrain.h>
 
 #define GLSL_VERSION 330
 #define SHADER_FILE "../app/custom_resources/"
 #define TERRAIN_FILE "./terrain/"
-
-typedef struct raymarch_locs {
-  u32 camPos;
-  u32 camDir;
-  u32 screenCenter;
-  u32 time;
-} raymarch_locs;
-
-typedef struct map_obj_locs {
-  u32 time;
-  u32 viewPos;
-  u32 viewCenter;
-  u32 resolution;
-} map_obj_locs;
-
-typedef struct atmosphere_locs {
-  u32 time;
-  u32 viewPos;
-  u32 viewTarget;
-  u32 resolution;
-} atmosphere_locs;
-
-typedef struct terrain_locs {
-  u32 viewPos;
-  u32 viewTarget;
-  u32 resolution;
-  u32 time;
-} terrain_locs;
+#define TERRAIN_HEIGHTMAP_SIZE 1024
+#define SDF_REFERENCE_FILE "sdf_reference.png"
+#define CLOUD_SHAPE_CACHE_FILE "cloud_shape.noise"
+#define CLOUD_DETAIL_CACHE_FILE "cloud_detail.noise"
+#define TERRAIN_CACHE_FILE "terrain.cache"
+#define PROFILE_CAPTURE_FILE "frame_capture.json"
+#define PROFILE_CAPTURE_FRAMES 300
+#define BENCH_REPORT_FILE "bench_report.json"
+#define BENCH_KEYS_FILE "bench_keys.txt"
+#define SCENE_MAX_INSTANCES 131072
+#define SCENE_STRESS_COUNT 100000
+#define SCENE_STRESS_MOVERS 1000
+#define SCENE_STRESS_MODELS 6
+#define SCATTER_TYPE_COUNT 5
+#define SCATTER_RESEED_RADIUS 10.f
 
 typedef struct main_system_state {
 	Model guide_plane;
-	Model terrain;
+  uniform_cache tiling_uniforms;
+  Vector2 tiling;
+  shader_handle tiling_shader;
+  shader_handle terrain_shader;
+  shader_handle atmosphere_shader;
+  shader_handle atmosphere_upsample_shader;
+  shader_handle map_objects_shader;
+  atmosphere_measurement atmosphere_error;
+  Model stress_models[SCENE_STRESS_MODELS];
+  scene_instance* stress_movers;
+  Matrix* stress_mover_transforms;
+  bool stress_scene;
+  bool show_memory_report;
+  bool show_profiler;
+  bool bench;
 } main_system_state;
 static main_system_state * state = nullptr;
 
+// Grass, bushes, pines, rocks and boulders, drawn with map_objects. Heights are world units, the terrain spans [-5, 5]
+static const scatter_rule scatter_rules[SCATTER_TYPE_COUNT] = {
+  { .spacing = 0.25f, .density = 1.f, .min_height = -5.f, .max_height = 2.5f, .min_slope = 0.f, .max_slope = 0.8f, .min_scale = 0.6f, .max_scale = 1.2f, .max_tilt = 0.25f, .sink = 0.05f },
+  { .spacing = 1.f, .density = 0.6f, .min_height = -4.f, .max_height = 1.f, .min_slope = 0.f, .max_slope = 0.5f, .min_scale = 0.5f, .max_scale = 1.1f, .max_tilt = 0.1f, .sink = 0.3f },
+  { .spacing = 2.5f, .density = 0.5f, .min_height = -3.f, .max_height = 2.5f, .min_slope = 0.f, .max_slope = 0.6f, .min_scale = 0.8f, .max_scale = 1.6f, .max_tilt = 0.05f, .sink = 0.05f },
+  { .spacing = 0.6f, .density = 0.6f, .min_height = -5.f, .max_height = 5.f, .min_slope = 0.3f, .max_slope = 10.f, .min_scale = 0.2f, .max_scale = 0.6f, .max_tilt = 0.4f, .sink = 0.2f },
+  { .spacing = 3.f, .density = 0.4f, .min_height = -5.f, .max_height = 5.f, .min_slope = 0.6f, .max_slope = 10.f, .min_scale = 0.8f, .max_scale = 2.f, .max_tilt = 0.5f, .sink = 0.3f },
+};
+
 // Load custom render texture, create a writable depth texture buffer
 static RenderTexture2D LoadRenderTextureDepthTex(int width, int height);
 static void UnloadRenderTextureDepthTex(RenderTexture2D target);
 void draw_guide_plane(void);
+static void draw_scene_geometry(void* data);
+static void draw_memory_report(i32 x, i32 y);
+static void draw_profile_overlay(i32 x, i32 y);
+static void load_stress_scene(Texture2D texture);
+static void unload_stress_scene(void);
+static void animate_stress_scene(f64 time);
+static bool stress_model_tiled(u32 index);
+static void add_scatter_types(void);
+static void run_sdf_reference(const char* path);
+static terrain_config default_terrain_config(void);
+static void set_terrain_locations(Shader shader);
+static bool on_shader_reloaded(i32 code, event_context context);
 const char * rsrc(const char * file_name);
 const char * rterr(const char * file_name);
 
-int main(void) {
+int main(int argc, char** argv) {
 	memory_system_initialize();
-	state = (main_system_state*)allocate_memory_linear(sizeof(main_system_state), true);
+	state = (main_system_state*)allocate_memory_linear(sizeof(main_system_state), true, MEMORY_TAG_GAME);
+  if (not logging_system_initialize()) {
+    TRACELOG(LOG_ERROR, "LOG: Logging system initialization failed");
+  }
+  if (not job_system_initialize(JOB_WORKERS_AUTO)) {
+    TRACELOG(LOG_ERROR, "JOB: Job system initialization failed");
+  }
+  if (not profile_system_initialize()) {
+    TRACELOG(LOG_ERROR, "PROFILE: Profile system initialization failed");
+  }
+  if (not event_system_initialize()) {
+    TRACELOG(LOG_ERROR, "EVENT: Event system initialization failed");
+  }
+  for (i32 i = 1; i < argc; ++i) {
+    const bool bench_pool = TextIsEqual(argv[i], "--bench-pool");
+    const bool bench_log = TextIsEqual(argv[i], "--bench-log");
+    const bool bench_event = TextIsEqual(argv[i], "--bench-event");
+    const bool bench_job = TextIsEqual(argv[i], "--bench-job");
+    const bool bench_random = TextIsEqual(argv[i], "--bench-random");
+    const bool bench_math = TextIsEqual(argv[i], "--bench-math");
+    const bool bench_sdf = TextIsEqual(argv[i], "--bench-sdf");
+    const bool bench_noise = TextIsEqual(argv[i], "--bench-noise");
+    const bool sdf_reference = TextIsEqual(argv[i], "--sdf-reference");
+    const bool bench_terrain = TextIsEqual(argv[i], "--bench-terrain");
+    const bool bench_terrain_select = TextIsEqual(argv[i], "--bench-terrain-select");
+    const bool bake_textures = TextIsEqual(argv[i], "--bake-textures");
+    const bool bench_textures = TextIsEqual(argv[i], "--bench-textures");
+    const bool bench_scene = TextIsEqual(argv[i], "--bench-scene");
+    const bool bench_scatter = TextIsEqual(argv[i], "--bench-scatter");
+    if (bench_pool or bench_log or bench_event or bench_job or bench_random or bench_math or bench_sdf or bench_noise or sdf_reference
+      or bench_terrain or bench_terrain_select or bake_textures or bench_textures or bench_scene or bench_scatter) {
+      if (bench_pool) memory_pool_run_benchmark();
+      if (bench_log) logging_run_benchmark();
+      if (bench_event) event_run_benchmark();
+      if (bench_job) job_run_benchmark();
+      if (bench_random) random_run_benchmark();
+      if (bench_math) math_run_benchmark();
+      if (bench_sdf) sdf_run_benchmark();
+      if (bench_noise) noise_run_benchmark();
+      if (sdf_reference) run_sdf_reference((i + 1 < argc) ? argv[i + 1] : SDF_REFERENCE_FILE);
+      if (bench_terrain) {
+        const noise_config heightmap_noise = noise_config_default();
+        terrain_run_startup_benchmark(default_terrain_config(), &heightmap_noise);
+      }
+      if (bench_terrain_select) {
+        const noise_config heightmap_noise = noise_config_default();
+        terrain_run_selection_benchmark(default_terrain_config(), &heightmap_noise);
+      }
+      if (bake_textures) texture_bake_directory((i + 1 < argc) ? argv[i + 1] : TERRAIN_FILE);
+      if (bench_textures) texture_run_benchmark((i + 1 < argc) ? argv[i + 1] : TERRAIN_FILE);
+      if (bench_scene) scene_run_benchmark();
+      if (bench_scatter) {
+        const terrain_config config = default_terrain_config();
+        const noise_config heightmap_noise = noise_config_default();
+        if (terrain_system_initialize_cached(config, &heightmap_noise, TERRAIN_CACHE_FILE, nullptr)) {
+          scatter_run_benchmark(Vector2 { config.position.x, config.position.z }, config.world_size, scatter_rules, SCATTER_TYPE_COUNT);
+          terrain_system_shutdown();
+        }
+      }
+      job_system_shutdown();
+      event_system_shutdown();
+      logging_system_shutdown();
+      return 0;
+    }
+  }
+  // The benchmark draws the same frames as the interactive mode into the offscreen target, nothing is presented
+  const char* bench_report = nullptr;
+  bool stress_scene = false;
+  for (i32 i = 1; i < argc; ++i) {
+    if (TextIsEqual(argv[i], "--bench")) {
+      bench_report = (i + 1 < argc and argv[i + 1][0] != '-') ? argv[i + 1] : BENCH_REPORT_FILE;
+      state->bench = true;
+    }
+    if (TextIsEqual(argv[i], "--scene-stress")) {
+      stress_scene = true;
+    }
+  }
+  IINFO("Raylib3D started, %u job threads", job_thread_count());
 
   const Vector2 resolution = Vector2 { 1280.f, 720.f };
+  if (state->bench) {
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+  }
   InitWindow(resolution.x, resolution.y, "Raylib3D");
 
 	Image checker_image = GenImageChecked(1024, 1024, 512, 512, Color {128, 142, 155, 255}, Color {72, 84, 96, 255});
 	Texture checker_texture = LoadTextureFromImage(checker_image);
 
-	Shader shdr_map_obj = LoadShader(0, TextFormat(rsrc("map_objects.fs"), GLSL_VERSION));
-  map_obj_locs map_obj_shdr_locs = {};
-  map_obj_shdr_locs.time = GetShaderLocation(shdr_map_obj, "time");
-  map_obj_shdr_locs.viewPos = GetShaderLocation(shdr_map_obj, "viewPos");
-  map_obj_shdr_locs.viewCenter = GetShaderLocation(shdr_map_obj, "viewCenter");
-  map_obj_shdr_locs.resolution = GetShaderLocation(shdr_map_obj, "resolution");
-
-  SetShaderValue(shdr_map_obj, map_obj_shdr_locs.resolution, &(resolution), RL_SHADER_UNIFORM_VEC2);
+  if (not uniform_system_initialize()) {
+    TRACELOG(LOG_ERROR, "UNIFORM: Uniform system initialization failed");
+  }
+  if (not gpu_timer_system_initialize()) {
+    TRACELOG(LOG_WARNING, "GPU_TIMER: Timestamp queries unavailable, the profiler shows CPU scopes only");
+  }
 
-	std::array<f32, 2> tiling = std::array<f32, 2>({ 10.0f, 10.0f });
-	Shader shdrTiling = LoadShader(0, TextFormat(rsrc("tiling.fs"), GLSL_VERSION));
-	SetShaderValue(shdrTiling, GetShaderLocation(shdrTiling, "tiling"), tiling.data(), SHADER_UNIFORM_VEC2);
+  // Programs come from the binary cache when nothing changed, edits under custom_resources reload them in place
+  if (not shader_system_initialize(SHADER_FILE, "")) {
+    TRACELOG(LOG_ERROR, "SHADER: Shader system initialization failed");
+  }
+  event_register(EVENT_CODE_SHADER_RELOADED, on_shader_reloaded);
+  state->map_objects_shader = shader_load("map_objects.vs", "map_objects.fs");
+
+  state->tiling = Vector2 { 10.0f, 10.0f };
+  state->tiling_shader = shader_load(nullptr, "tiling.fs");
+	Shader shdrTiling = shader_get(state->tiling_shader);
+  uniform_cache_initialize(&state->tiling_uniforms, shdrTiling);
+  uniform_set(&state->tiling_uniforms, "tiling", &state->tiling, SHADER_UNIFORM_VEC2);
 	Mesh plane_mesh = GenMeshPlane(20.f, 20.f, 1.f, 1.f);
 	state->guide_plane = LoadModelFromMesh(plane_mesh);
 	state->guide_plane.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = checker_texture;
   state->guide_plane.materials[0].shader = shdrTiling;
 
-  Shader shdrAtmosphere = LoadShader(0, TextFormat(rsrc("atmosphere.fs"), GLSL_VERSION));
-  atmosphere_locs atmosphere_shdr_locs = atmosphere_locs {
-    .time = static_cast<u32>(GetShaderLocation(shdrAtmosphere, "time")),
-    .viewPos = static_cast<u32>(GetShaderLocation(shdrAtmosphere, "viewPos")),
-    .viewTarget = static_cast<u32>(GetShaderLocation(shdrAtmosphere, "viewTarget")),
-    .resolution = static_cast<u32>(GetShaderLocation(shdrAtmosphere, "resolution")),
-  };
-
-  SetShaderValue(shdrAtmosphere, atmosphere_shdr_locs.resolution, &(resolution), RL_SHADER_UNIFORM_VEC2);
+  state->atmosphere_shader = shader_load(nullptr, "atmosphere.fs");
+  state->atmosphere_upsample_shader = shader_load(nullptr, "atmosphere_upsample.fs");
 
-  // Create terrain
-  [[__maybe_unused__]] Texture2D rocks_tex = LoadTexture(rterr("mntn_gray_d.jpg"));
-  [[__maybe_unused__]] Texture2D grass_tex = LoadTexture(rterr("grass_green_d.jpg"));
-  [[__maybe_unused__]] Texture2D snow_tex = LoadTexture(rterr("snow1_d.jpg"));
+  // Create terrain, its layers decode on the workers while the heightfield is built and stream in over the first frames
+  if (not texture_system_initialize(TEXTURE_UPLOAD_BUDGET)) {
+    TRACELOG(LOG_ERROR, "TEXTURE: Texture system initialization failed");
+  }
+  Texture2D rocks_tex = texture_get(texture_load_async(rterr("mntn_gray_d.jpg"), Color { 112, 112, 116, 255 }));
+  Texture2D grass_tex = texture_get(texture_load_async(rterr("grass_green_d.jpg"), Color { 86, 110, 52, 255 }));
+  Texture2D snow_tex = texture_get(texture_load_async(rterr("snow1_d.jpg"), Color { 232, 236, 240, 255 }));
+
+  state->terrain_shader = shader_load("terrain.vs", "terrain.fs");
+  TRACELOG(LOG_INFO, "SHADER: %u programs ready in %.2f ms, %u from the binary cache", shader_get_stats().program_count,
+    shader_get_stats().startup_ms, shader_get_stats().binary_loads);
+
+  // Heightfield and quadtree ranges are generated once, later launches map them from the cache
+  const noise_config heightmap_noise = noise_config_default();
+  bool terrain_from_cache = false;
+  const f64 terrain_start = GetTime();
+  if (not terrain_system_initialize_cached(default_terrain_config(), &heightmap_noise, TERRAIN_CACHE_FILE, &terrain_from_cache)) {
+    TRACELOG(LOG_ERROR, "TERRAIN: Terrain system initialization failed");
+  }
+  const f64 terrain_cpu_time = GetTime() - terrain_start;
 
-  Shader shdrTerrain = LoadShader(0, rsrc("terrain.fs"));
-  terrain_locs terrain_shdr_locs = {};
-  terrain_shdr_locs.viewPos    = GetShaderLocation(shdrTerrain, "viewPos");
-  terrain_shdr_locs.viewTarget = GetShaderLocation(shdrTerrain, "viewTarget");
-  terrain_shdr_locs.resolution = GetShaderLocation(shdrTerrain, "resolution");
-  terrain_shdr_locs.time = GetShaderLocation(shdrTerrain, "time");
+  // Set terrain shader and texture
+  Material terrain_material = LoadMaterialDefault();
+  terrain_material.shader = shader_get(state->terrain_shader);
+  terrain_material.maps[MATERIAL_MAP_METALNESS].texture = rocks_tex;
+  terrain_material.maps[MATERIAL_MAP_EMISSION].texture = grass_tex;
+  terrain_material.maps[MATERIAL_MAP_OCCLUSION].texture = snow_tex;
+  set_terrain_locations(terrain_material.shader);
+  const f64 terrain_upload_start = GetTime();
+  terrain_load_gpu_resources(terrain_material);
+  TRACELOG(LOG_INFO, "TERRAIN: Heightfield %ix%i %s in %.2f ms, uploaded in %.2f ms (%u threads)", TERRAIN_HEIGHTMAP_SIZE, TERRAIN_HEIGHTMAP_SIZE,
+    terrain_from_cache ? "mapped from cache" : "generated", terrain_cpu_time * 1000.0, (GetTime() - terrain_upload_start) * 1000.0, job_thread_count());
+
+  // Everything drawn besides the terrain and the sky goes through the scene, F10 fills it with the stress scene
+  if (not scene_system_initialize(SCENE_MAX_INSTANCES)) {
+    TRACELOG(LOG_ERROR, "SCENE: Scene system initialization failed");
+  }
+  if (stress_scene) {
+    load_stress_scene(checker_texture);
+  }
 
-  SetShaderValue(shdrTerrain, terrain_shdr_locs.resolution, &(resolution), RL_SHADER_UNIFORM_VEC2);
+  // Rocks and vegetation are placed on the workers by the first scatter_update(), F11 scatters the regions around the camera again
+  const terrain_config terrain = default_terrain_config();
+  if (not scatter_system_initialize(Vector2 { terrain.position.x, terrain.position.z }, terrain.world_size, RANDOM_DEFAULT_SEED)) {
+    TRACELOG(LOG_ERROR, "SCATTER: Scatter system initialization failed");
+  }
+  add_scatter_types();
+  scatter_set_shader(shader_get(state->map_objects_shader));
 
-  // Generate heightmap image for terrain
-  Image heightmap_img = GenImagePerlinNoise(256, 256, 0, 0, 5.0f);    // Load heightmap image (RAM)
-  Texture2D height_texture = LoadTextureFromImage(heightmap_img);    
-  
-  // Create terrain mesh from heightmap
-  Mesh terrain_mesh = GenMeshHeightmap(heightmap_img, Vector3{100.0f, 10.0f, 100.0f});
-  state->terrain = LoadModelFromMesh(terrain_mesh);
-  
-  // Set terrain shader and texture
-  state->terrain.materials[0].shader = shdrTerrain;
-  state->terrain.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = height_texture;
-  state->terrain.materials[0].maps[MATERIAL_MAP_METALNESS].texture = rocks_tex;
-  state->terrain.materials[0].maps[MATERIAL_MAP_EMISSION].texture = grass_tex;
-  state->terrain.materials[0].maps[MATERIAL_MAP_OCCLUSION].texture = snow_tex;
-  shdrTerrain.locs[SHADER_LOC_MAP_METALNESS] = GetShaderLocation(shdrTerrain, "texture1");
-  shdrTerrain.locs[SHADER_LOC_MAP_EMISSION] = GetShaderLocation(shdrTerrain, "texture2");
-  shdrTerrain.locs[SHADER_LOC_MAP_OCCLUSION] = GetShaderLocation(shdrTerrain, "texture3");
-  
-  // Clean up
-  UnloadImage(heightmap_img);
-  
-  SetTargetFPS(60); 
-	DisableCursor();
+  if (not state->bench) {
+    SetTargetFPS(60);
+    DisableCursor();
+  }
 
   // Use Customized function to create writable depth texture buffer
   RenderTexture2D target = LoadRenderTextureDepthTex(resolution.x, resolution.y);
+  if (not atmosphere_system_initialize(resolution.x, resolution.y, shader_get(state->atmosphere_shader), shader_get(state->atmosphere_upsample_shader))) {
+    TRACELOG(LOG_ERROR, "ATMOSPHERE: Atmosphere system initialization failed");
+  }
+  if (not atmosphere_load_noise_volumes(CLOUD_SHAPE_CACHE_FILE, CLOUD_DETAIL_CACHE_FILE)) {
+    TRACELOG(LOG_WARNING, "ATMOSPHERE: Noise volumes are unavailable, clouds use the ALU noise");
+  }
   // Define the camera to look into our 3d world
   Camera camera = Camera { 
     Vector3{0.5f, 1.0f, 1.5f}, // POSITION
@@ -141,75 +283,256 @@ int main(void) {
 
 	[[__maybe_unused__]] f32 delta_time = 0.f;
   [[__maybe_unused__]] Vector4 cloud_pos = Vector4(0.f, 10.f, 0.f);
-	f32 elapsed_time = 0.f;
-	Vector3 viewPos = Vector3 {0.f, 0.f, 0.f};
-	Vector3 viewTarget = Vector3 {0.f, 0.f, 0.f};
+	frame_uniforms frame = {};
+  frame.resolution = resolution;
+  if (state->bench) {
+    bench_config bench = bench_config_default(bench_report);
+    bench.keys_path = BENCH_KEYS_FILE;
+    if (not bench_system_initialize(&bench)) {
+      TRACELOG(LOG_ERROR, "BENCH: Bench system initialization failed");
+      state->bench = false;
+    }
+  }
+  f64 bench_time = 0.0;
 
   while (!WindowShouldClose())
   {
-    UpdateCamera(&camera, CAMERA_FREE);
-		delta_time = GetFrameTime();
-		elapsed_time = GetTime();
-		viewPos = Vector3 { camera.position.x, camera.position.y, camera.position.z };
-		viewTarget = Vector3 { camera.target.x, camera.target.y, camera.target.z };
+    if (state->bench and not bench_begin_frame(&camera, &delta_time, &bench_time)) {
+      break;
+    }
+    {
+      PROFILE_SCOPE("update");
+      job_system_update_main_thread();
+      event_system_dispatch_queued();
+      shader_system_update();
+      texture_system_update();
+      scatter_update();
+    }
+    if (IsKeyPressed(KEY_F2)) {
+      state->show_memory_report = not state->show_memory_report;
+    }
+    if (IsKeyPressed(KEY_F3)) {
+      atmosphere_set_scale((atmosphere_get_scale() == 4) ? 1 : atmosphere_get_scale() * 2);
+    }
+    if (IsKeyPressed(KEY_F5)) {
+      atmosphere_set_temporal(not atmosphere_get_temporal());
+    }
+    if (IsKeyPressed(KEY_F6)) {
+      atmosphere_set_noise_volumes(not atmosphere_get_noise_volumes());
+    }
+    if (IsKeyPressed(KEY_F7)) {
+      state->show_profiler = not state->show_profiler;
+    }
+    if (IsKeyPressed(KEY_F8)) {
+      profile_capture_begin(PROFILE_CAPTURE_FRAMES, PROFILE_CAPTURE_FILE);
+    }
+    if (IsKeyPressed(KEY_F9)) {
+      bench_record_key(BENCH_KEYS_FILE, camera);
+    }
+    if (IsKeyPressed(KEY_F11)) {
+      scatter_invalidate(Vector2 { camera.position.x - SCATTER_RESEED_RADIUS, camera.position.z - SCATTER_RESEED_RADIUS },
+        Vector2 { camera.position.x + SCATTER_RESEED_RADIUS, camera.position.z + SCATTER_RESEED_RADIUS });
+    }
+    if (IsKeyPressed(KEY_F10)) {
+      if (state->stress_scene) {
+        unload_stress_scene();
+      } else {
+        load_stress_scene(checker_texture);
+      }
+    }
+    if (not state->bench) {
+      UpdateCamera(&camera, CAMERA_FREE);
+      delta_time = GetFrameTime();
+    }
 
     // Camera FOV is pre-calculated in the camera distance
     f32 camDist = 1.0f / (tanf(camera.fovy * 0.5f * DEG2RAD));
     // Update Camera Looking Vector. Vector length determines FOV
     [[__maybe_unused__]] Vector3 viewDir = Vector3Scale(Vector3Normalize(Vector3Subtract(camera.target, camera.position)), camDist);
 
-    SetShaderValue(shdrAtmosphere, atmosphere_shdr_locs.viewPos,    &(viewPos), RL_SHADER_UNIFORM_VEC3);
-    SetShaderValue(shdrAtmosphere, atmosphere_shdr_locs.viewTarget, &(viewTarget), RL_SHADER_UNIFORM_VEC3);
-    SetShaderValue(shdrAtmosphere, atmosphere_shdr_locs.time, 	    &(elapsed_time), RL_SHADER_UNIFORM_FLOAT);
-    
-    // Update terrain shader uniforms
-    SetShaderValue(shdrTerrain, terrain_shdr_locs.viewPos, &(viewPos), RL_SHADER_UNIFORM_VEC3);
-    SetShaderValue(shdrTerrain, terrain_shdr_locs.viewTarget, &(viewTarget), RL_SHADER_UNIFORM_VEC3);
-    SetShaderValue(shdrTerrain, terrain_shdr_locs.time, &(elapsed_time), RL_SHADER_UNIFORM_FLOAT);
-    
-    SetShaderValue(shdr_map_obj, map_obj_shdr_locs.viewPos, &(viewPos), RL_SHADER_UNIFORM_VEC3);
-    SetShaderValue(shdr_map_obj, map_obj_shdr_locs.viewCenter, &(viewTarget), RL_SHADER_UNIFORM_VEC3);
-    SetShaderValue(shdr_map_obj, map_obj_shdr_locs.time, 	 &(elapsed_time), RL_SHADER_UNIFORM_FLOAT);
+    // Camera and time go up once for every program through the frame_data block
+    frame.view_pos = camera.position;
+    frame.view_target = camera.target;
+    frame.time = state->bench ? bench_time : GetTime();
+    frame.delta_time = delta_time;
+    uniform_update_frame(&frame);
+
+    terrain_select(camera, resolution.x / resolution.y);
+    if (state->stress_scene) {
+      animate_stress_scene(frame.time);
+    }
+    scene_cull(camera, resolution.x / resolution.y);
 
     //----------------------------------------------------------------------------------
-    BeginTextureMode(target);
-		{
-    	ClearBackground(WHITE);
-    	rlEnableDepthTest();
-
-    	BeginShaderMode(shdrAtmosphere); 
-      {
-				DrawRectangleRec(Rectangle{0.f, 0.f,  resolution.x, resolution.y}, WHITE);
-			}
-    	EndShaderMode();
-
-    	BeginMode3D(camera);
-			{
-				//draw_guide_plane();
-  
-        // Draw the terrain
-        DrawModel(state->terrain, Vector3{0.0f, -5.0f, 0.0f}, 1.0f, WHITE);
-			}
-    	EndMode3D();
-      
-		}
-    EndTextureMode();
+    if (IsKeyPressed(KEY_F4)) {
+      state->atmosphere_error = atmosphere_measure(target, camera, draw_scene_geometry, nullptr);
+    }
+    atmosphere_render_scene(target, camera, draw_scene_geometry, nullptr);
     //----------------------------------------------------------------------------------
 
     BeginDrawing();
       ClearBackground(RAYWHITE);
-      DrawTextureRec(target.texture, Rectangle{0, 0, resolution.x, -resolution.y}, Vector2{0.f, 0.f}, WHITE);
-      DrawFPS(10, 10);
+      if (not state->bench) {
+        PROFILE_SCOPE("present");
+        PROFILE_GPU_SCOPE("present");
+        atmosphere_present(target, Vector2{0.f, 0.f});
+      }
+      if (not state->bench) {
+        PROFILE_SCOPE("hud");
+        DrawFPS(10, 10);
+        terrain_stats terr_stats = terrain_get_stats();
+        DrawText(TextFormat("terrain: %u draws, %llu tris", terr_stats.draw_count, terr_stats.triangle_count), 10, 32, 10, LIME);
+        const uniform_stats uniforms = uniform_get_stats();
+        DrawText(TextFormat("uniforms: %u uploads, %u skipped, %u block uploads", uniforms.uploads, uniforms.skipped, uniforms.block_uploads), 10, 46, 10, LIME);
+        DrawText(TextFormat("atmosphere: 1/%u res (F3), temporal %s (F5), F4 measures: %llu -> %llu fragments, %.2f -> %.2f ms, rms %.4f",
+          atmosphere_get_scale(), atmosphere_get_temporal() ? "on" : "off", state->atmosphere_error.full_samples, state->atmosphere_error.reduced_samples,
+          state->atmosphere_error.full_gpu_ms, state->atmosphere_error.reduced_gpu_ms, state->atmosphere_error.rms_error), 10, 60, 10, LIME);
+        const atmosphere_noise_stats noise = atmosphere_get_noise_stats();
+        DrawText(TextFormat("clouds: %s noise (F6), volumes %s in %.1f ms, %llu KB, F4 sky: %.2f ms alu, %.2f ms volumes",
+          atmosphere_get_noise_volumes() ? "volume" : "alu", noise.from_cache ? "loaded" : "baked", noise.bake_ms, noise.gpu_bytes / 1024,
+          state->atmosphere_error.alu_noise_gpu_ms, state->atmosphere_error.volume_noise_gpu_ms), 10, 74, 10, LIME);
+        const shader_stats shaders = shader_get_stats();
+        DrawText(TextFormat("shaders: %u programs, %u from binaries, %u reloads (%u failed), last %.1f ms, %s",
+          shaders.program_count, shaders.binary_loads, shaders.reloads, shaders.failed_reloads, shaders.last_reload_ms,
+          shaders.parallel_compile ? "parallel compile" : "blocking compile"), 10, 88, 10, LIME);
+        const texture_stats textures = texture_get_stats();
+        DrawText(TextFormat("textures: %u pending, %u failed, %u baked, %.2f MB on the GPU, %llu KB this frame, first frame at %.1f ms, ready at %.1f ms",
+          textures.pending, textures.failed, textures.baked, textures.gpu_bytes / (1024.f * 1024.f), textures.frame_bytes / 1024,
+          textures.first_frame_ms, textures.all_ready_ms), 10, 102, 10, LIME);
+        const scene_stats scene = scene_get_stats();
+        DrawText(TextFormat("scene: %u instances (F10 stress), %u nodes, %u visible, %u draws, %u shader / %u material changes, cull %.2f ms, sort %.2f ms, refit %.2f ms (%u moved), %u rebuilds",
+          scene.instance_count, scene.node_count, scene.visible_count, scene.draw_count, scene.shader_changes, scene.material_changes,
+          scene.cull_ms, scene.sort_ms, scene.refit_ms, scene.moved_count, scene.rebuild_count), 10, 116, 10, LIME);
+        const scatter_stats scatter = scatter_get_stats();
+        DrawText(TextFormat("scatter: %u instances of %u types, %u draws, last placement %u regions in %.1f ms, %u uploads, %llu KB (F11 re-scatters)",
+          scatter.instance_count, scatter.type_count, scatter.draw_count, scatter.regions_placed, scatter.placement_ms, scatter.upload_count,
+          scatter.upload_bytes / 1024), 10, 130, 10, LIME);
+        if (state->show_memory_report) {
+          draw_memory_report(10, 144);
+        }
+        if (state->show_profiler) {
+          draw_profile_overlay(resolution.x - 420, 10);
+        }
+      }
     EndDrawing();
+    memory_system_end_frame();
+    uniform_system_end_frame();
+    gpu_timer_frame_end();
+    profile_frame_end();
+    bench_end_frame();
   }
+  const bool bench_failed = state->bench and not bench_write_report();
+  bench_system_shutdown();
 
+  atmosphere_system_shutdown();
   UnloadRenderTextureDepthTex(target);
-  UnloadShader(shdrAtmosphere);
-  UnloadShader(shdrTiling);
-  UnloadShader(shdrTerrain);
-  UnloadModel(state->terrain);
+  event_unregister(EVENT_CODE_SHADER_RELOADED, on_shader_reloaded);
+  // Models referencing shaders and textures go before the systems that own them
+  scatter_system_shutdown();
+  unload_stress_scene();
+  scene_system_shutdown();
+  shader_system_shutdown();
+  texture_system_shutdown();
+  uniform_system_shutdown();
+  memory_log_report();
+  terrain_system_shutdown();
+  job_system_shutdown();
+  profile_system_shutdown();
+  event_system_shutdown();
+  logging_system_shutdown();
+  gpu_timer_system_shutdown();
   CloseWindow();
-  return 0;
+  return bench_failed ? 1 : 0;
+}
+
+static void draw_memory_report(i32 x, i32 y) {
+  for (u32 i = 0; i < MEMORY_TAG_MAX; ++i) {
+    const memory_tag_stats stats = memory_get_tag_stats((memory_tag)i);
+    if (stats.allocation_count == 0) {
+      continue;
+    }
+    DrawText(TextFormat("%s: %.2f MB (peak %.2f MB), %llu live",
+      memory_tag_name((memory_tag)i), stats.current_bytes / (1024.f * 1024.f), stats.peak_bytes / (1024.f * 1024.f), stats.live_count), x, y, 10, LIME);
+    y += 12;
+  }
+  DrawText(TextFormat("linear: %.2f of %.2f MB", memory_get_linear_usage() / (1024.f * 1024.f), TOTAL_ALLOCATED_MEMORY / (1024.f * 1024.f)), x, y, 10, LIME);
+}
+
+// Per frame cost of every scope so far, children indented under their parents
+static void draw_profile_overlay(i32 x, i32 y) {
+  profile_scope_stats stats[PROFILE_MAX_SCOPES];
+  const u32 count = profile_get_scope_stats(stats, PROFILE_MAX_SCOPES);
+  DrawText(TextFormat("profiler (F7), F8 captures %u frames%s, %llu gpu frames dropped",
+    PROFILE_CAPTURE_FRAMES, profile_is_capturing() ? " [capturing]" : "", gpu_timer_dropped_frames()), x, y, 10, LIME);
+  y += 14;
+  DrawText("scope                  last    p50    p95    p99    max ms", x, y, 10, LIME);
+  y += 12;
+  for (u32 i = 0; i < count; ++i) {
+    const profile_scope_stats& scope = stats[i];
+    const u32 indent = (i == 0) ? 0 : scope.depth + 1;
+    DrawText(TextFormat("%s %*s%-*s %6.2f %6.2f %6.2f %6.2f %6.2f", scope.gpu ? "gpu" : "cpu", indent * 2, "", 18 - indent * 2, scope.name,
+      scope.last_ms, scope.p50_ms, scope.p95_ms, scope.p99_ms, scope.max_ms), x, y, 10, scope.gpu ? SKYBLUE : LIME);
+    y += 12;
+  }
+}
+
+// Renders raymarching.fs on the CPU. Writes the reference on the first run, compares against it afterwards.
+static void run_sdf_reference(const char* path) {
+  Image image = sdf_render_reference(640, 360, Vector3 { 3.f, 2.f, 0.5f }, Vector3 { -0.5f, -0.4f, 0.5f }, 0.f);
+  if (not FileExists(path)) {
+    if (ExportImage(image, path)) {
+      TRACELOG(LOG_INFO, "SDF: Reference written to %s", path);
+    }
+    UnloadImage(image);
+    return;
+  }
+  Image expected = LoadImage(path);
+  ImageFormat(&expected, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+  const f32 difference = sdf_image_difference(image, expected);
+  TRACELOG((difference < 0.f or difference > 0.01f) ? LOG_WARNING : LOG_INFO, "SDF: %s differs by %.5f rms", path, difference);
+  UnloadImage(expected);
+  UnloadImage(image);
+}
+
+// The terrain samples its layers through material maps raylib doesn't name in the shader
+static void set_terrain_locations(Shader shader) {
+  shader.locs[SHADER_LOC_MAP_METALNESS] = GetShaderLocation(shader, "texture1");
+  shader.locs[SHADER_LOC_MAP_EMISSION] = GetShaderLocation(shader, "texture2");
+  shader.locs[SHADER_LOC_MAP_OCCLUSION] = GetShaderLocation(shader, "texture3");
+}
+
+static bool on_shader_reloaded([[__maybe_unused__]] i32 code, event_context context) {
+  const shader_handle handle = context.data.u32[0];
+  if (handle == state->tiling_shader) {
+    state->guide_plane.materials[0].shader = shader_get(handle);
+    uniform_cache_initialize(&state->tiling_uniforms, shader_get(handle));
+    uniform_set(&state->tiling_uniforms, "tiling", &state->tiling, SHADER_UNIFORM_VEC2);
+    // The scene's copies share the materials array, the new program reaches them too
+    for (u32 i = 0; i < SCENE_STRESS_MODELS; ++i) {
+      if (state->stress_scene and stress_model_tiled(i)) {
+        state->stress_models[i].materials[0].shader = shader_get(handle);
+      }
+    }
+  } else if (handle == state->terrain_shader) {
+    set_terrain_locations(shader_get(handle));
+    terrain_set_shader(shader_get(handle));
+  } else if (handle == state->map_objects_shader) {
+    scatter_set_shader(shader_get(handle));
+  } else if (handle == state->atmosphere_shader or handle == state->atmosphere_upsample_shader) {
+    atmosphere_set_shaders(shader_get(state->atmosphere_shader), shader_get(state->atmosphere_upsample_shader));
+  }
+  return false;
+}
+
+static terrain_config default_terrain_config(void) {
+  return terrain_config {
+    .heightmap_size = TERRAIN_HEIGHTMAP_SIZE,
+    .chunk_resolution = 32,
+    .world_size = 100.f,
+    .height_scale = 10.f,
+    .lod_distance = 15.f,
+    .position = Vector3{0.0f, -5.0f, 0.0f},
+  };
 }
 
 static RenderTexture2D LoadRenderTextureDepthTex(int width, int height) {
@@ -269,6 +592,102 @@ void draw_guide_plane(void) {
 	DrawLine3D(Vector3 { 0.f, 0.f, 20.f}, Vector3 {0.f, 0.f, -20.f}, GREEN);
 }
 
+static void draw_scene_geometry([[__maybe_unused__]] void* data) {
+  //draw_guide_plane();
+
+  // Draw the terrain
+  terrain_draw();
+  scatter_draw();
+  scene_draw();
+}
+
+// One mesh per scatter_rules entry, the scatter unloads them
+static void add_scatter_types(void) {
+  const Mesh meshes[SCATTER_TYPE_COUNT] = {
+    GenMeshCone(0.04f, 0.35f, 4), GenMeshSphere(0.4f, 6, 8), GenMeshCone(0.6f, 2.4f, 8),
+    GenMeshHemiSphere(0.5f, 4, 6), GenMeshHemiSphere(1.f, 6, 8),
+  };
+  const Color colors[SCATTER_TYPE_COUNT] = {
+    Color { 96, 140, 60, 255 }, DARKGREEN, Color { 40, 80, 50, 255 }, GRAY, DARKGRAY,
+  };
+  for (u32 i = 0; i < SCATTER_TYPE_COUNT; ++i) {
+    scatter_add_type(meshes[i], colors[i], scatter_rules[i]);
+  }
+}
+
+// Six meshes across three materials scattered over the terrain, the first SCENE_STRESS_MOVERS bob every frame
+static void load_stress_scene(Texture2D texture) {
+  if (state->stress_scene) {
+    return;
+  }
+  const Mesh meshes[SCENE_STRESS_MODELS] = {
+    GenMeshCube(0.5f, 0.5f, 0.5f), GenMeshCube(0.3f, 0.8f, 0.3f), GenMeshSphere(0.3f, 8, 8),
+    GenMeshSphere(0.2f, 6, 6), GenMeshCylinder(0.15f, 0.7f, 8), GenMeshCylinder(0.3f, 0.3f, 12),
+  };
+  const Color colors[SCENE_STRESS_MODELS] = { WHITE, MAROON, WHITE, DARKBLUE, WHITE, GOLD };
+  for (u32 i = 0; i < SCENE_STRESS_MODELS; ++i) {
+    Model& model = state->stress_models[i];
+    model = LoadModelFromMesh(meshes[i]);
+    model.materials[0].maps[MATERIAL_MAP_DIFFUSE].color = colors[i];
+    if (i % 2 == 0) {
+      model.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = texture;
+    }
+    if (stress_model_tiled(i)) {
+      model.materials[0].shader = shader_get(state->tiling_shader);
+    }
+    scene_add_model(model, nullptr);
+  }
+
+  state->stress_movers = (scene_instance*)allocate_memory(sizeof(scene_instance) * SCENE_STRESS_MOVERS, false, MEMORY_TAG_GAME);
+  state->stress_mover_transforms = (Matrix*)allocate_memory(sizeof(Matrix) * SCENE_STRESS_MOVERS, false, MEMORY_TAG_GAME);
+  const terrain_config config = default_terrain_config();
+  random_state rng = {};
+  random_seed(&rng, 0x5CE7Eull);
+  for (u32 i = 0; i < SCENE_STRESS_COUNT; ++i) {
+    const f32 x = config.position.x + random_range_f32(&rng, 0.f, config.world_size);
+    const f32 z = config.position.z + random_range_f32(&rng, 0.f, config.world_size);
+    const f32 scale = random_range_f32(&rng, 0.5f, 1.5f);
+    const Matrix transform = MatrixMultiply(MatrixMultiply(MatrixScale(scale, scale, scale), MatrixRotateY(random_range_f32(&rng, 0.f, 2.f * PI))),
+      MatrixTranslate(x, terrain_get_height(x, z) + 0.2f * scale, z));
+    const scene_instance instance = scene_add_instance(i % SCENE_STRESS_MODELS, transform);
+    if (i < SCENE_STRESS_MOVERS) {
+      state->stress_movers[i] = instance;
+      state->stress_mover_transforms[i] = transform;
+    }
+  }
+  state->stress_scene = true;
+}
+
+static void unload_stress_scene(void) {
+  if (not state->stress_scene) {
+    return;
+  }
+  scene_clear();
+  // The tiling shader and the checker texture are shared, UnloadModel() would free them along with the materials
+  for (Model& model : state->stress_models) {
+    model.materials[0].shader = Shader { rlGetShaderIdDefault(), rlGetShaderLocsDefault() };
+    model.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = Texture2D {};
+    UnloadModel(model);
+    model = {};
+  }
+  free_memory(state->stress_movers);
+  free_memory(state->stress_mover_transforms);
+  state->stress_movers = nullptr;
+  state->stress_mover_transforms = nullptr;
+  state->stress_scene = false;
+}
+
+static bool stress_model_tiled(u32 index) {
+  return index % 3 == 0;
+}
+
+static void animate_stress_scene(f64 time) {
+  for (u32 i = 0; i < SCENE_STRESS_MOVERS; ++i) {
+    const f32 lift = sinf((f32)time * 2.f + (f32)i) * 0.5f + 0.5f;
+    scene_set_transform(state->stress_movers[i], MatrixMultiply(state->stress_mover_transforms[i], MatrixTranslate(0.f, lift, 0.f)));
+  }
+}
+
 const char * rsrc(const char * file_name) {
   return TextFormat("%s%s", SHADER_FILE, file_name);
 }
@@ -0,0 +1,492 @@
+#include "atmosphere.h"
+
+#include "raymath.h"
+#include "rlgl.h"
+#include <math.h>
+#include <stdlib.h> // Required for: abs()
+
+#include "core/fmemory.h"
+#include "core/fnoise.h"
+#include "core/logger.h"
+#include "render/gl_ext.h"
+#include "render/gpu_timer.h"
+#include "render/uniform.h"
+
+typedef struct gpu_sample {
+  u64 samples;
+  f64 gpu_ms;
+} gpu_sample;
+
+typedef struct atmosphere_system_state {
+  i32 width;
+  i32 height;
+  u32 scale_index;
+  Shader atmosphere;
+  Shader upsample;
+  uniform_cache atmosphere_uniforms;
+  i32 atmosphere_depth_loc;
+  i32 atmosphere_history_loc;
+  i32 upsample_depth_loc;
+  i32 upsample_atmosphere_loc;
+  // Sky targets of every scale, two of them for the temporal ping-pong. Scale 1 only uses them when temporal
+  RenderTexture2D targets[ATMOSPHERE_SCALE_COUNT][2];
+  u32 queries[2];
+  bool queries_available;
+
+  bool temporal;
+  bool history_valid;
+  u32 history_index;       // Target the last temporal frame wrote
+  u32 history_scale_index;
+  u32 temporal_frame;
+  Vector3 history_position;
+  Vector3 history_target;
+
+  u32 noise_textures[2]; // Shape and detail
+  atmosphere_noise_stats noise_stats;
+  bool noise_volumes;
+} atmosphere_system_state;
+
+static atmosphere_system_state * state = nullptr;
+
+// fbm_clouds() octaves 1 to 4, one tile spans 4 cells of its first octave. Values go up to the 0.9375 amplitude sum
+static const noise_volume_config cloud_shape_volume = noise_volume_config {
+  .seed = 0x636c6f75u, .size = 128u, .cells = 4u, .octaves = 4u, .gain = 0.5f
+};
+// Octaves 5 and 6, atmosphere.fs tiles it 16 times per shape tile so it continues where the shape stops
+static const noise_volume_config cloud_detail_volume = noise_volume_config {
+  .seed = 0x64657461u, .size = 32u, .cells = 4u, .octaves = 2u, .gain = 0.5f
+};
+
+static void render_pass(RenderTexture2D scene, Camera3D camera, PFN_draw_geometry draw, void* data, gpu_sample* sky);
+static void draw_sky(RenderTexture2D target, f32 render_scale, bool depth_cull, Texture2D depth, i32 temporal_frame, Texture2D history);
+static bool history_usable(Camera3D camera);
+static void bind_shaders(Shader atmosphere, Shader upsample);
+static void begin_gpu_query(void);
+static void end_gpu_query(gpu_sample* sample);
+
+static inline u32 scale_of(u32 index) {
+  return 1u << index;
+}
+
+// Scale 1 without temporal draws the sky straight into the scene
+static inline bool uses_sky_target(void) {
+  return state->scale_index > 0 or state->temporal;
+}
+
+bool atmosphere_system_initialize(i32 width, i32 height, Shader atmosphere, Shader upsample) {
+  if (state and state != nullptr) {
+    return false;
+  }
+  state = (atmosphere_system_state*)allocate_memory_linear(sizeof(atmosphere_system_state), true, MEMORY_TAG_RENDER);
+  state->width = width;
+  state->height = height;
+  bind_shaders(atmosphere, upsample);
+
+  for (u32 i = 0; i < ATMOSPHERE_SCALE_COUNT; ++i) {
+    const i32 scale = (i32)scale_of(i);
+    for (u32 j = 0; j < 2; ++j) {
+      RenderTexture2D& target = state->targets[i][j];
+      target = LoadRenderTexture((width + scale - 1) / scale, (height + scale - 1) / scale);
+      if (target.id == 0) {
+        TRACELOG(LOG_ERROR, "ATMOSPHERE: 1/%i resolution target can not be created", scale);
+        atmosphere_system_shutdown();
+        return false;
+      }
+      // History is read between texels when the camera turns
+      SetTextureFilter(target.texture, TEXTURE_FILTER_BILINEAR);
+    }
+  }
+  state->queries_available = gl_ext_load();
+  if (state->queries_available) {
+    gl_ext.gen_queries(2, state->queries);
+  }
+  return true;
+}
+
+void atmosphere_system_shutdown(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  for (u32 i = 0; i < ATMOSPHERE_SCALE_COUNT; ++i) {
+    for (u32 j = 0; j < 2; ++j) {
+      if (state->targets[i][j].id > 0) {
+        UnloadRenderTexture(state->targets[i][j]);
+      }
+    }
+  }
+  if (state->queries_available) {
+    gl_ext.delete_queries(2, state->queries);
+  }
+  if (state->noise_stats.loaded) {
+    gl_ext.delete_textures(2, state->noise_textures);
+  }
+  state = nullptr;
+}
+
+void atmosphere_set_shaders(Shader atmosphere, Shader upsample) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  bind_shaders(atmosphere, upsample);
+}
+
+void atmosphere_set_scale(u32 scale) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  u32 index = 0;
+  while (index + 1 < ATMOSPHERE_SCALE_COUNT and scale_of(index + 1) <= scale) {
+    ++index;
+  }
+  state->scale_index = index;
+}
+
+u32 atmosphere_get_scale(void) {
+  if (not state or state == nullptr) {
+    return 1;
+  }
+  return scale_of(state->scale_index);
+}
+
+void atmosphere_set_temporal(bool enabled) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  state->temporal = enabled;
+  state->history_valid = false;
+}
+
+bool atmosphere_get_temporal(void) {
+  return state and state != nullptr and state->temporal;
+}
+
+bool atmosphere_load_noise_volumes(const char* shape_cache_path, const char* detail_cache_path) {
+  if (not state or state == nullptr or state->noise_stats.loaded or not gl_ext_load()) {
+    return false;
+  }
+  const noise_volume_config* configs[2] = { &cloud_shape_volume, &cloud_detail_volume };
+  const char* paths[2] = { shape_cache_path, detail_cache_path };
+  const char* names[2] = { "Shape", "Detail" };
+  const i32 units[2] = { ATMOSPHERE_NOISE_SHAPE_UNIT, ATMOSPHERE_NOISE_DETAIL_UNIT };
+
+  atmosphere_noise_stats stats = {};
+  stats.from_cache = true;
+  gl_ext.gen_textures(2, state->noise_textures);
+  for (u32 i = 0; i < 2; ++i) {
+    const i32 size = (i32)configs[i]->size;
+    const u64 bytes = (u64)size * (u64)size * (u64)size * sizeof(u16);
+    u16* voxels = (u16*)allocate_memory(bytes, false, MEMORY_TAG_RENDER);
+    bool from_cache = false;
+    const f64 start = GetTime();
+    const bool generated = noise_load_or_generate_volume(configs[i], paths[i], voxels, &from_cache);
+    const f64 elapsed_ms = (GetTime() - start) * 1000.0;
+    if (not generated) {
+      TRACELOG(LOG_ERROR, "ATMOSPHERE: %s noise volume can not be generated", names[i]);
+      free_memory(voxels);
+      gl_ext.delete_textures(2, state->noise_textures);
+      return false;
+    }
+    // Sampled at mip 0 like the ALU noise, trilinear between voxels and wrapping so the tiles stay seamless
+    gl_ext.active_texture(GL_TEXTURE0 + (u32)units[i]);
+    gl_ext.bind_texture(GL_TEXTURE_3D, state->noise_textures[i]);
+    gl_ext.tex_parameter_i(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    gl_ext.tex_parameter_i(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    gl_ext.tex_parameter_i(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    gl_ext.tex_parameter_i(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    gl_ext.tex_parameter_i(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
+    gl_ext.tex_image_3d(GL_TEXTURE_3D, 0, GL_R16, size, size, size, 0, GL_RED, GL_UNSIGNED_SHORT, voxels);
+    free_memory(voxels);
+
+    stats.from_cache = stats.from_cache and from_cache;
+    stats.bake_ms += elapsed_ms;
+    stats.gpu_bytes += bytes;
+    TRACELOG(LOG_INFO, "ATMOSPHERE: %s noise volume %ix%ix%i %s in %.2f ms, %llu KB", names[i], size, size, size,
+      from_cache ? "loaded from cache" : "baked", elapsed_ms, bytes / 1024);
+  }
+  gl_ext.active_texture(GL_TEXTURE0);
+
+  stats.loaded = true;
+  state->noise_stats = stats;
+  state->noise_volumes = true;
+  bind_shaders(state->atmosphere, state->upsample);
+  return true;
+}
+
+atmosphere_noise_stats atmosphere_get_noise_stats(void) {
+  if (not state or state == nullptr) {
+    return atmosphere_noise_stats {};
+  }
+  return state->noise_stats;
+}
+
+void atmosphere_set_noise_volumes(bool enabled) {
+  if (not state or state == nullptr or not state->noise_stats.loaded) {
+    return;
+  }
+  state->noise_volumes = enabled;
+  state->history_valid = false;
+}
+
+bool atmosphere_get_noise_volumes(void) {
+  return state and state != nullptr and state->noise_volumes;
+}
+
+void atmosphere_render_scene(RenderTexture2D scene, Camera3D camera, PFN_draw_geometry draw, void* data) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  PROFILE_SCOPE("atmosphere_render_scene");
+  render_pass(scene, camera, draw, data, nullptr);
+}
+
+void atmosphere_present(RenderTexture2D scene, Vector2 position) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  const Rectangle source = Rectangle { 0.f, 0.f, (f32)scene.texture.width, -(f32)scene.texture.height };
+  if (not uses_sky_target()) {
+    DrawTextureRec(scene.texture, source, position, WHITE);
+    return;
+  }
+  const u32 target_index = state->temporal ? state->history_index : 0;
+  BeginShaderMode(state->upsample);
+  {
+    SetShaderValueTexture(state->upsample, state->upsample_depth_loc, scene.depth);
+    SetShaderValueTexture(state->upsample, state->upsample_atmosphere_loc, state->targets[state->scale_index][target_index].texture);
+    DrawTextureRec(scene.texture, source, position, WHITE);
+  }
+  EndShaderMode();
+}
+
+atmosphere_measurement atmosphere_measure(RenderTexture2D scene, Camera3D camera, PFN_draw_geometry draw, void* data) {
+  atmosphere_measurement result = {};
+  if (not state or state == nullptr) {
+    return result;
+  }
+  const u32 scale_index = state->scale_index;
+  const bool temporal = state->temporal;
+  result.scale = scale_of(scale_index);
+  result.temporal = temporal;
+  RenderTexture2D presented[2] = { LoadRenderTexture(state->width, state->height), LoadRenderTexture(state->width, state->height) };
+
+  // Full resolution reference, the history of the temporal path is left alone
+  gpu_sample full = {};
+  state->scale_index = 0;
+  state->temporal = false;
+  render_pass(scene, camera, draw, data, &full);
+  BeginTextureMode(presented[0]);
+  ClearBackground(BLANK);
+  atmosphere_present(scene, Vector2 { 0.f, 0.f });
+  EndTextureMode();
+
+  gpu_sample reduced = {};
+  gpu_sample upsample = {};
+  state->scale_index = scale_index;
+  state->temporal = temporal;
+  render_pass(scene, camera, draw, data, &reduced);
+  BeginTextureMode(presented[1]);
+  ClearBackground(BLANK);
+  const bool upsampled = uses_sky_target();
+  begin_gpu_query();
+  atmosphere_present(scene, Vector2 { 0.f, 0.f });
+  end_gpu_query(&upsample);
+  EndTextureMode();
+
+  if (state->noise_stats.loaded) {
+    // Same full resolution sky pass with either noise source
+    gpu_sample alu = {};
+    gpu_sample volume = {};
+    const bool noise_volumes = state->noise_volumes;
+    state->scale_index = 0;
+    state->temporal = false;
+    state->noise_volumes = false;
+    render_pass(scene, camera, draw, data, &alu);
+    state->noise_volumes = true;
+    render_pass(scene, camera, draw, data, &volume);
+    state->noise_volumes = noise_volumes;
+    state->scale_index = scale_index;
+    state->temporal = temporal;
+    result.alu_noise_gpu_ms = alu.gpu_ms;
+    result.volume_noise_gpu_ms = volume.gpu_ms;
+  }
+
+  result.full_samples = full.samples;
+  result.full_gpu_ms = full.gpu_ms;
+  result.reduced_samples = reduced.samples;
+  result.reduced_gpu_ms = reduced.gpu_ms + (upsampled ? upsample.gpu_ms : 0.0);
+
+  Image full_image = LoadImageFromTexture(presented[0].texture);
+  Image reduced_image = LoadImageFromTexture(presented[1].texture);
+  const u8* a = (const u8*)full_image.data;
+  const u8* b = (const u8*)reduced_image.data;
+  const u64 pixel_count = (u64)full_image.width * (u64)full_image.height;
+  f64 sum = 0.0;
+  i32 max_difference = 0;
+  for (u64 i = 0; i < pixel_count; ++i) {
+    for (u64 c = 0; c < 3; ++c) {
+      const i32 difference = abs((i32)a[i * 4 + c] - (i32)b[i * 4 + c]);
+      sum += (f64)(difference * difference);
+      max_difference = (difference > max_difference) ? difference : max_difference;
+    }
+  }
+  result.rms_error = (f32)(sqrt(sum / (f64)(pixel_count * 3)) / 255.0);
+  result.max_error = (f32)max_difference / 255.f;
+  UnloadImage(reduced_image);
+  UnloadImage(full_image);
+  UnloadRenderTexture(presented[1]);
+  UnloadRenderTexture(presented[0]);
+
+  TRACELOG(LOG_INFO, "ATMOSPHERE: 1/%u resolution%s, fragments %llu -> %llu (%.1f%%), gpu %.3f -> %.3f ms, rms error %.4f, max %.4f",
+    result.scale, temporal ? " temporal" : "", result.full_samples, result.reduced_samples,
+    (result.full_samples > 0) ? 100.0 * (f64)result.reduced_samples / (f64)result.full_samples : 0.0,
+    result.full_gpu_ms, result.reduced_gpu_ms, result.rms_error, result.max_error);
+  if (state->noise_stats.loaded) {
+    TRACELOG(LOG_INFO, "ATMOSPHERE: Full resolution sky with ALU noise %.3f ms, with noise volumes %.3f ms",
+      result.alu_noise_gpu_ms, result.volume_noise_gpu_ms);
+  }
+  return result;
+}
+
+static void render_pass(RenderTexture2D scene, Camera3D camera, PFN_draw_geometry draw, void* data, gpu_sample* sky) {
+  if (not uses_sky_target()) {
+    BeginTextureMode(scene);
+    {
+      ClearBackground(WHITE);
+      rlEnableDepthTest();
+      {
+        PROFILE_GPU_SCOPE("atmosphere");
+        if (sky) begin_gpu_query();
+        // Straight into the scene, its depth is the bound attachment and can't be sampled
+        draw_sky(scene, 1.f, false, Texture2D {}, -1, Texture2D {});
+        if (sky) end_gpu_query(sky);
+      }
+      PROFILE_GPU_SCOPE("geometry");
+      BeginMode3D(camera);
+      draw(data);
+      EndMode3D();
+    }
+    EndTextureMode();
+    return;
+  }
+
+  // Geometry first, the sky pass skips texels it covers completely
+  BeginTextureMode(scene);
+  {
+    PROFILE_GPU_SCOPE("geometry");
+    ClearBackground(BLANK);
+    rlEnableDepthTest();
+    BeginMode3D(camera);
+    draw(data);
+    EndMode3D();
+  }
+  EndTextureMode();
+
+  u32 target_index = 0;
+  i32 temporal_frame = -1;
+  Texture2D history = {};
+  if (state->temporal) {
+    // Every pixel marches on frames without usable history, which also rebuilds it
+    const u32 previous = state->history_index;
+    if (history_usable(camera)) {
+      temporal_frame = (i32)(state->temporal_frame % ATMOSPHERE_TEMPORAL_PERIOD);
+      history = state->targets[state->scale_index][previous].texture;
+    }
+    target_index = 1 - previous;
+    state->history_index = target_index;
+    state->history_scale_index = state->scale_index;
+    state->history_valid = true;
+    state->temporal_frame++;
+  }
+
+  const RenderTexture2D& target = state->targets[state->scale_index][target_index];
+  BeginTextureMode(target);
+  {
+    PROFILE_GPU_SCOPE("atmosphere");
+    ClearBackground(BLANK);
+    rlDisableDepthTest();
+    if (sky) begin_gpu_query();
+    draw_sky(target, (f32)scale_of(state->scale_index), true, scene.depth, temporal_frame, history);
+    if (sky) end_gpu_query(sky);
+  }
+  EndTextureMode();
+  if (state->temporal) {
+    // History reprojection reads these next frame
+    state->history_position = camera.position;
+    state->history_target = camera.target;
+  }
+}
+
+static void draw_sky(RenderTexture2D target, f32 render_scale, bool depth_cull, Texture2D depth, i32 temporal_frame, Texture2D history) {
+  BeginShaderMode(state->atmosphere);
+  {
+    uniform_set(&state->atmosphere_uniforms, "renderScale", &render_scale, SHADER_UNIFORM_FLOAT);
+    uniform_set(&state->atmosphere_uniforms, "temporalFrame", &temporal_frame, SHADER_UNIFORM_INT);
+    const i32 noise_volumes = state->noise_volumes ? 1 : 0;
+    uniform_set(&state->atmosphere_uniforms, "noiseVolumes", &noise_volumes, SHADER_UNIFORM_INT);
+    const i32 depth_cull_flag = depth_cull ? 1 : 0;
+    uniform_set(&state->atmosphere_uniforms, "depthCull", &depth_cull_flag, SHADER_UNIFORM_INT);
+    if (depth_cull) {
+      SetShaderValueTexture(state->atmosphere, state->atmosphere_depth_loc, depth);
+    }
+    if (temporal_frame >= 0) {
+      uniform_set(&state->atmosphere_uniforms, "prevViewPos", &state->history_position, SHADER_UNIFORM_VEC3);
+      uniform_set(&state->atmosphere_uniforms, "prevViewTarget", &state->history_target, SHADER_UNIFORM_VEC3);
+      SetShaderValueTexture(state->atmosphere, state->atmosphere_history_loc, history);
+    }
+    DrawRectangleRec(Rectangle { 0.f, 0.f, (f32)target.texture.width, (f32)target.texture.height }, WHITE);
+  }
+  EndShaderMode();
+}
+
+static bool history_usable(Camera3D camera) {
+  if (not state->history_valid or state->history_scale_index != state->scale_index) {
+    return false;
+  }
+  if (Vector3Distance(camera.position, state->history_position) > ATMOSPHERE_HISTORY_MAX_MOVE) {
+    return false;
+  }
+  const Vector3 forward = Vector3Normalize(Vector3Subtract(camera.target, camera.position));
+  const Vector3 history_forward = Vector3Normalize(Vector3Subtract(state->history_target, state->history_position));
+  return Vector3DotProduct(forward, history_forward) >= ATMOSPHERE_HISTORY_MIN_FORWARD_DOT;
+}
+
+static void bind_shaders(Shader atmosphere, Shader upsample) {
+  state->atmosphere = atmosphere;
+  state->upsample = upsample;
+  uniform_cache_initialize(&state->atmosphere_uniforms, atmosphere);
+  state->atmosphere_depth_loc = GetShaderLocation(atmosphere, "depthTexture");
+  state->atmosphere_history_loc = GetShaderLocation(atmosphere, "historyTexture");
+  state->upsample_depth_loc = GetShaderLocation(upsample, "depthTexture");
+  state->upsample_atmosphere_loc = GetShaderLocation(upsample, "atmosphereTexture");
+  // Samplers are only set once, the volumes stay on their units
+  if (state->noise_stats.loaded) {
+    const i32 units[2] = { ATMOSPHERE_NOISE_SHAPE_UNIT, ATMOSPHERE_NOISE_DETAIL_UNIT };
+    uniform_set(&state->atmosphere_uniforms, "cloudShape", &units[0], SHADER_UNIFORM_INT);
+    uniform_set(&state->atmosphere_uniforms, "cloudDetail", &units[1], SHADER_UNIFORM_INT);
+  }
+  state->history_valid = false;
+}
+
+static void begin_gpu_query(void) {
+  if (not state->queries_available) {
+    return;
+  }
+  rlDrawRenderBatchActive();
+  gl_ext.begin_query(GL_SAMPLES_PASSED, state->queries[0]);
+  gl_ext.begin_query(GL_TIME_ELAPSED, state->queries[1]);
+}
+
+static void end_gpu_query(gpu_sample* sample) {
+  if (not state->queries_available) {
+    return;
+  }
+  rlDrawRenderBatchActive();
+  gl_ext.end_query(GL_TIME_ELAPSED);
+  gl_ext.end_query(GL_SAMPLES_PASSED);
+  u32 passed = 0;
+  u64 elapsed = 0;
+  gl_ext.get_query_object_u32(state->queries[0], GL_QUERY_RESULT, &passed);
+  gl_ext.get_query_object_u64(state->queries[1], GL_QUERY_RESULT, &elapsed);
+  sample->samples = passed;
+  sample->gpu_ms = (f64)elapsed / 1000000.0;
+}
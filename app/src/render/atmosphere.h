@@ -0,0 +1,97 @@
+#ifndef ATMOSPHERE_H
+#define ATMOSPHERE_H
+
+#include "defines.h"
+#include "raylib.h"
+
+#define ATMOSPHERE_SCALE_COUNT 3 // 1, 2 and 4
+#define ATMOSPHERE_TEMPORAL_PERIOD 16 // 4x4 Bayer pattern, every pixel marches once per period
+#define ATMOSPHERE_HISTORY_MAX_MOVE 2.f // World units per frame before the history is dropped
+#define ATMOSPHERE_HISTORY_MIN_FORWARD_DOT 0.8f // ~37 degrees of turn per frame
+#define ATMOSPHERE_NOISE_SHAPE_UNIT 8 // Texture units of the cloud volumes, above the ones rlgl batches with
+#define ATMOSPHERE_NOISE_DETAIL_UNIT 9
+
+typedef void (*PFN_draw_geometry)(void* data);
+
+/**
+ * @brief Full resolution path against the current scale on the same frame.
+ */
+typedef struct atmosphere_measurement {
+  u32 scale;
+  bool temporal;
+  u64 full_samples;    // Fragments atmosphere.fs shaded
+  u64 reduced_samples; // Reduced texels written, covered ones are discarded early. Reprojected texels count too
+  f64 full_gpu_ms;
+  f64 reduced_gpu_ms;  // Reduced pass and the upsample
+  f32 rms_error;       // Presented images, per channel in [0, 1]
+  f32 max_error;
+  // Full resolution sky pass with each cloud noise source, zero when the volumes aren't loaded
+  f64 alu_noise_gpu_ms;
+  f64 volume_noise_gpu_ms;
+} atmosphere_measurement;
+
+/**
+ * @brief Cloud noise volumes as they ended up on the GPU.
+ */
+typedef struct atmosphere_noise_stats {
+  bool loaded;
+  bool from_cache; // Both volumes were read from disk
+  f64 bake_ms;     // Baking or loading, both volumes
+  u64 gpu_bytes;
+} atmosphere_noise_stats;
+
+/**
+ * @param atmosphere atmosphere.fs, renders the sky straight into the scene at scale 1
+ * @param upsample atmosphere_upsample.fs, composites the reduced sky behind the geometry
+ */
+[[__nodiscard__]] bool atmosphere_system_initialize(i32 width, i32 height, Shader atmosphere, Shader upsample);
+void atmosphere_system_shutdown(void);
+
+/**
+ * @brief Swaps in reloaded programs. Their uniforms are uploaded again and the temporal history restarts.
+ */
+void atmosphere_set_shaders(Shader atmosphere, Shader upsample);
+
+/**
+ * @brief Resolution divider of the sky pass, 1, 2 or 4. Anything else is rounded down to one of them.
+ */
+void atmosphere_set_scale(u32 scale);
+u32 atmosphere_get_scale(void);
+
+/**
+ * @brief Marches one pixel of every 4x4 block per frame and reprojects the rest from the last frame's sky.
+ * Works at every scale, scale 1 then goes through the upsample pass too.
+ */
+void atmosphere_set_temporal(bool enabled);
+bool atmosphere_get_temporal(void);
+
+/**
+ * @brief Loads the cloud shape and detail volumes from their cache files, bakes and writes them when missing or stale,
+ * and uploads them as 3D textures. The clouds sample them instead of evaluating fbm_clouds() once loaded.
+ */
+[[__nodiscard__]] bool atmosphere_load_noise_volumes(const char* shape_cache_path, const char* detail_cache_path);
+atmosphere_noise_stats atmosphere_get_noise_stats(void);
+
+/**
+ * @brief Switches the clouds between the noise volumes and the ALU noise. Ignored until the volumes are loaded.
+ */
+void atmosphere_set_noise_volumes(bool enabled);
+bool atmosphere_get_noise_volumes(void);
+
+/**
+ * @brief Draws the sky and the geometry into scene, which needs a depth texture.
+ * @param draw Called between BeginMode3D() and EndMode3D()
+ */
+void atmosphere_render_scene(RenderTexture2D scene, Camera3D camera, PFN_draw_geometry draw, void* data);
+
+/**
+ * @brief Draws the scene into the current framebuffer, upsampling the reduced sky behind the geometry.
+ */
+void atmosphere_present(RenderTexture2D scene, Vector2 position);
+
+/**
+ * @brief Renders the frame at full resolution and at the current scale and temporal setting, waits for the GPU and compares them.
+ */
+atmosphere_measurement atmosphere_measure(RenderTexture2D scene, Camera3D camera, PFN_draw_geometry draw, void* data);
+
+#endif
@@ -0,0 +1,339 @@
+#include "bench.h"
+
+#include "raymath.h"
+
+#include <stdio.h>  // Required for: fopen(), fprintf(), sscanf()
+#include <stdlib.h> // Required for: qsort()
+#include <string.h> // Required for: strcmp()
+
+#include "core/fmemory.h"
+#include "core/fprofile.h"
+#include "core/frandom.h"
+#include "render/gl_ext.h"
+#include "render/texture.h"
+
+typedef enum bench_phase {
+  BENCH_PHASE_LOADING,   // Textures streaming in, the first key is held
+  BENCH_PHASE_WARMUP,
+  BENCH_PHASE_RECORDING,
+  BENCH_PHASE_DONE,
+} bench_phase;
+
+typedef struct bench_pass {
+  const char* name;
+  bool gpu;
+  u32 sample_count;
+  f32* samples;   // config.frame_count, a pass can skip frames
+} bench_pass;
+
+typedef struct bench_summary {
+  f32 min_ms;
+  f32 avg_ms;
+  f32 p50_ms;
+  f32 p95_ms;
+  f32 p99_ms;
+  f32 max_ms;
+} bench_summary;
+
+typedef struct bench_system_state {
+  bench_config config;
+  char report_path[BENCH_PATH_MAX];
+  char keys_path[BENCH_PATH_MAX];
+  Vector3 positions[BENCH_MAX_KEYS];
+  Vector3 targets[BENCH_MAX_KEYS];
+  u32 key_count;
+  bool keys_loaded;  // From keys_path rather than the built-in loop
+  bench_phase phase;
+  u32 phase_frames;
+  u64 begin_ns;
+  u64 last_end_ns;
+  f64 loading_ms;
+  f32* frame_ms;
+  u32 frame_count;
+  bench_pass passes[BENCH_MAX_PASSES];
+  u32 pass_count;
+} bench_system_state;
+
+static bench_system_state * state = nullptr;
+
+// A loop around the middle of the default terrain, high enough to clear its peaks
+static const Vector3 default_positions[] = {
+  Vector3 { 90.f, 10.f, 50.f }, Vector3 { 78.3f, 8.f, 78.3f }, Vector3 { 50.f, 9.f, 90.f }, Vector3 { 21.7f, 12.f, 78.3f },
+  Vector3 { 10.f, 16.f, 50.f }, Vector3 { 21.7f, 12.f, 21.7f }, Vector3 { 50.f, 8.f, 10.f }, Vector3 { 78.3f, 9.f, 21.7f },
+  Vector3 { 90.f, 10.f, 50.f },
+};
+static const Vector3 default_target = Vector3 { 50.f, -2.f, 50.f };
+
+static void load_keys(const char* path);
+static Vector3 catmull_rom(const Vector3* keys, u32 count, f32 t);
+static void record_passes(void);
+static bench_summary summarize(const f32* samples, u32 count);
+static void write_summary(FILE* file, const bench_summary& summary);
+static i32 compare_f32(const void* a, const void* b);
+
+bench_config bench_config_default(const char* report_path) {
+  return bench_config {
+    .report_path = report_path,
+    .keys_path = nullptr,
+    .warmup_frames = 120,
+    .frame_count = 1200,
+    .timestep = 1.f / 60.f,
+    .seed = 0x5EEDull,
+  };
+}
+
+bool bench_system_initialize(const bench_config* config) {
+  if ((state and state != nullptr) or not config or not config->report_path or config->frame_count == 0 or config->timestep <= 0.f) {
+    return false;
+  }
+  state = (bench_system_state*)allocate_memory_linear(sizeof(bench_system_state), true, MEMORY_TAG_GAME);
+  state->config = *config;
+  snprintf(state->report_path, BENCH_PATH_MAX, "%s", config->report_path);
+  snprintf(state->keys_path, BENCH_PATH_MAX, "%s", config->keys_path ? config->keys_path : "");
+  state->config.report_path = state->report_path;
+  state->config.keys_path = state->keys_path;
+  state->frame_ms = (f32*)allocate_memory(sizeof(f32) * config->frame_count, false, MEMORY_TAG_GAME);
+
+  load_keys(state->keys_path);
+  random_set_global_seed(config->seed);
+  state->phase = BENCH_PHASE_LOADING;
+  state->begin_ns = profile_now_ns();
+  state->last_end_ns = state->begin_ns;
+  TRACELOG(LOG_INFO, "BENCH: %u warmup and %u recorded frames at %.4f s over %u keys (%s), seed %llu", config->warmup_frames,
+    config->frame_count, config->timestep, state->key_count, state->keys_loaded ? state->keys_path : "built-in loop", config->seed);
+  return true;
+}
+
+void bench_system_shutdown(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  for (u32 i = 0; i < state->pass_count; ++i) {
+    free_memory(state->passes[i].samples);
+  }
+  free_memory(state->frame_ms);
+  state = nullptr;
+}
+
+bool bench_begin_frame(Camera* camera, f32* delta_time, f64* time) {
+  if (not state or state == nullptr or state->phase == BENCH_PHASE_DONE) {
+    return false;
+  }
+  const bool recording = state->phase == BENCH_PHASE_RECORDING;
+  const u32 last_frame = (state->config.frame_count > 1) ? state->config.frame_count - 1 : 1;
+  const f32 t = recording ? (f32)state->phase_frames / (f32)last_frame : 0.f;
+  camera->position = catmull_rom(state->positions, state->key_count, t);
+  camera->target = catmull_rom(state->targets, state->key_count, t);
+  *delta_time = state->config.timestep;
+  *time = recording ? (f64)state->phase_frames * (f64)state->config.timestep : 0.0;
+  return true;
+}
+
+void bench_end_frame(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  const u64 now_ns = profile_now_ns();
+  const f32 frame_ms = (f32)((f64)(now_ns - state->last_end_ns) / 1000000.0);
+  state->last_end_ns = now_ns;
+
+  switch (state->phase) {
+    case BENCH_PHASE_LOADING: {
+      if (texture_get_stats().pending == 0) {
+        state->loading_ms = (f64)(now_ns - state->begin_ns) / 1000000.0;
+        state->phase = BENCH_PHASE_WARMUP;
+        state->phase_frames = 0;
+      }
+      break;
+    }
+    case BENCH_PHASE_WARMUP: {
+      if (++state->phase_frames >= state->config.warmup_frames) {
+        state->phase = BENCH_PHASE_RECORDING;
+        state->phase_frames = 0;
+      }
+      break;
+    }
+    case BENCH_PHASE_RECORDING: {
+      state->frame_ms[state->frame_count++] = frame_ms;
+      record_passes();
+      if (++state->phase_frames >= state->config.frame_count) {
+        state->phase = BENCH_PHASE_DONE;
+      }
+      break;
+    }
+    case BENCH_PHASE_DONE: break;
+  }
+}
+
+bool bench_write_report(void) {
+  if (not state or state == nullptr) {
+    return false;
+  }
+  if (state->frame_count == 0) {
+    TRACELOG(LOG_WARNING, "BENCH: No frames were recorded, %s isn't written", state->report_path);
+    return false;
+  }
+  FILE* file = fopen(state->report_path, "w");
+  if (not file) {
+    TRACELOG(LOG_WARNING, "BENCH: Report couldn't be written to %s", state->report_path);
+    return false;
+  }
+  const char* renderer = (gl_ext_load() and gl_ext.get_string) ? (const char*)gl_ext.get_string(GL_RENDERER) : nullptr;
+  const char* version = (gl_ext_load() and gl_ext.get_string) ? (const char*)gl_ext.get_string(GL_VERSION) : nullptr;
+  fprintf(file, "{\n  \"renderer\": \"%s\",\n  \"gl_version\": \"%s\",\n", renderer ? renderer : "unknown", version ? version : "unknown");
+  fprintf(file, "  \"resolution\": [%i, %i],\n  \"seed\": %llu,\n  \"timestep\": %.6f,\n", GetRenderWidth(), GetRenderHeight(),
+    state->config.seed, state->config.timestep);
+  fprintf(file, "  \"warmup_frames\": %u,\n  \"frames\": %u,\n  \"keys\": %u,\n  \"keys_path\": \"%s\",\n  \"loading_ms\": %.3f,\n",
+    state->config.warmup_frames, state->frame_count, state->key_count, state->keys_loaded ? state->keys_path : "", state->loading_ms);
+  fprintf(file, "  \"frame_ms\": ");
+  const bench_summary frame = summarize(state->frame_ms, state->frame_count);
+  write_summary(file, frame);
+  fprintf(file, ",\n  \"passes\": [");
+  for (u32 i = 0; i < state->pass_count; ++i) {
+    const bench_pass* pass = &state->passes[i];
+    fprintf(file, "%s\n    { \"name\": \"%s\", \"type\": \"%s\", \"frames\": %u, \"ms\": ", (i == 0) ? "" : ",", pass->name,
+      pass->gpu ? "gpu" : "cpu", pass->sample_count);
+    write_summary(file, summarize(pass->samples, pass->sample_count));
+    fprintf(file, " }");
+  }
+  fprintf(file, "\n  ]\n}\n");
+  if (fclose(file) != 0) {
+    TRACELOG(LOG_WARNING, "BENCH: Report couldn't be written to %s", state->report_path);
+    return false;
+  }
+  TRACELOG(LOG_INFO, "BENCH: %u frames, %.2f ms avg, %.2f ms p95, %.2f ms p99 on %s, written to %s", state->frame_count, frame.avg_ms,
+    frame.p95_ms, frame.p99_ms, renderer ? renderer : "unknown", state->report_path);
+  return true;
+}
+
+bool bench_record_key(const char* path, Camera camera) {
+  FILE* file = fopen(path, "a");
+  if (not file) {
+    return false;
+  }
+  fprintf(file, "%.3f %.3f %.3f %.3f %.3f %.3f\n", camera.position.x, camera.position.y, camera.position.z,
+    camera.target.x, camera.target.y, camera.target.z);
+  const bool written = fclose(file) == 0;
+  if (written) {
+    TRACELOG(LOG_INFO, "BENCH: Key at %.2f %.2f %.2f appended to %s", camera.position.x, camera.position.y, camera.position.z, path);
+  }
+  return written;
+}
+
+// Lines that don't hold six numbers are skipped, fewer than two keys fall back to the built-in loop
+static void load_keys(const char* path) {
+  char* text = (path and path[0] != '\0' and FileExists(path)) ? LoadFileText(path) : nullptr;
+  u32 count = 0;
+  for (const char* line = text; line and *line != '\0' and count < BENCH_MAX_KEYS; ) {
+    Vector3 position = {};
+    Vector3 target = {};
+    if (sscanf(line, "%f %f %f %f %f %f", &position.x, &position.y, &position.z, &target.x, &target.y, &target.z) == 6) {
+      state->positions[count] = position;
+      state->targets[count] = target;
+      ++count;
+    }
+    line = strchr(line, '\n');
+    line = line ? line + 1 : nullptr;
+  }
+  if (text) {
+    UnloadFileText(text);
+  }
+  if (count >= 2) {
+    state->key_count = count;
+    state->keys_loaded = true;
+    return;
+  }
+  if (text) {
+    TRACELOG(LOG_WARNING, "BENCH: %s holds %u keys, using the built-in loop", path, count);
+  }
+  state->key_count = sizeof(default_positions) / sizeof(default_positions[0]);
+  for (u32 i = 0; i < state->key_count; ++i) {
+    state->positions[i] = default_positions[i];
+    state->targets[i] = default_target;
+  }
+  state->keys_loaded = false;
+}
+
+// Uniform Catmull-Rom through every key, t in [0, 1] spans the whole path
+static Vector3 catmull_rom(const Vector3* keys, u32 count, f32 t) {
+  if (count < 2) {
+    return keys[0];
+  }
+  const f32 s = Clamp(t, 0.f, 1.f) * (f32)(count - 1);
+  const u32 segment = ((u32)s < count - 1) ? (u32)s : count - 2;
+  const f32 u = s - (f32)segment;
+  const Vector3 p0 = keys[(segment > 0) ? segment - 1 : 0];
+  const Vector3 p1 = keys[segment];
+  const Vector3 p2 = keys[segment + 1];
+  const Vector3 p3 = keys[(segment + 2 < count) ? segment + 2 : count - 1];
+  const f32 u2 = u * u;
+  const f32 u3 = u2 * u;
+  Vector3 result = Vector3Scale(p1, 2.f);
+  result = Vector3Add(result, Vector3Scale(Vector3Subtract(p2, p0), u));
+  result = Vector3Add(result, Vector3Scale(Vector3Add(Vector3Subtract(Vector3Scale(p0, 2.f), Vector3Scale(p1, 5.f)),
+    Vector3Subtract(Vector3Scale(p2, 4.f), p3)), u2));
+  result = Vector3Add(result, Vector3Scale(Vector3Add(Vector3Subtract(Vector3Scale(p1, 3.f), p0),
+    Vector3Subtract(p3, Vector3Scale(p2, 3.f))), u3));
+  return Vector3Scale(result, 0.5f);
+}
+
+// GPU scopes land GPU_TIMER_FRAMES - 1 frames late, the first few of them still come from the warmup
+static void record_passes(void) {
+  profile_scope_stats scopes[BENCH_MAX_PASSES];
+  const u32 count = profile_get_last_frame(scopes, BENCH_MAX_PASSES);
+  for (u32 i = 0; i < count; ++i) {
+    bench_pass* pass = nullptr;
+    for (u32 p = 0; p < state->pass_count; ++p) {
+      if (state->passes[p].gpu == scopes[i].gpu and strcmp(state->passes[p].name, scopes[i].name) == 0) {
+        pass = &state->passes[p];
+        break;
+      }
+    }
+    if (not pass) {
+      if (state->pass_count >= BENCH_MAX_PASSES) {
+        continue;
+      }
+      pass = &state->passes[state->pass_count++];
+      pass->name = scopes[i].name;
+      pass->gpu = scopes[i].gpu;
+      pass->samples = (f32*)allocate_memory(sizeof(f32) * state->config.frame_count, false, MEMORY_TAG_GAME);
+    }
+    if (pass->sample_count < state->config.frame_count) {
+      pass->samples[pass->sample_count++] = scopes[i].last_ms;
+    }
+  }
+}
+
+static bench_summary summarize(const f32* samples, u32 count) {
+  bench_summary summary = {};
+  if (count == 0) {
+    return summary;
+  }
+  f32* sorted = (f32*)allocate_memory(sizeof(f32) * count, false, MEMORY_TAG_GAME);
+  f64 sum = 0.0;
+  for (u32 i = 0; i < count; ++i) {
+    sorted[i] = samples[i];
+    sum += samples[i];
+  }
+  qsort(sorted, count, sizeof(f32), compare_f32);
+  const u32 last = count - 1;
+  summary.min_ms = sorted[0];
+  summary.avg_ms = (f32)(sum / (f64)count);
+  summary.p50_ms = sorted[(u32)(last * 0.50f)];
+  summary.p95_ms = sorted[(u32)(last * 0.95f)];
+  summary.p99_ms = sorted[(u32)(last * 0.99f)];
+  summary.max_ms = sorted[last];
+  free_memory(sorted);
+  return summary;
+}
+
+static void write_summary(FILE* file, const bench_summary& summary) {
+  fprintf(file, "{ \"min\": %.4f, \"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }",
+    summary.min_ms, summary.avg_ms, summary.p50_ms, summary.p95_ms, summary.p99_ms, summary.max_ms);
+}
+
+static i32 compare_f32(const void* a, const void* b) {
+  const f32 left = *(const f32*)a;
+  const f32 right = *(const f32*)b;
+  return (left > right) - (left < right);
+}
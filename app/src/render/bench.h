@@ -0,0 +1,53 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "defines.h"
+#include "raylib.h"
+
+#define BENCH_MAX_KEYS 64
+#define BENCH_MAX_PASSES 64
+#define BENCH_PATH_MAX 256
+
+/**
+ * @brief A run holds the first key until every texture is in, renders warmup_frames there and then records
+ * frame_count frames over the whole path. Time only advances by timestep, so two runs draw the same frames.
+ */
+typedef struct bench_config {
+  const char* report_path;
+  const char* keys_path;  // One "px py pz tx ty tz" line per key, the built-in loop when missing
+  u32 warmup_frames;
+  u32 frame_count;
+  f32 timestep;
+  u64 seed;
+} bench_config;
+
+bench_config bench_config_default(const char* report_path);
+
+/**
+ * @brief Seeds random_set_global_seed() with config->seed, keeps a copy of the strings.
+ */
+[[__nodiscard__]] bool bench_system_initialize(const bench_config* config);
+void bench_system_shutdown(void);
+
+/**
+ * @brief Main thread, in place of the interactive camera update.
+ * @return false once every frame is recorded
+ */
+bool bench_begin_frame(Camera* camera, f32* delta_time, f64* time);
+
+/**
+ * @brief Main thread, after profile_frame_end(). Collects the frame time and the profiler's scopes.
+ */
+void bench_end_frame(void);
+
+/**
+ * @brief Frame time and per scope min/avg/p50/p95/p99/max as JSON, along with the GL renderer that drew them.
+ */
+bool bench_write_report(void);
+
+/**
+ * @brief Appends the camera as a key, a path is recorded by flying it and calling this at each point.
+ */
+bool bench_record_key(const char* path, Camera camera);
+
+#endif
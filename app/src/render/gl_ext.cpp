@@ -0,0 +1,89 @@
+#include "gl_ext.h"
+
+#include "raylib.h"
+
+typedef void (*PFN_gl_proc)(void);
+extern "C" PFN_gl_proc glfwGetProcAddress(const char* name);
+
+gl_ext_api gl_ext = {};
+
+static i32 load_result = -1; // -1 before the first call
+
+template <typename T>
+static bool load(T& function, const char* name) {
+  function = (T)glfwGetProcAddress(name);
+  if (not function) {
+    TRACELOG(LOG_ERROR, "GL: Entry point %s is missing", name);
+    return false;
+  }
+  return true;
+}
+
+bool gl_ext_load(void) {
+  if (load_result >= 0) {
+    return load_result == 1;
+  }
+  bool loaded = true;
+  loaded &= load(gl_ext.gen_buffers, "glGenBuffers");
+  loaded &= load(gl_ext.delete_buffers, "glDeleteBuffers");
+  loaded &= load(gl_ext.bind_buffer, "glBindBuffer");
+  loaded &= load(gl_ext.bind_buffer_base, "glBindBufferBase");
+  loaded &= load(gl_ext.buffer_data, "glBufferData");
+  loaded &= load(gl_ext.vertex_attrib_pointer, "glVertexAttribPointer");
+  loaded &= load(gl_ext.get_uniform_block_index, "glGetUniformBlockIndex");
+  loaded &= load(gl_ext.uniform_block_binding, "glUniformBlockBinding");
+  loaded &= load(gl_ext.gen_queries, "glGenQueries");
+  loaded &= load(gl_ext.delete_queries, "glDeleteQueries");
+  loaded &= load(gl_ext.begin_query, "glBeginQuery");
+  loaded &= load(gl_ext.end_query, "glEndQuery");
+  loaded &= load(gl_ext.get_query_object_u32, "glGetQueryObjectuiv");
+  loaded &= load(gl_ext.get_query_object_u64, "glGetQueryObjectui64v");
+  loaded &= load(gl_ext.query_counter, "glQueryCounter");
+  loaded &= load(gl_ext.get_integer64_v, "glGetInteger64v");
+  loaded &= load(gl_ext.gen_textures, "glGenTextures");
+  loaded &= load(gl_ext.delete_textures, "glDeleteTextures");
+  loaded &= load(gl_ext.bind_texture, "glBindTexture");
+  loaded &= load(gl_ext.active_texture, "glActiveTexture");
+  loaded &= load(gl_ext.tex_parameter_i, "glTexParameteri");
+  loaded &= load(gl_ext.tex_image_2d, "glTexImage2D");
+  loaded &= load(gl_ext.tex_sub_image_2d, "glTexSubImage2D");
+  loaded &= load(gl_ext.compressed_tex_image_2d, "glCompressedTexImage2D");
+  loaded &= load(gl_ext.tex_image_3d, "glTexImage3D");
+  loaded &= load(gl_ext.get_string, "glGetString");
+  loaded &= load(gl_ext.get_string_i, "glGetStringi");
+  loaded &= load(gl_ext.get_integer_v, "glGetIntegerv");
+  loaded &= load(gl_ext.create_shader, "glCreateShader");
+  loaded &= load(gl_ext.delete_shader, "glDeleteShader");
+  loaded &= load(gl_ext.shader_source, "glShaderSource");
+  loaded &= load(gl_ext.compile_shader, "glCompileShader");
+  loaded &= load(gl_ext.get_shader_iv, "glGetShaderiv");
+  loaded &= load(gl_ext.get_shader_info_log, "glGetShaderInfoLog");
+  loaded &= load(gl_ext.create_program, "glCreateProgram");
+  loaded &= load(gl_ext.delete_program, "glDeleteProgram");
+  loaded &= load(gl_ext.attach_shader, "glAttachShader");
+  loaded &= load(gl_ext.detach_shader, "glDetachShader");
+  loaded &= load(gl_ext.bind_attrib_location, "glBindAttribLocation");
+  loaded &= load(gl_ext.link_program, "glLinkProgram");
+  loaded &= load(gl_ext.get_program_iv, "glGetProgramiv");
+  loaded &= load(gl_ext.get_program_info_log, "glGetProgramInfoLog");
+  gl_ext.program_parameter_i = (decltype(gl_ext.program_parameter_i))glfwGetProcAddress("glProgramParameteri");
+  gl_ext.get_program_binary = (decltype(gl_ext.get_program_binary))glfwGetProcAddress("glGetProgramBinary");
+  gl_ext.program_binary = (decltype(gl_ext.program_binary))glfwGetProcAddress("glProgramBinary");
+  load_result = loaded ? 1 : 0;
+  return loaded;
+}
+
+bool gl_ext_has_extension(const char* name) {
+  if (load_result != 1) {
+    return false;
+  }
+  i32 count = 0;
+  gl_ext.get_integer_v(GL_NUM_EXTENSIONS, &count);
+  for (i32 i = 0; i < count; ++i) {
+    const char* extension = (const char*)gl_ext.get_string_i(GL_EXTENSIONS, (u32)i);
+    if (extension and TextIsEqual(extension, name)) {
+      return true;
+    }
+  }
+  return false;
+}
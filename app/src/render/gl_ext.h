@@ -0,0 +1,123 @@
+#ifndef GL_EXT_H
+#define GL_EXT_H
+
+#include "defines.h"
+
+#define GL_UNIFORM_BUFFER 0x8A11
+#define GL_DYNAMIC_DRAW 0x88E8
+#define GL_INVALID_INDEX 0xFFFFFFFFu
+#define GL_SAMPLES_PASSED 0x8914
+#define GL_TIME_ELAPSED 0x88BF
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#define GL_TIMESTAMP 0x8E28
+#define GL_TEXTURE0 0x84C0
+#define GL_TEXTURE_3D 0x806F
+#define GL_TEXTURE_MIN_FILTER 0x2801
+#define GL_TEXTURE_MAG_FILTER 0x2800
+#define GL_TEXTURE_WRAP_S 0x2802
+#define GL_TEXTURE_WRAP_T 0x2803
+#define GL_TEXTURE_WRAP_R 0x8072
+#define GL_LINEAR 0x2601
+#define GL_REPEAT 0x2901
+#define GL_RED 0x1903
+#define GL_R16 0x822A
+#define GL_UNSIGNED_SHORT 0x1403
+#define GL_TEXTURE_2D 0x0DE1
+#define GL_TEXTURE_BASE_LEVEL 0x813C
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#define GL_LINEAR_MIPMAP_LINEAR 0x2703
+#define GL_RGBA 0x1908
+#define GL_RGBA8 0x8058
+#define GL_UNSIGNED_BYTE 0x1401
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0 // EXT_texture_compression_s3tc
+#define GL_VENDOR 0x1F00
+#define GL_RENDERER 0x1F01
+#define GL_VERSION 0x1F02
+#define GL_NUM_EXTENSIONS 0x821D
+#define GL_EXTENSIONS 0x1F03
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_INFO_LOG_LENGTH 0x8B84
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_COMPLETION_STATUS 0x91B1 // ARB/KHR_parallel_shader_compile
+
+#if defined(_WIN32) && !defined(_WIN64)
+#define GL_EXT_API __stdcall
+#else
+#define GL_EXT_API
+#endif
+
+/**
+ * @brief GL 3.3 entry points rlgl doesn't wrap. raylib is built with GLFW, they are loaded through it.
+ */
+typedef struct gl_ext_api {
+  void (GL_EXT_API *gen_buffers)(i32 count, u32* buffers);
+  void (GL_EXT_API *delete_buffers)(i32 count, const u32* buffers);
+  void (GL_EXT_API *bind_buffer)(u32 target, u32 buffer);
+  void (GL_EXT_API *bind_buffer_base)(u32 target, u32 index, u32 buffer);
+  void (GL_EXT_API *buffer_data)(u32 target, i64 size, const void* data, u32 usage);
+  void (GL_EXT_API *vertex_attrib_pointer)(u32 index, i32 size, u32 type, u8 normalized, i32 stride, const void* offset);
+  u32 (GL_EXT_API *get_uniform_block_index)(u32 program, const char* name);
+  void (GL_EXT_API *uniform_block_binding)(u32 program, u32 block_index, u32 binding);
+
+  void (GL_EXT_API *gen_queries)(i32 count, u32* queries);
+  void (GL_EXT_API *delete_queries)(i32 count, const u32* queries);
+  void (GL_EXT_API *begin_query)(u32 target, u32 query);
+  void (GL_EXT_API *end_query)(u32 target);
+  void (GL_EXT_API *get_query_object_u32)(u32 query, u32 name, u32* result);
+  void (GL_EXT_API *get_query_object_u64)(u32 query, u32 name, u64* result);
+  void (GL_EXT_API *query_counter)(u32 query, u32 target);
+  void (GL_EXT_API *get_integer64_v)(u32 name, i64* data);
+
+  void (GL_EXT_API *gen_textures)(i32 count, u32* textures);
+  void (GL_EXT_API *delete_textures)(i32 count, const u32* textures);
+  void (GL_EXT_API *bind_texture)(u32 target, u32 texture);
+  void (GL_EXT_API *active_texture)(u32 unit);
+  void (GL_EXT_API *tex_parameter_i)(u32 target, u32 name, i32 value);
+  void (GL_EXT_API *tex_image_2d)(u32 target, i32 level, i32 internal_format, i32 width, i32 height, i32 border, u32 format, u32 type, const void* data);
+  void (GL_EXT_API *tex_sub_image_2d)(u32 target, i32 level, i32 x, i32 y, i32 width, i32 height, u32 format, u32 type, const void* data);
+  void (GL_EXT_API *compressed_tex_image_2d)(u32 target, i32 level, u32 internal_format, i32 width, i32 height, i32 border, i32 size, const void* data);
+  void (GL_EXT_API *tex_image_3d)(u32 target, i32 level, i32 internal_format, i32 width, i32 height, i32 depth, i32 border, u32 format, u32 type, const void* data);
+
+  const u8* (GL_EXT_API *get_string)(u32 name);
+  const u8* (GL_EXT_API *get_string_i)(u32 name, u32 index);
+  void (GL_EXT_API *get_integer_v)(u32 name, i32* data);
+  u32 (GL_EXT_API *create_shader)(u32 type);
+  void (GL_EXT_API *delete_shader)(u32 shader);
+  void (GL_EXT_API *shader_source)(u32 shader, i32 count, const char* const* sources, const i32* lengths);
+  void (GL_EXT_API *compile_shader)(u32 shader);
+  void (GL_EXT_API *get_shader_iv)(u32 shader, u32 name, i32* value);
+  void (GL_EXT_API *get_shader_info_log)(u32 shader, i32 capacity, i32* length, char* log);
+  u32 (GL_EXT_API *create_program)(void);
+  void (GL_EXT_API *delete_program)(u32 program);
+  void (GL_EXT_API *attach_shader)(u32 program, u32 shader);
+  void (GL_EXT_API *detach_shader)(u32 program, u32 shader);
+  void (GL_EXT_API *bind_attrib_location)(u32 program, u32 index, const char* name);
+  void (GL_EXT_API *link_program)(u32 program);
+  void (GL_EXT_API *get_program_iv)(u32 program, u32 name, i32* value);
+  void (GL_EXT_API *get_program_info_log)(u32 program, i32 capacity, i32* length, char* log);
+
+  // GL 4.1 or ARB_get_program_binary, null when the driver doesn't export them
+  void (GL_EXT_API *program_parameter_i)(u32 program, u32 name, i32 value);
+  void (GL_EXT_API *get_program_binary)(u32 program, i32 capacity, i32* length, u32* format, void* binary);
+  void (GL_EXT_API *program_binary)(u32 program, u32 format, const void* binary, i32 length);
+} gl_ext_api;
+
+extern gl_ext_api gl_ext;
+
+/**
+ * @brief Fills gl_ext once a context exists. Later calls return the first result.
+ */
+[[__nodiscard__]] bool gl_ext_load(void);
+
+/**
+ * @brief Searches the context's extension strings, gl_ext_load() has to succeed first.
+ */
+bool gl_ext_has_extension(const char* name);
+
+#endif
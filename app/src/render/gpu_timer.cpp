@@ -0,0 +1,141 @@
+#include "gpu_timer.h"
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#include "core/fmemory.h"
+#include "render/gl_ext.h"
+
+typedef struct gpu_timer_frame {
+  const char* names[GPU_TIMER_MAX_SCOPES];
+  u32 depths[GPU_TIMER_MAX_SCOPES];
+  bool ended[GPU_TIMER_MAX_SCOPES];
+  u32 queries[GPU_TIMER_MAX_SCOPES * 2]; // Begin and end timestamp of every scope
+  u32 scope_count;
+  u32 last_query; // Issued last, nesting puts outer ends after inner ones
+  i64 clock_offset_ns; // profile_now_ns() minus GL time, when the frame was recorded
+} gpu_timer_frame;
+
+typedef struct gpu_timer_system_state {
+  gpu_timer_frame frames[GPU_TIMER_FRAMES];
+  u64 frame_index;
+  u32 depth;
+  i64 clock_offset_ns;
+  u64 dropped_frames;
+} gpu_timer_system_state;
+
+static gpu_timer_system_state * state = nullptr;
+
+static void sync_clock(void);
+static bool resolve(gpu_timer_frame* frame);
+
+bool gpu_timer_system_initialize(void) {
+  if (state and state != nullptr) {
+    return false;
+  }
+  if (not gl_ext_load()) {
+    return false;
+  }
+  state = (gpu_timer_system_state*)allocate_memory_linear(sizeof(gpu_timer_system_state), true, MEMORY_TAG_RENDER);
+  for (u32 i = 0; i < GPU_TIMER_FRAMES; ++i) {
+    gl_ext.gen_queries(GPU_TIMER_MAX_SCOPES * 2, state->frames[i].queries);
+  }
+  sync_clock();
+  return true;
+}
+
+void gpu_timer_system_shutdown(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  for (u32 i = 0; i < GPU_TIMER_FRAMES; ++i) {
+    gl_ext.delete_queries(GPU_TIMER_MAX_SCOPES * 2, state->frames[i].queries);
+  }
+  state = nullptr;
+}
+
+u32 gpu_timer_begin(const char* name) {
+  if (not state or state == nullptr or not profile_active.load(std::memory_order_relaxed)) {
+    return INVALID_IDU32;
+  }
+  gpu_timer_frame* frame = &state->frames[state->frame_index % GPU_TIMER_FRAMES];
+  if (frame->scope_count >= GPU_TIMER_MAX_SCOPES) {
+    return INVALID_IDU32;
+  }
+  const u32 scope = frame->scope_count++;
+  frame->names[scope] = name;
+  frame->depths[scope] = state->depth++;
+  frame->ended[scope] = false;
+  rlDrawRenderBatchActive();
+  gl_ext.query_counter(frame->queries[scope * 2], GL_TIMESTAMP);
+  frame->last_query = frame->queries[scope * 2];
+  return scope;
+}
+
+void gpu_timer_end(u32 scope) {
+  if (not state or state == nullptr or scope == INVALID_IDU32) {
+    return;
+  }
+  gpu_timer_frame* frame = &state->frames[state->frame_index % GPU_TIMER_FRAMES];
+  if (scope >= frame->scope_count) {
+    return;
+  }
+  rlDrawRenderBatchActive();
+  gl_ext.query_counter(frame->queries[scope * 2 + 1], GL_TIMESTAMP);
+  frame->last_query = frame->queries[scope * 2 + 1];
+  frame->ended[scope] = true;
+  --state->depth;
+}
+
+void gpu_timer_frame_end(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  state->frames[state->frame_index % GPU_TIMER_FRAMES].clock_offset_ns = state->clock_offset_ns;
+  state->frame_index++;
+  state->depth = 0;
+  if (state->frame_index % GPU_TIMER_SYNC_INTERVAL == 0) {
+    sync_clock();
+  }
+
+  // The slot written next was recorded GPU_TIMER_FRAMES frames ago, its queries are done or given up on
+  gpu_timer_frame* oldest = &state->frames[state->frame_index % GPU_TIMER_FRAMES];
+  if (oldest->scope_count > 0 and not resolve(oldest)) {
+    state->dropped_frames++;
+  }
+  oldest->scope_count = 0;
+}
+
+u64 gpu_timer_dropped_frames(void) {
+  if (not state or state == nullptr) {
+    return 0;
+  }
+  return state->dropped_frames;
+}
+
+// GL time when the commands so far reached the driver, close enough to line GPU scopes up with CPU ones
+static void sync_clock(void) {
+  i64 gpu_now = 0;
+  gl_ext.get_integer64_v(GL_TIMESTAMP, &gpu_now);
+  state->clock_offset_ns = (i64)profile_now_ns() - gpu_now;
+}
+
+static bool resolve(gpu_timer_frame* frame) {
+  // Timestamps complete in order, the last one being there means every earlier one is
+  u32 available = 0;
+  gl_ext.get_query_object_u32(frame->last_query, GL_QUERY_RESULT_AVAILABLE, &available);
+  if (available == 0) {
+    return false;
+  }
+  for (u32 i = 0; i < frame->scope_count; ++i) {
+    if (not frame->ended[i]) {
+      continue;
+    }
+    u64 begin = 0;
+    u64 end = 0;
+    gl_ext.get_query_object_u64(frame->queries[i * 2], GL_QUERY_RESULT, &begin);
+    gl_ext.get_query_object_u64(frame->queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+    profile_record_gpu(frame->names[i], (u64)((i64)begin + frame->clock_offset_ns), (u64)((i64)end + frame->clock_offset_ns), frame->depths[i]);
+  }
+  return true;
+}
@@ -0,0 +1,47 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include "defines.h"
+
+#include "core/fprofile.h"
+
+#define GPU_TIMER_FRAMES 4       // Frames in flight, a frame's queries are read when its slot comes around again
+#define GPU_TIMER_MAX_SCOPES 32  // Per frame
+#define GPU_TIMER_SYNC_INTERVAL 60 // Frames between realigning the GPU clock to profile_now_ns()
+
+/**
+ * @brief Timestamp queries around passes, the results go to the profiler GPU_TIMER_FRAMES - 1 frames later.
+ * The CPU never waits for them, a frame whose queries aren't done by then is dropped.
+ */
+[[__nodiscard__]] bool gpu_timer_system_initialize(void);
+void gpu_timer_system_shutdown(void);
+
+/**
+ * @brief Main thread. Flushes raylib's batch so the draws before the scope aren't counted in it.
+ * @return INVALID_IDU32 when stopped or out of scopes, gpu_timer_end() ignores it
+ */
+u32 gpu_timer_begin(const char* name);
+void gpu_timer_end(u32 scope);
+
+/**
+ * @brief Main thread, after the frame's last scope and before profile_frame_end().
+ */
+void gpu_timer_frame_end(void);
+
+u64 gpu_timer_dropped_frames(void);
+
+typedef struct gpu_timer_scope {
+  u32 scope;
+  explicit gpu_timer_scope(const char* name) : scope(gpu_timer_begin(name)) {}
+  ~gpu_timer_scope(void) { gpu_timer_end(scope); }
+  gpu_timer_scope(const gpu_timer_scope&) = delete;
+  gpu_timer_scope& operator=(const gpu_timer_scope&) = delete;
+} gpu_timer_scope;
+
+#if PROFILE_ENABLED
+  #define PROFILE_GPU_SCOPE(name) gpu_timer_scope PROFILE_CONCAT(gpu_timer_scope_, __LINE__)(name)
+#else
+  #define PROFILE_GPU_SCOPE(name) ((void)0)
+#endif
+
+#endif
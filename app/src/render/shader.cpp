@@ -0,0 +1,546 @@
+#include "shader.h"
+
+#include "rlgl.h"
+#include <stdio.h> // Required for: snprintf()
+
+#include "core/event.h"
+#include "core/fcache.h"
+#include "core/fmemory.h"
+#include "render/gl_ext.h"
+#include "render/uniform.h"
+
+#if PLATFORM_LINUX
+  #include <sys/inotify.h>
+  #include <unistd.h>
+#endif
+
+#define SHADER_CACHE_TYPE 0x53485201u // "SHR" and the layout version
+#define SHADER_PATH_MAX 512
+#define SHADER_INFO_LOG_MAX 2048
+
+typedef enum shader_cache_section {
+  SHADER_SECTION_HEADER, // shader_binary_header
+  SHADER_SECTION_BINARY,
+} shader_cache_section;
+
+typedef struct shader_binary_header {
+  u32 format;
+  u32 length;
+} shader_binary_header;
+
+typedef enum shader_reload_phase {
+  SHADER_RELOAD_IDLE,
+  SHADER_RELOAD_CHANGED, // Waiting out SHADER_RELOAD_DELAY
+  SHADER_RELOAD_LINKING, // Compile and link are issued, polled once per frame
+} shader_reload_phase;
+
+typedef struct shader_build {
+  u32 vertex;
+  u32 fragment;
+  u32 program;
+  u64 key;
+} shader_build;
+
+typedef struct shader_program {
+  char vs_file[SHADER_FILE_NAME_MAX]; // Empty for raylib's default vertex shader
+  char fs_file[SHADER_FILE_NAME_MAX];
+  Shader shader;
+  u64 key; // Sources and driver the current program was built from
+  shader_reload_phase phase;
+  bool changed_while_linking;
+  f64 changed_time;
+  f64 reload_start;
+  shader_build pending;
+  i64 vs_modified;
+  i64 fs_modified;
+} shader_program;
+
+typedef struct shader_system_state {
+  char source_dir[SHADER_PATH_MAX];
+  char cache_dir[SHADER_PATH_MAX];
+  u64 driver_key;
+  u32 program_count;
+  shader_program programs[SHADER_MAX_PROGRAMS];
+  shader_stats stats;
+  i32 watch_descriptor; // inotify instance, -1 while polling
+  f64 last_poll;
+} shader_system_state;
+
+static shader_system_state * state = nullptr;
+
+// raylib's GLSL 330 default vertex shader, for programs that only bring a fragment shader
+static const char* default_vertex_shader =
+  "#version 330\n"
+  "in vec3 vertexPosition;\n"
+  "in vec2 vertexTexCoord;\n"
+  "in vec4 vertexColor;\n"
+  "out vec2 fragTexCoord;\n"
+  "out vec4 fragColor;\n"
+  "uniform mat4 mvp;\n"
+  "void main()\n"
+  "{\n"
+  "    fragTexCoord = vertexTexCoord;\n"
+  "    fragColor = vertexColor;\n"
+  "    gl_Position = mvp*vec4(vertexPosition, 1.0);\n"
+  "}\n";
+
+static bool load_sources(const shader_program* program, char** vs_code, char** fs_code);
+static void unload_sources(char* vs_code, char* fs_code);
+static u64 source_key(const char* vs_code, const char* fs_code);
+static void binary_path(const shader_program* program, char* path);
+static u32 load_binary(const shader_program* program, u64 key);
+static void save_binary(const shader_program* program, u32 id, u64 key);
+static bool start_build(const char* vs_code, const char* fs_code, shader_build* build);
+static bool build_ready(const shader_build* build);
+static bool finish_build(const shader_program* program, shader_build* build);
+static Shader make_shader(u32 id);
+static void poll_changes(f64 now);
+static void mark_changed(const char* file, f64 now);
+static void update_program(shader_handle handle, f64 now);
+static i64 modified_time(const char* file);
+
+bool shader_system_initialize(const char* source_dir, const char* cache_dir) {
+  if (state and state != nullptr) {
+    return false;
+  }
+  if (not source_dir or not cache_dir or not gl_ext_load()) {
+    return false;
+  }
+  state = (shader_system_state*)allocate_memory_linear(sizeof(shader_system_state), true, MEMORY_TAG_RENDER);
+  snprintf(state->source_dir, SHADER_PATH_MAX, "%s", source_dir);
+  snprintf(state->cache_dir, SHADER_PATH_MAX, "%s", cache_dir);
+  state->watch_descriptor = -1;
+
+  // Binaries only load on the driver that wrote them, the key keeps others from even trying
+  const char* driver[3] = {
+    (const char*)gl_ext.get_string(GL_VENDOR), (const char*)gl_ext.get_string(GL_RENDERER), (const char*)gl_ext.get_string(GL_VERSION)
+  };
+  for (const char* text : driver) {
+    state->driver_key = cache_hash(text ? text : "", text ? TextLength(text) : 0, state->driver_key);
+  }
+  i32 binary_formats = 0;
+  if (gl_ext.program_parameter_i and gl_ext.get_program_binary and gl_ext.program_binary) {
+    gl_ext.get_integer_v(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats);
+  }
+  state->stats.binary_cache = binary_formats > 0;
+  state->stats.parallel_compile = gl_ext_has_extension("GL_ARB_parallel_shader_compile") or gl_ext_has_extension("GL_KHR_parallel_shader_compile");
+
+  #if PLATFORM_LINUX
+    // Editors save in place or write a new file and rename it over the old one
+    state->watch_descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (state->watch_descriptor >= 0 and inotify_add_watch(state->watch_descriptor, source_dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+      close(state->watch_descriptor);
+      state->watch_descriptor = -1;
+    }
+  #endif
+  state->stats.watching = state->watch_descriptor >= 0;
+
+  TRACELOG(LOG_INFO, "SHADER: %s, binary cache %s, parallel compile %s, %s %s", driver[1] ? driver[1] : "unknown renderer",
+    state->stats.binary_cache ? "on" : "off", state->stats.parallel_compile ? "on" : "off",
+    state->stats.watching ? "watching" : "polling", source_dir);
+  return true;
+}
+
+void shader_system_shutdown(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  for (u32 i = 0; i < state->program_count; ++i) {
+    shader_program& program = state->programs[i];
+    if (program.phase == SHADER_RELOAD_LINKING) {
+      gl_ext.delete_shader(program.pending.vertex);
+      gl_ext.delete_shader(program.pending.fragment);
+      gl_ext.delete_program(program.pending.program);
+    }
+    UnloadShader(program.shader);
+  }
+  #if PLATFORM_LINUX
+    if (state->watch_descriptor >= 0) {
+      close(state->watch_descriptor);
+    }
+  #endif
+  state = nullptr;
+}
+
+shader_handle shader_load(const char* vs_file, const char* fs_file) {
+  if (not state or state == nullptr or not fs_file or state->program_count == SHADER_MAX_PROGRAMS) {
+    return INVALID_IDU32;
+  }
+  if ((vs_file and TextLength(vs_file) >= SHADER_FILE_NAME_MAX) or TextLength(fs_file) >= SHADER_FILE_NAME_MAX) {
+    TRACELOG(LOG_WARNING, "SHADER: File names longer than %i characters aren't supported", SHADER_FILE_NAME_MAX - 1);
+    return INVALID_IDU32;
+  }
+  const f64 start = GetTime();
+  const shader_handle handle = state->program_count++;
+  state->stats.program_count = state->program_count;
+  shader_program* program = &state->programs[handle];
+  *program = shader_program {};
+  snprintf(program->vs_file, SHADER_FILE_NAME_MAX, "%s", vs_file ? vs_file : "");
+  snprintf(program->fs_file, SHADER_FILE_NAME_MAX, "%s", fs_file);
+  program->shader = Shader { rlGetShaderIdDefault(), rlGetShaderLocsDefault() };
+  program->vs_modified = modified_time(program->vs_file);
+  program->fs_modified = modified_time(program->fs_file);
+
+  char* vs_code = nullptr;
+  char* fs_code = nullptr;
+  if (not load_sources(program, &vs_code, &fs_code)) {
+    TRACELOG(LOG_WARNING, "SHADER: %s can not be read, the default shader stands in", fs_file);
+    return handle;
+  }
+  const u64 key = source_key(vs_code ? vs_code : default_vertex_shader, fs_code);
+  u32 id = load_binary(program, key);
+  const bool from_binary = id != 0;
+  if (not from_binary) {
+    shader_build build = {};
+    if (start_build(vs_code ? vs_code : default_vertex_shader, fs_code, &build) and finish_build(program, &build)) {
+      id = build.program;
+      save_binary(program, id, key);
+    }
+  }
+  unload_sources(vs_code, fs_code);
+  if (id == 0) {
+    TRACELOG(LOG_WARNING, "SHADER: %s failed, the default shader stands in until it's fixed", fs_file);
+    return handle;
+  }
+
+  program->shader = make_shader(id);
+  program->key = key;
+  const f64 elapsed_ms = (GetTime() - start) * 1000.0;
+  state->stats.startup_ms += elapsed_ms;
+  if (from_binary) state->stats.binary_loads++;
+  else state->stats.source_compiles++;
+  TRACELOG(LOG_INFO, "SHADER: [SHDR ID %u] %s %s in %.2f ms", id, fs_file, from_binary ? "loaded from the binary cache" : "compiled", elapsed_ms);
+  return handle;
+}
+
+Shader shader_get(shader_handle handle) {
+  if (not state or state == nullptr or handle >= state->program_count) {
+    return Shader { rlGetShaderIdDefault(), rlGetShaderLocsDefault() };
+  }
+  return state->programs[handle].shader;
+}
+
+void shader_system_update(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  const f64 now = GetTime();
+  poll_changes(now);
+  for (u32 i = 0; i < state->program_count; ++i) {
+    update_program(i, now);
+  }
+}
+
+shader_stats shader_get_stats(void) {
+  if (not state or state == nullptr) {
+    return shader_stats {};
+  }
+  return state->stats;
+}
+
+static void update_program(shader_handle handle, f64 now) {
+  shader_program* program = &state->programs[handle];
+  if (program->phase == SHADER_RELOAD_CHANGED) {
+    if (now - program->changed_time < SHADER_RELOAD_DELAY) {
+      return;
+    }
+    program->phase = SHADER_RELOAD_IDLE;
+    char* vs_code = nullptr;
+    char* fs_code = nullptr;
+    if (not load_sources(program, &vs_code, &fs_code)) {
+      return;
+    }
+    const u64 key = source_key(vs_code ? vs_code : default_vertex_shader, fs_code);
+    // Saved without changes, or only the other program sharing the file changed
+    if (key == program->key) {
+      unload_sources(vs_code, fs_code);
+      return;
+    }
+    program->reload_start = now;
+    program->pending = shader_build {};
+    program->pending.key = key;
+    if (start_build(vs_code ? vs_code : default_vertex_shader, fs_code, &program->pending)) {
+      program->phase = SHADER_RELOAD_LINKING;
+    }
+    unload_sources(vs_code, fs_code);
+    return;
+  }
+  if (program->phase != SHADER_RELOAD_LINKING or not build_ready(&program->pending)) {
+    return;
+  }
+
+  program->phase = SHADER_RELOAD_IDLE;
+  if (finish_build(program, &program->pending)) {
+    const Shader previous = program->shader;
+    program->shader = make_shader(program->pending.program);
+    program->key = program->pending.key;
+    // Holders of the old program swap before anything draws with it again
+    event_fire(EVENT_CODE_SHADER_RELOADED, event_context(handle, previous.id, program->shader.id));
+    UnloadShader(previous);
+    save_binary(program, program->shader.id, program->key);
+    state->stats.reloads++;
+    state->stats.last_reload_ms = (GetTime() - program->reload_start) * 1000.0;
+    TRACELOG(LOG_INFO, "SHADER: [SHDR ID %u] %s reloaded in %.2f ms", program->shader.id, program->fs_file, state->stats.last_reload_ms);
+  } else {
+    state->stats.failed_reloads++;
+    TRACELOG(LOG_WARNING, "SHADER: [SHDR ID %u] %s keeps the last working program", program->shader.id, program->fs_file);
+  }
+  if (program->changed_while_linking) {
+    program->changed_while_linking = false;
+    program->phase = SHADER_RELOAD_CHANGED;
+    program->changed_time = now;
+  }
+}
+
+static bool load_sources(const shader_program* program, char** vs_code, char** fs_code) {
+  *vs_code = nullptr;
+  *fs_code = LoadFileText(TextFormat("%s%s", state->source_dir, program->fs_file));
+  if (not *fs_code) {
+    return false;
+  }
+  if (program->vs_file[0] != '\0') {
+    *vs_code = LoadFileText(TextFormat("%s%s", state->source_dir, program->vs_file));
+    if (not *vs_code) {
+      UnloadFileText(*fs_code);
+      *fs_code = nullptr;
+      return false;
+    }
+  }
+  return true;
+}
+
+static void unload_sources(char* vs_code, char* fs_code) {
+  if (vs_code) UnloadFileText(vs_code);
+  if (fs_code) UnloadFileText(fs_code);
+}
+
+static u64 source_key(const char* vs_code, const char* fs_code) {
+  const u64 key = cache_hash(vs_code, TextLength(vs_code), state->driver_key);
+  return cache_hash(fs_code, TextLength(fs_code), key);
+}
+
+static void binary_path(const shader_program* program, char* path) {
+  snprintf(path, SHADER_PATH_MAX, "%s%s_%s.program", state->cache_dir, (program->vs_file[0] != '\0') ? program->vs_file : "default", program->fs_file);
+}
+
+static u32 load_binary(const shader_program* program, u64 key) {
+  if (not state->stats.binary_cache) {
+    return 0;
+  }
+  char path[SHADER_PATH_MAX];
+  binary_path(program, path);
+  cache_file file = {};
+  if (cache_open(path, SHADER_CACHE_TYPE, key, &file) != CACHE_OK) {
+    return 0;
+  }
+  u32 id = 0;
+  const shader_binary_header* header = (const shader_binary_header*)cache_find_section(&file, SHADER_SECTION_HEADER, sizeof(shader_binary_header));
+  const void* binary = header ? cache_find_section(&file, SHADER_SECTION_BINARY, header->length) : nullptr;
+  if (binary) {
+    id = gl_ext.create_program();
+    gl_ext.program_binary(id, header->format, binary, (i32)header->length);
+    i32 linked = 0;
+    gl_ext.get_program_iv(id, GL_LINK_STATUS, &linked);
+    // Drivers may still reject their own binaries after an update, the source path rebuilds it
+    if (linked == 0) {
+      gl_ext.delete_program(id);
+      id = 0;
+    }
+  }
+  cache_close(&file);
+  return id;
+}
+
+static void save_binary(const shader_program* program, u32 id, u64 key) {
+  if (not state->stats.binary_cache) {
+    return;
+  }
+  i32 length = 0;
+  gl_ext.get_program_iv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return;
+  }
+  void* binary = allocate_memory((u64)length, false, MEMORY_TAG_RENDER);
+  shader_binary_header header = {};
+  i32 written = 0;
+  gl_ext.get_program_binary(id, length, &written, &header.format, binary);
+  header.length = (u32)written;
+  if (written > 0) {
+    char path[SHADER_PATH_MAX];
+    binary_path(program, path);
+    const cache_section sections[2] = {
+      cache_section { SHADER_SECTION_HEADER, &header, sizeof(header) },
+      cache_section { SHADER_SECTION_BINARY, binary, (u64)written },
+    };
+    if (not cache_write(path, SHADER_CACHE_TYPE, key, sections, 2)) {
+      TRACELOG(LOG_WARNING, "SHADER: %s can not be written", path);
+    }
+  }
+  free_memory(binary);
+}
+
+/**
+ * @brief Issues everything without asking for a result, so a driver with parallel compile can work across frames.
+ */
+static bool start_build(const char* vs_code, const char* fs_code, shader_build* build) {
+  build->vertex = gl_ext.create_shader(GL_VERTEX_SHADER);
+  build->fragment = gl_ext.create_shader(GL_FRAGMENT_SHADER);
+  build->program = gl_ext.create_program();
+  if (build->vertex == 0 or build->fragment == 0 or build->program == 0) {
+    if (build->vertex) gl_ext.delete_shader(build->vertex);
+    if (build->fragment) gl_ext.delete_shader(build->fragment);
+    if (build->program) gl_ext.delete_program(build->program);
+    return false;
+  }
+  gl_ext.shader_source(build->vertex, 1, &vs_code, nullptr);
+  gl_ext.shader_source(build->fragment, 1, &fs_code, nullptr);
+  gl_ext.compile_shader(build->vertex);
+  gl_ext.compile_shader(build->fragment);
+  gl_ext.attach_shader(build->program, build->vertex);
+  gl_ext.attach_shader(build->program, build->fragment);
+
+  // Same attribute slots rlLoadShaderProgram() binds, raylib's meshes are laid out for them
+  gl_ext.bind_attrib_location(build->program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, RL_DEFAULT_SHADER_ATTRIB_NAME_POSITION);
+  gl_ext.bind_attrib_location(build->program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD, RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD);
+  gl_ext.bind_attrib_location(build->program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL, RL_DEFAULT_SHADER_ATTRIB_NAME_NORMAL);
+  gl_ext.bind_attrib_location(build->program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, RL_DEFAULT_SHADER_ATTRIB_NAME_COLOR);
+  gl_ext.bind_attrib_location(build->program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_TANGENT, RL_DEFAULT_SHADER_ATTRIB_NAME_TANGENT);
+  gl_ext.bind_attrib_location(build->program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD2, RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD2);
+  if (state->stats.binary_cache) {
+    gl_ext.program_parameter_i(build->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, 1);
+  }
+  gl_ext.link_program(build->program);
+  return true;
+}
+
+static bool build_ready(const shader_build* build) {
+  if (not state->stats.parallel_compile) {
+    return true;
+  }
+  i32 complete = 0;
+  gl_ext.get_program_iv(build->program, GL_COMPLETION_STATUS, &complete);
+  return complete != 0;
+}
+
+/**
+ * @brief Blocks until the link is done. Logs the compile and link errors and deletes the program on failure.
+ */
+static bool finish_build(const shader_program* program, shader_build* build) {
+  char log[SHADER_INFO_LOG_MAX];
+  i32 linked = 0;
+  gl_ext.get_program_iv(build->program, GL_LINK_STATUS, &linked);
+  if (linked == 0) {
+    const u32 stages[2] = { build->vertex, build->fragment };
+    const char* files[2] = { (program->vs_file[0] != '\0') ? program->vs_file : "default vertex shader", program->fs_file };
+    for (u32 i = 0; i < 2; ++i) {
+      i32 compiled = 0;
+      gl_ext.get_shader_iv(stages[i], GL_COMPILE_STATUS, &compiled);
+      if (compiled == 0) {
+        gl_ext.get_shader_info_log(stages[i], SHADER_INFO_LOG_MAX, nullptr, log);
+        TRACELOG(LOG_WARNING, "SHADER: %s failed to compile:\n%s", files[i], log);
+      }
+    }
+    gl_ext.get_program_info_log(build->program, SHADER_INFO_LOG_MAX, nullptr, log);
+    TRACELOG(LOG_WARNING, "SHADER: %s failed to link:\n%s", program->fs_file, log);
+  }
+  gl_ext.detach_shader(build->program, build->vertex);
+  gl_ext.detach_shader(build->program, build->fragment);
+  gl_ext.delete_shader(build->vertex);
+  gl_ext.delete_shader(build->fragment);
+  build->vertex = 0;
+  build->fragment = 0;
+  if (linked == 0) {
+    gl_ext.delete_program(build->program);
+    build->program = 0;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief The default locations LoadShader() looks up. Programs declaring frame_data get the shared block.
+ */
+static Shader make_shader(u32 id) {
+  Shader shader = {};
+  shader.id = id;
+  shader.locs = (i32*)MemAlloc(RL_MAX_SHADER_LOCATIONS * sizeof(i32));
+  for (i32 i = 0; i < RL_MAX_SHADER_LOCATIONS; ++i) {
+    shader.locs[i] = -1;
+  }
+  shader.locs[SHADER_LOC_VERTEX_POSITION] = rlGetLocationAttrib(id, RL_DEFAULT_SHADER_ATTRIB_NAME_POSITION);
+  shader.locs[SHADER_LOC_VERTEX_TEXCOORD01] = rlGetLocationAttrib(id, RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD);
+  shader.locs[SHADER_LOC_VERTEX_TEXCOORD02] = rlGetLocationAttrib(id, RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD2);
+  shader.locs[SHADER_LOC_VERTEX_NORMAL] = rlGetLocationAttrib(id, RL_DEFAULT_SHADER_ATTRIB_NAME_NORMAL);
+  shader.locs[SHADER_LOC_VERTEX_TANGENT] = rlGetLocationAttrib(id, RL_DEFAULT_SHADER_ATTRIB_NAME_TANGENT);
+  shader.locs[SHADER_LOC_VERTEX_COLOR] = rlGetLocationAttrib(id, RL_DEFAULT_SHADER_ATTRIB_NAME_COLOR);
+  shader.locs[SHADER_LOC_MATRIX_MVP] = rlGetLocationUniform(id, RL_DEFAULT_SHADER_UNIFORM_NAME_MVP);
+  shader.locs[SHADER_LOC_MATRIX_VIEW] = rlGetLocationUniform(id, RL_DEFAULT_SHADER_UNIFORM_NAME_VIEW);
+  shader.locs[SHADER_LOC_MATRIX_PROJECTION] = rlGetLocationUniform(id, RL_DEFAULT_SHADER_UNIFORM_NAME_PROJECTION);
+  shader.locs[SHADER_LOC_MATRIX_MODEL] = rlGetLocationUniform(id, RL_DEFAULT_SHADER_UNIFORM_NAME_MODEL);
+  shader.locs[SHADER_LOC_MATRIX_NORMAL] = rlGetLocationUniform(id, RL_DEFAULT_SHADER_UNIFORM_NAME_NORMAL);
+  shader.locs[SHADER_LOC_COLOR_DIFFUSE] = rlGetLocationUniform(id, RL_DEFAULT_SHADER_UNIFORM_NAME_COLOR);
+  shader.locs[SHADER_LOC_MAP_DIFFUSE] = rlGetLocationUniform(id, RL_DEFAULT_SHADER_SAMPLER2D_NAME_TEXTURE0);
+  shader.locs[SHADER_LOC_MAP_SPECULAR] = rlGetLocationUniform(id, RL_DEFAULT_SHADER_SAMPLER2D_NAME_TEXTURE1);
+  shader.locs[SHADER_LOC_MAP_NORMAL] = rlGetLocationUniform(id, RL_DEFAULT_SHADER_SAMPLER2D_NAME_TEXTURE2);
+
+  if (gl_ext.get_uniform_block_index(id, FRAME_UNIFORM_BLOCK_NAME) != GL_INVALID_INDEX) {
+    uniform_attach_frame_block(shader);
+  }
+  return shader;
+}
+
+static void poll_changes(f64 now) {
+  #if PLATFORM_LINUX
+    if (state->watch_descriptor >= 0) {
+      alignas(inotify_event) char buffer[4096];
+      for (;;) {
+        const ssize_t length = read(state->watch_descriptor, buffer, sizeof(buffer));
+        if (length <= 0) {
+          return;
+        }
+        for (ssize_t offset = 0; offset < length; ) {
+          const inotify_event* event = (const inotify_event*)(buffer + offset);
+          if (event->len > 0) {
+            mark_changed(event->name, now);
+          }
+          offset += (ssize_t)sizeof(inotify_event) + event->len;
+        }
+      }
+    }
+  #endif
+  if (now - state->last_poll < SHADER_POLL_INTERVAL) {
+    return;
+  }
+  state->last_poll = now;
+  for (u32 i = 0; i < state->program_count; ++i) {
+    shader_program& program = state->programs[i];
+    const i64 vs_modified = modified_time(program.vs_file);
+    const i64 fs_modified = modified_time(program.fs_file);
+    if (vs_modified != program.vs_modified) mark_changed(program.vs_file, now);
+    if (fs_modified != program.fs_modified) mark_changed(program.fs_file, now);
+    program.vs_modified = vs_modified;
+    program.fs_modified = fs_modified;
+  }
+}
+
+static void mark_changed(const char* file, f64 now) {
+  for (u32 i = 0; i < state->program_count; ++i) {
+    shader_program& program = state->programs[i];
+    if (not TextIsEqual(file, program.vs_file) and not TextIsEqual(file, program.fs_file)) {
+      continue;
+    }
+    if (program.phase == SHADER_RELOAD_LINKING) {
+      program.changed_while_linking = true;
+      continue;
+    }
+    program.phase = SHADER_RELOAD_CHANGED;
+    program.changed_time = now;
+  }
+}
+
+static i64 modified_time(const char* file) {
+  if (not file or file[0] == '\0') {
+    return 0;
+  }
+  return (i64)GetFileModTime(TextFormat("%s%s", state->source_dir, file));
+}
@@ -0,0 +1,55 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+#include "defines.h"
+#include "raylib.h"
+
+#define SHADER_MAX_PROGRAMS 16
+#define SHADER_FILE_NAME_MAX 64
+#define SHADER_RELOAD_DELAY 0.1 // Seconds without another write before a changed file compiles, editors save in steps
+#define SHADER_POLL_INTERVAL 0.5 // File time polling where inotify isn't available
+
+typedef u32 shader_handle;
+
+typedef struct shader_stats {
+  u32 program_count;
+  u32 binary_loads;    // Programs created from the binary cache
+  u32 source_compiles;
+  u32 reloads;
+  u32 failed_reloads;
+  f64 startup_ms;      // Every shader_load() so far
+  f64 last_reload_ms;  // Compile start to swap, the reload delay excluded
+  bool binary_cache;   // The driver hands out program binaries
+  bool parallel_compile;
+  bool watching;       // inotify, file times are polled otherwise
+} shader_stats;
+
+/**
+ * @param source_dir Directory of the shader files with the trailing separator, watched for changes
+ * @param cache_dir Prefix of the program binary files, "" for the working directory
+ */
+[[__nodiscard__]] bool shader_system_initialize(const char* source_dir, const char* cache_dir);
+void shader_system_shutdown(void);
+
+/**
+ * @brief Creates the program from the binary cache when the sources and the driver match, compiles and caches it otherwise.
+ * Programs declaring the frame_data block are attached to it. A program that fails gets raylib's default shader
+ * until a reload fixes it.
+ * @param vs_file Relative to source_dir, nullptr for raylib's default vertex shader
+ */
+shader_handle shader_load(const char* vs_file, const char* fs_file);
+
+/**
+ * @brief Current program of handle. Copies go stale on reload, EVENT_CODE_SHADER_RELOADED says when.
+ */
+Shader shader_get(shader_handle handle);
+
+/**
+ * @brief Main thread, once per frame. Picks up changed files, starts their compile and swaps in the programs
+ * whose link finished. Doesn't wait on the driver when it supports parallel shader compile.
+ */
+void shader_system_update(void);
+
+shader_stats shader_get_stats(void);
+
+#endif
@@ -0,0 +1,420 @@
+#include "texture.h"
+
+#include "rlgl.h"
+#include <atomic>
+#include <stdio.h> // Required for: fopen(), fread()
+
+#include "core/fjob.h"
+#include "core/fmemory.h"
+#include "core/fprofile.h"
+#include "render/gl_ext.h"
+
+#define TEXTURE_MIP_ROW_BATCH 32
+#define TEXTURE_TIMELINE_COLUMNS 48
+
+typedef enum texture_phase {
+  TEXTURE_PHASE_QUEUED,
+  TEXTURE_PHASE_DECODED, // The mip chain is in pixels, waiting for upload budget
+  TEXTURE_PHASE_UPLOADING,
+  TEXTURE_PHASE_READY,
+  TEXTURE_PHASE_FAILED,
+} texture_phase;
+
+typedef struct texture_slot {
+  char path[TEXTURE_PATH_MAX];
+  Texture2D texture;
+  std::atomic<u32> phase; // The decode job publishes DECODED or FAILED, the main thread owns the rest
+  job_counter decode;
+  char baked_path[TEXTURE_PATH_MAX]; // Empty without a usable container
+  u8* pixels; // Decoded RGBA8 levels, null for containers
+  texture_container container;
+  const u8* levels[TEXTURE_MAX_LEVELS];
+  u64 level_bytes[TEXTURE_MAX_LEVELS];
+  i32 width;
+  i32 height;
+  i32 mip_count;
+  i32 upload_level; // Counts down, the smallest level goes up first
+  i32 upload_row;
+  texture_timeline timeline;
+} texture_slot;
+
+typedef struct texture_system_state {
+  f64 start_time;
+  u64 upload_budget;
+  u64 frame_count;
+  u32 texture_count;
+  texture_slot slots[TEXTURE_MAX_COUNT];
+  texture_stats stats;
+  bool compressed; // EXT_texture_compression_s3tc, containers are ignored without it
+  bool timeline_logged;
+} texture_system_state;
+
+typedef struct mip_context {
+  const u8* source;
+  u8* destination;
+  i32 source_width;
+  i32 source_height;
+  i32 width;
+} mip_context;
+
+static texture_system_state * state = nullptr;
+
+static f64 elapsed_ms(void);
+static i32 level_size(i32 size, i32 level);
+static void decode_texture(void* data);
+static Image load_image(const char* path);
+static void downsample_rows(u32 begin, u32 end, void* data);
+static u64 upload_levels(texture_slot* slot, u64 budget);
+static void log_timeline(void);
+
+bool texture_system_initialize(u64 upload_budget) {
+  if (state and state != nullptr) {
+    return false;
+  }
+  if (not gl_ext_load()) {
+    return false;
+  }
+  state = (texture_system_state*)allocate_memory_linear(sizeof(texture_system_state), true, MEMORY_TAG_RENDER);
+  state->start_time = GetTime();
+  state->upload_budget = FMAX(upload_budget, 1ull);
+  state->compressed = gl_ext_has_extension("GL_EXT_texture_compression_s3tc");
+  if (not state->compressed) {
+    TRACELOG(LOG_WARNING, "TEXTURE: No S3TC support, baked containers are skipped");
+  }
+  return true;
+}
+
+void texture_system_shutdown(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  for (u32 i = 0; i < state->texture_count; ++i) {
+    texture_slot* slot = &state->slots[i];
+    job_wait(&slot->decode);
+    if (slot->pixels) {
+      free_memory(slot->pixels);
+    }
+    texture_container_close(&slot->container);
+    rlUnloadTexture(slot->texture.id);
+  }
+  state = nullptr;
+}
+
+texture_handle texture_load_async(const char* path, Color placeholder) {
+  if (not state or state == nullptr or not path) {
+    return INVALID_IDU32;
+  }
+  if (state->texture_count >= TEXTURE_MAX_COUNT or TextLength(path) >= TEXTURE_PATH_MAX) {
+    TRACELOG(LOG_WARNING, "TEXTURE: [%s] Can't be queued", path);
+    return INVALID_IDU32;
+  }
+  const texture_handle handle = state->texture_count++;
+  texture_slot* slot = &state->slots[handle];
+  TextCopy(slot->path, path);
+  // A container older than its source waits for the next bake
+  const char* baked = texture_baked_path(path);
+  if (state->compressed and FileExists(baked) and (not FileExists(path) or GetFileModTime(baked) >= GetFileModTime(path))) {
+    TextCopy(slot->baked_path, baked);
+  }
+  slot->texture.id = rlLoadTexture(&placeholder, 1, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1);
+  slot->texture.width = 1;
+  slot->texture.height = 1;
+  slot->texture.mipmaps = 1;
+  slot->texture.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+  slot->timeline.queued_ms = elapsed_ms();
+  state->stats.texture_count = state->texture_count;
+  state->stats.all_ready_ms = 0.0;
+  state->timeline_logged = false;
+
+  job_run(job_desc { decode_texture, slot }, &slot->decode);
+  return handle;
+}
+
+Texture2D texture_get(texture_handle handle) {
+  if (not state or state == nullptr or handle >= state->texture_count) {
+    return Texture2D {};
+  }
+  return state->slots[handle].texture;
+}
+
+bool texture_is_ready(texture_handle handle) {
+  if (not state or state == nullptr or handle >= state->texture_count) {
+    return false;
+  }
+  return state->slots[handle].phase.load(std::memory_order_acquire) == TEXTURE_PHASE_READY;
+}
+
+void texture_system_update(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  const f64 now_ms = elapsed_ms();
+  if (state->frame_count++ == 0) {
+    state->stats.first_frame_ms = now_ms;
+  }
+  u64 budget = state->upload_budget;
+  u32 pending = 0;
+  u32 failed = 0;
+  state->stats.frame_bytes = 0;
+  for (u32 i = 0; i < state->texture_count; ++i) {
+    texture_slot* slot = &state->slots[i];
+    u32 phase = slot->phase.load(std::memory_order_acquire);
+    if (phase == TEXTURE_PHASE_DECODED and budget > 0) {
+      slot->upload_level = slot->mip_count - 1;
+      slot->upload_row = 0;
+      slot->timeline.upload_begin_ms = now_ms;
+      phase = TEXTURE_PHASE_UPLOADING;
+      slot->phase.store(phase, std::memory_order_relaxed);
+    }
+    if (phase == TEXTURE_PHASE_UPLOADING and budget > 0) {
+      const u64 uploaded = upload_levels(slot, budget);
+      budget = (uploaded >= budget) ? 0 : budget - uploaded;
+      state->stats.frame_bytes += uploaded;
+      phase = slot->phase.load(std::memory_order_relaxed);
+    }
+    failed += (phase == TEXTURE_PHASE_FAILED) ? 1 : 0;
+    pending += (phase != TEXTURE_PHASE_READY and phase != TEXTURE_PHASE_FAILED) ? 1 : 0;
+  }
+  state->stats.uploaded_bytes += state->stats.frame_bytes;
+  state->stats.pending = pending;
+  state->stats.failed = failed;
+  if (pending == 0 and state->texture_count > 0 and not state->timeline_logged) {
+    state->stats.all_ready_ms = now_ms;
+    state->timeline_logged = true;
+    log_timeline();
+  }
+}
+
+texture_stats texture_get_stats(void) {
+  if (not state or state == nullptr) {
+    return texture_stats {};
+  }
+  return state->stats;
+}
+
+texture_timeline texture_get_timeline(texture_handle handle) {
+  if (not state or state == nullptr or handle >= state->texture_count) {
+    return texture_timeline {};
+  }
+  return state->slots[handle].timeline;
+}
+
+u8* texture_build_mips(const Image* image, i32* out_mip_count, u64* out_level_offsets) {
+  if (not image or not image->data or image->format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+    return nullptr;
+  }
+  const i32 largest = FMAX(image->width, image->height);
+  i32 mip_count = 1;
+  while ((largest >> mip_count) > 0 and mip_count < TEXTURE_MAX_LEVELS) {
+    ++mip_count;
+  }
+  u64 total = 0;
+  for (i32 level = 0; level < mip_count; ++level) {
+    out_level_offsets[level] = total;
+    total += (u64)level_size(image->width, level) * level_size(image->height, level) * 4;
+  }
+  u8* pixels = (u8*)allocate_memory(total, false, MEMORY_TAG_RENDER);
+  copy_memory(pixels, image->data, (u64)image->width * image->height * 4);
+
+  for (i32 level = 1; level < mip_count; ++level) {
+    mip_context context = {};
+    context.source = pixels + out_level_offsets[level - 1];
+    context.destination = pixels + out_level_offsets[level];
+    context.source_width = level_size(image->width, level - 1);
+    context.source_height = level_size(image->height, level - 1);
+    context.width = level_size(image->width, level);
+    job_parallel_for((u32)level_size(image->height, level), TEXTURE_MIP_ROW_BATCH, downsample_rows, &context);
+  }
+  *out_mip_count = mip_count;
+  return pixels;
+}
+
+static f64 elapsed_ms(void) {
+  return (GetTime() - state->start_time) * 1000.0;
+}
+
+static i32 level_size(i32 size, i32 level) {
+  const i32 scaled = size >> level;
+  return FMAX(scaled, 1);
+}
+
+// Worker thread. Maps the container, or decodes, converts to RGBA8 and builds the mip chain.
+static void decode_texture(void* data) {
+  PROFILE_SCOPE("texture_decode");
+  texture_slot* slot = (texture_slot*)data;
+  slot->timeline.decode_thread = job_thread_index();
+  slot->timeline.decode_begin_ms = elapsed_ms();
+  if (slot->baked_path[0] != '\0') {
+    if (texture_container_open(slot->baked_path, &slot->container)) {
+      slot->width = slot->container.width;
+      slot->height = slot->container.height;
+      slot->mip_count = slot->container.mip_count;
+      for (i32 level = 0; level < slot->mip_count; ++level) {
+        slot->levels[level] = slot->container.levels[level];
+        slot->level_bytes[level] = slot->container.level_bytes[level];
+      }
+      slot->timeline.baked = true;
+      slot->timeline.decode_end_ms = elapsed_ms();
+      slot->timeline.mips_end_ms = slot->timeline.decode_end_ms;
+      slot->phase.store(TEXTURE_PHASE_DECODED, std::memory_order_release);
+      return;
+    }
+    TRACELOG(LOG_WARNING, "TEXTURE: [%s] Container is unusable, decoding the source", slot->baked_path);
+  }
+
+  Image image = load_image(slot->path);
+  if (image.data) {
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+  }
+  slot->timeline.decode_end_ms = elapsed_ms();
+  if (not image.data or image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+    TRACELOG(LOG_WARNING, "TEXTURE: [%s] Failed to decode, the placeholder stays", slot->path);
+    UnloadImage(image);
+    slot->phase.store(TEXTURE_PHASE_FAILED, std::memory_order_release);
+    return;
+  }
+  u64 level_offsets[TEXTURE_MAX_LEVELS];
+  slot->width = image.width;
+  slot->height = image.height;
+  slot->pixels = texture_build_mips(&image, &slot->mip_count, level_offsets);
+  UnloadImage(image);
+  for (i32 level = 0; level < slot->mip_count; ++level) {
+    slot->levels[level] = slot->pixels + level_offsets[level];
+    slot->level_bytes[level] = (u64)level_size(slot->width, level) * level_size(slot->height, level) * 4;
+  }
+  slot->timeline.mips_end_ms = elapsed_ms();
+  slot->phase.store(TEXTURE_PHASE_DECODED, std::memory_order_release);
+}
+
+// The file is only needed until it's decoded, so it's read into the thread's scratch arena instead of a heap copy.
+// Files that don't fit go through LoadImage()
+static Image load_image(const char* path) {
+  memory_arena* scratch = memory_get_scratch_arena();
+  arena_scope scope(scratch);
+  const i32 file_size = GetFileLength(path);
+  if (file_size <= 0 or (u64)file_size + MEMORY_DEFAULT_ALIGNMENT > scratch->size - scratch->offset) {
+    return LoadImage(path);
+  }
+  u8* file_data = (u8*)allocate_memory_arena(scratch, (u64)file_size, MEMORY_DEFAULT_ALIGNMENT, false);
+  FILE* file = fopen(path, "rb");
+  const bool read = file and fread(file_data, 1, (u64)file_size, file) == (u64)file_size;
+  if (file) {
+    fclose(file);
+  }
+  return read ? LoadImageFromMemory(GetFileExtension(path), file_data, file_size) : Image {};
+}
+
+// 2x2 box filter, odd edges repeat their last texel
+static void downsample_rows(u32 begin, u32 end, void* data) {
+  PROFILE_SCOPE("texture_mips");
+  const mip_context* context = (const mip_context*)data;
+  const i32 source_stride = context->source_width * 4;
+  for (u32 y = begin; y < end; ++y) {
+    const i32 y1 = (i32)y * 2 + 1;
+    const u8* row0 = context->source + (u64)(y * 2) * source_stride;
+    const u8* row1 = context->source + (u64)((y1 < context->source_height) ? y1 : y1 - 1) * source_stride;
+    u8* out = context->destination + (u64)y * context->width * 4;
+    for (i32 x = 0; x < context->width; ++x) {
+      const i32 x0 = x * 2 * 4;
+      const i32 x1 = (x * 2 + 1 < context->source_width) ? x0 + 4 : x0;
+      for (i32 c = 0; c < 4; ++c) {
+        out[x * 4 + c] = (u8)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+      }
+    }
+  }
+}
+
+// Main thread. Sends rows, or whole levels of a container, until the budget runs out. A finished level becomes
+// the texture's base level.
+static u64 upload_levels(texture_slot* slot, u64 budget) {
+  u64 uploaded = 0;
+  gl_ext.bind_texture(GL_TEXTURE_2D, slot->texture.id);
+  while (slot->upload_level >= 0 and uploaded < budget) {
+    const i32 level = slot->upload_level;
+    const i32 width = level_size(slot->width, level);
+    const i32 height = level_size(slot->height, level);
+    if (slot->timeline.baked) {
+      // The driver copies the blocks as they are, no decode and no conversion on the way
+      gl_ext.compressed_tex_image_2d(GL_TEXTURE_2D, level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, width, height, 0,
+        (i32)slot->level_bytes[level], slot->levels[level]);
+      uploaded += slot->level_bytes[level];
+    } else {
+      const u64 row_bytes = (u64)width * 4;
+      if (slot->upload_row == 0) {
+        gl_ext.tex_image_2d(GL_TEXTURE_2D, level, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+      }
+      const u64 affordable = (budget - uploaded) / row_bytes;
+      const u64 remaining = (u64)(height - slot->upload_row);
+      i32 rows = (i32)((affordable < remaining) ? affordable : remaining);
+      rows = FMAX(rows, 1);
+      gl_ext.tex_sub_image_2d(GL_TEXTURE_2D, level, 0, slot->upload_row, width, rows, GL_RGBA, GL_UNSIGNED_BYTE,
+        slot->levels[level] + (u64)slot->upload_row * row_bytes);
+      uploaded += (u64)rows * row_bytes;
+      slot->upload_row += rows;
+      if (slot->upload_row < height) {
+        continue;
+      }
+    }
+    slot->timeline.gpu_bytes += slot->level_bytes[level];
+    state->stats.gpu_bytes += slot->level_bytes[level];
+    // Levels up to the smallest one are complete, sampling switches to them right away
+    if (level == slot->mip_count - 1) {
+      gl_ext.tex_parameter_i(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, slot->mip_count - 1);
+      gl_ext.tex_parameter_i(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+      gl_ext.tex_parameter_i(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    gl_ext.tex_parameter_i(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    --slot->upload_level;
+    slot->upload_row = 0;
+  }
+  gl_ext.bind_texture(GL_TEXTURE_2D, 0);
+  ++slot->timeline.upload_frames;
+
+  if (slot->upload_level < 0) {
+    if (slot->pixels) {
+      free_memory(slot->pixels);
+      slot->pixels = nullptr;
+    }
+    texture_container_close(&slot->container);
+    slot->texture.width = slot->width;
+    slot->texture.height = slot->height;
+    slot->texture.mipmaps = slot->mip_count;
+    slot->texture.format = slot->timeline.baked ? PIXELFORMAT_COMPRESSED_DXT1_RGB : PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    state->stats.baked += slot->timeline.baked ? 1 : 0;
+    slot->timeline.upload_end_ms = elapsed_ms();
+    slot->phase.store(TEXTURE_PHASE_READY, std::memory_order_relaxed);
+  }
+  return uploaded;
+}
+
+// One bar per texture over the same scale: d decode or mapping, m mips, u upload, | the first frame
+static void log_timeline(void) {
+  const f64 end_ms = state->stats.all_ready_ms;
+  const f64 column_ms = FMAX(end_ms / TEXTURE_TIMELINE_COLUMNS, 0.001);
+  const i32 first_frame_column = (i32)(state->stats.first_frame_ms / column_ms);
+  TRACELOG(LOG_INFO, "TEXTURE: %u textures (%u baked) ready at %.1f ms, %.2f MB on the GPU, first frame at %.1f ms, %.2f ms per column",
+    state->texture_count - state->stats.failed, state->stats.baked, end_ms, state->stats.gpu_bytes / (1024.0 * 1024.0),
+    state->stats.first_frame_ms, column_ms);
+  for (u32 i = 0; i < state->texture_count; ++i) {
+    const texture_slot* slot = &state->slots[i];
+    const texture_timeline* timeline = &slot->timeline;
+    char bar[TEXTURE_TIMELINE_COLUMNS + 1];
+    for (i32 column = 0; column < TEXTURE_TIMELINE_COLUMNS; ++column) {
+      const f64 time = (column + 0.5) * column_ms;
+      char mark = (column == first_frame_column) ? '|' : '.';
+      if (time >= timeline->decode_begin_ms and time < timeline->decode_end_ms) mark = 'd';
+      else if (time >= timeline->decode_end_ms and time < timeline->mips_end_ms) mark = 'm';
+      else if (time >= timeline->upload_begin_ms and time < timeline->upload_end_ms) mark = 'u';
+      bar[column] = mark;
+    }
+    bar[TEXTURE_TIMELINE_COLUMNS] = '\0';
+    if (slot->phase.load(std::memory_order_relaxed) == TEXTURE_PHASE_FAILED) {
+      TRACELOG(LOG_INFO, "TEXTURE: %s %s failed", bar, GetFileName(slot->path));
+      continue;
+    }
+    TRACELOG(LOG_INFO, "TEXTURE: %s %s %ix%i %s, %s %.1f-%.1f on thread %u, mips to %.1f, upload %.1f-%.1f in %u frames, %llu KB",
+      bar, GetFileName(slot->path), slot->width, slot->height, timeline->baked ? "BC1" : "RGBA8", timeline->baked ? "mapped" : "decode",
+      timeline->decode_begin_ms, timeline->decode_end_ms, timeline->decode_thread, timeline->mips_end_ms, timeline->upload_begin_ms,
+      timeline->upload_end_ms, timeline->upload_frames, timeline->gpu_bytes / 1024);
+  }
+}
@@ -0,0 +1,119 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include "defines.h"
+#include "raylib.h"
+
+#include "core/fcache.h"
+
+#define TEXTURE_MAX_COUNT 32
+#define TEXTURE_PATH_MAX 256
+#define TEXTURE_UPLOAD_BUDGET (4 * 1024 * 1024) // Bytes handed to the driver per frame
+#define TEXTURE_MAX_LEVELS 16 // 32768 texels wide
+
+typedef u32 texture_handle;
+
+/**
+ * @brief Milliseconds since texture_system_initialize(), the decode and mip steps run on a worker.
+ */
+typedef struct texture_timeline {
+  f64 queued_ms;
+  f64 decode_begin_ms;
+  f64 decode_end_ms;
+  f64 mips_end_ms;
+  f64 upload_begin_ms;
+  f64 upload_end_ms;
+  u32 decode_thread;
+  u32 upload_frames;
+  u64 gpu_bytes;
+  bool baked;        // Mapped from the container, decode is the mapping and mips are empty
+} texture_timeline;
+
+typedef struct texture_stats {
+  u32 texture_count;
+  u32 pending;         // Queued, decoding or uploading
+  u32 failed;
+  u32 baked;           // Loaded from containers
+  u64 gpu_bytes;       // Levels of the uploaded textures
+  u64 uploaded_bytes;  // Every level of every texture so far
+  u64 frame_bytes;     // Last texture_system_update()
+  f64 first_frame_ms;  // First texture_system_update()
+  f64 all_ready_ms;    // 0 while textures are pending
+} texture_stats;
+
+/**
+ * @param upload_budget Bytes uploaded per texture_system_update(), at least a row of a level goes up each frame
+ */
+[[__nodiscard__]] bool texture_system_initialize(u64 upload_budget);
+
+/**
+ * @brief Waits for the decodes in flight and unloads every texture.
+ */
+void texture_system_shutdown(void);
+
+/**
+ * @brief Returns at once with a 1x1 placeholder of color. A worker maps the baked container next to path or,
+ * without one, decodes the file and builds its mip chain. texture_system_update() uploads it from the smallest
+ * level up into the same texture id.
+ * @param path Any format raylib's LoadImage() reads
+ */
+texture_handle texture_load_async(const char* path, Color placeholder);
+
+/**
+ * @brief The id never changes, copies in materials show the levels as they arrive. Size and mipmaps are the
+ * placeholder's until the upload is done.
+ */
+Texture2D texture_get(texture_handle handle);
+bool texture_is_ready(texture_handle handle);
+
+/**
+ * @brief Main thread, once per frame. Uploads decoded levels within the budget and logs the startup timeline
+ * once nothing is pending.
+ */
+void texture_system_update(void);
+
+texture_stats texture_get_stats(void);
+texture_timeline texture_get_timeline(texture_handle handle);
+
+/**
+ * @brief RGBA8 mip chain of image, 2x2 box filtered with the rows of each level spread over the workers.
+ * Levels are back to back from level 0, free the result with free_memory().
+ */
+u8* texture_build_mips(const Image* image, i32* out_mip_count, u64* out_level_offsets);
+
+/**
+ * @brief Pre-mipped BC1 texture mapped in place, level pointers stay valid until texture_container_close().
+ */
+typedef struct texture_container {
+  cache_file mapping;
+  i32 width;
+  i32 height;
+  i32 mip_count;
+  const u8* levels[TEXTURE_MAX_LEVELS];
+  u64 level_bytes[TEXTURE_MAX_LEVELS];
+} texture_container;
+
+/**
+ * @brief Accepts the DDS files texture_bake_directory() writes: DXT1 with its mip chain.
+ */
+bool texture_container_open(const char* path, texture_container* out);
+void texture_container_close(texture_container* container);
+
+/**
+ * @brief Container that stands in for source_path, the extension swapped for .dds. Main thread, the buffer is reused.
+ */
+const char* texture_baked_path(const char* source_path);
+
+/**
+ * @brief Offline step behind --bake-textures. Converts every .jpg and .png of directory that is newer than its
+ * container. Returns the number of files written.
+ */
+u32 texture_bake_directory(const char* directory);
+
+/**
+ * @brief Bakes directory, then times what a worker does per texture with and without its container and compares
+ * the level bytes. Headless, so the upload and the driver's memory are left to the startup timeline. Results are logged.
+ */
+void texture_run_benchmark(const char* directory);
+
+#endif
@@ -0,0 +1,348 @@
+#include "texture.h"
+
+#include <math.h>   // Required for: sqrt(), fabsf(), fmaxf()
+#include <stdio.h>  // Required for: snprintf()
+#include <string.h> // Required for: memcpy()
+
+#include "core/fjob.h"
+#include "core/fmemory.h"
+
+#define DDS_MAGIC 0x20534444u   // "DDS "
+#define DDS_FOURCC_DXT1 0x31545844u
+#define DDS_FLAGS 0x000A1007u   // CAPS, HEIGHT, WIDTH, PIXELFORMAT, MIPMAPCOUNT, LINEARSIZE
+#define DDS_PIXEL_FOURCC 0x4u
+#define DDS_CAPS 0x00401008u    // COMPLEX, TEXTURE, MIPMAP
+#define BC1_BLOCK_BYTES 8
+#define BC1_ROW_BATCH 4
+#define BAKE_POWER_ITERATIONS 8
+
+typedef struct dds_pixel_format {
+  u32 size;
+  u32 flags;
+  u32 four_cc;
+  u32 rgb_bit_count;
+  u32 masks[4];
+} dds_pixel_format;
+
+typedef struct dds_header {
+  u32 magic;
+  u32 size; // 124, the magic isn't counted
+  u32 flags;
+  u32 height;
+  u32 width;
+  u32 linear_size;
+  u32 depth;
+  u32 mip_count;
+  u32 reserved[11];
+  dds_pixel_format pixel_format;
+  u32 caps[4];
+  u32 reserved2;
+} dds_header;
+
+static_assert(sizeof(dds_header) == 128, "dds_header is written as it is");
+
+typedef struct bc1_context {
+  const u8* pixels; // RGBA8 level
+  u8* blocks;
+  i32 width;
+  i32 height;
+  u64* row_errors; // Squared error per block row, null to skip
+} bc1_context;
+
+static u64 bc1_level_bytes(i32 width, i32 height);
+static bool bake_file(const char* source, const char* baked);
+static void compress_block_rows(u32 begin, u32 end, void* data);
+static u64 encode_block(const u8* block, u8* out);
+static u16 pack_565(const f32* color);
+static void unpack_565(u16 packed, f32* color);
+
+bool texture_container_open(const char* path, texture_container* out) {
+  if (not out) {
+    return false;
+  }
+  *out = texture_container {};
+  if (not cache_map(path, &out->mapping)) {
+    return false;
+  }
+  dds_header header = {};
+  if (out->mapping.size >= sizeof(header)) {
+    memcpy(&header, out->mapping.data, sizeof(header));
+  }
+  const bool valid = header.magic == DDS_MAGIC and header.size == sizeof(dds_header) - sizeof(u32)
+    and (header.pixel_format.flags & DDS_PIXEL_FOURCC) and header.pixel_format.four_cc == DDS_FOURCC_DXT1
+    and header.width > 0 and header.height > 0 and header.mip_count > 0 and header.mip_count <= TEXTURE_MAX_LEVELS;
+  if (not valid) {
+    texture_container_close(out);
+    return false;
+  }
+  out->width = (i32)header.width;
+  out->height = (i32)header.height;
+  out->mip_count = (i32)header.mip_count;
+  u64 offset = sizeof(header);
+  for (i32 level = 0; level < out->mip_count; ++level) {
+    const i32 width = (out->width >> level) > 0 ? out->width >> level : 1;
+    const i32 height = (out->height >> level) > 0 ? out->height >> level : 1;
+    out->levels[level] = out->mapping.data + offset;
+    out->level_bytes[level] = bc1_level_bytes(width, height);
+    offset += out->level_bytes[level];
+  }
+  if (offset > out->mapping.size) {
+    texture_container_close(out);
+    return false;
+  }
+  return true;
+}
+
+void texture_container_close(texture_container* container) {
+  if (not container) {
+    return;
+  }
+  cache_close(&container->mapping);
+  *container = texture_container {};
+}
+
+const char* texture_baked_path(const char* source_path) {
+  static char path[TEXTURE_PATH_MAX];
+  i32 stem = TextLength(source_path);
+  for (i32 i = stem - 1; i >= 0 and source_path[i] != '/' and source_path[i] != '\\'; --i) {
+    if (source_path[i] == '.') {
+      stem = i;
+      break;
+    }
+  }
+  snprintf(path, sizeof(path), "%.*s.dds", stem, source_path);
+  return path;
+}
+
+u32 texture_bake_directory(const char* directory) {
+  if (not DirectoryExists(directory)) {
+    TRACELOG(LOG_WARNING, "TEXTURE: Bake directory %s doesn't exist", directory);
+    return 0;
+  }
+  const f64 start = GetTime();
+  FilePathList files = LoadDirectoryFiles(directory);
+  u32 written = 0;
+  u32 current = 0;
+  for (u32 i = 0; i < files.count; ++i) {
+    const char* source = files.paths[i];
+    if (not IsFileExtension(source, ".jpg;.png")) {
+      continue;
+    }
+    const char* baked = texture_baked_path(source);
+    if (FileExists(baked) and GetFileModTime(baked) >= GetFileModTime(source)) {
+      ++current;
+      continue;
+    }
+    written += bake_file(source, baked) ? 1 : 0;
+  }
+  UnloadDirectoryFiles(files);
+  TRACELOG(LOG_INFO, "TEXTURE: Baked %u textures in %.1f ms, %u were up to date", written, (GetTime() - start) * 1000.0, current);
+  return written;
+}
+
+static u64 bc1_level_bytes(i32 width, i32 height) {
+  return (u64)((width + 3) / 4) * ((height + 3) / 4) * BC1_BLOCK_BYTES;
+}
+
+static bool bake_file(const char* source, const char* baked) {
+  const f64 start = GetTime();
+  Image image = LoadImage(source);
+  if (image.data) {
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+  }
+  if (not image.data or image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+    TRACELOG(LOG_WARNING, "TEXTURE: [%s] Failed to decode, not baked", source);
+    UnloadImage(image);
+    return false;
+  }
+  const f64 decoded = GetTime();
+  i32 mip_count = 0;
+  u64 level_offsets[TEXTURE_MAX_LEVELS];
+  u8* pixels = texture_build_mips(&image, &mip_count, level_offsets);
+
+  u64 rgba_bytes = 0;
+  u64 file_size = sizeof(dds_header);
+  for (i32 level = 0; level < mip_count; ++level) {
+    const i32 width = (image.width >> level) > 0 ? image.width >> level : 1;
+    const i32 height = (image.height >> level) > 0 ? image.height >> level : 1;
+    rgba_bytes += (u64)width * height * 4;
+    file_size += bc1_level_bytes(width, height);
+  }
+  u8* file = (u8*)allocate_memory(file_size, true, MEMORY_TAG_RENDER);
+  dds_header header = {};
+  header.magic = DDS_MAGIC;
+  header.size = sizeof(dds_header) - sizeof(u32);
+  header.flags = DDS_FLAGS;
+  header.height = (u32)image.height;
+  header.width = (u32)image.width;
+  header.linear_size = (u32)bc1_level_bytes(image.width, image.height);
+  header.mip_count = (u32)mip_count;
+  header.pixel_format.size = sizeof(dds_pixel_format);
+  header.pixel_format.flags = DDS_PIXEL_FOURCC;
+  header.pixel_format.four_cc = DDS_FOURCC_DXT1;
+  header.caps[0] = DDS_CAPS;
+  memcpy(file, &header, sizeof(header));
+
+  // Block rows of every level spread over the workers, level 0 also reports its error
+  const u32 top_block_rows = (u32)(image.height + 3) / 4;
+  u64* row_errors = (u64*)allocate_memory(top_block_rows * sizeof(u64), true, MEMORY_TAG_RENDER);
+  u64 offset = sizeof(dds_header);
+  for (i32 level = 0; level < mip_count; ++level) {
+    bc1_context context = {};
+    context.pixels = pixels + level_offsets[level];
+    context.blocks = file + offset;
+    context.width = (image.width >> level) > 0 ? image.width >> level : 1;
+    context.height = (image.height >> level) > 0 ? image.height >> level : 1;
+    context.row_errors = (level == 0) ? row_errors : nullptr;
+    job_parallel_for((u32)(context.height + 3) / 4, BC1_ROW_BATCH, compress_block_rows, &context);
+    offset += bc1_level_bytes(context.width, context.height);
+  }
+  u64 squared_error = 0;
+  for (u32 row = 0; row < top_block_rows; ++row) {
+    squared_error += row_errors[row];
+  }
+  const f64 rms = sqrt((f64)squared_error / ((f64)image.width * image.height * 3));
+
+  const bool saved = SaveFileData(baked, file, (i32)file_size);
+  if (saved) {
+    TRACELOG(LOG_INFO, "TEXTURE: [%s] %ix%i, %i levels, decode %.1f ms, mips and BC1 %.1f ms, %.2f MB RGBA8 -> %.2f MB BC1, rms %.2f",
+      GetFileName(baked), image.width, image.height, mip_count, (decoded - start) * 1000.0, (GetTime() - decoded) * 1000.0,
+      rgba_bytes / (1024.0 * 1024.0), (file_size - sizeof(dds_header)) / (1024.0 * 1024.0), rms);
+  } else {
+    TRACELOG(LOG_WARNING, "TEXTURE: [%s] Couldn't be written", baked);
+  }
+  free_memory(row_errors);
+  free_memory(file);
+  free_memory(pixels);
+  UnloadImage(image);
+  return saved;
+}
+
+static void compress_block_rows(u32 begin, u32 end, void* data) {
+  const bc1_context* context = (const bc1_context*)data;
+  const i32 blocks_x = (context->width + 3) / 4;
+  u8 block[16 * 4];
+  for (u32 row = begin; row < end; ++row) {
+    u64 row_error = 0;
+    for (i32 bx = 0; bx < blocks_x; ++bx) {
+      // Edge blocks repeat the last column and row
+      for (i32 y = 0; y < 4; ++y) {
+        const i32 sy = FMIN((i32)row * 4 + y, context->height - 1);
+        for (i32 x = 0; x < 4; ++x) {
+          const i32 sx = FMIN(bx * 4 + x, context->width - 1);
+          memcpy(block + (y * 4 + x) * 4, context->pixels + ((u64)sy * context->width + sx) * 4, 4);
+        }
+      }
+      row_error += encode_block(block, context->blocks + ((u64)row * blocks_x + bx) * BC1_BLOCK_BYTES);
+    }
+    if (context->row_errors) {
+      context->row_errors[row] = row_error;
+    }
+  }
+}
+
+// Endpoints are the extremes along the principal axis of the block's colors, returns the squared error
+static u64 encode_block(const u8* block, u8* out) {
+  f32 mean[3] = {};
+  for (i32 i = 0; i < 16; ++i) {
+    for (i32 c = 0; c < 3; ++c) {
+      mean[c] += block[i * 4 + c] / 16.f;
+    }
+  }
+  f32 covariance[6] = {}; // rr rg rb gg gb bb
+  for (i32 i = 0; i < 16; ++i) {
+    const f32 r = block[i * 4] - mean[0];
+    const f32 g = block[i * 4 + 1] - mean[1];
+    const f32 b = block[i * 4 + 2] - mean[2];
+    covariance[0] += r * r;
+    covariance[1] += r * g;
+    covariance[2] += r * b;
+    covariance[3] += g * g;
+    covariance[4] += g * b;
+    covariance[5] += b * b;
+  }
+  f32 axis[3] = { 1.f, 1.f, 1.f };
+  for (i32 i = 0; i < BAKE_POWER_ITERATIONS; ++i) {
+    const f32 x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+    const f32 y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+    const f32 z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+    const f32 largest = fmaxf(fabsf(x), fmaxf(fabsf(y), fabsf(z)));
+    if (largest < 1e-6f) {
+      break;
+    }
+    axis[0] = x / largest;
+    axis[1] = y / largest;
+    axis[2] = z / largest;
+  }
+  i32 lowest = 0;
+  i32 highest = 0;
+  f32 min_projection = 0.f;
+  f32 max_projection = 0.f;
+  for (i32 i = 0; i < 16; ++i) {
+    const f32 projection = block[i * 4] * axis[0] + block[i * 4 + 1] * axis[1] + block[i * 4 + 2] * axis[2];
+    if (i == 0 or projection < min_projection) {
+      min_projection = projection;
+      lowest = i;
+    }
+    if (i == 0 or projection > max_projection) {
+      max_projection = projection;
+      highest = i;
+    }
+  }
+  const f32 high[3] = { (f32)block[highest * 4], (f32)block[highest * 4 + 1], (f32)block[highest * 4 + 2] };
+  const f32 low[3] = { (f32)block[lowest * 4], (f32)block[lowest * 4 + 1], (f32)block[lowest * 4 + 2] };
+  u16 color0 = pack_565(high);
+  u16 color1 = pack_565(low);
+  // color0 > color1 selects the four color mode
+  if (color0 < color1) {
+    const u16 swap = color0;
+    color0 = color1;
+    color1 = swap;
+  }
+  f32 palette[4][3];
+  unpack_565(color0, palette[0]);
+  unpack_565(color1, palette[1]);
+  for (i32 c = 0; c < 3; ++c) {
+    palette[2][c] = (2.f * palette[0][c] + palette[1][c]) / 3.f;
+    palette[3][c] = (palette[0][c] + 2.f * palette[1][c]) / 3.f;
+  }
+  const i32 palette_size = (color0 == color1) ? 1 : 4;
+  u32 indices = 0;
+  f32 error = 0.f;
+  for (i32 i = 0; i < 16; ++i) {
+    i32 best = 0;
+    f32 best_distance = 0.f;
+    for (i32 p = 0; p < palette_size; ++p) {
+      const f32 r = block[i * 4] - palette[p][0];
+      const f32 g = block[i * 4 + 1] - palette[p][1];
+      const f32 b = block[i * 4 + 2] - palette[p][2];
+      const f32 distance = r * r + g * g + b * b;
+      if (p == 0 or distance < best_distance) {
+        best_distance = distance;
+        best = p;
+      }
+    }
+    indices |= (u32)best << (i * 2);
+    error += best_distance;
+  }
+  memcpy(out, &color0, sizeof(color0));
+  memcpy(out + 2, &color1, sizeof(color1));
+  memcpy(out + 4, &indices, sizeof(indices));
+  return (u64)error;
+}
+
+static u16 pack_565(const f32* color) {
+  const u32 r = (u32)(color[0] * 31.f / 255.f + 0.5f);
+  const u32 g = (u32)(color[1] * 63.f / 255.f + 0.5f);
+  const u32 b = (u32)(color[2] * 31.f / 255.f + 0.5f);
+  return (u16)((r << 11) | (g << 5) | b);
+}
+
+static void unpack_565(u16 packed, f32* color) {
+  const u32 r = (packed >> 11) & 31;
+  const u32 g = (packed >> 5) & 63;
+  const u32 b = packed & 31;
+  color[0] = (f32)((r << 3) | (r >> 2));
+  color[1] = (f32)((g << 2) | (g >> 4));
+  color[2] = (f32)((b << 3) | (b >> 2));
+}
@@ -0,0 +1,105 @@
+#include "texture.h"
+
+#include <chrono>
+
+#include "core/fmemory.h"
+
+#define TEXTURE_BENCH_RUNS 4
+
+static f64 elapsed_ms(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// What a worker does for a texture without a container, the RGBA8 chain it leaves is what the GPU would hold
+static bool time_decode(const char* source, f64* best_ms, u64* bytes) {
+  for (u32 run = 0; run < TEXTURE_BENCH_RUNS; ++run) {
+    const auto start = std::chrono::steady_clock::now();
+    Image image = LoadImage(source);
+    if (image.data) {
+      ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    }
+    if (not image.data or image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+      UnloadImage(image);
+      return false;
+    }
+    i32 mip_count = 0;
+    u64 level_offsets[TEXTURE_MAX_LEVELS];
+    u8* pixels = texture_build_mips(&image, &mip_count, level_offsets);
+    const f64 ms = elapsed_ms(start);
+    const i32 last = mip_count - 1;
+    const i32 last_width = FMAX(image.width >> last, 1);
+    const i32 last_height = FMAX(image.height >> last, 1);
+    *bytes = level_offsets[last] + (u64)last_width * last_height * 4;
+    free_memory(pixels);
+    UnloadImage(image);
+    *best_ms = (run == 0 or ms < *best_ms) ? ms : *best_ms;
+  }
+  return true;
+}
+
+// Mapping alone faults nothing in, so every level is read through once the way the upload hands it to the driver
+static bool time_mapping(const char* baked, f64* best_ms, u64* bytes, u64* checksum) {
+  for (u32 run = 0; run < TEXTURE_BENCH_RUNS; ++run) {
+    texture_container container = {};
+    const auto start = std::chrono::steady_clock::now();
+    if (not texture_container_open(baked, &container)) {
+      return false;
+    }
+    u64 sum = 0;
+    for (i32 level = 0; level < container.mip_count; ++level) {
+      sum = cache_hash(container.levels[level], container.level_bytes[level], sum);
+    }
+    const f64 ms = elapsed_ms(start);
+    *bytes = 0;
+    for (i32 level = 0; level < container.mip_count; ++level) {
+      *bytes += container.level_bytes[level];
+    }
+    *checksum = sum;
+    texture_container_close(&container);
+    *best_ms = (run == 0 or ms < *best_ms) ? ms : *best_ms;
+  }
+  return true;
+}
+
+void texture_run_benchmark(const char* directory) {
+  texture_bake_directory(directory);
+  FilePathList files = LoadDirectoryFiles(directory);
+  f64 decode_total_ms = 0.0;
+  f64 mapping_total_ms = 0.0;
+  u64 rgba_total = 0;
+  u64 bc1_total = 0;
+  u32 compared = 0;
+  TRACELOG(LOG_INFO, "TEXTURE: Worker side of a load from %s, best of %u with a warm file cache", directory, TEXTURE_BENCH_RUNS);
+  for (u32 i = 0; i < files.count; ++i) {
+    const char* source = files.paths[i];
+    if (not IsFileExtension(source, ".jpg;.png")) {
+      continue;
+    }
+    f64 decode_ms = 0.0;
+    f64 mapping_ms = 0.0;
+    u64 rgba_bytes = 0;
+    u64 bc1_bytes = 0;
+    u64 checksum = 0;
+    if (not time_decode(source, &decode_ms, &rgba_bytes) or not time_mapping(texture_baked_path(source), &mapping_ms, &bc1_bytes, &checksum)) {
+      TRACELOG(LOG_WARNING, "TEXTURE: [%s] Can not be decoded or has no container, left out", source);
+      continue;
+    }
+    TRACELOG(LOG_INFO, "TEXTURE:   %-24s decode and mips %8.2f ms, %7llu KB RGBA8 | mapped and read %6.3f ms, %6llu KB BC1 (%016llx)",
+      GetFileName(source), decode_ms, rgba_bytes / 1024, mapping_ms, bc1_bytes / 1024, checksum);
+    decode_total_ms += decode_ms;
+    mapping_total_ms += mapping_ms;
+    rgba_total += rgba_bytes;
+    bc1_total += bc1_bytes;
+    compared++;
+  }
+  UnloadDirectoryFiles(files);
+  if (compared == 0) {
+    TRACELOG(LOG_ERROR, "TEXTURE: No texture in %s could be compared", directory);
+    return;
+  }
+  TRACELOG(LOG_INFO, "TEXTURE:   %u textures, %.2f ms against %.3f ms, %.2f MB against %.2f MB of levels (%.1fx smaller)", compared,
+    decode_total_ms, mapping_total_ms, rgba_total / (1024.0 * 1024.0), bc1_total / (1024.0 * 1024.0),
+    (bc1_total > 0) ? (f64)rgba_total / (f64)bc1_total : 0.0);
+  // Needs a GL context, the texture timeline logs both once the window is up
+  TRACELOG(LOG_INFO, "TEXTURE:   upload time and driver memory aren't part of this, compare the startup timeline with and without the .dds files");
+}
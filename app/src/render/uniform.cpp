@@ -0,0 +1,172 @@
+#include "uniform.h"
+
+#include <string.h>
+
+#include "core/fmemory.h"
+#include "core/logger.h"
+#include "render/gl_ext.h"
+
+typedef struct uniform_system_state {
+  u32 frame_buffer;
+  bool frame_valid;
+  frame_uniforms frame;
+
+  uniform_stats current;
+  uniform_stats last_frame;
+} uniform_system_state;
+
+static uniform_system_state * state = nullptr;
+
+static u32 uniform_type_size(ShaderUniformDataType type);
+static u32 hash_name(const char* name);
+static bool entry_matches(const uniform_entry* entry, u32 hash, const char* name);
+
+bool uniform_system_initialize(void) {
+  if (state and state != nullptr) {
+    return false;
+  }
+  if (not gl_ext_load()) {
+    TRACELOG(LOG_ERROR, "UNIFORM: Uniform buffer objects are not supported by the context");
+    return false;
+  }
+  state = (uniform_system_state*)allocate_memory_linear(sizeof(uniform_system_state), true, MEMORY_TAG_RENDER);
+
+  gl_ext.gen_buffers(1, &state->frame_buffer);
+  gl_ext.bind_buffer(GL_UNIFORM_BUFFER, state->frame_buffer);
+  gl_ext.buffer_data(GL_UNIFORM_BUFFER, sizeof(frame_uniforms), nullptr, GL_DYNAMIC_DRAW);
+  gl_ext.bind_buffer(GL_UNIFORM_BUFFER, 0);
+  // raylib never touches uniform buffer bindings, so the block stays bound for the whole session
+  gl_ext.bind_buffer_base(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, state->frame_buffer);
+  return true;
+}
+
+void uniform_system_shutdown(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  gl_ext.delete_buffers(1, &state->frame_buffer);
+  state = nullptr;
+}
+
+void uniform_system_end_frame(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  state->last_frame = state->current;
+  state->current = uniform_stats {};
+}
+
+bool uniform_attach_frame_block(Shader shader) {
+  if (not state or state == nullptr) {
+    return false;
+  }
+  const u32 block_index = gl_ext.get_uniform_block_index(shader.id, FRAME_UNIFORM_BLOCK_NAME);
+  if (block_index == GL_INVALID_INDEX) {
+    TRACELOG(LOG_WARNING, "UNIFORM: [SHDR ID %u] Shader doesn't declare the %s block", shader.id, FRAME_UNIFORM_BLOCK_NAME);
+    return false;
+  }
+  gl_ext.uniform_block_binding(shader.id, block_index, FRAME_UNIFORM_BINDING);
+  return true;
+}
+
+void uniform_update_frame(const frame_uniforms* data) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  if (state->frame_valid and memcmp(&state->frame, data, sizeof(frame_uniforms)) == 0) {
+    state->current.block_skipped++;
+    return;
+  }
+  state->frame = *data;
+  state->frame_valid = true;
+  // Respecifying the whole store lets the driver hand out fresh memory instead of waiting on the last frame
+  gl_ext.bind_buffer(GL_UNIFORM_BUFFER, state->frame_buffer);
+  gl_ext.buffer_data(GL_UNIFORM_BUFFER, sizeof(frame_uniforms), data, GL_DYNAMIC_DRAW);
+  gl_ext.bind_buffer(GL_UNIFORM_BUFFER, 0);
+  state->current.block_uploads++;
+}
+
+void uniform_cache_initialize(uniform_cache* cache, Shader shader) {
+  *cache = uniform_cache {};
+  cache->shader = shader;
+}
+
+void uniform_set(uniform_cache* cache, const char* name, const void* value, ShaderUniformDataType type) {
+  const u32 hash = hash_name(name);
+  uniform_entry* entry = nullptr;
+  for (u32 i = 0; i < cache->entry_count; ++i) {
+    if (entry_matches(&cache->entries[i], hash, name)) {
+      entry = &cache->entries[i];
+      break;
+    }
+  }
+  if (not entry) {
+    if (cache->entry_count == UNIFORM_CACHE_MAX_ENTRIES) {
+      TRACELOG(LOG_WARNING, "UNIFORM: [SHDR ID %u] Cache is full, %s is uploaded uncached", cache->shader.id, name);
+      SetShaderValue(cache->shader, GetShaderLocation(cache->shader, name), value, type);
+      return;
+    }
+    entry = &cache->entries[cache->entry_count++];
+    entry->name_hash = hash;
+    entry->location = GetShaderLocation(cache->shader, name);
+    #ifdef _DEBUG
+      strncpy(entry->name, name, UNIFORM_NAME_MAX - 1);
+      // Found once when the second name is added, release builds would alias both to the first location
+      for (u32 i = 0; i + 1 < cache->entry_count; ++i) {
+        if (cache->entries[i].name_hash == hash) {
+          TRACELOG(LOG_ERROR, "UNIFORM: [SHDR ID %u] %s and %s share the hash %08x", cache->shader.id, cache->entries[i].name, name, hash);
+        }
+      }
+    #endif
+  }
+  if (entry->location < 0) {
+    return;
+  }
+  const u32 size = uniform_type_size(type);
+  if (entry->size == size and memcmp(entry->value, value, size) == 0) {
+    if (state and state != nullptr) state->current.skipped++;
+    return;
+  }
+  memcpy(entry->value, value, size);
+  entry->size = size;
+  SetShaderValue(cache->shader, entry->location, value, type);
+  if (state and state != nullptr) state->current.uploads++;
+}
+
+uniform_stats uniform_get_stats(void) {
+  if (not state or state == nullptr) {
+    return uniform_stats {};
+  }
+  return state->last_frame;
+}
+
+static u32 uniform_type_size(ShaderUniformDataType type) {
+  switch (type) {
+    case SHADER_UNIFORM_VEC2: case SHADER_UNIFORM_IVEC2: return 8;
+    case SHADER_UNIFORM_VEC3: case SHADER_UNIFORM_IVEC3: return 12;
+    case SHADER_UNIFORM_VEC4: case SHADER_UNIFORM_IVEC4: return 16;
+    default: return 4;
+  }
+}
+
+// FNV-1a, uniform names are short and a shader only has a handful of them
+static u32 hash_name(const char* name) {
+  u32 hash = 2166136261u;
+  for (; *name; ++name) {
+    hash = (hash ^ (u8)*name) * 16777619u;
+  }
+  return hash;
+}
+
+// Release builds trust the hash, _DEBUG builds also compare the name
+static bool entry_matches(const uniform_entry* entry, u32 hash, const char* name) {
+  if (entry->name_hash != hash) {
+    return false;
+  }
+  #ifdef _DEBUG
+    return strncmp(entry->name, name, UNIFORM_NAME_MAX - 1) == 0;
+  #else
+    (void)name;
+    return true;
+  #endif
+}
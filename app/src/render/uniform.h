@@ -0,0 +1,83 @@
+#ifndef UNIFORM_H
+#define UNIFORM_H
+
+#include "defines.h"
+#include "raylib.h"
+
+#define UNIFORM_CACHE_MAX_ENTRIES 16
+#define UNIFORM_MAX_VALUE_SIZE 16
+#define UNIFORM_NAME_MAX 32 // _DEBUG builds keep this much of the name to catch hash collisions
+#define FRAME_UNIFORM_BLOCK_NAME "frame_data"
+#define FRAME_UNIFORM_BINDING 0
+
+/**
+ * @brief Per frame camera and time data, std140 layout of the frame_data block in custom_resources.
+ */
+typedef struct frame_uniforms {
+  Vector3 view_pos;
+  f32 time;
+  Vector3 view_target;
+  f32 delta_time;
+  Vector2 resolution;
+  Vector2 padding;
+} frame_uniforms;
+static_assert(sizeof(frame_uniforms) == 48, "frame_uniforms must match the std140 frame_data block");
+
+typedef struct uniform_entry {
+  u32 name_hash;
+  i32 location;
+  u32 size; // 0 until the first upload
+  u8 value[UNIFORM_MAX_VALUE_SIZE];
+#ifdef _DEBUG
+  char name[UNIFORM_NAME_MAX];
+#endif
+} uniform_entry;
+
+/**
+ * @brief Locations looked up by name on first use and the last uploaded values of one shader.
+ * Assumes nothing else sets these uniforms behind its back.
+ */
+typedef struct uniform_cache {
+  Shader shader;
+  u32 entry_count;
+  uniform_entry entries[UNIFORM_CACHE_MAX_ENTRIES];
+} uniform_cache;
+
+typedef struct uniform_stats {
+  u32 uploads;
+  u32 skipped;
+  u32 block_uploads;
+  u32 block_skipped;
+} uniform_stats;
+
+/**
+ * @brief Loads the uniform buffer entry points and creates the frame block, needs a GL context.
+ */
+[[__nodiscard__]] bool uniform_system_initialize(void);
+void uniform_system_shutdown(void);
+
+/**
+ * @brief Rolls the upload counters, uniform_get_stats() reports the frame that just ended.
+ */
+void uniform_system_end_frame(void);
+
+/**
+ * @brief Binds the shader's frame_data block to the shared buffer. False when the shader doesn't declare it.
+ */
+bool uniform_attach_frame_block(Shader shader);
+
+/**
+ * @brief One buffer upload for every attached shader, skipped when nothing changed since the last frame.
+ */
+void uniform_update_frame(const frame_uniforms* data);
+
+void uniform_cache_initialize(uniform_cache* cache, Shader shader);
+
+/**
+ * @brief SetShaderValue() that skips the upload when the uniform already holds value.
+ */
+void uniform_set(uniform_cache* cache, const char* name, const void* value, ShaderUniformDataType type);
+
+uniform_stats uniform_get_stats(void);
+
+#endif
@@ -0,0 +1,481 @@
+#include "scatter.h"
+
+#include <math.h>   // Required for: ceilf(), floorf(), sqrtf()
+#include <string.h> // Required for: memcpy()
+
+#include "raymath.h"
+#include "rlgl.h"
+
+#include "core/fjob.h"
+#include "core/fmemory.h"
+#include "core/fprofile.h"
+#include "core/frandom.h"
+#include "render/gl_ext.h"
+#include "render/gpu_timer.h"
+#include "render/uniform.h"
+#include "world/terrain.h"
+
+#define SCATTER_CELL_EMPTY -1.f
+
+/**
+ * @brief Cells are spacing / sqrt(2) wide, so each holds one instance at most. Instances are kept in region order,
+ * a region that's placed again only rewrites its own range unless its count changed.
+ */
+typedef struct scatter_type_data {
+  Mesh mesh;
+  Color color;
+  scatter_rule rule;
+  u32 cells_per_side;
+  f32 cell_size;
+  i32 neighbor_range;  // Cells around a candidate the disk reaches into
+  f32* cell_x;         // Relative to the origin, SCATTER_CELL_EMPTY when the cell holds nothing
+  f32* cell_y;         // Ground height
+  f32* cell_z;
+  u32* cell_bits;      // Scale, yaw and tilt
+  u32 region_counts[SCATTER_REGION_COUNT];
+  u32 region_offsets[SCATTER_REGION_COUNT];
+
+  float16* transforms; // Column major through MatrixToFloatV(), as the instanceTransform attribute reads them
+  u32 instance_count;
+  u32 transform_capacity;
+  u32 buffer;          // Instance vertex buffer, 0 until the first upload
+  u32 buffer_capacity;
+} scatter_type_data;
+
+typedef struct scatter_system_state {
+  Vector2 origin;
+  f32 size;
+  f32 region_size;
+  u64 seed;
+  scatter_type_data types[SCATTER_MAX_TYPES];
+  u32 type_count;
+  u32 region_generation[SCATTER_REGION_COUNT];
+  bool region_dirty[SCATTER_REGION_COUNT];
+  bool dirty;
+
+  Shader shader;
+  uniform_cache uniforms;
+  scatter_stats stats;
+} scatter_system_state;
+
+/**
+ * @brief Type and region pairs, type in the high half.
+ */
+typedef struct placement_context {
+  u32 items[SCATTER_MAX_TYPES * SCATTER_REGION_COUNT];
+  u32 item_count;
+} placement_context;
+
+static scatter_system_state * state = nullptr;
+
+static void place_items(u32 begin, u32 end, void* data);
+static void build_items(u32 begin, u32 end, void* data);
+static void place_region(scatter_type_data* type, u32 type_index, u32 region);
+static void build_region(scatter_type_data* type, u32 region);
+static bool fits(const scatter_type_data* type, i32 cx, i32 cz, f32 x, f32 z);
+static void cell_range(const scatter_type_data* type, u32 region_coord, u32* begin, u32* end);
+static void upload(scatter_type_data* type, u32 first, u32 count);
+static u64 mix_seed(u64 value);
+static f32 elapsed_ms(u64 begin_ns);
+
+bool scatter_system_initialize(Vector2 origin, f32 size, u64 seed) {
+  if ((state and state != nullptr) or size <= 0.f) {
+    return false;
+  }
+  state = (scatter_system_state*)allocate_memory_linear(sizeof(scatter_system_state), true, MEMORY_TAG_GAME);
+  state->origin = origin;
+  state->size = size;
+  state->region_size = size / (f32)SCATTER_REGIONS_PER_SIDE;
+  state->seed = seed;
+  state->stats.area_km2 = size * size / 1000000.f;
+  return true;
+}
+
+void scatter_system_shutdown(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  for (u32 i = 0; i < state->type_count; ++i) {
+    scatter_type_data& type = state->types[i];
+    free_memory(type.cell_x);
+    free_memory(type.cell_y);
+    free_memory(type.cell_z);
+    free_memory(type.cell_bits);
+    if (type.transforms) free_memory(type.transforms);
+    if (type.buffer > 0) rlUnloadVertexBuffer(type.buffer);
+    if (type.mesh.vaoId > 0) UnloadMesh(type.mesh);
+  }
+  state = nullptr;
+}
+
+scatter_type scatter_add_type(Mesh mesh, Color color, scatter_rule rule) {
+  if (not state or state == nullptr or state->type_count >= SCATTER_MAX_TYPES) {
+    return INVALID_IDU32;
+  }
+  // Regions placed at the same time have one region between them, and a region can be as narrow as
+  // cells_per_side / SCATTER_REGIONS_PER_SIDE cells. Up to half a region the neighbor range stays 2 cells and never
+  // reaches across the region in between
+  const f32 max_spacing = state->region_size * 0.5f;
+  if (rule.spacing > max_spacing) {
+    TRACELOG(LOG_WARNING, "SCATTER: Spacing %.2f is wider than half a region, clamped to %.2f", rule.spacing, max_spacing);
+    rule.spacing = max_spacing;
+  }
+  const scatter_type handle = state->type_count++;
+  scatter_type_data& type = state->types[handle];
+  type.mesh = mesh;
+  type.color = color;
+  type.rule = rule;
+  type.cells_per_side = (u32)ceilf(state->size / (rule.spacing / sqrtf(2.f)));
+  type.cell_size = state->size / (f32)type.cells_per_side;
+  type.neighbor_range = (i32)ceilf(rule.spacing / type.cell_size);
+
+  const u64 cell_count = (u64)type.cells_per_side * type.cells_per_side;
+  type.cell_x = (f32*)allocate_memory(sizeof(f32) * cell_count, false, MEMORY_TAG_GAME);
+  type.cell_y = (f32*)allocate_memory(sizeof(f32) * cell_count, false, MEMORY_TAG_GAME);
+  type.cell_z = (f32*)allocate_memory(sizeof(f32) * cell_count, false, MEMORY_TAG_GAME);
+  type.cell_bits = (u32*)allocate_memory(sizeof(u32) * cell_count, false, MEMORY_TAG_GAME);
+  for (u64 i = 0; i < cell_count; ++i) {
+    type.cell_x[i] = SCATTER_CELL_EMPTY;
+  }
+  for (bool& dirty : state->region_dirty) {
+    dirty = true;
+  }
+  state->dirty = true;
+  state->stats.type_count = state->type_count;
+  return handle;
+}
+
+void scatter_set_shader(Shader shader) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  state->shader = shader;
+  uniform_cache_initialize(&state->uniforms, shader);
+  if (GetShaderLocationAttrib(shader, "instanceTransform") != SCATTER_INSTANCE_LOCATION) {
+    TRACELOG(LOG_WARNING, "SCATTER: [SHDR ID %u] instanceTransform isn't at location %i", shader.id, SCATTER_INSTANCE_LOCATION);
+  }
+}
+
+void scatter_invalidate(Vector2 min, Vector2 max) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  const i32 last = SCATTER_REGIONS_PER_SIDE - 1;
+  const i32 x0 = (i32)Clamp(floorf((min.x - state->origin.x) / state->region_size), 0.f, (f32)last);
+  const i32 z0 = (i32)Clamp(floorf((min.y - state->origin.y) / state->region_size), 0.f, (f32)last);
+  const i32 x1 = (i32)Clamp(floorf((max.x - state->origin.x) / state->region_size), 0.f, (f32)last);
+  const i32 z1 = (i32)Clamp(floorf((max.y - state->origin.y) / state->region_size), 0.f, (f32)last);
+  for (i32 z = z0; z <= z1; ++z) {
+    for (i32 x = x0; x <= x1; ++x) {
+      const u32 region = (u32)(z * SCATTER_REGIONS_PER_SIDE + x);
+      state->region_generation[region]++;
+      state->region_dirty[region] = true;
+    }
+  }
+  state->dirty = true;
+}
+
+void scatter_update(void) {
+  if (not state or state == nullptr or not state->dirty) {
+    return;
+  }
+  PROFILE_SCOPE("scatter_update");
+  const u64 begin = profile_now_ns();
+  state->stats.regions_placed = 0;
+  state->stats.upload_count = 0;
+  state->stats.upload_bytes = 0;
+
+  // Regions of one phase are a region apart, none reads cells another one writes. The result doesn't depend
+  // on how the phase is split over threads
+  placement_context context = {};
+  for (u32 phase = 0; phase < 4; ++phase) {
+    context.item_count = 0;
+    for (u32 region = 0; region < SCATTER_REGION_COUNT; ++region) {
+      const u32 x = region % SCATTER_REGIONS_PER_SIDE;
+      const u32 z = region / SCATTER_REGIONS_PER_SIDE;
+      if (not state->region_dirty[region] or (x % 2) + (z % 2) * 2 != phase) {
+        continue;
+      }
+      for (u32 t = 0; t < state->type_count; ++t) {
+        context.items[context.item_count++] = (t << 16) | region;
+      }
+    }
+    job_parallel_for(context.item_count, 1, place_items, &context);
+  }
+
+  // Regions after the first placed one move when its count changed, their transforms are rewritten in place
+  u32 first_changed[SCATTER_MAX_TYPES];
+  bool shifted[SCATTER_MAX_TYPES];
+  context.item_count = 0;
+  for (u32 t = 0; t < state->type_count; ++t) {
+    scatter_type_data& type = state->types[t];
+    u32 offset = 0;
+    first_changed[t] = SCATTER_REGION_COUNT;
+    shifted[t] = false;
+    for (u32 region = 0; region < SCATTER_REGION_COUNT; ++region) {
+      shifted[t] |= first_changed[t] < region and type.region_offsets[region] != offset;
+      type.region_offsets[region] = offset;
+      offset += type.region_counts[region];
+      if (state->region_dirty[region] and first_changed[t] == SCATTER_REGION_COUNT) {
+        first_changed[t] = region;
+      }
+    }
+    shifted[t] |= offset != type.instance_count;
+    if (offset > type.transform_capacity) {
+      float16* transforms = (float16*)allocate_memory(sizeof(float16) * offset, false, MEMORY_TAG_GAME);
+      if (type.transforms) {
+        memcpy(transforms, type.transforms, sizeof(float16) * type.instance_count);
+        free_memory(type.transforms);
+      }
+      type.transforms = transforms;
+      type.transform_capacity = offset;
+    }
+    type.instance_count = offset;
+    for (u32 region = 0; region < SCATTER_REGION_COUNT; ++region) {
+      if (state->region_dirty[region] or (shifted[t] and region > first_changed[t])) {
+        context.items[context.item_count++] = (t << 16) | region;
+      }
+    }
+  }
+  job_parallel_for(context.item_count, 4, build_items, &context);
+
+  // A type whose regions kept their counts uploads just the placed ranges, otherwise everything after the first
+  u32 instance_count = 0;
+  for (u32 t = 0; t < state->type_count; ++t) {
+    scatter_type_data& type = state->types[t];
+    instance_count += type.instance_count;
+    if (type.mesh.vaoId == 0 or first_changed[t] == SCATTER_REGION_COUNT) {
+      continue;
+    }
+    if (shifted[t] or type.buffer == 0 or type.instance_count > type.buffer_capacity) {
+      const u32 first = type.region_offsets[first_changed[t]];
+      upload(&type, first, type.instance_count - first);
+      continue;
+    }
+    for (u32 region = first_changed[t]; region < SCATTER_REGION_COUNT; ++region) {
+      if (state->region_dirty[region] and type.region_counts[region] > 0) {
+        upload(&type, type.region_offsets[region], type.region_counts[region]);
+      }
+    }
+  }
+  for (u32 region = 0; region < SCATTER_REGION_COUNT; ++region) {
+    state->stats.regions_placed += state->region_dirty[region] ? 1 : 0;
+    state->region_dirty[region] = false;
+  }
+  state->dirty = false;
+  state->stats.instance_count = instance_count;
+  state->stats.placement_ms = elapsed_ms(begin);
+}
+
+void scatter_draw(void) {
+  if (not state or state == nullptr or state->shader.id == 0) {
+    return;
+  }
+  PROFILE_SCOPE("scatter_draw");
+  PROFILE_GPU_SCOPE("scatter");
+  // Instances carry their own model matrix, mvp is only the view projection
+  const Matrix view_projection = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+  state->stats.draw_count = 0;
+  for (u32 t = 0; t < state->type_count; ++t) {
+    const scatter_type_data& type = state->types[t];
+    if (type.buffer == 0 or type.instance_count == 0) {
+      continue;
+    }
+    const Vector4 color = ColorNormalize(type.color);
+    uniform_set(&state->uniforms, "colDiffuse", &color, SHADER_UNIFORM_VEC4);
+    rlEnableShader(state->shader.id);
+    rlSetUniformMatrix(state->shader.locs[SHADER_LOC_MATRIX_MVP], view_projection);
+    rlActiveTextureSlot(0);
+    rlEnableTexture(rlGetTextureIdDefault());
+    rlEnableVertexArray(type.mesh.vaoId);
+    if (type.mesh.indices) {
+      rlDrawVertexArrayElementsInstanced(0, type.mesh.triangleCount * 3, nullptr, (i32)type.instance_count);
+    } else {
+      rlDrawVertexArrayInstanced(0, type.mesh.vertexCount, (i32)type.instance_count);
+    }
+    rlDisableVertexArray();
+    rlDisableTexture();
+    rlDisableShader();
+    state->stats.draw_count++;
+  }
+}
+
+const float16* scatter_get_transforms(scatter_type type, u32* count) {
+  if (not state or state == nullptr or type >= state->type_count) {
+    *count = 0;
+    return nullptr;
+  }
+  *count = state->types[type].instance_count;
+  return state->types[type].transforms;
+}
+
+scatter_stats scatter_get_stats(void) {
+  if (not state or state == nullptr) {
+    return scatter_stats {};
+  }
+  return state->stats;
+}
+
+static void place_items(u32 begin, u32 end, void* data) {
+  PROFILE_SCOPE("scatter_place");
+  const placement_context* context = (const placement_context*)data;
+  for (u32 i = begin; i < end; ++i) {
+    const u32 t = context->items[i] >> 16;
+    place_region(&state->types[t], t, context->items[i] & 0xFFFF);
+  }
+}
+
+static void build_items(u32 begin, u32 end, void* data) {
+  const placement_context* context = (const placement_context*)data;
+  for (u32 i = begin; i < end; ++i) {
+    build_region(&state->types[context->items[i] >> 16], context->items[i] & 0xFFFF);
+  }
+}
+
+// Dart throwing over the region's cells, a few candidates per cell. The rules are checked once at the cell's center,
+// the ground barely changes within a cell and the candidates then only test their distance
+static void place_region(scatter_type_data* type, u32 type_index, u32 region) {
+  const scatter_rule& rule = type->rule;
+  const u32 n = type->cells_per_side;
+  u32 x0, x1, z0, z1;
+  cell_range(type, region % SCATTER_REGIONS_PER_SIDE, &x0, &x1);
+  cell_range(type, region / SCATTER_REGIONS_PER_SIDE, &z0, &z1);
+  for (u32 cz = z0; cz < z1; ++cz) {
+    for (u32 cx = x0; cx < x1; ++cx) {
+      type->cell_x[cz * n + cx] = SCATTER_CELL_EMPTY;
+    }
+  }
+
+  random_state rng = {};
+  random_seed(&rng, mix_seed(state->seed ^ mix_seed(((u64)type_index << 48) | ((u64)region << 32) | state->region_generation[region])));
+  const f32 step = type->cell_size * 0.5f;
+  u32 count = 0;
+  for (u32 cz = z0; cz < z1; ++cz) {
+    for (u32 cx = x0; cx < x1; ++cx) {
+      if (random_next_f32(&rng) >= rule.density) {
+        continue;
+      }
+      const f32 center_x = state->origin.x + ((f32)cx + 0.5f) * type->cell_size;
+      const f32 center_z = state->origin.y + ((f32)cz + 0.5f) * type->cell_size;
+      const f32 center_height = terrain_get_height(center_x, center_z);
+      if (center_height < rule.min_height or center_height > rule.max_height) {
+        continue;
+      }
+      const f32 dx = terrain_get_height(center_x + step, center_z) - terrain_get_height(center_x - step, center_z);
+      const f32 dz = terrain_get_height(center_x, center_z + step) - terrain_get_height(center_x, center_z - step);
+      const f32 slope = sqrtf(dx * dx + dz * dz) / (2.f * step);
+      if (slope < rule.min_slope or slope > rule.max_slope) {
+        continue;
+      }
+      for (u32 attempt = 0; attempt < SCATTER_CELL_ATTEMPTS; ++attempt) {
+        const f32 x = ((f32)cx + random_next_f32(&rng)) * type->cell_size;
+        const f32 z = ((f32)cz + random_next_f32(&rng)) * type->cell_size;
+        if (not fits(type, (i32)cx, (i32)cz, x, z)) {
+          continue;
+        }
+        const u32 cell = cz * n + cx;
+        type->cell_x[cell] = x;
+        type->cell_y[cell] = terrain_get_height(state->origin.x + x, state->origin.y + z);
+        type->cell_z[cell] = z;
+        type->cell_bits[cell] = random_next_u32(&rng);
+        count++;
+        break;
+      }
+    }
+  }
+  type->region_counts[region] = count;
+}
+
+// Low 16 bits pick the scale, the next 8 the yaw and the top 8 the tilt
+static void build_region(scatter_type_data* type, u32 region) {
+  const scatter_rule& rule = type->rule;
+  const u32 n = type->cells_per_side;
+  u32 x0, x1, z0, z1;
+  cell_range(type, region % SCATTER_REGIONS_PER_SIDE, &x0, &x1);
+  cell_range(type, region / SCATTER_REGIONS_PER_SIDE, &z0, &z1);
+  float16* out = type->transforms + type->region_offsets[region];
+  for (u32 cz = z0; cz < z1; ++cz) {
+    for (u32 cx = x0; cx < x1; ++cx) {
+      const u32 cell = cz * n + cx;
+      if (type->cell_x[cell] == SCATTER_CELL_EMPTY) {
+        continue;
+      }
+      const u32 bits = type->cell_bits[cell];
+      const f32 scale = Lerp(rule.min_scale, rule.max_scale, (f32)(bits & 0xFFFF) / 65535.f);
+      const f32 yaw = (f32)((bits >> 16) & 0xFF) / 256.f * 2.f * PI;
+      const f32 tilt = (f32)(bits >> 24) / 255.f * rule.max_tilt;
+      const Matrix orientation = MatrixMultiply(MatrixRotateX(tilt), MatrixRotateY(yaw));
+      *out++ = MatrixToFloatV(MatrixMultiply(MatrixMultiply(MatrixScale(scale, scale, scale), orientation), MatrixTranslate(state->origin.x + type->cell_x[cell],
+        type->cell_y[cell] - rule.sink * scale, state->origin.y + type->cell_z[cell])));
+    }
+  }
+}
+
+static bool fits(const scatter_type_data* type, i32 cx, i32 cz, f32 x, f32 z) {
+  const i32 n = (i32)type->cells_per_side;
+  const i32 range = type->neighbor_range;
+  const f32 spacing_sq = type->rule.spacing * type->rule.spacing;
+  for (i32 nz = FMAX(cz - range, 0); nz <= (FMIN(cz + range, n - 1)); ++nz) {
+    for (i32 nx = FMAX(cx - range, 0); nx <= (FMIN(cx + range, n - 1)); ++nx) {
+      const u32 cell = (u32)(nz * n + nx);
+      if (type->cell_x[cell] == SCATTER_CELL_EMPTY) {
+        continue;
+      }
+      const f32 dx = type->cell_x[cell] - x;
+      const f32 dz = type->cell_z[cell] - z;
+      if (dx * dx + dz * dz < spacing_sq) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static void cell_range(const scatter_type_data* type, u32 region_coord, u32* begin, u32* end) {
+  *begin = region_coord * type->cells_per_side / SCATTER_REGIONS_PER_SIDE;
+  *end = (region_coord + 1) * type->cells_per_side / SCATTER_REGIONS_PER_SIDE;
+}
+
+// The buffer lives in the mesh's vertex array, so drawing binds nothing but the array. It's only created again
+// when the type outgrows it
+static void upload(scatter_type_data* type, u32 first, u32 count) {
+  if (type->buffer == 0 or type->instance_count > type->buffer_capacity) {
+    if (not gl_ext_load()) {
+      return;
+    }
+    if (type->buffer > 0) {
+      rlUnloadVertexBuffer(type->buffer);
+    }
+    type->buffer_capacity = type->instance_count + type->instance_count / 4;
+    rlEnableVertexArray(type->mesh.vaoId);
+    type->buffer = rlLoadVertexBuffer(nullptr, (i32)(sizeof(float16) * type->buffer_capacity), true);
+    // rlSetVertexAttribute() changed its offset parameter between raylib releases
+    for (u32 column = 0; column < 4; ++column) {
+      rlEnableVertexAttribute(SCATTER_INSTANCE_LOCATION + column);
+      gl_ext.vertex_attrib_pointer(SCATTER_INSTANCE_LOCATION + column, 4, RL_FLOAT, 0, sizeof(float16), (const void*)(sizeof(Vector4) * column));
+      rlSetVertexAttributeDivisor(SCATTER_INSTANCE_LOCATION + column, 1);
+    }
+    rlDisableVertexArray();
+    rlDisableVertexBuffer();
+    first = 0;
+    count = type->instance_count;
+  }
+  if (count == 0) {
+    return;
+  }
+  rlUpdateVertexBuffer(type->buffer, type->transforms + first, (i32)(sizeof(float16) * count), (i32)(sizeof(float16) * first));
+  state->stats.upload_count++;
+  state->stats.upload_bytes += sizeof(float16) * count;
+}
+
+// splitmix64 finalizer, neighbouring regions and generations get unrelated streams
+static u64 mix_seed(u64 value) {
+  value += 0x9E3779B97F4A7C15ull;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+  return value ^ (value >> 31);
+}
+
+static f32 elapsed_ms(u64 begin_ns) {
+  return (f32)((f64)(profile_now_ns() - begin_ns) / 1000000.0);
+}
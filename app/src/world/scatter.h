@@ -0,0 +1,92 @@
+#ifndef SCATTER_H
+#define SCATTER_H
+
+#include "defines.h"
+#include "raylib.h"
+#include "raymath.h"
+
+#define SCATTER_MAX_TYPES 8
+#define SCATTER_REGIONS_PER_SIDE 8
+#define SCATTER_REGION_COUNT (SCATTER_REGIONS_PER_SIDE * SCATTER_REGIONS_PER_SIDE)
+#define SCATTER_CELL_ATTEMPTS 8       // Candidates thrown into a grid cell before it's left empty
+#define SCATTER_INSTANCE_LOCATION 12  // First of the four attribute slots instanceTransform takes in map_objects.vs
+
+typedef u32 scatter_type;
+
+/**
+ * @brief Where a type grows. Heights are in world units, slopes are rise over run of the ground.
+ */
+typedef struct scatter_rule {
+  f32 spacing;       // Poisson-disk radius, no two instances of the type come closer
+  f32 density;       // Share of the grid cells that try to take an instance, thins the disk set
+  f32 min_height;
+  f32 max_height;
+  f32 min_slope;
+  f32 max_slope;
+  f32 min_scale;
+  f32 max_scale;
+  f32 max_tilt;      // Radians the instance leans away from up at most
+  f32 sink;          // Part of the scale the instance is pushed into the ground
+} scatter_rule;
+
+typedef struct scatter_stats {
+  u32 type_count;
+  u32 instance_count;
+  u32 draw_count;       // Instanced draws of the last scatter_draw(), one per type
+  u32 regions_placed;   // By the last placement
+  u32 upload_count;     // Buffer ranges the last placement uploaded
+  u64 upload_bytes;
+  f32 placement_ms;
+  f32 area_km2;         // World units taken as meters
+} scatter_stats;
+
+/**
+ * @brief Scatters over the square [origin, origin + size] in xz, heights come from terrain_get_height().
+ * Doesn't need a GL context until an uploaded mesh is added.
+ */
+[[__nodiscard__]] bool scatter_system_initialize(Vector2 origin, f32 size, u64 seed);
+void scatter_system_shutdown(void);
+
+/**
+ * @brief The scatter owns mesh from here on. A mesh that isn't uploaded is placed but never drawn, so placement
+ * runs headless. Every region is placed again in the next scatter_update().
+ * @return INVALID_IDU32 once SCATTER_MAX_TYPES are in
+ */
+scatter_type scatter_add_type(Mesh mesh, Color color, scatter_rule rule);
+
+/**
+ * @brief Every type draws with this program, instanceTransform has to sit at SCATTER_INSTANCE_LOCATION.
+ */
+void scatter_set_shader(Shader shader);
+
+/**
+ * @brief Regions touching the xz rectangle draw new samples in the next scatter_update().
+ */
+void scatter_invalidate(Vector2 min, Vector2 max);
+
+/**
+ * @brief Main thread. Places the invalidated regions on the job system and uploads the instance ranges
+ * that changed. Does nothing while no region is invalid.
+ */
+void scatter_update(void);
+
+/**
+ * @brief Between BeginMode3D() and EndMode3D(), one instanced draw per type.
+ */
+void scatter_draw(void);
+
+/**
+ * @brief World transforms of a type in region order, column major as MatrixToFloatV() writes them. Valid until
+ * the next scatter_update().
+ */
+const float16* scatter_get_transforms(scatter_type type, u32* count);
+
+scatter_stats scatter_get_stats(void);
+
+/**
+ * @brief Places the rules over the terrain headless, which has to be initialized. Times a full placement,
+ * checks a second one with the same seed matches it and times invalidating a single region. Results are logged.
+ */
+void scatter_run_benchmark(Vector2 origin, f32 size, const scatter_rule* rules, u32 rule_count);
+
+#endif
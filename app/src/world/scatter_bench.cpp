@@ -0,0 +1,126 @@
+#include "scatter.h"
+
+#include <math.h>   // Required for: fabsf()
+#include <string.h> // Required for: memcmp()
+
+#include "core/fjob.h"
+#include "core/fmemory.h"
+#include "world/terrain.h"
+
+#define SCATTER_BENCH_SEED 0x5CA7ull
+#define SCATTER_BENCH_RUNS 4
+#define SCATTER_BENCH_INVALIDATIONS 16
+
+// Copies every type's transforms so a later placement can be compared against them
+static float16* snapshot(u32 rule_count, u32* total) {
+  *total = 0;
+  for (u32 t = 0; t < rule_count; ++t) {
+    u32 count = 0;
+    scatter_get_transforms(t, &count);
+    *total += count;
+  }
+  float16* copy = (float16*)allocate_memory(sizeof(float16) * (*total + 1), false, MEMORY_TAG_GAME);
+  u32 offset = 0;
+  for (u32 t = 0; t < rule_count; ++t) {
+    u32 count = 0;
+    const float16* transforms = scatter_get_transforms(t, &count);
+    if (count > 0) memcpy(copy + offset, transforms, sizeof(float16) * count);
+    offset += count;
+  }
+  return copy;
+}
+
+// The translation has to sit in the last column, on the ground the instance was placed on. A transposed
+// layout leaves it in the bottom row, where the vertex shader would read it as w
+static u32 count_misplaced(Vector2 origin, f32 size, const scatter_rule* rules, u32 rule_count) {
+  u32 misplaced = 0;
+  for (u32 t = 0; t < rule_count; ++t) {
+    u32 count = 0;
+    const float16* transforms = scatter_get_transforms(t, &count);
+    const f32 max_sink = rules[t].sink * rules[t].max_scale + 0.001f;
+    for (u32 i = 0; i < count; ++i) {
+      const f32* m = transforms[i].v;
+      const bool inside = m[12] >= origin.x and m[12] <= origin.x + size and m[14] >= origin.y and m[14] <= origin.y + size;
+      const bool affine = m[3] == 0.f and m[7] == 0.f and m[11] == 0.f and m[15] == 1.f;
+      misplaced += (not inside or not affine or fabsf(terrain_get_height(m[12], m[14]) - m[13]) > max_sink) ? 1 : 0;
+    }
+  }
+  return misplaced;
+}
+
+static bool initialize(Vector2 origin, f32 size, const scatter_rule* rules, u32 rule_count) {
+  if (not scatter_system_initialize(origin, size, SCATTER_BENCH_SEED)) {
+    return false;
+  }
+  // Meshes that aren't uploaded, placement only
+  for (u32 t = 0; t < rule_count; ++t) {
+    scatter_add_type(Mesh {}, WHITE, rules[t]);
+  }
+  return true;
+}
+
+void scatter_run_benchmark(Vector2 origin, f32 size, const scatter_rule* rules, u32 rule_count) {
+  if (not initialize(origin, size, rules, rule_count)) {
+    TRACELOG(LOG_ERROR, "SCATTER: Benchmark can not initialize the scatter");
+    return;
+  }
+  scatter_update();
+  const scatter_stats first = scatter_get_stats();
+  u32 reference_count = 0;
+  float16* reference = snapshot(rule_count, &reference_count);
+  const u32 misplaced = count_misplaced(origin, size, rules, rule_count);
+  for (u32 t = 0; t < rule_count; ++t) {
+    u32 count = 0;
+    scatter_get_transforms(t, &count);
+    TRACELOG(LOG_INFO, "SCATTER:   type %u: %u instances, spacing %.2f", t, count, rules[t].spacing);
+  }
+  scatter_system_shutdown();
+
+  // Same seed, same layout however the phases were split over the workers
+  f32 total_ms = 0.f;
+  f32 best_ms = F32_MAX;
+  u32 mismatches = 0;
+  for (u32 run = 0; run < SCATTER_BENCH_RUNS; ++run) {
+    if (not initialize(origin, size, rules, rule_count)) {
+      break;
+    }
+    scatter_update();
+    const f32 ms = scatter_get_stats().placement_ms;
+    total_ms += ms;
+    best_ms = FMIN(best_ms, ms);
+    u32 count = 0;
+    float16* transforms = snapshot(rule_count, &count);
+    mismatches += (count != reference_count or memcmp(transforms, reference, sizeof(float16) * count) != 0) ? 1 : 0;
+    free_memory(transforms);
+    if (run + 1 < SCATTER_BENCH_RUNS) {
+      scatter_system_shutdown();
+    }
+  }
+
+  // One region at a time along the diagonal, its neighbours stay where they are
+  f32 invalidate_ms = 0.f;
+  const f32 region_size = size / (f32)SCATTER_REGIONS_PER_SIDE;
+  for (u32 i = 0; i < SCATTER_BENCH_INVALIDATIONS; ++i) {
+    const f32 offset = ((f32)(i % SCATTER_REGIONS_PER_SIDE) + 0.5f) * region_size;
+    const Vector2 point = Vector2 { origin.x + offset, origin.y + offset };
+    scatter_invalidate(point, point);
+    scatter_update();
+    invalidate_ms += scatter_get_stats().placement_ms;
+  }
+  const scatter_stats last = scatter_get_stats();
+  scatter_system_shutdown();
+  free_memory(reference);
+
+  if (misplaced > 0) {
+    TRACELOG(LOG_ERROR, "SCATTER: %u of %u transforms aren't column major on the ground they were placed on", misplaced, reference_count);
+  }
+  if (mismatches > 0) {
+    TRACELOG(LOG_ERROR, "SCATTER: %u of %u placements differ from the first one with the same seed", mismatches, SCATTER_BENCH_RUNS);
+  }
+  const f32 mean_ms = total_ms / SCATTER_BENCH_RUNS;
+  TRACELOG(LOG_INFO, "SCATTER: %u instances of %u types over %.4f km2, %u regions, %u threads", first.instance_count, rule_count,
+    first.area_km2, first.regions_placed, job_thread_count());
+  TRACELOG(LOG_INFO, "SCATTER:   place  %8.2f ms mean, %.2f ms best, %.1f ms per km2", mean_ms, best_ms, mean_ms / first.area_km2);
+  TRACELOG(LOG_INFO, "SCATTER:   region %8.3f ms mean to place one again, %u instances after %u", invalidate_ms / SCATTER_BENCH_INVALIDATIONS,
+    last.instance_count, SCATTER_BENCH_INVALIDATIONS);
+}
@@ -0,0 +1,603 @@
+#include "scene.h"
+
+#include <bit>      // Required for: std::countl_zero()
+#include <math.h>   // Required for: fabsf(), fmaxf()
+#include <stdlib.h> // Required for: qsort()
+
+#include "raymath.h"
+#include "rlgl.h"
+
+#include "core/fmath.h"
+#include "core/fmemory.h"
+#include "core/fprofile.h"
+#include "render/gpu_timer.h"
+
+typedef struct scene_model_data {
+  Model model;
+  BoundingBox bounds;
+  u32 rank;  // Position in the shader and material order
+} scene_model_data;
+
+/**
+ * @brief Children are allocated in pairs after their parent, so a reverse walk over the nodes visits children first.
+ */
+typedef struct scene_node {
+  Vector3 min;
+  u32 first;   // The subtree's items are [first, first + count)
+  Vector3 max;
+  u32 count;
+  u32 left;    // Right child is left + 1, 0 for leaves
+  u32 parent;  // INVALID_IDU32 for the root
+} scene_node;
+
+typedef struct scene_system_state {
+  u32 capacity;
+  scene_model_data models[SCENE_MAX_MODELS];
+  u32 model_count;
+  u32 model_order[SCENE_MAX_MODELS];  // Model of every rank
+
+  // Per instance handle
+  u32* instance_model;       // INVALID_IDU32 for free slots
+  Matrix* instance_transform; // Model transform included
+  u32* instance_item;        // INVALID_IDU32 until the next rebuild
+  u32* free_slots;
+  u32 free_count;
+  u32 slot_count;            // Slots handed out so far
+  u32 instance_count;
+
+  // Per item, in BVH order. Bounds are six streams, min xyz then max xyz, for the batch frustum test
+  u32* item_instance;
+  u32* item_leaf;
+  f32* item_bounds[6];
+  u32 item_count;
+  u32* sort_buffer;          // Morton codes and instances, twice over for the radix passes
+
+  scene_node* nodes;
+  u8* node_dirty;
+  u32 node_capacity;
+  u32 node_count;
+  f32 built_area;
+  bool needs_rebuild;
+  u32 moved_count;
+
+  u32* visible;       // Traversal order
+  u32* sorted;        // By model rank
+  u32 visible_count;
+
+  scene_stats stats;
+} scene_system_state;
+
+static scene_system_state * state = nullptr;
+
+static void world_bounds(BoundingBox local, Matrix transform, Vector3* min, Vector3* max);
+static void write_item_bounds(u32 item, u32 instance);
+static void fit_node(scene_node* node);
+static f32 surface_area(Vector3 min, Vector3 max);
+static void rebuild(void);
+static void refit(void);
+static void sort_items(void);
+static u32 find_split(const u32* codes, u32 first, u32 count);
+static u32 expand_bits(u32 value);
+static u32 classify(const frustum* fr, const scene_node* node, u32 planes);
+static void traverse(const frustum* fr);
+static void sort_visible(void);
+static void rank_models(void);
+static i32 compare_models(const void* a, const void* b);
+static f32 elapsed_ms(u64 begin_ns);
+
+bool scene_system_initialize(u32 max_instances) {
+  if ((state and state != nullptr) or max_instances == 0) {
+    return false;
+  }
+  state = (scene_system_state*)allocate_memory_linear(sizeof(scene_system_state), true, MEMORY_TAG_GAME);
+  state->capacity = max_instances;
+  // Leaves split in halves hold at least SCENE_BVH_LEAF_SIZE / 2 items, so there are fewer nodes than half the items
+  state->node_capacity = max_instances / 2 + 2;
+
+  state->instance_model = (u32*)allocate_memory(sizeof(u32) * max_instances, false, MEMORY_TAG_GAME);
+  state->instance_transform = (Matrix*)allocate_memory(sizeof(Matrix) * max_instances, false, MEMORY_TAG_GAME);
+  state->instance_item = (u32*)allocate_memory(sizeof(u32) * max_instances, false, MEMORY_TAG_GAME);
+  state->free_slots = (u32*)allocate_memory(sizeof(u32) * max_instances, false, MEMORY_TAG_GAME);
+  state->item_instance = (u32*)allocate_memory(sizeof(u32) * max_instances, false, MEMORY_TAG_GAME);
+  state->item_leaf = (u32*)allocate_memory(sizeof(u32) * max_instances, false, MEMORY_TAG_GAME);
+  state->sort_buffer = (u32*)allocate_memory(sizeof(u32) * max_instances * 4, false, MEMORY_TAG_GAME);
+  for (f32*& stream : state->item_bounds) {
+    stream = (f32*)allocate_memory(sizeof(f32) * max_instances, false, MEMORY_TAG_GAME);
+  }
+  state->nodes = (scene_node*)allocate_memory(sizeof(scene_node) * state->node_capacity, false, MEMORY_TAG_GAME);
+  state->node_dirty = (u8*)allocate_memory(state->node_capacity, true, MEMORY_TAG_GAME);
+  state->visible = (u32*)allocate_memory(sizeof(u32) * max_instances, false, MEMORY_TAG_GAME);
+  state->sorted = (u32*)allocate_memory(sizeof(u32) * max_instances, false, MEMORY_TAG_GAME);
+  return true;
+}
+
+void scene_system_shutdown(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  free_memory(state->instance_model);
+  free_memory(state->instance_transform);
+  free_memory(state->instance_item);
+  free_memory(state->free_slots);
+  free_memory(state->item_instance);
+  free_memory(state->item_leaf);
+  free_memory(state->sort_buffer);
+  for (f32* stream : state->item_bounds) {
+    free_memory(stream);
+  }
+  free_memory(state->nodes);
+  free_memory(state->node_dirty);
+  free_memory(state->visible);
+  free_memory(state->sorted);
+  state = nullptr;
+}
+
+scene_model scene_add_model(Model model, const BoundingBox* bounds) {
+  if (not state or state == nullptr or state->model_count >= SCENE_MAX_MODELS) {
+    return INVALID_IDU32;
+  }
+  const scene_model handle = state->model_count++;
+  state->models[handle].model = model;
+  state->models[handle].bounds = bounds ? *bounds : GetModelBoundingBox(model);
+  rank_models();
+  return handle;
+}
+
+scene_instance scene_add_instance(scene_model model, Matrix transform) {
+  if (not state or state == nullptr or model >= state->model_count or state->instance_count >= state->capacity) {
+    return INVALID_IDU32;
+  }
+  const scene_instance instance = (state->free_count > 0) ? state->free_slots[--state->free_count] : state->slot_count++;
+  state->instance_model[instance] = model;
+  state->instance_transform[instance] = MatrixMultiply(state->models[model].model.transform, transform);
+  state->instance_item[instance] = INVALID_IDU32;
+  state->instance_count++;
+  state->needs_rebuild = true;
+  return instance;
+}
+
+void scene_remove_instance(scene_instance instance) {
+  if (not state or state == nullptr or instance >= state->slot_count or state->instance_model[instance] == INVALID_IDU32) {
+    return;
+  }
+  state->instance_model[instance] = INVALID_IDU32;
+  state->instance_item[instance] = INVALID_IDU32;
+  state->free_slots[state->free_count++] = instance;
+  state->instance_count--;
+  state->needs_rebuild = true;
+}
+
+void scene_set_transform(scene_instance instance, Matrix transform) {
+  if (not state or state == nullptr or instance >= state->slot_count or state->instance_model[instance] == INVALID_IDU32) {
+    return;
+  }
+  state->instance_transform[instance] = MatrixMultiply(state->models[state->instance_model[instance]].model.transform, transform);
+  const u32 item = state->instance_item[instance];
+  if (state->needs_rebuild or item == INVALID_IDU32) {
+    return;
+  }
+  write_item_bounds(item, instance);
+  for (u32 node = state->item_leaf[item]; node != INVALID_IDU32 and not state->node_dirty[node]; node = state->nodes[node].parent) {
+    state->node_dirty[node] = 1;
+  }
+  state->moved_count++;
+}
+
+void scene_clear(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  state->model_count = 0;
+  state->free_count = 0;
+  state->slot_count = 0;
+  state->instance_count = 0;
+  state->item_count = 0;
+  state->node_count = 0;
+  state->visible_count = 0;
+  state->moved_count = 0;
+  state->needs_rebuild = false;
+}
+
+void scene_cull(Camera3D camera, f32 aspect) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  PROFILE_SCOPE("scene_cull");
+  scene_stats& stats = state->stats;
+  stats.moved_count = state->moved_count;
+  stats.refit_ms = 0.f;
+  if (state->needs_rebuild) {
+    rebuild();
+  } else if (state->moved_count > 0) {
+    const u64 refit_begin = profile_now_ns();
+    refit();
+    stats.refit_ms = elapsed_ms(refit_begin);
+    // Refits keep the tree valid but not tight, once movers have stretched it far enough it's cheaper to start over
+    if (state->node_count > 0 and surface_area(state->nodes[0].min, state->nodes[0].max) > state->built_area * SCENE_REBUILD_GROWTH) {
+      rebuild();
+    }
+  }
+  state->moved_count = 0;
+
+  const u64 cull_begin = profile_now_ns();
+  const frustum fr = frustum_from_camera(camera, aspect, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+  state->visible_count = 0;
+  stats.nodes_visited = 0;
+  stats.leaves_tested = 0;
+  if (state->node_count > 0) {
+    traverse(&fr);
+  }
+  stats.cull_ms = elapsed_ms(cull_begin);
+
+  const u64 sort_begin = profile_now_ns();
+  sort_visible();
+  stats.sort_ms = elapsed_ms(sort_begin);
+  stats.visible_count = state->visible_count;
+}
+
+void scene_draw(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  scene_stats& stats = state->stats;
+  stats.draw_count = 0;
+  stats.shader_changes = 0;
+  stats.material_changes = 0;
+  if (state->visible_count == 0) {
+    return;
+  }
+  PROFILE_SCOPE("scene_draw");
+  PROFILE_GPU_SCOPE("scene");
+  u32 last_shader = INVALID_IDU32;
+  u32 last_texture = INVALID_IDU32;
+  i32 last_color = 0;
+  for (u32 i = 0; i < state->visible_count; ++i) {
+    const scene_instance instance = state->sorted[i];
+    const Model& model = state->models[state->instance_model[instance]].model;
+    for (i32 m = 0; m < model.meshCount; ++m) {
+      const Material& material = model.materials[model.meshMaterial ? model.meshMaterial[m] : 0];
+      const MaterialMap& diffuse = material.maps[MATERIAL_MAP_DIFFUSE];
+      if (material.shader.id != last_shader) {
+        stats.shader_changes++;
+        last_shader = material.shader.id;
+      }
+      if (diffuse.texture.id != last_texture or ColorToInt(diffuse.color) != last_color) {
+        stats.material_changes++;
+        last_texture = diffuse.texture.id;
+        last_color = ColorToInt(diffuse.color);
+      }
+      DrawMesh(model.meshes[m], material, state->instance_transform[instance]);
+      stats.draw_count++;
+    }
+  }
+}
+
+scene_stats scene_get_stats(void) {
+  if (not state or state == nullptr) {
+    return scene_stats {};
+  }
+  state->stats.model_count = state->model_count;
+  state->stats.instance_count = state->instance_count;
+  state->stats.node_count = state->node_count;
+  return state->stats;
+}
+
+// Arvo's method, the extents along each world axis are the absolute rotation and scale applied to the half size
+static void world_bounds(BoundingBox local, Matrix transform, Vector3* min, Vector3* max) {
+  const Vector3 center = Vector3Transform(Vector3Scale(Vector3Add(local.min, local.max), 0.5f), transform);
+  const Vector3 half = Vector3Scale(Vector3Subtract(local.max, local.min), 0.5f);
+  const Vector3 extent = Vector3 {
+    fabsf(transform.m0) * half.x + fabsf(transform.m4) * half.y + fabsf(transform.m8) * half.z,
+    fabsf(transform.m1) * half.x + fabsf(transform.m5) * half.y + fabsf(transform.m9) * half.z,
+    fabsf(transform.m2) * half.x + fabsf(transform.m6) * half.y + fabsf(transform.m10) * half.z,
+  };
+  *min = Vector3Subtract(center, extent);
+  *max = Vector3Add(center, extent);
+}
+
+static void write_item_bounds(u32 item, u32 instance) {
+  Vector3 min = {};
+  Vector3 max = {};
+  world_bounds(state->models[state->instance_model[instance]].bounds, state->instance_transform[instance], &min, &max);
+  state->item_bounds[0][item] = min.x;
+  state->item_bounds[1][item] = min.y;
+  state->item_bounds[2][item] = min.z;
+  state->item_bounds[3][item] = max.x;
+  state->item_bounds[4][item] = max.y;
+  state->item_bounds[5][item] = max.z;
+}
+
+static void fit_node(scene_node* node) {
+  if (node->left != 0) {
+    const scene_node& left = state->nodes[node->left];
+    const scene_node& right = state->nodes[node->left + 1];
+    node->min = Vector3Min(left.min, right.min);
+    node->max = Vector3Max(left.max, right.max);
+    return;
+  }
+  Vector3 min = Vector3 { F32_MAX, F32_MAX, F32_MAX };
+  Vector3 max = Vector3 { -F32_MAX, -F32_MAX, -F32_MAX };
+  for (u32 i = node->first; i < node->first + node->count; ++i) {
+    min = Vector3Min(min, Vector3 { state->item_bounds[0][i], state->item_bounds[1][i], state->item_bounds[2][i] });
+    max = Vector3Max(max, Vector3 { state->item_bounds[3][i], state->item_bounds[4][i], state->item_bounds[5][i] });
+  }
+  node->min = min;
+  node->max = max;
+}
+
+static f32 surface_area(Vector3 min, Vector3 max) {
+  const Vector3 size = Vector3Subtract(max, min);
+  return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+// Items are sorted along a Morton curve through their centers, then ranges split where the codes first differ
+static void rebuild(void) {
+  const u64 begin_ns = profile_now_ns();
+  sort_items();
+  const u32* codes = state->sort_buffer;
+  state->node_count = 0;
+  state->needs_rebuild = false;
+  if (state->item_count == 0) {
+    return;
+  }
+  for (u32 i = 0; i < state->item_count; ++i) {
+    write_item_bounds(i, state->item_instance[i]);
+    state->instance_item[state->item_instance[i]] = i;
+  }
+
+  state->nodes[0] = scene_node { .min = {}, .first = 0, .max = {}, .count = state->item_count, .left = 0, .parent = INVALID_IDU32 };
+  state->node_count = 1;
+  u32 stack[SCENE_BVH_MAX_DEPTH];
+  u32 stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size > 0) {
+    const u32 index = stack[--stack_size];
+    scene_node* node = &state->nodes[index];
+    if (node->count <= SCENE_BVH_LEAF_SIZE or stack_size + 2 > SCENE_BVH_MAX_DEPTH or state->node_count + 2 > state->node_capacity) {
+      for (u32 i = node->first; i < node->first + node->count; ++i) {
+        state->item_leaf[i] = index;
+      }
+      continue;
+    }
+    const u32 half = find_split(codes, node->first, node->count);
+    const u32 left = state->node_count;
+    state->node_count += 2;
+    node->left = left;
+    state->nodes[left] = scene_node { .min = {}, .first = node->first, .max = {}, .count = half, .left = 0, .parent = index };
+    state->nodes[left + 1] = scene_node { .min = {}, .first = node->first + half, .max = {}, .count = node->count - half, .left = 0, .parent = index };
+    stack[stack_size++] = left + 1;
+    stack[stack_size++] = left;
+  }
+
+  for (u32 i = state->node_count; i-- > 0; ) {
+    fit_node(&state->nodes[i]);
+    state->node_dirty[i] = 0;
+  }
+  state->built_area = surface_area(state->nodes[0].min, state->nodes[0].max);
+  state->stats.rebuild_ms = elapsed_ms(begin_ns);
+  state->stats.rebuild_count++;
+}
+
+static void refit(void) {
+  for (u32 i = state->node_count; i-- > 0; ) {
+    if (state->node_dirty[i]) {
+      fit_node(&state->nodes[i]);
+      state->node_dirty[i] = 0;
+    }
+  }
+}
+
+// Fills item_instance in Morton order of the instance centers, the sorted codes are left at the start of sort_buffer
+static void sort_items(void) {
+  u32* codes = state->sort_buffer;
+  u32* instances = state->sort_buffer + state->capacity;
+  Vector3 center_min = Vector3 { F32_MAX, F32_MAX, F32_MAX };
+  Vector3 center_max = Vector3 { -F32_MAX, -F32_MAX, -F32_MAX };
+  u32 count = 0;
+  for (u32 instance = 0; instance < state->slot_count; ++instance) {
+    if (state->instance_model[instance] == INVALID_IDU32) {
+      continue;
+    }
+    const BoundingBox& local = state->models[state->instance_model[instance]].bounds;
+    const Vector3 center = Vector3Transform(Vector3Scale(Vector3Add(local.min, local.max), 0.5f), state->instance_transform[instance]);
+    // The bounds streams hold the centers until the items are in order
+    state->item_bounds[0][count] = center.x;
+    state->item_bounds[1][count] = center.y;
+    state->item_bounds[2][count] = center.z;
+    center_min = Vector3Min(center_min, center);
+    center_max = Vector3Max(center_max, center);
+    instances[count++] = instance;
+  }
+  state->item_count = count;
+
+  // Cubic cells, a flat scene shouldn't spend as many splits on its height as on its width
+  const Vector3 extent = Vector3Subtract(center_max, center_min);
+  const f32 largest = fmaxf(fmaxf(extent.x, extent.y), extent.z);
+  const f32 scale = (largest > 0.f) ? 1023.f / largest : 0.f;
+  for (u32 i = 0; i < count; ++i) {
+    const u32 x = (u32)((state->item_bounds[0][i] - center_min.x) * scale);
+    const u32 y = (u32)((state->item_bounds[1][i] - center_min.y) * scale);
+    const u32 z = (u32)((state->item_bounds[2][i] - center_min.z) * scale);
+    codes[i] = (expand_bits(x) << 2) | (expand_bits(y) << 1) | expand_bits(z);
+  }
+
+  // 30 bit codes, four byte wide passes land back in the first half
+  u32* temp_codes = state->sort_buffer + state->capacity * 2;
+  u32* temp_instances = state->sort_buffer + state->capacity * 3;
+  for (u32 shift = 0; shift < 32; shift += 8) {
+    u32 offsets[257] = {};
+    for (u32 i = 0; i < count; ++i) {
+      offsets[((codes[i] >> shift) & 0xFFu) + 1]++;
+    }
+    for (u32 b = 0; b < 256; ++b) {
+      offsets[b + 1] += offsets[b];
+    }
+    for (u32 i = 0; i < count; ++i) {
+      const u32 slot = offsets[(codes[i] >> shift) & 0xFFu]++;
+      temp_codes[slot] = codes[i];
+      temp_instances[slot] = instances[i];
+    }
+    u32* swap = codes;
+    codes = temp_codes;
+    temp_codes = swap;
+    swap = instances;
+    instances = temp_instances;
+    temp_instances = swap;
+  }
+  copy_memory(state->item_instance, instances, sizeof(u32) * count);
+}
+
+// Size of the left half, where the highest bit that differs over the range flips. Falls back to the middle when
+// that would leave a side thinner than half a leaf, so leaves stay full enough for the node budget
+static u32 find_split(const u32* codes, u32 first, u32 count) {
+  const u32 half = count / 2;
+  const u32 first_code = codes[first];
+  const u32 last_code = codes[first + count - 1];
+  if (first_code == last_code) {
+    return half;
+  }
+  const i32 prefix = std::countl_zero(first_code ^ last_code);
+  u32 split = 0;
+  u32 step = count - 1;
+  do {
+    step = (step + 1) / 2;
+    const u32 candidate = split + step;
+    if (candidate < count - 1 and std::countl_zero(first_code ^ codes[first + candidate]) > prefix) {
+      split = candidate;
+    }
+  } while (step > 1);
+  const u32 left = split + 1;
+  const u32 thinnest = SCENE_BVH_LEAF_SIZE / 2;
+  return (left < thinnest or count - left < thinnest) ? half : left;
+}
+
+// Spreads the low 10 bits two zeros apart
+static u32 expand_bits(u32 value) {
+  value = (value > 1023u) ? 1023u : value;
+  value = (value * 0x00010001u) & 0xFF0000FFu;
+  value = (value * 0x00000101u) & 0x0F00F00Fu;
+  value = (value * 0x00000011u) & 0xC30C30C3u;
+  value = (value * 0x00000005u) & 0x49249249u;
+  return value;
+}
+
+// Bit p stays set while the box straddles plane p, U32_MAX once it's behind one of them
+static u32 classify(const frustum* fr, const scene_node* node, u32 planes) {
+  for (u32 p = 0; p < 6; ++p) {
+    if (not (planes & (1u << p))) {
+      continue;
+    }
+    const Vector4& pl = fr->planes[p];
+    const f32 far_distance = pl.x * ((pl.x >= 0.f) ? node->max.x : node->min.x) + pl.y * ((pl.y >= 0.f) ? node->max.y : node->min.y)
+      + pl.z * ((pl.z >= 0.f) ? node->max.z : node->min.z) + pl.w;
+    if (far_distance < 0.f) {
+      return U32_MAX;
+    }
+    const f32 near_distance = pl.x * ((pl.x >= 0.f) ? node->min.x : node->max.x) + pl.y * ((pl.y >= 0.f) ? node->min.y : node->max.y)
+      + pl.z * ((pl.z >= 0.f) ? node->min.z : node->max.z) + pl.w;
+    if (near_distance >= 0.f) {
+      planes &= ~(1u << p);
+    }
+  }
+  return planes;
+}
+
+// Subtrees inside every plane are taken whole, leaves straddling one go through the batch test
+static void traverse(const frustum* fr) {
+  u32 stack[SCENE_BVH_MAX_DEPTH * 2];
+  u32 stack_size = 0;
+  stack[stack_size++] = 0;
+  stack[stack_size++] = 0x3Fu;
+  while (stack_size > 0) {
+    const u32 parent_planes = stack[--stack_size];
+    const u32 index = stack[--stack_size];
+    const scene_node* node = &state->nodes[index];
+    state->stats.nodes_visited++;
+    const u32 planes = classify(fr, node, parent_planes);
+    if (planes == U32_MAX) {
+      continue;
+    }
+    if (planes == 0) {
+      for (u32 i = node->first; i < node->first + node->count; ++i) {
+        state->visible[state->visible_count++] = state->item_instance[i];
+      }
+      continue;
+    }
+    if (node->left == 0) {
+      u8 visible[SCENE_BVH_LEAF_SIZE];
+      const u32 first = node->first;
+      const vec3_soa min = vec3_soa { state->item_bounds[0] + first, state->item_bounds[1] + first, state->item_bounds[2] + first };
+      const vec3_soa max = vec3_soa { state->item_bounds[3] + first, state->item_bounds[4] + first, state->item_bounds[5] + first };
+      for (u32 tested = 0; tested < node->count; tested += SCENE_BVH_LEAF_SIZE) {
+        const u32 count = (node->count - tested < SCENE_BVH_LEAF_SIZE) ? node->count - tested : SCENE_BVH_LEAF_SIZE;
+        const vec3_soa part_min = vec3_soa { min.x + tested, min.y + tested, min.z + tested };
+        const vec3_soa part_max = vec3_soa { max.x + tested, max.y + tested, max.z + tested };
+        frustum_batch_intersects_aabb(fr, part_min, part_max, visible, count);
+        for (u32 i = 0; i < count; ++i) {
+          if (visible[i]) {
+            state->visible[state->visible_count++] = state->item_instance[first + tested + i];
+          }
+        }
+      }
+      state->stats.leaves_tested++;
+      continue;
+    }
+    stack[stack_size++] = node->left + 1;
+    stack[stack_size++] = planes;
+    stack[stack_size++] = node->left;
+    stack[stack_size++] = planes;
+  }
+}
+
+// Counting sort on the model rank, instances of a model keep their traversal order
+static void sort_visible(void) {
+  u32 offsets[SCENE_MAX_MODELS + 1] = {};
+  for (u32 i = 0; i < state->visible_count; ++i) {
+    offsets[state->models[state->instance_model[state->visible[i]]].rank + 1]++;
+  }
+  for (u32 r = 0; r < state->model_count; ++r) {
+    offsets[r + 1] += offsets[r];
+  }
+  for (u32 i = 0; i < state->visible_count; ++i) {
+    const scene_instance instance = state->visible[i];
+    state->sorted[offsets[state->models[state->instance_model[instance]].rank]++] = instance;
+  }
+}
+
+static void rank_models(void) {
+  for (u32 i = 0; i < state->model_count; ++i) {
+    state->model_order[i] = i;
+  }
+  qsort(state->model_order, state->model_count, sizeof(u32), compare_models);
+  for (u32 r = 0; r < state->model_count; ++r) {
+    state->models[state->model_order[r]].rank = r;
+  }
+}
+
+// Shader first, then the diffuse texture and color of the first material
+static i32 compare_models(const void* a, const void* b) {
+  const u32 left_index = *(const u32*)a;
+  const u32 right_index = *(const u32*)b;
+  const Model& left = state->models[left_index].model;
+  const Model& right = state->models[right_index].model;
+  const u32 left_shader = (left.materialCount > 0) ? left.materials[0].shader.id : 0;
+  const u32 right_shader = (right.materialCount > 0) ? right.materials[0].shader.id : 0;
+  if (left_shader != right_shader) {
+    return (left_shader < right_shader) ? -1 : 1;
+  }
+  const u32 left_texture = (left.materialCount > 0) ? left.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture.id : 0;
+  const u32 right_texture = (right.materialCount > 0) ? right.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture.id : 0;
+  if (left_texture != right_texture) {
+    return (left_texture < right_texture) ? -1 : 1;
+  }
+  const u32 left_color = (left.materialCount > 0) ? ColorToInt(left.materials[0].maps[MATERIAL_MAP_DIFFUSE].color) : 0;
+  const u32 right_color = (right.materialCount > 0) ? ColorToInt(right.materials[0].maps[MATERIAL_MAP_DIFFUSE].color) : 0;
+  if (left_color != right_color) {
+    return (left_color < right_color) ? -1 : 1;
+  }
+  return (left_index > right_index) - (left_index < right_index);
+}
+
+static f32 elapsed_ms(u64 begin_ns) {
+  return (f32)((f64)(profile_now_ns() - begin_ns) / 1000000.0);
+}
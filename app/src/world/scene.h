@@ -0,0 +1,78 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "defines.h"
+#include "raylib.h"
+
+#define SCENE_MAX_MODELS 256
+#define SCENE_BVH_LEAF_SIZE 8      // Instances per leaf at most, tested a SIMD register at a time
+#define SCENE_BVH_MAX_DEPTH 64
+#define SCENE_REBUILD_GROWTH 2.f   // Refits that grow the root's surface area past this times its built area rebuild
+
+typedef u32 scene_model;
+typedef u32 scene_instance;
+
+typedef struct scene_stats {
+  u32 model_count;
+  u32 instance_count;
+  u32 node_count;
+  u32 nodes_visited;
+  u32 leaves_tested;     // Leaves straddling the frustum, their instances went through the SIMD test
+  u32 visible_count;
+  u32 draw_count;        // Meshes drawn by the last scene_draw()
+  u32 shader_changes;
+  u32 material_changes;  // Diffuse texture or color changed between two draws
+  u32 moved_count;       // Instances refitted by the last scene_cull()
+  u32 rebuild_count;
+  f32 rebuild_ms;        // Last rebuild
+  f32 refit_ms;
+  f32 cull_ms;
+  f32 sort_ms;
+} scene_stats;
+
+/**
+ * @brief Instances live in a BVH over their world bounds. Doesn't need a GL context until scene_draw().
+ */
+[[__nodiscard__]] bool scene_system_initialize(u32 max_instances);
+void scene_system_shutdown(void);
+
+/**
+ * @brief The scene draws a copy of model, unloading it stays with the caller.
+ * @param bounds Optional local bounds, GetModelBoundingBox() when null
+ * @return INVALID_IDU32 once SCENE_MAX_MODELS are in
+ */
+scene_model scene_add_model(Model model, const BoundingBox* bounds);
+
+/**
+ * @brief Adding and removing rebuild the BVH in the next scene_cull(), moving only refits it.
+ * @return INVALID_IDU32 when the scene is full
+ */
+scene_instance scene_add_instance(scene_model model, Matrix transform);
+void scene_remove_instance(scene_instance instance);
+void scene_set_transform(scene_instance instance, Matrix transform);
+
+/**
+ * @brief Removes every instance and model.
+ */
+void scene_clear(void);
+
+/**
+ * @brief Refits or rebuilds the BVH, culls it against the camera frustum and orders the survivors by shader,
+ * material and model.
+ */
+void scene_cull(Camera3D camera, f32 aspect);
+
+/**
+ * @brief Between BeginMode3D() and EndMode3D(), draws what the last scene_cull() kept.
+ */
+void scene_draw(void);
+
+scene_stats scene_get_stats(void);
+
+/**
+ * @brief Culls a 100k instance scene headless along a camera loop, BVH against a flat SIMD pass over every
+ * instance, and times refits and rebuilds. Results are logged.
+ */
+void scene_run_benchmark(void);
+
+#endif
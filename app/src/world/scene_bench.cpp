@@ -0,0 +1,136 @@
+#include "scene.h"
+
+#include <chrono>
+#include <math.h> // Required for: cosf(), sinf()
+
+#include "raymath.h"
+#include "rlgl.h"
+
+#include "core/fmath.h"
+#include "core/fmemory.h"
+#include "core/frandom.h"
+
+#define SCENE_BENCH_INSTANCES 100000
+#define SCENE_BENCH_MODELS 4
+#define SCENE_BENCH_VIEWS 64
+#define SCENE_BENCH_MOVERS 1000
+#define SCENE_BENCH_REFITS 32
+#define SCENE_BENCH_WORLD_SIZE 100.f
+
+static f64 elapsed_ms(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Half the views look across the middle, the other half out of it, where most of the scene is behind the camera
+static Camera3D bench_camera(u32 view) {
+  const f32 angle = (f32)view / (f32)SCENE_BENCH_VIEWS * 2.f * PI;
+  const Vector3 center = Vector3 { SCENE_BENCH_WORLD_SIZE * 0.5f, 0.f, SCENE_BENCH_WORLD_SIZE * 0.5f };
+  const Vector3 offset = Vector3 { cosf(angle) * 40.f, 10.f, sinf(angle) * 40.f };
+  const Vector3 position = Vector3Add(center, offset);
+  const Vector3 target = (view % 2 == 0) ? center : Vector3Add(position, Vector3 { offset.x, -10.f, offset.z });
+  return Camera3D { position, target, Vector3 { 0.f, 1.f, 0.f }, 90.f, CAMERA_PERSPECTIVE };
+}
+
+void scene_run_benchmark(void) {
+  if (not scene_system_initialize(SCENE_BENCH_INSTANCES)) {
+    TRACELOG(LOG_ERROR, "SCENE: Benchmark can not initialize the scene");
+    return;
+  }
+  // Models without meshes, culling only needs their bounds
+  const BoundingBox unit = BoundingBox { Vector3 { -0.5f, -0.5f, -0.5f }, Vector3 { 0.5f, 0.5f, 0.5f } };
+  for (u32 i = 0; i < SCENE_BENCH_MODELS; ++i) {
+    Model model = {};
+    model.transform = MatrixIdentity();
+    scene_add_model(model, &unit);
+  }
+
+  // The same boxes as flat streams, for the pass over every instance
+  f32* streams[6];
+  for (f32*& stream : streams) {
+    stream = (f32*)allocate_memory(sizeof(f32) * SCENE_BENCH_INSTANCES, false, MEMORY_TAG_GAME);
+  }
+  u8* visible = (u8*)allocate_memory(SCENE_BENCH_INSTANCES, false, MEMORY_TAG_GAME);
+  Vector3* positions = (Vector3*)allocate_memory(sizeof(Vector3) * SCENE_BENCH_INSTANCES, false, MEMORY_TAG_GAME);
+  f32* scales = (f32*)allocate_memory(sizeof(f32) * SCENE_BENCH_INSTANCES, false, MEMORY_TAG_GAME);
+  random_state rng = {};
+  random_seed(&rng, 0x5CE7Eull);
+  for (u32 i = 0; i < SCENE_BENCH_INSTANCES; ++i) {
+    positions[i] = Vector3 { random_range_f32(&rng, 0.f, SCENE_BENCH_WORLD_SIZE), random_range_f32(&rng, -5.f, 5.f),
+      random_range_f32(&rng, 0.f, SCENE_BENCH_WORLD_SIZE) };
+    scales[i] = random_range_f32(&rng, 0.1f, 0.6f);
+    const f32 half = scales[i] * 0.5f;
+    streams[0][i] = positions[i].x - half;
+    streams[1][i] = positions[i].y - half;
+    streams[2][i] = positions[i].z - half;
+    streams[3][i] = positions[i].x + half;
+    streams[4][i] = positions[i].y + half;
+    streams[5][i] = positions[i].z + half;
+    scene_add_instance(i % SCENE_BENCH_MODELS, MatrixMultiply(MatrixScale(scales[i], scales[i], scales[i]),
+      MatrixTranslate(positions[i].x, positions[i].y, positions[i].z)));
+  }
+
+  const f32 aspect = 16.f / 9.f;
+  scene_cull(bench_camera(0), aspect);
+  const scene_stats built = scene_get_stats();
+
+  f64 bvh_ms = 0.0;
+  f64 sort_ms = 0.0;
+  f64 flat_ms = 0.0;
+  u64 nodes_visited = 0;
+  u64 leaves_tested = 0;
+  u64 visible_total = 0;
+  u32 mismatches = 0;
+  for (u32 view = 0; view < SCENE_BENCH_VIEWS; ++view) {
+    const Camera3D camera = bench_camera(view);
+    scene_cull(camera, aspect);
+    const scene_stats stats = scene_get_stats();
+    bvh_ms += stats.cull_ms;
+    sort_ms += stats.sort_ms;
+    nodes_visited += stats.nodes_visited;
+    leaves_tested += stats.leaves_tested;
+    visible_total += stats.visible_count;
+
+    const auto start = std::chrono::steady_clock::now();
+    const frustum fr = frustum_from_camera(camera, aspect, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+    const u32 flat_visible = frustum_batch_intersects_aabb(&fr, vec3_soa { streams[0], streams[1], streams[2] },
+      vec3_soa { streams[3], streams[4], streams[5] }, visible, SCENE_BENCH_INSTANCES);
+    flat_ms += elapsed_ms(start);
+    mismatches += (flat_visible != stats.visible_count) ? 1 : 0;
+  }
+
+  // Movers bob in place, every cull refits their leaves and the paths above them
+  f64 refit_ms = 0.0;
+  for (u32 r = 0; r < SCENE_BENCH_REFITS; ++r) {
+    const f32 lift = sinf((f32)r * 0.5f) * 0.5f;
+    for (u32 i = 0; i < SCENE_BENCH_MOVERS; ++i) {
+      const scene_instance instance = i * (SCENE_BENCH_INSTANCES / SCENE_BENCH_MOVERS);
+      scene_set_transform(instance, MatrixMultiply(MatrixScale(scales[instance], scales[instance], scales[instance]),
+        MatrixTranslate(positions[instance].x, positions[instance].y + lift, positions[instance].z)));
+    }
+    scene_cull(bench_camera(r % SCENE_BENCH_VIEWS), aspect);
+    refit_ms += scene_get_stats().refit_ms;
+  }
+  const scene_stats refitted = scene_get_stats();
+
+  for (f32* stream : streams) {
+    free_memory(stream);
+  }
+  free_memory(visible);
+  free_memory(positions);
+  free_memory(scales);
+  scene_system_shutdown();
+
+  if (mismatches > 0) {
+    TRACELOG(LOG_ERROR, "SCENE: BVH culling kept a different set than the flat pass in %u of %u views", mismatches, SCENE_BENCH_VIEWS);
+  }
+  const f64 bvh_mean_ms = bvh_ms / SCENE_BENCH_VIEWS;
+  const f64 flat_mean_ms = flat_ms / SCENE_BENCH_VIEWS;
+  TRACELOG(LOG_INFO, "SCENE: %u instances, %u BVH nodes built in %.2f ms, %u views", built.instance_count, built.node_count,
+    built.rebuild_ms, SCENE_BENCH_VIEWS);
+  TRACELOG(LOG_INFO, "SCENE:   bvh   %8.3f ms mean cull, %.3f ms sort, %llu nodes, %llu leaves tested, %llu visible per view",
+    bvh_mean_ms, sort_ms / SCENE_BENCH_VIEWS, nodes_visited / SCENE_BENCH_VIEWS, leaves_tested / SCENE_BENCH_VIEWS, visible_total / SCENE_BENCH_VIEWS);
+  TRACELOG(LOG_INFO, "SCENE:   flat  %8.3f ms mean over every instance (%.1fx the BVH)", flat_mean_ms,
+    (bvh_mean_ms > 0.0) ? flat_mean_ms / bvh_mean_ms : 0.0);
+  TRACELOG(LOG_INFO, "SCENE:   refit %8.3f ms mean for %u movers, %u rebuilds", refit_ms / SCENE_BENCH_REFITS, SCENE_BENCH_MOVERS,
+    refitted.rebuild_count - built.rebuild_count);
+}
@@ -0,0 +1,522 @@
+#include "terrain.h"
+
+#include "raymath.h"
+#include "rlgl.h"
+#include <math.h>
+
+#include "core/fcache.h"
+#include "core/fmath.h"
+#include "core/fmemory.h"
+#include "core/fprofile.h"
+#include "render/gpu_timer.h"
+#include "render/uniform.h"
+
+#define TERRAIN_MORPH_START_RATIO 0.7f
+#define TERRAIN_CACHE_TYPE 0x54455201u // "TER" and the layout version, bump it when a section changes
+
+typedef enum terrain_cache_section {
+  TERRAIN_SECTION_HEIGHTS,
+  TERRAIN_SECTION_GRID_VERTICES,
+  TERRAIN_SECTION_GRID_INDICES,
+  TERRAIN_SECTION_MIN_MAX, // One per depth, TERRAIN_SECTION_MIN_MAX + depth
+} terrain_cache_section;
+
+typedef struct terrain_node {
+  u16 depth;
+  u16 lod;
+  u32 x;
+  u32 z;
+} terrain_node;
+
+typedef struct terrain_system_state {
+  terrain_config config;
+  u32 lod_count;
+  const f32* heights;
+  const Vector2* min_max[TERRAIN_MAX_LOD_COUNT]; // Height range of every node, indexed by depth
+  f32 lod_ranges[TERRAIN_MAX_LOD_COUNT];
+  // Heights, ranges and the grid point into the mapping instead of owned memory when it's open
+  cache_file cache;
+  const f32* cached_grid_vertices;
+  const u16* cached_grid_indices;
+
+  frustum view_frustum;
+  Vector3 view_position;
+  terrain_node* selected; // Frame arena, valid until the next terrain_select()
+  u32 selected_count;
+  terrain_stats stats;
+
+  Mesh grid;
+  Material material;
+  Texture2D height_texture;
+  uniform_cache uniforms;
+  bool gpu_resources_loaded;
+} terrain_system_state;
+
+static terrain_system_state * state = nullptr;
+
+static bool create_state(terrain_config config);
+static void build_min_max(void);
+static void build_grid(u32 res, f32* vertices, u16* indices);
+static u64 terrain_cache_key(const terrain_config* config, const noise_config* noise);
+static bool use_cache(void);
+static bool write_cache(const char* path, u64 key);
+static bool select_node(u32 depth, u32 x, u32 z, bool ignore_range);
+static void add_node(u32 depth, u32 x, u32 z);
+static BoundingBox node_bounds(u32 depth, u32 x, u32 z);
+static void bind_shader(Shader shader);
+
+bool terrain_system_initialize(terrain_config config, const f32* heights) {
+  if (not heights or not create_state(config)) {
+    return false;
+  }
+  const u64 sample_count = (u64)config.heightmap_size * config.heightmap_size;
+  f32* owned_heights = (f32*)allocate_memory(sample_count * sizeof(f32), false, MEMORY_TAG_TERRAIN);
+  copy_memory(owned_heights, heights, sample_count * sizeof(f32));
+  state->heights = owned_heights;
+
+  build_min_max();
+  return true;
+}
+
+bool terrain_system_initialize_cached(terrain_config config, const noise_config* noise, const char* cache_path, bool* from_cache) {
+  if (from_cache) {
+    *from_cache = false;
+  }
+  if (not noise or not create_state(config)) {
+    return false;
+  }
+  const u64 key = terrain_cache_key(&config, noise);
+  cache_result result = cache_open(cache_path, TERRAIN_CACHE_TYPE, key, &state->cache);
+  if (result == CACHE_OK) {
+    if (use_cache()) {
+      if (from_cache) {
+        *from_cache = true;
+      }
+      return true;
+    }
+    // Same key with other sizes can only come from a bug in the writer
+    cache_close(&state->cache);
+    result = CACHE_CORRUPT;
+  }
+  if (result != CACHE_MISSING) {
+    TRACELOG(LOG_WARNING, "TERRAIN: Cache %s is %s, regenerating", cache_path, cache_result_string(result));
+  }
+
+  const u64 sample_count = (u64)config.heightmap_size * config.heightmap_size;
+  f32* heights = (f32*)allocate_memory(sample_count * sizeof(f32), false, MEMORY_TAG_TERRAIN);
+  state->heights = heights;
+  if (not noise_generate_heightfield(noise, config.heightmap_size, config.heightmap_size, heights)) {
+    terrain_system_shutdown();
+    return false;
+  }
+  build_min_max();
+  if (not write_cache(cache_path, key)) {
+    TRACELOG(LOG_WARNING, "TERRAIN: Cache %s can not be written", cache_path);
+  }
+  return true;
+}
+
+void terrain_system_shutdown(void) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  terrain_unload_gpu_resources();
+
+  if (state->cache.data) {
+    cache_close(&state->cache);
+  } else {
+    for (u32 i = 0; i < state->lod_count; ++i) {
+      if (state->min_max[i]) free_memory((void*)state->min_max[i]);
+    }
+    if (state->heights) free_memory((void*)state->heights);
+  }
+  state = nullptr;
+}
+
+bool terrain_load_gpu_resources(Material material) {
+  if (not state or state == nullptr or state->gpu_resources_loaded) {
+    return false;
+  }
+  const terrain_config& config = state->config;
+  const i32 res = (i32)config.chunk_resolution;
+  const i32 vertex_count = (res + 1) * (res + 1);
+
+  // Single unit grid shared by every node, placed and displaced in terrain.vs
+  Mesh grid = {};
+  grid.vertexCount = vertex_count;
+  grid.triangleCount = res * res * 2;
+  if (state->cached_grid_vertices) {
+    // Uploaded straight from the mapping. UnloadMesh() frees the CPU arrays, these aren't ours
+    grid.vertices = (float*)state->cached_grid_vertices;
+    grid.indices = (unsigned short*)state->cached_grid_indices;
+    UploadMesh(&grid, false);
+    grid.vertices = nullptr;
+    grid.indices = nullptr;
+  } else {
+    grid.vertices = (float*)MemAlloc(vertex_count * 3 * sizeof(float));
+    grid.indices = (unsigned short*)MemAlloc(grid.triangleCount * 3 * sizeof(unsigned short));
+    build_grid(config.chunk_resolution, grid.vertices, grid.indices);
+    UploadMesh(&grid, false);
+  }
+  state->grid = grid;
+
+  Image height_image = Image {
+    .data = (void*)state->heights,
+    .width = (i32)config.heightmap_size,
+    .height = (i32)config.heightmap_size,
+    .mipmaps = 1,
+    .format = PIXELFORMAT_UNCOMPRESSED_R32,
+  };
+  state->height_texture = LoadTextureFromImage(height_image);
+  SetTextureFilter(state->height_texture, TEXTURE_FILTER_BILINEAR);
+  SetTextureWrap(state->height_texture, TEXTURE_WRAP_CLAMP);
+
+  state->material = material;
+  state->material.maps[MATERIAL_MAP_DIFFUSE].texture = state->height_texture;
+  bind_shader(material.shader);
+
+  state->gpu_resources_loaded = true;
+  return true;
+}
+
+void terrain_unload_gpu_resources(void) {
+  if (not state or state == nullptr or not state->gpu_resources_loaded) {
+    return;
+  }
+  UnloadMesh(state->grid);
+  UnloadTexture(state->height_texture);
+  state->grid = Mesh {};
+  state->height_texture = Texture2D {};
+  state->gpu_resources_loaded = false;
+}
+
+void terrain_set_shader(Shader shader) {
+  if (not state or state == nullptr or not state->gpu_resources_loaded) {
+    return;
+  }
+  bind_shader(shader);
+}
+
+void terrain_select(Camera3D camera, f32 aspect) {
+  if (not state or state == nullptr) {
+    return;
+  }
+  PROFILE_SCOPE("terrain_select");
+  state->view_frustum = frustum_from_camera(camera, aspect, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR);
+  state->view_position = camera.position;
+  state->selected = (terrain_node*)allocate_memory_frame(sizeof(terrain_node) * TERRAIN_MAX_SELECTED_NODES, false);
+  state->selected_count = 0;
+
+  terrain_stats& stats = state->stats;
+  stats.nodes_visited = 0;
+  stats.nodes_culled = 0;
+  stats.draw_count = 0;
+  stats.triangle_count = 0;
+  for (u32& count : stats.draws_per_lod) {
+    count = 0;
+  }
+  select_node(0, 0, 0, true);
+}
+
+void terrain_draw(void) {
+  if (not state or state == nullptr or not state->gpu_resources_loaded) {
+    return;
+  }
+  PROFILE_SCOPE("terrain_draw");
+  PROFILE_GPU_SCOPE("terrain");
+  const f32 world_size = state->config.world_size;
+  const Matrix transform = MatrixTranslate(state->config.position.x, state->config.position.y, state->config.position.z);
+
+  for (u32 i = 0; i < state->selected_count; ++i) {
+    const terrain_node& node = state->selected[i];
+    const f32 size = world_size / (f32)(1u << node.depth);
+    const f32 morph_end = state->lod_ranges[node.lod];
+    const f32 prev_range = (node.lod > 0) ? state->lod_ranges[node.lod - 1] : 0.f;
+
+    const Vector4 node_params = Vector4 { node.x * size, node.z * size, size, (f32)node.lod };
+    const Vector2 morph_params = Vector2 { prev_range + (morph_end - prev_range) * TERRAIN_MORPH_START_RATIO, morph_end };
+    // Nodes of the same lod share morphParams, the cache drops those uploads
+    uniform_set(&state->uniforms, "nodeParams", &node_params, SHADER_UNIFORM_VEC4);
+    uniform_set(&state->uniforms, "morphParams", &morph_params, SHADER_UNIFORM_VEC2);
+
+    DrawMesh(state->grid, state->material, transform);
+  }
+}
+
+f32 terrain_get_height(f32 x, f32 z) {
+  if (not state or state == nullptr) {
+    return 0.f;
+  }
+  const terrain_config& config = state->config;
+  const u32 n = config.heightmap_size;
+  const f32 fx = Clamp((x - config.position.x) / config.world_size, 0.f, 1.f) * (f32)(n - 1);
+  const f32 fz = Clamp((z - config.position.z) / config.world_size, 0.f, 1.f) * (f32)(n - 1);
+  const u32 x0 = (u32)fx;
+  const u32 z0 = (u32)fz;
+  const u32 x1 = FMIN(x0 + 1, n - 1);
+  const u32 z1 = FMIN(z0 + 1, n - 1);
+  const f32 tx = fx - (f32)x0;
+  const f32 tz = fz - (f32)z0;
+
+  const f32* h = state->heights;
+  const f32 top = Lerp(h[z0 * n + x0], h[z0 * n + x1], tx);
+  const f32 bottom = Lerp(h[z1 * n + x0], h[z1 * n + x1], tx);
+  return config.position.y + Lerp(top, bottom, tz) * config.height_scale;
+}
+
+terrain_stats terrain_get_stats(void) {
+  if (not state or state == nullptr) {
+    return terrain_stats {};
+  }
+  return state->stats;
+}
+
+static void bind_shader(Shader shader) {
+  const terrain_config& config = state->config;
+  state->material.shader = shader;
+  uniform_cache_initialize(&state->uniforms, shader);
+  const Vector4 terrain_params = Vector4 { config.world_size, config.height_scale, (f32)config.heightmap_size, (f32)config.chunk_resolution };
+  uniform_set(&state->uniforms, "terrainParams", &terrain_params, SHADER_UNIFORM_VEC4);
+}
+
+static bool create_state(terrain_config config) {
+  if (state and state != nullptr) {
+    return false;
+  }
+  // Grid indices are 16 bit
+  const u64 grid_vertex_count = (u64)(config.chunk_resolution + 1) * (config.chunk_resolution + 1);
+  if (config.heightmap_size < 2 or config.chunk_resolution == 0 or grid_vertex_count > U16_MAX) {
+    return false;
+  }
+  state = (terrain_system_state*)allocate_memory_linear(sizeof(terrain_system_state), true, MEMORY_TAG_TERRAIN);
+  if (not state or state == nullptr) {
+    return false;
+  }
+  state->config = config;
+
+  const u32 chunk_count = FMAX(config.heightmap_size / config.chunk_resolution, 1u);
+  state->lod_count = 1;
+  while ((1u << (state->lod_count - 1)) < chunk_count and state->lod_count < TERRAIN_MAX_LOD_COUNT) {
+    state->lod_count++;
+  }
+  state->stats.lod_count = state->lod_count;
+
+  // Ranges have to cover at least a node diagonal, otherwise neighbours can differ more than one lod
+  const f32 leaf_size = config.world_size / (f32)(1u << (state->lod_count - 1));
+  f32 range = FMAX(config.lod_distance, leaf_size * 2.f);
+  for (u32 i = 0; i < state->lod_count; ++i) {
+    state->lod_ranges[i] = range;
+    range *= 2.f;
+  }
+  return true;
+}
+
+static void build_min_max(void) {
+  const u32 n = state->config.heightmap_size;
+  const u32 leaf_depth = state->lod_count - 1;
+  const u32 leaf_count = 1u << leaf_depth;
+
+  Vector2* levels[TERRAIN_MAX_LOD_COUNT] = {};
+  for (u32 depth = 0; depth <= leaf_depth; ++depth) {
+    const u64 count = (u64)(1u << depth) * (1u << depth);
+    levels[depth] = (Vector2*)allocate_memory(count * sizeof(Vector2), false, MEMORY_TAG_TERRAIN);
+    state->min_max[depth] = levels[depth];
+  }
+
+  // Leaves scan their samples including one sample of border, so morphed edges stay inside the bounds
+  Vector2* leaves = levels[leaf_depth];
+  for (u32 lz = 0; lz < leaf_count; ++lz) {
+    for (u32 lx = 0; lx < leaf_count; ++lx) {
+      const u32 x_first = (u32)((u64)lx * n / leaf_count);
+      const u32 z_first = (u32)((u64)lz * n / leaf_count);
+      const u32 x_begin = (x_first > 0) ? x_first - 1 : 0;
+      const u32 z_begin = (z_first > 0) ? z_first - 1 : 0;
+      const u32 x_end = FMIN((u32)((u64)(lx + 1) * n / leaf_count) + 1, n - 1);
+      const u32 z_end = FMIN((u32)((u64)(lz + 1) * n / leaf_count) + 1, n - 1);
+
+      Vector2 range = Vector2 { F32_MAX, -F32_MAX };
+      for (u32 z = z_begin; z <= z_end; ++z) {
+        for (u32 x = x_begin; x <= x_end; ++x) {
+          const f32 h = state->heights[z * n + x];
+          range.x = fminf(range.x, h);
+          range.y = fmaxf(range.y, h);
+        }
+      }
+      leaves[lz * leaf_count + lx] = range;
+    }
+  }
+
+  for (i32 depth = (i32)leaf_depth - 1; depth >= 0; --depth) {
+    const u32 count = 1u << depth;
+    const Vector2* children = levels[depth + 1];
+    Vector2* nodes = levels[depth];
+    for (u32 z = 0; z < count; ++z) {
+      for (u32 x = 0; x < count; ++x) {
+        const u32 stride = count * 2;
+        const Vector2 c0 = children[(z * 2) * stride + x * 2];
+        const Vector2 c1 = children[(z * 2) * stride + x * 2 + 1];
+        const Vector2 c2 = children[(z * 2 + 1) * stride + x * 2];
+        const Vector2 c3 = children[(z * 2 + 1) * stride + x * 2 + 1];
+        nodes[z * count + x] = Vector2 {
+          fminf(fminf(c0.x, c1.x), fminf(c2.x, c3.x)),
+          fmaxf(fmaxf(c0.y, c1.y), fmaxf(c2.y, c3.y)),
+        };
+      }
+    }
+  }
+}
+
+static void build_grid(u32 res, f32* vertices, u16* indices) {
+  for (u32 z = 0; z <= res; ++z) {
+    for (u32 x = 0; x <= res; ++x) {
+      const u32 v = (z * (res + 1) + x) * 3;
+      vertices[v + 0] = (f32)x / (f32)res;
+      vertices[v + 1] = 0.f;
+      vertices[v + 2] = (f32)z / (f32)res;
+    }
+  }
+  u32 index = 0;
+  for (u32 z = 0; z < res; ++z) {
+    for (u32 x = 0; x < res; ++x) {
+      const u16 a = (u16)(z * (res + 1) + x);
+      const u16 b = (u16)(a + res + 1);
+      indices[index++] = a;
+      indices[index++] = b;
+      indices[index++] = a + 1;
+      indices[index++] = a + 1;
+      indices[index++] = b;
+      indices[index++] = b + 1;
+    }
+  }
+}
+
+// Only what the cached data depends on. World size, height scale and lod distance are applied at draw time
+static u64 terrain_cache_key(const terrain_config* config, const noise_config* noise) {
+  u64 key = 0;
+  const auto append = [&key](const void* field, u64 size) { key = cache_hash(field, size, key); };
+  append(&config->heightmap_size, sizeof(config->heightmap_size));
+  append(&config->chunk_resolution, sizeof(config->chunk_resolution));
+  append(&noise->seed, sizeof(noise->seed));
+  append(&noise->octaves, sizeof(noise->octaves));
+  append(&noise->scale, sizeof(noise->scale));
+  append(&noise->lacunarity, sizeof(noise->lacunarity));
+  append(&noise->gain, sizeof(noise->gain));
+  append(&noise->mode, sizeof(noise->mode));
+  append(&noise->warp_strength, sizeof(noise->warp_strength));
+  append(&noise->warp_scale, sizeof(noise->warp_scale));
+  append(&noise->offset_x, sizeof(noise->offset_x));
+  append(&noise->offset_y, sizeof(noise->offset_y));
+  append(&noise->normalize, sizeof(noise->normalize));
+  return key;
+}
+
+static bool use_cache(void) {
+  const u64 n = state->config.heightmap_size;
+  const u64 res = state->config.chunk_resolution;
+  const f32* heights = (const f32*)cache_find_section(&state->cache, TERRAIN_SECTION_HEIGHTS, n * n * sizeof(f32));
+  const f32* vertices = (const f32*)cache_find_section(&state->cache, TERRAIN_SECTION_GRID_VERTICES, (res + 1) * (res + 1) * 3 * sizeof(f32));
+  const u16* indices = (const u16*)cache_find_section(&state->cache, TERRAIN_SECTION_GRID_INDICES, res * res * 6 * sizeof(u16));
+  if (not heights or not vertices or not indices) {
+    return false;
+  }
+  const Vector2* min_max[TERRAIN_MAX_LOD_COUNT] = {};
+  for (u32 depth = 0; depth < state->lod_count; ++depth) {
+    const u64 count = (u64)(1u << depth) * (1u << depth);
+    min_max[depth] = (const Vector2*)cache_find_section(&state->cache, TERRAIN_SECTION_MIN_MAX + depth, count * sizeof(Vector2));
+    if (not min_max[depth]) {
+      return false;
+    }
+  }
+  state->heights = heights;
+  state->cached_grid_vertices = vertices;
+  state->cached_grid_indices = indices;
+  for (u32 depth = 0; depth < state->lod_count; ++depth) {
+    state->min_max[depth] = min_max[depth];
+  }
+  return true;
+}
+
+static bool write_cache(const char* path, u64 key) {
+  const u64 n = state->config.heightmap_size;
+  const u32 res = state->config.chunk_resolution;
+  const u64 vertex_size = (u64)(res + 1) * (res + 1) * 3 * sizeof(f32);
+  const u64 index_size = (u64)res * res * 6 * sizeof(u16);
+  f32* vertices = (f32*)allocate_memory(vertex_size, false, MEMORY_TAG_TERRAIN);
+  u16* indices = (u16*)allocate_memory(index_size, false, MEMORY_TAG_TERRAIN);
+  build_grid(res, vertices, indices);
+
+  cache_section sections[TERRAIN_SECTION_MIN_MAX + TERRAIN_MAX_LOD_COUNT] = {};
+  u32 count = 0;
+  sections[count++] = cache_section { TERRAIN_SECTION_HEIGHTS, state->heights, n * n * sizeof(f32) };
+  sections[count++] = cache_section { TERRAIN_SECTION_GRID_VERTICES, vertices, vertex_size };
+  sections[count++] = cache_section { TERRAIN_SECTION_GRID_INDICES, indices, index_size };
+  for (u32 depth = 0; depth < state->lod_count; ++depth) {
+    const u64 node_count = (u64)(1u << depth) * (1u << depth);
+    sections[count++] = cache_section { TERRAIN_SECTION_MIN_MAX + depth, state->min_max[depth], node_count * sizeof(Vector2) };
+  }
+  const bool written = cache_write(path, TERRAIN_CACHE_TYPE, key, sections, count);
+  free_memory(indices);
+  free_memory(vertices);
+  return written;
+}
+
+static BoundingBox node_bounds(u32 depth, u32 x, u32 z) {
+  const terrain_config& config = state->config;
+  const f32 size = config.world_size / (f32)(1u << depth);
+  const Vector2 range = state->min_max[depth][z * (1u << depth) + x];
+  return BoundingBox {
+    Vector3 { config.position.x + x * size, config.position.y + range.x * config.height_scale, config.position.z + z * size },
+    Vector3 { config.position.x + (x + 1) * size, config.position.y + range.y * config.height_scale, config.position.z + (z + 1) * size },
+  };
+}
+
+/**
+ * @brief CDLOD style selection. Returns false if the node is outside of its own lod range
+ * and its parent has to cover the area instead.
+ */
+static bool select_node(u32 depth, u32 x, u32 z, bool ignore_range) {
+  const u32 lod = state->lod_count - 1 - depth;
+  const BoundingBox box = node_bounds(depth, x, z);
+  state->stats.nodes_visited++;
+
+  if (not frustum_intersects_aabb(&state->view_frustum, box.min, box.max)) {
+    state->stats.nodes_culled++;
+    return true;
+  }
+  const f32 distance_sqr = aabb_distance_sqr(box.min, box.max, state->view_position);
+  const f32 range = state->lod_ranges[lod];
+  if (not ignore_range and distance_sqr > range * range) {
+    return false;
+  }
+  if (lod == 0) {
+    add_node(depth, x, z);
+    return true;
+  }
+  const f32 child_range = state->lod_ranges[lod - 1];
+  if (distance_sqr > child_range * child_range) {
+    add_node(depth, x, z);
+    return true;
+  }
+  for (u32 i = 0; i < 4; ++i) {
+    const u32 cx = x * 2 + (i & 1);
+    const u32 cz = z * 2 + (i >> 1);
+    // Children out of the finer range are drawn on their own grid, fully morphed to this lod
+    if (not select_node(depth + 1, cx, cz, false)) {
+      add_node(depth + 1, cx, cz);
+    }
+  }
+  return true;
+}
+
+static void add_node(u32 depth, u32 x, u32 z) {
+  if (not state->selected or state->selected_count >= TERRAIN_MAX_SELECTED_NODES) {
+    return;
+  }
+  const u16 lod = (u16)(state->lod_count - 1 - depth);
+  state->selected[state->selected_count++] = terrain_node { (u16)depth, lod, x, z };
+
+  terrain_stats& stats = state->stats;
+  stats.draw_count++;
+  stats.triangle_count += (u64)state->config.chunk_resolution * state->config.chunk_resolution * 2;
+  stats.draws_per_lod[lod]++;
+}
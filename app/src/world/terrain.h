@@ -0,0 +1,75 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include "defines.h"
+#include "raylib.h"
+
+#include "core/fnoise.h"
+
+#define TERRAIN_MAX_LOD_COUNT 12
+#define TERRAIN_MAX_SELECTED_NODES 4096
+
+typedef struct terrain_config {
+  u32 heightmap_size;   // Samples per side, power of two
+  u32 chunk_resolution; // Quads per side of a chunk grid, power of two
+  f32 world_size;
+  f32 height_scale;
+  f32 lod_distance;     // View range of the finest lod, doubled for every coarser lod
+  Vector3 position;     // Minimum corner of the terrain in world space
+} terrain_config;
+
+typedef struct terrain_stats {
+  u32 lod_count;
+  u32 nodes_visited;
+  u32 nodes_culled;
+  u32 draw_count;
+  u64 triangle_count;
+  u32 draws_per_lod[TERRAIN_MAX_LOD_COUNT];
+} terrain_stats;
+
+/**
+ * @brief Builds the quadtree over a copy of heights. Doesn't need a GL context,
+ * so selection and stats can run headless.
+ * @param heights heightmap_size * heightmap_size samples in [0, 1], row major along z
+ */
+[[__nodiscard__]] bool terrain_system_initialize(terrain_config config, const f32* heights);
+
+/**
+ * @brief Generates the heightfield from noise and builds the quadtree, or maps both from cache_path when it was
+ * written for the same heightmap size, chunk resolution and noise. The chunk grid comes from the cache too.
+ * Missing, stale or corrupt caches are regenerated and written again.
+ * @param from_cache Optional, set to true when nothing had to be generated
+ */
+[[__nodiscard__]] bool terrain_system_initialize_cached(terrain_config config, const noise_config* noise, const char* cache_path, bool* from_cache);
+void terrain_system_shutdown(void);
+
+/**
+ * @brief Creates the shared chunk grid and height texture. Height texture is bound to MATERIAL_MAP_DIFFUSE.
+ */
+bool terrain_load_gpu_resources(Material material);
+void terrain_unload_gpu_resources(void);
+
+/**
+ * @brief Swaps the material's program for a reloaded one, terrainParams is uploaded again.
+ */
+void terrain_set_shader(Shader shader);
+
+void terrain_select(Camera3D camera, f32 aspect);
+void terrain_draw(void);
+
+f32 terrain_get_height(f32 x, f32 z);
+terrain_stats terrain_get_stats(void);
+
+/**
+ * @brief Times terrain startup without a cache, with a cold cache and with a warm one. Runs headless,
+ * the GPU upload is left out. Results are logged.
+ */
+void terrain_run_startup_benchmark(terrain_config config, const noise_config* noise);
+
+/**
+ * @brief Selects from a fixed camera while the world grows to 4096x4096 samples at the same spacing and logs
+ * the draw and triangle counts of each size. Runs headless, reports an error if the triangles don't stay level.
+ */
+void terrain_run_selection_benchmark(terrain_config config, const noise_config* noise);
+
+#endif
@@ -0,0 +1,135 @@
+#include "terrain.h"
+
+#include <chrono>
+#include <stdio.h> // Required for: remove(), snprintf()
+
+#include "core/fmemory.h"
+
+#define TERRAIN_BENCH_CACHE_FILE "terrain_bench.cache"
+#define TERRAIN_BENCH_WARM_RUNS 8
+#define TERRAIN_BENCH_SELECT_RUNS 64
+#define TERRAIN_BENCH_MAX_HEIGHTMAP_SIZE 4096
+#define TERRAIN_BENCH_ASPECT (16.f / 9.f)
+
+static f64 elapsed_ms(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void terrain_run_startup_benchmark(terrain_config config, const noise_config* noise) {
+  remove(TERRAIN_BENCH_CACHE_FILE);
+
+  // What every launch paid before the cache
+  auto start = std::chrono::steady_clock::now();
+  const u64 sample_count = (u64)config.heightmap_size * config.heightmap_size;
+  f32* heights = (f32*)allocate_memory(sample_count * sizeof(f32), false, MEMORY_TAG_TERRAIN);
+  const bool generated = noise_generate_heightfield(noise, config.heightmap_size, config.heightmap_size, heights)
+    and terrain_system_initialize(config, heights);
+  free_memory(heights);
+  const f64 uncached_ms = elapsed_ms(start);
+  terrain_system_shutdown();
+
+  // Cold generates the same data and writes the cache on top
+  bool from_cache = true;
+  start = std::chrono::steady_clock::now();
+  const bool cold = terrain_system_initialize_cached(config, noise, TERRAIN_BENCH_CACHE_FILE, &from_cache);
+  const f64 cold_ms = elapsed_ms(start);
+  terrain_system_shutdown();
+  if (not generated or not cold or from_cache) {
+    TRACELOG(LOG_ERROR, "TERRAIN: Startup benchmark can not generate the terrain");
+    remove(TERRAIN_BENCH_CACHE_FILE);
+    return;
+  }
+  const u64 cache_size = (u64)GetFileLength(TERRAIN_BENCH_CACHE_FILE);
+
+  f64 warm_best_ms = 0.0;
+  f64 warm_total_ms = 0.0;
+  for (u32 i = 0; i < TERRAIN_BENCH_WARM_RUNS; ++i) {
+    start = std::chrono::steady_clock::now();
+    const bool warm = terrain_system_initialize_cached(config, noise, TERRAIN_BENCH_CACHE_FILE, &from_cache);
+    const f64 warm_ms = elapsed_ms(start);
+    terrain_system_shutdown();
+    if (not warm or not from_cache) {
+      TRACELOG(LOG_ERROR, "TERRAIN: Startup benchmark cache was not used on warm run %u", i);
+      remove(TERRAIN_BENCH_CACHE_FILE);
+      return;
+    }
+    warm_best_ms = (i == 0 or warm_ms < warm_best_ms) ? warm_ms : warm_best_ms;
+    warm_total_ms += warm_ms;
+  }
+  remove(TERRAIN_BENCH_CACHE_FILE);
+
+  TRACELOG(LOG_INFO, "TERRAIN: Startup %ux%u heightfield, cache %llu KB, GPU upload excluded", config.heightmap_size, config.heightmap_size, cache_size / 1024);
+  TRACELOG(LOG_INFO, "TERRAIN:   uncached %8.2f ms", uncached_ms);
+  TRACELOG(LOG_INFO, "TERRAIN:   cold     %8.2f ms (generates and writes the cache)", cold_ms);
+  TRACELOG(LOG_INFO, "TERRAIN:   warm     %8.2f ms best, %.2f ms mean of %u (%.1fx faster than uncached)",
+    warm_best_ms, warm_total_ms / TERRAIN_BENCH_WARM_RUNS, TERRAIN_BENCH_WARM_RUNS, (warm_best_ms > 0.0) ? uncached_ms / warm_best_ms : 0.0);
+}
+
+// Same eye and view direction whatever the world size, a few units in from the corner looking across it
+static Camera3D selection_camera(terrain_config config) {
+  const Vector3 origin = config.position;
+  return Camera3D {
+    Vector3 { origin.x + 8.f, origin.y + config.height_scale + 2.f, origin.z + 8.f },
+    Vector3 { origin.x + 40.f, origin.y + config.height_scale * 0.5f, origin.z + 40.f },
+    Vector3 { 0.f, 1.f, 0.f },
+    90.f,
+    CAMERA_PERSPECTIVE
+  };
+}
+
+void terrain_run_selection_benchmark(terrain_config config, const noise_config* noise) {
+  const Camera3D camera = selection_camera(config);
+  const u32 base_size = config.heightmap_size;
+  const f32 sample_spacing = config.world_size / (f32)base_size;
+  u64 min_triangles = U64_MAX;
+  u64 max_triangles = 0;
+
+  TRACELOG(LOG_INFO, "TERRAIN: Selection from (%.1f, %.1f, %.1f), %u chunk grid, lod distance %.1f", camera.position.x, camera.position.y,
+    camera.position.z, config.chunk_resolution, config.lod_distance);
+  // The world grows at the same sample spacing, the camera stays where it is
+  for (u32 size = base_size; size <= TERRAIN_BENCH_MAX_HEIGHTMAP_SIZE; size *= 2) {
+    terrain_config grown = config;
+    grown.heightmap_size = size;
+    grown.world_size = sample_spacing * (f32)size;
+
+    const u64 sample_count = (u64)size * size;
+    f32* heights = (f32*)allocate_memory(sample_count * sizeof(f32), false, MEMORY_TAG_TERRAIN);
+    const bool generated = noise_generate_heightfield(noise, size, size, heights) and terrain_system_initialize(grown, heights);
+    free_memory(heights);
+    if (not generated) {
+      TRACELOG(LOG_ERROR, "TERRAIN: Selection benchmark can not generate a %ux%u terrain", size, size);
+      return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (u32 i = 0; i < TERRAIN_BENCH_SELECT_RUNS; ++i) {
+      terrain_select(camera, TERRAIN_BENCH_ASPECT);
+      memory_system_end_frame();
+    }
+    const f64 select_ms = elapsed_ms(start) / TERRAIN_BENCH_SELECT_RUNS;
+    // The selection is deterministic, the last run stands for all of them
+    terrain_select(camera, TERRAIN_BENCH_ASPECT);
+    const terrain_stats stats = terrain_get_stats();
+    memory_system_end_frame();
+    terrain_system_shutdown();
+
+    char lods[TERRAIN_MAX_LOD_COUNT * 8] = {};
+    u32 length = 0;
+    for (u32 lod = 0; lod < stats.lod_count; ++lod) {
+      length += (u32)snprintf(lods + length, sizeof(lods) - length, (lod == 0) ? "%u" : " %u", stats.draws_per_lod[lod]);
+    }
+    TRACELOG(LOG_INFO, "TERRAIN:   %4ux%-4u %6.0f units, %u lods: %5u draws %8llu triangles, %4u nodes visited %4u culled, %.3f ms, draws per lod %s",
+      size, size, grown.world_size, stats.lod_count, stats.draw_count, stats.triangle_count, stats.nodes_visited, stats.nodes_culled, select_ms, lods);
+    min_triangles = FMIN(min_triangles, stats.triangle_count);
+    max_triangles = FMAX(max_triangles, stats.triangle_count);
+  }
+
+  // Each doubling adds one coarser ring, the near field that holds most triangles is unchanged
+  const f32 growth = (min_triangles > 0) ? (f32)max_triangles / (f32)min_triangles : 0.f;
+  if (min_triangles == 0 or growth > 2.f) {
+    TRACELOG(LOG_ERROR, "TERRAIN: Selected triangles grow %.2fx with the world, should stay roughly constant", growth);
+    return;
+  }
+  TRACELOG(LOG_INFO, "TERRAIN:   triangles grow %.2fx from %ux%u to %ux%u", growth, base_size, base_size, TERRAIN_BENCH_MAX_HEIGHTMAP_SIZE,
+    TERRAIN_BENCH_MAX_HEIGHTMAP_SIZE);
+}